@@ -0,0 +1,58 @@
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include "../include/archive.hpp"
+
+// Бенчмарк сжатого архива: степень сжатия и скорость декодирования
+// Запуск: bench_archive [число фигур] [точность]
+int main(int argc, char* argv[]) {
+    size_t count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+    ArchiveOptions opts;
+    if (argc > 2) {
+        opts.precision = std::strtod(argv[2], nullptr);
+    }
+
+    // Случайные правильные фигуры в квадрате 1000x1000
+    std::mt19937_64 rng(42);
+    std::uniform_real_distribution<double> pos(-500.0, 500.0);
+    std::uniform_real_distribution<double> radius(0.1, 10.0);
+    std::uniform_real_distribution<double> phase(0.0, 2.0 * M_PI);
+    FigureBuffer figures;
+    for (size_t i = 0; i < count; ++i) {
+        FigureKind kind = static_cast<FigureKind>(4 + i % 3);
+        size_t n = kindApexCount(kind);
+        double cx = pos(rng), cy = pos(rng), r = radius(rng), phi = phase(rng);
+        double xs[6], ys[6];
+        for (size_t j = 0; j < n; ++j) {
+            xs[j] = cx + r * std::cos(phi + 2.0 * M_PI * j / n);
+            ys[j] = cy + r * std::sin(phi + 2.0 * M_PI * j / n);
+        }
+        figures.push(kind, xs, ys);
+    }
+
+    using clock = std::chrono::steady_clock;
+    std::stringstream ss;
+    auto t0 = clock::now();
+    writeArchive(ss, figures, opts);
+    auto t1 = clock::now();
+    ArchiveReader reader(ss);
+    auto t2 = clock::now();
+    FigureBuffer decoded = reader.readAll();
+    auto t3 = clock::now();
+
+    double raw = static_cast<double>(figures.apexTotal()) * 2 * sizeof(double);
+    double packed = static_cast<double>(ss.str().size());
+    double enc = std::chrono::duration<double>(t1 - t0).count();
+    double dec = std::chrono::duration<double>(t3 - t2).count();
+
+    std::cout << "Фигур: " << count << ", точность: " << opts.precision << "\n"
+              << "Исходный размер: " << raw / 1e6 << " МБ\n"
+              << "Архив: " << packed / 1e6 << " МБ (сжатие " << raw / packed << "x)\n"
+              << "Кодирование: " << raw / enc / 1e6 << " МБ/с\n"
+              << "Декодирование: " << raw / dec / 1e6 << " МБ/с, "
+              << decoded.size() / dec / 1e6 << " млн фигур/с\n";
+    return 0;
+}
@@ -0,0 +1,70 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+#include "../include/generator.hpp"
+
+// Бенчмарк совмещённого вычисления площади и центра масс: batchAreaCentroids
+// против проходов только по площади (batchAreas, area(i)) и против отдельных
+// проходов по площади и центру масс.
+// Запуск: bench_centroid [число фигур] [повторов]
+int main(int argc, char* argv[]) {
+    GeneratorOptions opts;
+    opts.count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 2000000;
+    size_t repeats = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 5;
+    opts.irregularPentagons = 1;
+    opts.irregularHexagons = 1;
+    FigureBuffer figures = generateFigures(opts);
+    size_t n = figures.size();
+    std::vector<double> areas(n), cx(n), cy(n);
+
+    using clock = std::chrono::steady_clock;
+    auto measure = [&](const char* name, auto body) {
+        double best = 1e300;
+        for (size_t r = 0; r < repeats; ++r) {
+            auto t0 = clock::now();
+            body();
+            best = std::min(best, std::chrono::duration<double>(clock::now() - t0).count());
+        }
+        std::cout << name << ": " << best * 1e3 << " мс (" << n / best / 1e6 << " млн фигур/с)\n";
+        return best;
+    };
+
+    double area = measure("batchAreas", [&] { batchAreas(figures, areas.data()); });
+    area = std::min(area, measure("area(i)", [&] {
+        for (size_t i = 0; i < n; ++i) {
+            areas[i] = figures.area(i);
+        }
+    }));
+    double fused = measure("batchAreaCentroids", [&] {
+        batchAreaCentroids(figures, areas.data(), cx.data(), cy.data());
+    });
+    measure("area(i) + centroid(i)", [&] {
+        for (size_t i = 0; i < n; ++i) {
+            areas[i] = figures.area(i);
+            auto c = figures.centroid(i);
+            cx[i] = c.first;
+            cy[i] = c.second;
+        }
+    });
+    measure("batchAreas + centroid(i)", [&] {
+        batchAreas(figures, areas.data());
+        for (size_t i = 0; i < n; ++i) {
+            auto c = figures.centroid(i);
+            cx[i] = c.first;
+            cy[i] = c.second;
+        }
+    });
+
+    // Насколько среднее вершин отличается от центра масс у неправильных фигур
+    double shift = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+        auto c = figures.center(i);
+        shift += std::abs(c.first - cx[i]) + std::abs(c.second - cy[i]);
+    }
+    std::cout << "Фигур: " << n << ", совмещённый проход / лучший проход только по площади: " << fused / area << "\n"
+              << "Среднее расхождение среднего вершин и центра масс: " << shift / n << "\n";
+    return 0;
+}
@@ -0,0 +1,75 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+#include "../include/compact_buffer.hpp"
+#include "../include/generator.hpp"
+#include "../include/memory_report.hpp"
+
+// Бенчмарк компактного хранения правильных фигур: память и скорость
+// площадей и центров у объектов Figure, FigureBuffer и CompactBuffer.
+// Запуск: bench_compact [число фигур] [доля неправильных 0..1]
+int main(int argc, char* argv[]) {
+    GeneratorOptions opts;
+    opts.count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+    double irregular = argc > 2 ? std::strtod(argv[2], nullptr) : 0.0;
+    opts.diamonds = 0;
+    opts.pentagons = 1.0 - irregular;
+    opts.hexagons = 1.0 - irregular;
+    opts.irregularPentagons = irregular;
+    opts.irregularHexagons = irregular;
+    FigureBuffer flat = generateFigures(opts);
+    size_t n = flat.size();
+
+    using clock = std::chrono::steady_clock;
+    auto t0 = clock::now();
+    CompactBuffer compact = toCompact(flat);
+    double detect = std::chrono::duration<double>(clock::now() - t0).count();
+    std::vector<std::unique_ptr<Figure>> objects = flat.materializeAll();
+
+    size_t objectBytes = measureMemory(objects).heapBytes();
+    size_t flatBytes = flat.memoryUsage().heapBytes;
+    size_t compactBytes = compact.memoryUsage().heapBytes;
+    std::cout << "Фигур: " << n << ", правильных: " << compact.regularCount()
+              << ", проверка при добавлении: " << detect * 1e3 << " мс\n"
+              << "Память: объекты " << objectBytes << " байт (" << objectBytes / n << " на фигуру), буфер "
+              << flatBytes << " (" << flatBytes / n << "), компактно " << compactBytes << " ("
+              << compactBytes / n << ")\n"
+              << "Экономия: к объектам " << double(objectBytes) / compactBytes << "x, к буферу "
+              << double(flatBytes) / compactBytes << "x\n";
+
+    // Сумма площадей и центров — лучший из пяти проходов
+    auto measure = [&](const char* name, auto body) {
+        double best = 1e300;
+        double check = 0.0;
+        for (int r = 0; r < 5; ++r) {
+            auto start = clock::now();
+            check = body();
+            best = std::min(best, std::chrono::duration<double>(clock::now() - start).count());
+        }
+        std::cout << name << ": " << best * 1e3 << " мс (" << n / best / 1e6 << " млн фигур/с), сумма " << check << "\n";
+    };
+    measure("Объекты", [&] {
+        double sum = 0.0;
+        for (const auto& fig : objects) {
+            sum += fig->calculateArea() + fig->getCenter().first;
+        }
+        return sum;
+    });
+    measure("FigureBuffer", [&] {
+        double sum = 0.0;
+        for (size_t i = 0; i < n; ++i) {
+            sum += flat.area(i) + flat.center(i).first;
+        }
+        return sum;
+    });
+    measure("CompactBuffer", [&] {
+        double sum = 0.0;
+        for (size_t i = 0; i < n; ++i) {
+            sum += compact.area(i) + compact.center(i).first;
+        }
+        return sum;
+    });
+    return 0;
+}
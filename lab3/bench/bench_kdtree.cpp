@@ -0,0 +1,94 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+#include "../include/kdtree.hpp"
+
+// Бенчмарк k-d дерева против полного перебора: построение, k ближайших,
+// поиск в радиусе и добавление в инкрементальное дерево.
+// Запуск: bench_kdtree [точек] [запросов] [k] [потоков]
+// Точки — центры фигур, равномерно в квадрате 1000x1000. Для 1e8 точек
+// нужно около 2.5 ГБ памяти; перебор измеряется на части запросов
+int main(int argc, char* argv[]) {
+    size_t count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+    size_t queries = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 100000;
+    size_t k = argc > 3 ? std::strtoull(argv[3], nullptr, 10) : 8;
+    unsigned threads = argc > 4 ? static_cast<unsigned>(std::strtoul(argv[4], nullptr, 10)) : 0;
+
+    std::mt19937_64 rng(42);
+    std::uniform_real_distribution<double> pos(-500.0, 500.0);
+    std::vector<KdPoint> points(count);
+    for (size_t i = 0; i < count; ++i) {
+        points[i] = {pos(rng), pos(rng), i};
+    }
+    std::vector<std::pair<double, double>> probes(queries);
+    for (auto& q : probes) {
+        q = {pos(rng), pos(rng)};
+    }
+    // Радиус, при котором в круг попадает в среднем около k точек
+    double radius = std::sqrt(static_cast<double>(k) / M_PI / count) * 1000.0;
+
+    using clock = std::chrono::steady_clock;
+    auto seconds = [](clock::time_point a, clock::time_point b) {
+        return std::chrono::duration<double>(b - a).count();
+    };
+
+    auto t0 = clock::now();
+    KdTree tree(points, threads);
+    auto t1 = clock::now();
+    auto knn = tree.nearestBatch(probes, k, threads);
+    auto t2 = clock::now();
+    auto ranges = tree.withinBatch(probes, radius, threads);
+    auto t3 = clock::now();
+
+    // Перебор: столько запросов, чтобы просмотреть порядка 1e9 точек
+    size_t bruteQueries = std::min(queries, std::max<size_t>(1, 1000000000 / std::max<size_t>(1, count)));
+    size_t mismatches = 0;
+    std::vector<Neighbor> all(count);
+    auto t4 = clock::now();
+    for (size_t q = 0; q < bruteQueries; ++q) {
+        for (size_t i = 0; i < count; ++i) {
+            double dx = points[i].x - probes[q].first;
+            double dy = points[i].y - probes[q].second;
+            all[i] = {i, dx * dx + dy * dy};
+        }
+        size_t m = std::min(k, count);
+        std::partial_sort(all.begin(), all.begin() + m, all.end(), [](const Neighbor& a, const Neighbor& b) {
+            return a.distance < b.distance || (a.distance == b.distance && a.id < b.id);
+        });
+        for (size_t j = 0; j < m; ++j) {
+            if (knn[q][j].id != all[j].id) {
+                ++mismatches;
+                break;
+            }
+        }
+    }
+    auto t5 = clock::now();
+
+    size_t incCount = std::min<size_t>(count, 10000000);
+    IncrementalKdTree inc;
+    auto t6 = clock::now();
+    for (size_t i = 0; i < incCount; ++i) {
+        inc.insert(points[i].x, points[i].y, i);
+    }
+    auto t7 = clock::now();
+
+    size_t found = 0;
+    for (const auto& r : ranges) {
+        found += r.size();
+    }
+    double bruteQuery = seconds(t4, t5) / bruteQueries;
+    double treeQuery = seconds(t1, t2) / std::max<size_t>(1, queries);
+    std::cout << "Точек: " << count << ", запросов: " << queries << ", k = " << k << "\n"
+              << "Построение: " << seconds(t0, t1) << " с (" << count / seconds(t0, t1) / 1e6 << " млн точек/с)\n"
+              << "k ближайших: " << queries / seconds(t1, t2) << " запросов/с\n"
+              << "Радиус " << radius << ": " << queries / seconds(t2, t3) << " запросов/с, в среднем "
+              << static_cast<double>(found) / std::max<size_t>(1, queries) << " точек\n"
+              << "Перебор: " << 1.0 / bruteQuery << " запросов/с (" << bruteQueries << " запросов), "
+              << "ускорение " << bruteQuery / treeQuery << "x, расхождений: " << mismatches << "\n"
+              << "Инкрементальное добавление: " << incCount / seconds(t6, t7) / 1e6 << " млн точек/с\n";
+    return mismatches == 0 ? 0 : 1;
+}
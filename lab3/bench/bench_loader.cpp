@@ -0,0 +1,51 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <thread>
+#include "../include/bulk_loader.hpp"
+#include "../include/text_format.hpp"
+
+// Бенчмарк параллельной загрузки текстового дампа: перебор числа потоков
+// Запуск: bench_loader [число фигур] [максимум потоков]
+int main(int argc, char* argv[]) {
+    size_t count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 2000000;
+    unsigned maxThreads = argc > 2 ? static_cast<unsigned>(std::strtoul(argv[2], nullptr, 10))
+                                   : std::max(1u, std::thread::hardware_concurrency());
+
+    std::mt19937_64 rng(7);
+    std::uniform_real_distribution<double> coord(-1000.0, 1000.0);
+    FigureBuffer figures;
+    double xs[6], ys[6];
+    for (size_t i = 0; i < count; ++i) {
+        FigureKind kind = static_cast<FigureKind>(4 + i % 3);
+        for (size_t j = 0; j < kindApexCount(kind); ++j) {
+            xs[j] = coord(rng);
+            ys[j] = coord(rng);
+        }
+        figures.push(kind, xs, ys);
+    }
+    std::string path = "bench_loader.txt";
+    {
+        std::ofstream out(path, std::ios::binary);
+        writeFigures(out, figures);
+    }
+    std::ifstream probe(path, std::ios::binary | std::ios::ate);
+    double bytes = static_cast<double>(probe.tellg());
+    std::cout << "Фигур: " << count << ", размер файла: " << bytes / 1e6 << " МБ\n";
+
+    double base = 0.0;
+    for (unsigned t = 1; t <= maxThreads; t *= 2) {
+        auto t0 = std::chrono::steady_clock::now();
+        FigureBuffer loaded = loadFigures(path, t);
+        double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        if (t == 1) base = sec;
+        std::cout << "Потоков: " << t << "  " << bytes / sec / 1e6 << " МБ/с"
+                  << "  ускорение " << base / sec << "x"
+                  << (loaded.size() == count ? "" : "  (ошибка: не все фигуры)") << "\n";
+    }
+    std::remove(path.c_str());
+    return 0;
+}
@@ -0,0 +1,61 @@
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include "../include/raster.hpp"
+
+// Бенчмарк растеризации: мелкие правильные фигуры в изображение 4K.
+// Запуск: bench_raster [число фигур] [отсчётов на ось] [потоков] [файл.pgm]
+int main(int argc, char* argv[]) {
+    size_t count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 10000000;
+    RasterOptions opts;
+    opts.width = 3840;
+    opts.height = 2160;
+    opts.samples = argc > 2 ? static_cast<unsigned>(std::strtoul(argv[2], nullptr, 10)) : 1;
+    opts.threads = argc > 3 ? static_cast<unsigned>(std::strtoul(argv[3], nullptr, 10)) : 0;
+    const char* path = argc > 4 ? argv[4] : nullptr;
+
+    // Область 3840x2160, фигуры радиусом 0.5..3 пикселя
+    std::mt19937_64 rng(42);
+    std::uniform_real_distribution<double> px(0.0, 3840.0);
+    std::uniform_real_distribution<double> py(0.0, 2160.0);
+    std::uniform_real_distribution<double> radius(0.5, 3.0);
+    std::uniform_real_distribution<double> phase(0.0, 2.0 * M_PI);
+    FigureBuffer figures;
+    figures.reserve(count, count * 5);
+    for (size_t i = 0; i < count; ++i) {
+        FigureKind kind = static_cast<FigureKind>(4 + i % 3);
+        size_t n = kindApexCount(kind);
+        double cx = px(rng), cy = py(rng), r = radius(rng), phi = phase(rng);
+        double xs[6], ys[6];
+        for (size_t j = 0; j < n; ++j) {
+            xs[j] = cx + r * std::cos(phi + 2.0 * M_PI * j / n);
+            ys[j] = cy + r * std::sin(phi + 2.0 * M_PI * j / n);
+        }
+        figures.push(kind, xs, ys);
+    }
+    opts.view.add(0.0, 0.0);
+    opts.view.add(3840.0, 2160.0);
+
+    using clock = std::chrono::steady_clock;
+    auto t0 = clock::now();
+    Raster raster = rasterize(figures, opts);
+    auto t1 = clock::now();
+    double seconds = std::chrono::duration<double>(t1 - t0).count();
+
+    double covered = 0.0;
+    for (float c : raster.coverage) {
+        covered += c;
+    }
+    std::cout << "Фигур: " << count << ", изображение " << raster.width << " x " << raster.height
+              << ", отсчётов " << opts.samples << "x" << opts.samples << "\n"
+              << "Растеризация: " << seconds << " с (" << count / seconds / 1e6 << " млн фигур/с)\n"
+              << "Покрыто: " << 100.0 * covered / raster.coverage.size() << "% площади\n";
+    if (path) {
+        std::ofstream out(path, std::ios::binary);
+        writePgm(out, raster);
+    }
+    return 0;
+}
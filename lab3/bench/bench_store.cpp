@@ -0,0 +1,64 @@
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include "../include/concurrent_store.hpp"
+#include "../include/diamond.hpp"
+
+// Бенчмарк конкурентного хранилища: пропускная способность при разном
+// соотношении читателей и писателей
+// Запуск: bench_store [всего потоков] [секунд на конфигурацию]
+int main(int argc, char* argv[]) {
+    unsigned total = argc > 1 ? static_cast<unsigned>(std::strtoul(argv[1], nullptr, 10)) : 4;
+    double seconds = argc > 2 ? std::strtod(argv[2], nullptr) : 0.5;
+    if (total < 2) total = 2;
+
+    for (unsigned writers = 1; writers < total; ++writers) {
+        unsigned readers = total - writers;
+        ConcurrentStore store;
+        // Начальное наполнение, чтобы снимкам было что читать
+        for (int i = 0; i < 10000; ++i) {
+            store.add(std::make_unique<Diamond>());
+        }
+        std::atomic<bool> stop{false};
+        std::atomic<std::uint64_t> added{0};
+        std::atomic<std::uint64_t> scanned{0};
+        std::vector<std::thread> pool;
+        for (unsigned w = 0; w < writers; ++w) {
+            pool.emplace_back([&]() {
+                std::uint64_t n = 0;
+                while (!stop.load(std::memory_order_relaxed)) {
+                    FigureId id = store.add(std::make_unique<Diamond>());
+                    if (++n % 4 == 0) {
+                        store.remove(id);
+                    }
+                    if (n % 65536 == 0) {
+                        store.collect();
+                    }
+                }
+                added += n;
+            });
+        }
+        for (unsigned r = 0; r < readers; ++r) {
+            pool.emplace_back([&]() {
+                std::uint64_t n = 0;
+                while (!stop.load(std::memory_order_relaxed)) {
+                    FigureSnapshot snap = store.snapshot();
+                    n += snap.size();
+                }
+                scanned += n;
+            });
+        }
+        std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+        stop = true;
+        for (auto& t : pool) {
+            t.join();
+        }
+        std::cout << "Писателей: " << writers << ", читателей: " << readers
+                  << "  добавлений/с: " << added / seconds / 1e6 << " млн"
+                  << "  прочитано фигур/с: " << scanned / seconds / 1e6 << " млн\n";
+    }
+    return 0;
+}
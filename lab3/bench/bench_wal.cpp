@@ -0,0 +1,73 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../include/wal.hpp"
+
+// Бенчмарк журнала: пропускная способность при разных режимах фиксации
+// и скорость восстановления.
+// Запуск: bench_wal [операций] [потоков] [файл журнала]
+int main(int argc, char* argv[]) {
+    size_t ops = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 20000;
+    unsigned threads = argc > 2 ? static_cast<unsigned>(std::strtoul(argv[2], nullptr, 10)) : 4;
+    std::string path = argc > 3 ? argv[3] : "bench_wal.log";
+    if (threads == 0) threads = 1;
+
+    const double xs[4] = {1.0, 0.0, -1.0, 0.0};
+    const double ys[4] = {0.0, 1.0, 0.0, -1.0};
+    const size_t batch = 64;   // операций в пачке для режима batch (как одна команда import)
+    using clock = std::chrono::steady_clock;
+
+    struct Config {
+        Durability durability;
+        unsigned writers;
+    };
+    std::vector<Config> configs = {
+        {Durability::Off, 1}, {Durability::Batch, 1}, {Durability::PerOp, 1}, {Durability::PerOp, threads}
+    };
+    for (const Config& config : configs) {
+        WalOptions opts;
+        opts.durability = config.durability;
+        size_t perWriter = ops / config.writers;
+        auto t0 = clock::now();
+        size_t syncs;
+        {
+            WriteAheadLog wal(path, opts);
+            auto work = [&]() {
+                for (size_t i = 0; i < perWriter; ++i) {
+                    wal.logAdd(FigureKind::Diamond, xs, ys);
+                    if (config.durability == Durability::Batch && (i + 1) % batch == 0) {
+                        wal.commit();
+                    }
+                }
+            };
+            std::vector<std::thread> pool;
+            for (unsigned w = 0; w < config.writers; ++w) {
+                pool.emplace_back(work);
+            }
+            for (auto& t : pool) {
+                t.join();
+            }
+            wal.commit();
+            syncs = wal.syncs();
+        }
+        double seconds = std::chrono::duration<double>(clock::now() - t0).count();
+        size_t total = perWriter * config.writers;
+        std::cout << "Фиксация " << durabilityName(config.durability) << ", потоков " << config.writers
+                  << ": " << total / seconds << " операций/с, записей на диск " << syncs
+                  << " (" << static_cast<double>(total) / syncs << " операций на fsync)\n";
+    }
+
+    // Восстановление из последнего журнала
+    auto t0 = clock::now();
+    FigureCollection figures;
+    WalReplay replay = replayWal(path, figures);
+    double seconds = std::chrono::duration<double>(clock::now() - t0).count();
+    std::cout << "Восстановление: " << replay.records << " записей, "
+              << replay.records / seconds / 1e6 << " млн записей/с\n";
+    std::remove(path.c_str());
+    return 0;
+}
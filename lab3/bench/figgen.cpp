@@ -0,0 +1,73 @@
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include "../include/archive.hpp"
+#include "../include/generator.hpp"
+#include "../include/text_format.hpp"
+
+// Генератор синтетических коллекций для нагрузочных прогонов.
+// Запуск: figgen <число фигур> <файл|-> [format=text|archive] [precision=шаг] [ключ=значение ...]
+// Ключи генератора — см. setGeneratorOption (seed, mix, layout, sizes, ...).
+// Текст — команды add, как при вводе в REPL; archive — сжатый архив для команды load
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        std::cerr << "Использование: figgen <число фигур> <файл|-> [format=text|archive] [precision=шаг]\n"
+                  << "  [seed=N] [mix=diamond:1,pentagon:1,irregular-pentagon:1,hexagon:1,irregular-hexagon:1]\n"
+                  << "  [layout=uniform|clustered] [clusters=N] [spread=доля] [world=полуширина]\n"
+                  << "  [sizes=uniform|zipf] [min=r] [max=r] [zipf=показатель] [threads=N]\n";
+        return 1;
+    }
+    GeneratorOptions opts;
+    ArchiveOptions archive;
+    std::string path = argv[2];
+    std::string format = "text";
+    try {
+        setGeneratorOption(opts, std::string("count=") + argv[1]);
+        for (int i = 3; i < argc; ++i) {
+            std::string option = argv[i];
+            if (option.rfind("format=", 0) == 0) {
+                format = option.substr(7);
+            } else if (option.rfind("precision=", 0) == 0) {
+                archive.precision = std::strtod(option.c_str() + 10, nullptr);
+            } else {
+                setGeneratorOption(opts, option);
+            }
+        }
+        if (format != "text" && format != "archive") {
+            throw std::invalid_argument("Unknown format: " + format);
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Ошибка: " << e.what() << "\n";
+        return 1;
+    }
+
+    using clock = std::chrono::steady_clock;
+    auto t0 = clock::now();
+    FigureBuffer figures = generateFigures(opts);
+    double generated = std::chrono::duration<double>(clock::now() - t0).count();
+
+    std::ofstream file;
+    if (path != "-") {
+        file.open(path, std::ios::binary);
+        if (!file) {
+            std::cerr << "Не удалось открыть файл: " << path << "\n";
+            return 1;
+        }
+    }
+    std::ostream& out = path == "-" ? std::cout : file;
+    auto t1 = clock::now();
+    if (format == "text") {
+        writeFigures(out, figures);
+    } else {
+        writeArchive(out, figures, archive);
+    }
+    out.flush();
+    double written = std::chrono::duration<double>(clock::now() - t1).count();
+
+    double bytes = static_cast<double>(figures.apexTotal()) * 2 * sizeof(double);
+    std::cerr << "Фигур: " << figures.size() << ", генерация " << generated << " с ("
+              << bytes / generated / 1e6 << " МБ/с координат), запись " << written << " с\n";
+    return out ? 0 : 1;
+}
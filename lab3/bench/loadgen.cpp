@@ -0,0 +1,84 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "../include/server.hpp"
+
+// Генератор нагрузки для lab3_main --serve: запросы в секунду и задержки.
+// Каждый клиент отправляет пачки по depth запросов (конвейер) и ждёт ответы.
+// Запуск: loadgen <адрес> [клиентов] [запросов на клиента] [глубина конвейера]
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "Использование: loadgen unix:<путь>|tcp:<порт> [клиентов] [запросов] [глубина]\n";
+        return 1;
+    }
+    std::string address = argv[1];
+    unsigned clients = argc > 2 ? static_cast<unsigned>(std::strtoul(argv[2], nullptr, 10)) : 8;
+    size_t requests = argc > 3 ? std::strtoull(argv[3], nullptr, 10) : 20000;
+    size_t depth = argc > 4 ? std::strtoull(argv[4], nullptr, 10) : 16;
+    if (depth == 0) depth = 1;
+
+    using clock = std::chrono::steady_clock;
+    std::vector<std::vector<double>> latencies(clients);
+    std::vector<std::thread> pool;
+    auto t0 = clock::now();
+    for (unsigned c = 0; c < clients; ++c) {
+        pool.emplace_back([&, c]() {
+            int fd = connectToServer(address);
+            std::string reply;
+            char buf[65536];
+            for (size_t done = 0; done < requests; ) {
+                size_t batch = std::min(depth, requests - done);
+                // Смесь записи и чтения: добавление ромба и запрос числа фигур
+                std::string out;
+                for (size_t i = 0; i < batch; ++i) {
+                    out += (done + i) % 4 == 0 ? "add diamond 1 0 0 1 -1 0 0 -1\n" : "count\n";
+                }
+                auto sent = clock::now();
+                ::send(fd, out.data(), out.size(), MSG_NOSIGNAL);
+                size_t answered = 0;
+                while (answered < batch) {
+                    ssize_t got = ::recv(fd, buf, sizeof(buf), 0);
+                    if (got <= 0) {
+                        ::close(fd);
+                        return;
+                    }
+                    reply.append(buf, static_cast<size_t>(got));
+                    size_t pos;
+                    while ((pos = reply.find("\n.\n")) != std::string::npos || reply.rfind(".\n", 0) == 0) {
+                        size_t cut = reply.rfind(".\n", 0) == 0 ? 2 : pos + 3;
+                        reply.erase(0, cut);
+                        ++answered;
+                        latencies[c].push_back(std::chrono::duration<double, std::micro>(clock::now() - sent).count());
+                    }
+                }
+                done += batch;
+            }
+            ::close(fd);
+        });
+    }
+    for (auto& t : pool) {
+        t.join();
+    }
+    double seconds = std::chrono::duration<double>(clock::now() - t0).count();
+
+    std::vector<double> all;
+    for (const auto& l : latencies) {
+        all.insert(all.end(), l.begin(), l.end());
+    }
+    if (all.empty()) {
+        std::cerr << "Нет ответов от сервера\n";
+        return 1;
+    }
+    std::sort(all.begin(), all.end());
+    std::cout << "Клиентов: " << clients << ", глубина конвейера: " << depth << "\n"
+              << "Запросов: " << all.size() << ", в секунду: " << all.size() / seconds << "\n"
+              << "Задержка p50: " << all[all.size() / 2] << " мкс, p99: "
+              << all[std::min(all.size() - 1, all.size() * 99 / 100)] << " мкс\n";
+    return 0;
+}
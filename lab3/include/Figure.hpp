@@ -30,4 +30,11 @@ public:
 
     // Виртуальная функция клонирования для полиморфного копирования
     virtual std::unique_ptr<Figure> clone() const = 0;
+
+    // Доступ к вершинам для пакетной обработки. Наследник, который их не
+    // переопределяет, вершин не отдаёт (0 и nullptr): он работает как обычная
+    // фигура, но не попадает в буферы, журнал и преобразования
+    virtual size_t apexCount() const { return 0; }
+    virtual const std::pair<double, double>* apexData() const { return nullptr; }
+    virtual std::pair<double, double>* apexData() { return nullptr; }
 };
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+#include "Figure.hpp"
+#include "figure_buffer.hpp"
+
+// Сжатый архив коллекции фигур.
+// Координаты квантуются с шагом precision, вершины кодируются как разности
+// относительно первой вершины фигуры и упаковываются в zigzag-varint.
+// Фигуры группируются в блоки; индекс блоков в конце файла даёт произвольный доступ.
+struct ArchiveOptions {
+    double precision = 1e-6;   // шаг квантования
+    size_t blockSize = 4096;   // фигур в блоке
+};
+
+// std::invalid_argument, если координата не конечна или после квантования
+// превышает 2^62 шагов (например, 1e300 при шаге 1e-6)
+void writeArchive(std::ostream& os, const FigureBuffer& figures, const ArchiveOptions& opts = {});
+void writeArchive(std::ostream& os, const std::vector<std::unique_ptr<Figure>>& figures,
+                  const ArchiveOptions& opts = {});
+
+class ArchiveReader
+{
+    private:
+        struct Block {
+            std::uint64_t offset;
+            std::uint32_t count;
+            std::uint32_t bytes;
+        };
+        std::string data;
+        double step = 0.0;
+        std::uint64_t figures = 0;
+        std::vector<Block> blocks;
+    public:
+        // Читает архив целиком (std::runtime_error при повреждении)
+        explicit ArchiveReader(std::istream& is);
+
+        size_t figureCount() const;
+        size_t blockCount() const;
+        size_t blockFigureCount(size_t block) const;
+        double precision() const;
+
+        // Декодирование одного блока (дописывает фигуры в out)
+        void readBlock(size_t block, FigureBuffer& out) const;
+        FigureBuffer readAll() const;
+};
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <memory>
+#include <set>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "Figure.hpp"
+#include "figure_collection.hpp"
+
+// Упорядоченный по площади индекс фигур коллекции.
+// Площадь вычисляется один раз при добавлении; запросы top/bottom/range
+// выполняются за O(log n + k). Фигуры с площадью NaN (вырожденные
+// координаты) хранятся в конце порядка и в запросы не попадают
+class AreaIndex
+{
+    public:
+        using Entry = std::pair<double, const Figure*>;
+        // Строгий порядок и при NaN: NaN больше любого числа, равны между собой
+        struct Order {
+            bool operator()(const Entry& a, const Entry& b) const;
+        };
+    private:
+        std::set<Entry, Order> entries;
+        std::unordered_map<const Figure*, double> areas;
+    public:
+        // Инкрементальное обновление
+        void insert(const Figure& fig);
+        void insert(const Figure& fig, double area);   // площадь уже известна
+        bool erase(const Figure& fig);
+        void clear();
+
+        // Обновление после преобразования фигур: площадь умножается на factor
+        // без пересчёта по вершинам. moved — фигуры, скопированные при
+        // изменении (старый адрес → новый); их записи переносятся на копии
+        void rescale(double factor);
+        void rescale(double factor, const std::unordered_map<const Figure*, const Figure*>& moved);
+        void rescale(const Figure& fig, double factor);
+
+        // Перестроение по всей коллекции: площади считаются параллельно,
+        // отсортированные данные вставляются в дерево за линейное время
+        void build(const std::vector<std::unique_ptr<Figure>>& figures, unsigned threads = 0);
+        void build(const std::vector<const Figure*>& figures, unsigned threads = 0);
+        void build(const FigureCollection& figures, unsigned threads = 0);
+
+        size_t size() const;
+
+        // k наибольших (по убыванию площади) и k наименьших (по возрастанию)
+        std::vector<const Figure*> top(size_t k) const;
+        std::vector<const Figure*> bottom(size_t k) const;
+        // Фигуры с площадью из [lo, hi] по возрастанию площади
+        std::vector<const Figure*> range(double lo, double hi) const;
+};
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "figure_buffer.hpp"
+
+// Обмен коллекцией в формате Apache Arrow IPC (версия метаданных V5,
+// little-endian) без библиотеки Arrow. Схема:
+//   type:     uint8 — код вида (FigureKind: 0 многоугольник, 4 ромб, 5, 6)
+//   vertices: list<struct<x: double, y: double>>
+// Поля не допускают null. Вершины лежат в дочерних буферах x и y подряд
+// для всей записи, как в FigureBuffer, так что запись и чтение — это
+// копирование массивов координат, а не разбор текста.
+//
+// Формат файла (.arrow): "ARROW1", поток сообщений и оглавление в конце.
+// Формат потока (.arrows): только сообщения с признаком конца
+
+struct ArrowOptions {
+    bool file = true;              // false — потоковый формат
+    size_t batchSize = 65536;      // фигур в записи (RecordBatch)
+};
+
+void writeArrow(std::ostream& os, const FigureBuffer& figures, const ArrowOptions& opts = {});
+
+// Одна запись в виде указателей на её буферы. Вершины i-й фигуры —
+// элементы xs и ys с номерами от offsets[i] до offsets[i + 1]
+struct ArrowBatchView {
+    size_t length = 0;
+    const std::uint8_t* kinds = nullptr;
+    const std::int32_t* offsets = nullptr;   // length + 1 значений
+    const double* xs = nullptr;
+    const double* ys = nullptr;
+};
+
+// Чтение файла или потока Arrow (формат определяется по сигнатуре).
+// Буферы выровненных записей используются на месте — из отображённого
+// в память файла или из прочитанного целиком потока; невыровненные
+// буферы копируются. Неподдерживаемая схема, сжатие, null-значения или
+// повреждённые метаданные — std::runtime_error
+class ArrowReader
+{
+    private:
+        std::vector<std::uint64_t> storage;   // данные, прочитанные из потока
+        void* mapped = nullptr;               // или отображение файла
+        const unsigned char* data = nullptr;
+        size_t bytes = 0;
+        std::vector<ArrowBatchView> batches;
+        std::vector<std::vector<std::uint64_t>> copies;   // копии невыровненных буферов
+        size_t figures = 0;
+        bool inPlace = true;
+
+        void parse();
+    public:
+        explicit ArrowReader(std::istream& is);
+        explicit ArrowReader(const std::string& path);
+        ~ArrowReader();
+        ArrowReader(const ArrowReader&) = delete;
+        ArrowReader& operator=(const ArrowReader&) = delete;
+
+        size_t figureCount() const;
+        size_t batchCount() const;
+        const ArrowBatchView& batch(size_t i) const;
+        // true, если все буферы использованы без копирования
+        bool zeroCopy() const;
+
+        // Проверяет коды видов и число вершин и дописывает фигуры в out
+        void readBatch(size_t i, FigureBuffer& out) const;
+        FigureBuffer readAll() const;
+};
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <string>
+#include "figure_buffer.hpp"
+
+// Параллельная загрузка текстового дампа (формат text_format.hpp).
+// Вход делится на куски по границам строк, куски разбираются в отдельных
+// потоках в локальные буферы и склеиваются в исходном порядке.
+// threads == 0 — по числу ядер
+
+FigureBuffer parseFiguresParallel(const char* begin, const char* end, unsigned threads = 0);
+
+// Файл отображается в память через mmap
+FigureBuffer loadFigures(const std::string& path, unsigned threads = 0);
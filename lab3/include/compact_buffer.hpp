@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "figure_buffer.hpp"
+#include "figure_collection.hpp"
+#include "heap.hpp"
+
+// Правильный пяти- или шестиугольник в параметрах: центр и вектор от центра
+// к первой вершине (радиус описанной окружности и угол поворота). Вершины
+// идут против часовой стрелки: k-я — первая, повёрнутая на 2πk/n
+struct RegularShape {
+    double cx = 0.0;
+    double cy = 0.0;
+    double rc = 0.0;   // r·cos(phase)
+    double rs = 0.0;   // r·sin(phase)
+
+    double radius() const;
+    double phase() const;
+};
+
+// Проверка правильности: каждая вершина отстоит от вершины, восстановленной
+// по параметрам, не больше чем на tolerance·r. Только Pentagon и Hexagon,
+// обход против часовой стрелки
+bool detectRegular(FigureKind kind, const double* xs, const double* ys, double tolerance, RegularShape& out);
+
+// Вершины по параметрам, без тригонометрии
+void expandRegular(FigureKind kind, const RegularShape& shape, double* xs, double* ys);
+
+// Площадь правильной фигуры: n/2 · r² · sin(2π/n)
+double regularArea(FigureKind kind, const RegularShape& shape);
+
+// Компактное хранилище: правильные пяти- и шестиугольники, найденные при
+// добавлении, хранятся четырьмя числами вместо 10–12 координат, остальные
+// фигуры — как в FigureBuffer. Площадь и центр правильных фигур считаются
+// по формулам, вершины восстанавливаются только по запросу (вывод,
+// отсечение), с погрешностью не больше tolerance·r
+class CompactBuffer
+{
+    private:
+        double tolerance;
+        std::vector<FigureKind> kinds;
+        // Номер в shapes, если установлен старший бит (REGULAR), иначе в others
+        std::vector<std::uint32_t> refs;
+        std::vector<RegularShape> shapes;
+        FigureBuffer others;
+
+        static const std::uint32_t REGULAR = 0x80000000u;
+    public:
+        explicit CompactBuffer(double tolerance = 1e-9);
+
+        // Добавление с проверкой правильности
+        void push(FigureKind kind, const double* xs, const double* ys, size_t n);
+        void append(const FigureBuffer& figures);
+        void clear();
+
+        // Доступ
+        size_t size() const;
+        size_t regularCount() const;
+        FigureKind kind(size_t i) const;
+        size_t apexCount(size_t i) const;
+        bool isRegular(size_t i) const;
+        const RegularShape& shape(size_t i) const;   // только для isRegular(i)
+
+        // Вычисления над i-й фигурой
+        double area(size_t i) const;
+        std::pair<double, double> center(size_t i) const;
+        void areas(double* out) const;
+
+        // Вершины i-й фигуры в xs, ys (не меньше apexCount(i) элементов)
+        void vertices(size_t i, double* xs, double* ys) const;
+        std::unique_ptr<Figure> materialize(size_t i) const;
+        FigureBuffer expand() const;
+
+        ContainerMemory memoryUsage() const;
+};
+
+CompactBuffer toCompact(const FigureBuffer& figures, double tolerance = 1e-9);
+
+// Размеры данных коллекции в плоском и компактном хранении (usedBytes,
+// без запаса ёмкости), посчитанные по числу фигур, вершин и правильных
+// фигур — без построения самих буферов
+struct CompactEstimate {
+    size_t figures = 0;
+    size_t regular = 0;
+    size_t flatBytes = 0;
+    size_t compactBytes = 0;
+};
+
+CompactEstimate estimateCompact(const FigureCollection& figures, double tolerance = 1e-9);
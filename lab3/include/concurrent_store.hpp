@@ -0,0 +1,100 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <vector>
+#include "Figure.hpp"
+
+// Идентификатор фигуры в хранилище: шард и номер слота в нём
+struct FigureId {
+    std::uint32_t shard;
+    std::uint64_t slot;
+};
+
+class FigureSnapshot;
+
+// Потокобезопасная коллекция фигур.
+//  * Добавление: слоты только дописываются; писатели распределяются по шардам
+//    и блокируют только свой шард.
+//  * Удаление: слот помечается номером версии; фигура остаётся видимой
+//    снимкам, сделанным раньше.
+//  * Снимки: фиксируют версию и длины шардов, чтение не блокирует писателей.
+//  * Освобождение памяти: collect() удаляет фигуры, которые не видит ни один
+//    живой снимок (эпохи по номерам версий).
+class ConcurrentStore
+{
+    private:
+        static const size_t CHUNK = 4096;          // слотов в куске
+        static const size_t PAGE = 256;            // кусков на странице оглавления
+        static const size_t PAGES = 256;           // страниц в шарде
+        static const size_t AFFINITY_CACHE = 64;   // хранилищ в кэше шардов потока
+
+        struct Slot {
+            std::atomic<const Figure*> figure{nullptr};
+            std::atomic<std::uint64_t> removed{UINT64_MAX};
+        };
+        using Page = std::atomic<Slot*>[PAGE];
+        // Оглавление шарда двухуровневое: страницы кусков выделяются по мере
+        // роста, пустой шард занимает только массив указателей на страницы
+        struct Shard {
+            std::mutex mutex;
+            std::atomic<Page*> pages[PAGES] = {};
+            std::atomic<std::uint64_t> count{0};
+        };
+
+        std::vector<std::unique_ptr<Shard>> shards;
+        std::atomic<std::uint64_t> version{0};
+        std::atomic<std::uint32_t> nextShard{0};
+        std::uint64_t instance;   // номер хранилища, не переиспользуется
+        std::mutex removeMutex;
+        std::mutex registryMutex;
+        std::multiset<std::uint64_t> readers;      // версии живых снимков
+        std::vector<std::pair<FigureId, std::uint64_t>> retired;
+
+        Slot& slotAt(const Shard& shard, std::uint64_t slot) const;
+        // Шард, в который пишет текущий поток
+        std::uint32_t writerShard();
+
+        friend class FigureSnapshot;
+        void release(std::uint64_t snapshotVersion);
+    public:
+        explicit ConcurrentStore(unsigned shardCount = 0);
+        ~ConcurrentStore();
+        ConcurrentStore(const ConcurrentStore&) = delete;
+        ConcurrentStore& operator=(const ConcurrentStore&) = delete;
+
+        FigureId add(std::unique_ptr<Figure> fig);
+        bool remove(FigureId id);
+
+        // Неизменяемый снимок текущего состояния
+        FigureSnapshot snapshot();
+
+        // Освобождение удалённых фигур, невидимых живым снимкам; возвращает их число
+        size_t collect();
+};
+
+// Снимок хранилища. Пока снимок жив, видимые в нём фигуры не освобождаются
+class FigureSnapshot
+{
+    private:
+        ConcurrentStore* store;
+        std::uint64_t version;
+        std::vector<std::uint64_t> counts;
+
+        friend class ConcurrentStore;
+        FigureSnapshot(ConcurrentStore* owner, std::uint64_t ver, std::vector<std::uint64_t> shardCounts);
+    public:
+        FigureSnapshot(FigureSnapshot&& other) noexcept;
+        FigureSnapshot& operator=(FigureSnapshot&& other) noexcept;
+        FigureSnapshot(const FigureSnapshot&) = delete;
+        FigureSnapshot& operator=(const FigureSnapshot&) = delete;
+        ~FigureSnapshot();
+
+        void forEach(const std::function<void(FigureId, const Figure&)>& visit) const;
+        size_t size() const;
+        double totalArea() const;
+};
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "figure_buffer.hpp"
+
+// Площадь объединения фигур — покрытая площадь без двойного учёта
+// перекрытий. Внутренность фигуры определяется правилом чёт-нечет.
+//
+// Плоскость делится на квадратные ячейки порядка размера фигуры, и ячейки
+// обрабатываются параллельно. Ячейка, через которую проходит много рёбер
+// нескольких фигур, рекурсивно делится на четыре части; фигура без рёбер в
+// части либо покрывает её целиком, либо отбрасывается. В листьях ось x
+// делится на полосы по абсциссам вершин, точек пересечения рёбер и
+// пересечений рёбер со сторонами листа: в полосе рёбра не пересекаются,
+// покрытая длина сечения линейна по x, и площадь полосы точно равна
+// ширине, умноженной на длину сечения посередине. Одиночная фигура без
+// самопересечений, целиком лежащая в листе, считается по формуле Гаусса.
+// Лист с e рёбрами обходится за O(e^2 log e), и e ограничено, пока рёбра не
+// сходятся в одну точку, поэтому время растёт примерно как число листьев —
+// линейно по n плюс число точек пересечения k (для пучка рёбер через одну
+// точку — до O(e^3) в листе наибольшей глубины). Результат не зависит от
+// числа потоков
+double unionArea(const FigureBuffer& figures, unsigned threads = 0);
@@ -12,7 +12,7 @@ class Diamond : public Figure
         // Конструкторы
         Diamond();
         Diamond(const std::array<std::pair<double, double>, 4>& apxs);
-        Diamond(const Diamond& other);
+        Diamond(const Diamond& other) noexcept;
         // Геттеры
         std::array<std::pair<double, double>, 4> &get_apexes();
         void set_apexes(const std::array<std::pair<double, double>, 4>& apxs);
@@ -36,4 +36,9 @@ class Diamond : public Figure
 
         // Клонирование
         std::unique_ptr<Figure> clone() const override;
+
+        // Вершины
+        size_t apexCount() const override;
+        const std::pair<double, double>* apexData() const override;
+        std::pair<double, double>* apexData() override;
 };
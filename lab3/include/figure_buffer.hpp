@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "Figure.hpp"
+#include "figure_collection.hpp"
+
+// Вид фигуры; для фиксированных видов значение совпадает с числом вершин,
+// у многоугольника (Polygon) число вершин хранится отдельно
+enum class FigureKind : std::uint8_t {
+    Polygon = 0,
+    Diamond = 4,
+    Pentagon = 5,
+    Hexagon = 6
+};
+
+// Число вершин вида; 0 для Polygon
+size_t kindApexCount(FigureKind kind);
+// Номер вида 0..3 для массивов по видам: ромб, пятиугольник, шестиугольник, многоугольник
+size_t kindSlot(FigureKind kind);
+const char* kindName(FigureKind kind);
+bool parseKind(const std::string& name, FigureKind& kind);
+bool isValidKind(std::uint8_t code);
+
+// Определение вида фигуры; классы, не известные библиотеке, считаются
+// многоугольниками из своих вершин
+FigureKind kindOf(const Figure& fig);
+
+// Вершины фигуры для пакетной обработки; std::invalid_argument, если
+// фигура их не отдаёт (apexCount() == 0)
+const std::pair<double, double>* requireApexes(const Figure& fig);
+
+// Фабрика: фигура заданного вида из массивов координат.
+// Варианты без n — для видов с фиксированным числом вершин
+std::unique_ptr<Figure> makeFigure(FigureKind kind, const double* xs, const double* ys, size_t n);
+std::unique_ptr<Figure> makeFigure(FigureKind kind, const double* xs, const double* ys);
+
+// Площадь и центр по n вершинам, те же формулы, что и в классах фигур
+double apexArea(FigureKind kind, const double* xs, const double* ys, size_t n);
+std::pair<double, double> apexCenter(FigureKind kind, const double* xs, const double* ys, size_t n);
+double apexArea(FigureKind kind, const double* xs, const double* ys);
+std::pair<double, double> apexCenter(FigureKind kind, const double* xs, const double* ys);
+
+// Центр масс многоугольника (взвешенный по площади), в отличие от apexCenter —
+// среднего вершин; у вырожденной фигуры нулевой площади — среднее вершин
+std::pair<double, double> apexCentroid(FigureKind kind, const double* xs, const double* ys, size_t n);
+
+// Плоское хранилище фигур: координаты x и y лежат в отдельных массивах,
+// начало вершин i-й фигуры задаётся массивом смещений (как в CSR)
+class FigureBuffer
+{
+    private:
+        std::vector<FigureKind> kinds;
+        std::vector<size_t> offsets{0};
+        std::vector<double> xcoords;
+        std::vector<double> ycoords;
+    public:
+        // Добавление
+        void push(FigureKind kind, const double* xs, const double* ys, size_t n);
+        void push(FigureKind kind, const double* xs, const double* ys);
+        void push(const Figure& fig);
+        void append(const FigureBuffer& other);
+        void reserve(size_t figures, size_t apexes);
+        void clear();
+
+        // Доступ
+        size_t size() const;
+        bool empty() const;
+        size_t apexTotal() const;
+        FigureKind kind(size_t i) const;
+        size_t apexCount(size_t i) const;
+        const double* xs(size_t i) const;
+        const double* ys(size_t i) const;
+        double* xs(size_t i);
+        double* ys(size_t i);
+
+        // Вычисления над i-й фигурой
+        double area(size_t i) const;
+        std::pair<double, double> center(size_t i) const;
+        std::pair<double, double> centroid(size_t i) const;
+
+        // Обратное преобразование в объекты Figure
+        std::unique_ptr<Figure> materialize(size_t i) const;
+        std::vector<std::unique_ptr<Figure>> materializeAll() const;
+
+        // Память массивов буфера
+        ContainerMemory memoryUsage() const;
+};
+
+// Площади всех фигур буфера в out. Фигуры группируются по виду и числу
+// вершин; внутри группы координаты перекладываются по номеру вершины, и
+// площадь считается циклом по фигурам группы, который векторизуется.
+// Результат совпадает с area(i) бит в бит
+void batchAreas(const FigureBuffer& figures, double* out);
+
+// Площади и центры масс всех фигур за один проход по вершинам: у каждой
+// фигуры слагаемые площади и моменты считаются в одном цикле по рёбрам,
+// развёрнутом для фиксированных видов. Фигуры идут подряд, без
+// группировки и перекладки по видам, как в batchAreas: моментов
+// больше, и перекладка уже не окупается. Результаты совпадают с area(i) и
+// centroid(i) бит в бит
+void batchAreaCentroids(const FigureBuffer& figures, double* areas, double* cx, double* cy);
+
+FigureBuffer toBuffer(const std::vector<std::unique_ptr<Figure>>& figures);
+FigureBuffer toBuffer(const FigureCollection& figures);
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <unordered_set>
+#include <vector>
+#include "Figure.hpp"
+#include "heap.hpp"
+
+// Различие двух состояний коллекции по идентичности фигур
+struct CollectionDiff {
+    size_t removed = 0;   // есть только в исходном состоянии (удалены или изменены)
+    size_t added = 0;     // есть только в новом состоянии (добавлены или изменены)
+};
+
+// Коллекция фигур с копированием при записи.
+// Фигуры лежат кусками до CHUNK фигур; оглавление, куски и сами фигуры
+// разделяются между копиями коллекции по счётчику ссылок. Копия (снимок)
+// стоит O(1); изменение копирует оглавление (O(n / CHUNK) указателей),
+// затронутый кусок и, при изменении вершин, саму фигуру.
+// Копии не потокобезопасны: коллекция и её снимки живут в одном потоке
+class FigureCollection
+{
+    private:
+        static const size_t CHUNK = 64;
+
+        using Chunk = std::vector<std::shared_ptr<Figure>>;
+        struct Spine {
+            std::vector<std::shared_ptr<Chunk>> chunks;
+            std::vector<size_t> ends;   // число фигур в кусках 0..i
+        };
+
+        std::shared_ptr<Spine> spine;
+
+        Spine& ownSpine();
+        Chunk& ownChunk(size_t chunk);
+        void locate(size_t i, size_t& chunk, size_t& pos) const;
+    public:
+        FigureCollection();
+
+        size_t size() const;
+        bool empty() const;
+        const Figure& operator[](size_t i) const;
+
+        // Доступ на запись: разделяемые кусок и фигура сначала копируются,
+        // поэтому адрес фигуры может измениться
+        Figure& mutate(size_t i);
+
+        const Figure& push_back(std::unique_ptr<Figure> fig);
+        void assign(size_t i, std::unique_ptr<Figure> fig);
+        void erase(size_t i);
+        void clear();
+
+        // Обход фигур по порядку: f(const Figure&)
+        template <typename F>
+        void forEach(F f) const {
+            for (const auto& chunk : spine->chunks) {
+                for (const auto& fig : *chunk) {
+                    f(*fig);
+                }
+            }
+        }
+
+        // Память самой коллекции без фигур: оглавление, куски и управляющие
+        // блоки указателей. Части, общие со снимками, учитываются полностью
+        ContainerMemory memoryUsage() const;
+        // То же для нескольких версий коллекции: оглавление, куски и фигуры,
+        // адреса которых уже есть в seen, пропускаются, новые добавляются;
+        // onFigure вызывается для каждой ещё не учтённой фигуры
+        ContainerMemory memoryUsage(std::unordered_set<const void*>& seen,
+                                    const std::function<void(const Figure&)>& onFigure) const;
+
+        // Сравнение с другим состоянием; общие куски пропускаются целиком,
+        // так что фигуры просматриваются только в изменённых кусках
+        CollectionDiff diff(const FigureCollection& before) const;
+};
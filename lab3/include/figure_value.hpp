@@ -0,0 +1,143 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include "Figure.hpp"
+#include "hexagon.hpp"
+
+// Фигура как значение. Объект хранится во встроенном буфере, которого
+// хватает на Hexagon: копирование и перемещение не обращаются к куче, а
+// std::vector<FigureValue> хранит фигуры подряд без отдельных выделений.
+// Операции вызываются через собственную таблицу функций, одну на тип;
+// площадь и центр вызываются напрямую, без виртуального вызова.
+// Подходит любой наследник Figure; типы, которые не помещаются в буфер
+// или могут бросить исключение при перемещении, хранятся в куче
+class FigureValue
+{
+    public:
+        static const size_t INLINE_SIZE = sizeof(Hexagon);
+        static const size_t INLINE_ALIGN = alignof(std::max_align_t);
+
+        template <typename T>
+        static constexpr bool fitsInline = sizeof(T) <= INLINE_SIZE && alignof(T) <= INLINE_ALIGN &&
+                                           std::is_nothrow_move_constructible<T>::value;
+    private:
+        struct Ops {
+            void (*copy)(const FigureValue& from, FigureValue& to);
+            void (*move)(FigureValue& from, FigureValue& to) noexcept;   // from становится пустым
+            void (*destroy)(FigureValue& value) noexcept;
+            Figure* (*figure)(const FigureValue& value);
+            double (*area)(const FigureValue& value);
+            std::pair<double, double> (*center)(const FigureValue& value);
+            bool inlined;
+        };
+
+        // Объект типа T прямо в буфере
+        template <typename T>
+        struct InlineOps {
+            static T* object(const FigureValue& value) {
+                return std::launder(reinterpret_cast<T*>(const_cast<unsigned char*>(value.storage)));
+            }
+            static void copy(const FigureValue& from, FigureValue& to) {
+                ::new (static_cast<void*>(to.storage)) T(*object(from));
+                to.ops = &table;
+            }
+            static void move(FigureValue& from, FigureValue& to) noexcept {
+                ::new (static_cast<void*>(to.storage)) T(std::move(*object(from)));
+                to.ops = &table;
+                destroy(from);
+            }
+            static void destroy(FigureValue& value) noexcept {
+                object(value)->~T();
+                value.ops = nullptr;
+            }
+            static Figure* figure(const FigureValue& value) {
+                return object(value);
+            }
+            static double area(const FigureValue& value) {
+                return object(value)->T::calculateArea();
+            }
+            static std::pair<double, double> center(const FigureValue& value) {
+                return object(value)->T::getCenter();
+            }
+            static constexpr Ops table = {&copy, &move, &destroy, &figure, &area, &center, true};
+        };
+
+        // В буфере лежит указатель на объект в куче; копия через clone()
+        static const Ops heapOps;
+
+        alignas(INLINE_ALIGN) unsigned char storage[INLINE_SIZE];
+        const Ops* ops = nullptr;
+
+        void adoptHeap(Figure* fig) noexcept;
+    public:
+        FigureValue() = default;
+
+        template <typename T, typename D = std::decay_t<T>,
+                  typename = std::enable_if_t<std::is_base_of<Figure, D>::value>>
+        FigureValue(T&& fig) {
+            emplace<D>(std::forward<T>(fig));
+        }
+
+        // Копия фигуры произвольного динамического типа: известные виды
+        // хранятся в буфере, остальные клонируются в кучу
+        static FigureValue copyOf(const Figure& fig);
+        static FigureValue adopt(std::unique_ptr<Figure> fig);
+
+        FigureValue(const FigureValue& other) {
+            if (other.ops) other.ops->copy(other, *this);
+        }
+        FigureValue(FigureValue&& other) noexcept {
+            if (other.ops) other.ops->move(other, *this);
+        }
+        FigureValue& operator=(const FigureValue& other) {
+            if (this != &other) {
+                FigureValue copy(other);
+                *this = std::move(copy);
+            }
+            return *this;
+        }
+        FigureValue& operator=(FigureValue&& other) noexcept {
+            if (this != &other) {
+                reset();
+                if (other.ops) other.ops->move(other, *this);
+            }
+            return *this;
+        }
+        ~FigureValue() {
+            reset();
+        }
+
+        template <typename T, typename... Args>
+        T& emplace(Args&&... args) {
+            static_assert(std::is_base_of<Figure, T>::value, "FigureValue holds Figure subclasses");
+            reset();
+            if constexpr (fitsInline<T>) {
+                T* obj = ::new (static_cast<void*>(storage)) T(std::forward<Args>(args)...);
+                ops = &InlineOps<T>::table;
+                return *obj;
+            } else {
+                T* obj = new T(std::forward<Args>(args)...);
+                adoptHeap(obj);
+                return *obj;
+            }
+        }
+
+        void reset() noexcept {
+            if (ops) ops->destroy(*this);
+        }
+
+        bool empty() const { return ops == nullptr; }
+        bool isInline() const { return ops && ops->inlined; }
+
+        // Для пустого значения поведение не определено
+        double area() const { return ops->area(*this); }
+        std::pair<double, double> center() const { return ops->center(*this); }
+        const Figure& get() const { return *ops->figure(*this); }
+        Figure& get() { return *ops->figure(*this); }
+        const Figure* operator->() const { return ops->figure(*this); }
+        Figure* operator->() { return ops->figure(*this); }
+};
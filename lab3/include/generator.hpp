@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include "figure_buffer.hpp"
+
+// Размещение центров фигур
+enum class Layout {
+    Uniform,     // равномерно в квадрате [-world, world]²
+    Clustered    // нормально вокруг clusters случайных центров
+};
+
+// Закон распределения размеров (радиус описанной окружности)
+enum class SizeLaw {
+    Uniform,     // равномерно в [minSize, maxSize]
+    Zipf         // степенной: размер maxSize / r, r ~ r^-zipf на [1, maxSize / minSize]
+};
+
+// Параметры синтетической нагрузки. Веса видов задают доли в смеси
+// (нормируются по сумме, нулевой вес исключает вид)
+struct GeneratorOptions {
+    size_t count = 1000;
+    std::uint64_t seed = 1;
+
+    double diamonds = 1.0;
+    double pentagons = 1.0;            // правильные
+    double irregularPentagons = 1.0;   // выпуклые неправильные
+    double hexagons = 1.0;
+    double irregularHexagons = 1.0;
+
+    Layout layout = Layout::Uniform;
+    double world = 1000.0;
+    size_t clusters = 16;
+    double spread = 0.05;              // СКО кластера в долях world
+
+    SizeLaw sizes = SizeLaw::Uniform;
+    double minSize = 1.0;
+    double maxSize = 10.0;
+    double zipf = 1.0;
+
+    unsigned threads = 0;
+};
+
+// Параметр в виде key=value, как в командах generate и утилиты figgen:
+//   seed, layout=uniform|clustered, world, clusters, spread,
+//   sizes=uniform|zipf, min, max, zipf, threads,
+//   mix=diamond:2,pentagon:1,irregular-pentagon:1,hexagon:0,irregular-hexagon:1
+// (виды, не названные в mix, получают вес 0).
+// std::invalid_argument для неизвестного ключа или неверного значения
+void setGeneratorOption(GeneratorOptions& opts, const std::string& option);
+
+// Генерация opts.count корректных выпуклых фигур. Фигуры делятся на блоки
+// фиксированного размера; у каждого блока свой поток случайных чисел,
+// получаемый из seed и номера блока, и блоки заполняются параллельно.
+// Результат зависит только от параметров, но не от числа потоков
+FigureBuffer generateFigures(const GeneratorOptions& opts);
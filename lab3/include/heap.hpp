@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstddef>
+
+// Учёт кучи. Объектная библиотека heap_hooks (src/heap_hooks.cpp)
+// заменяет глобальные operator new/delete: каждое выделение учитывается
+// размером блока, который реально занят в распределителе (полезный размер
+// malloc_usable_size плюс заголовок), так что выравнивание и служебные
+// байты распределителя входят в счёт. Без heap_hooks счётчики остаются
+// нулевыми, а blockSize по-прежнему работает
+struct HeapStats {
+    size_t liveBytes = 0;     // занято блоками сейчас
+    size_t liveBlocks = 0;
+    size_t peakBytes = 0;     // максимум liveBytes с запуска или с resetHeapPeak
+    size_t allocations = 0;   // всего выделений с запуска
+};
+
+HeapStats heapStats();
+void resetHeapPeak();
+
+// Байт кучи, занятых блоком, выделенным через new (0 для nullptr).
+// p должен указывать на начало блока
+size_t blockSize(const void* p);
+
+// Выделено минус освобождено текущим потоком с его запуска
+long long threadHeapBytes();
+
+// Подключён ли heap_hooks (прошло ли хоть одно выделение через учёт)
+bool heapTracking();
+
+// Учёт блока, выделенного malloc, и освобождение учтённого блока;
+// вызываются из замещённых операторов heap_hooks
+void* heapTrack(void* p);
+void heapRelease(void* p);
+
+// Сколько байт кучи осталось занятыми после вызова f() в текущем потоке
+// (выделенное и освобождённое внутри f не считается)
+template <typename F>
+long long heapDelta(F f) {
+    long long before = threadHeapBytes();
+    f();
+    return threadHeapBytes() - before;
+}
+
+// Память контейнера: блоки кучи целиком, ёмкость и заполненная часть
+// массивов элементов
+struct ContainerMemory {
+    size_t heapBytes = 0;
+    size_t capacityBytes = 0;
+    size_t usedBytes = 0;
+
+    // Буфер вектора v
+    template <typename V>
+    void addBuffer(const V& v) {
+        heapBytes += blockSize(v.data());
+        capacityBytes += v.capacity() * sizeof(typename V::value_type);
+        usedBytes += v.size() * sizeof(typename V::value_type);
+    }
+
+    void add(const ContainerMemory& other) {
+        heapBytes += other.heapBytes;
+        capacityBytes += other.capacityBytes;
+        usedBytes += other.usedBytes;
+    }
+};
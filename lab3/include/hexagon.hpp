@@ -12,7 +12,7 @@ class Hexagon : public Figure
         // Конструкторы
         Hexagon();
         Hexagon(const std::array<std::pair<double, double>, 6>& apxs);
-        Hexagon(const Hexagon& other);
+        Hexagon(const Hexagon& other) noexcept;
         // Геттеры
         std::array<std::pair<double, double>, 6> get_apexes();
         void set_apexes(const std::array<std::pair<double, double>, 6>& apxs);
@@ -36,4 +36,9 @@ class Hexagon : public Figure
 
         // Клонирование
         std::unique_ptr<Figure> clone() const override;
+
+        // Вершины
+        size_t apexCount() const override;
+        const std::pair<double, double>* apexData() const override;
+        std::pair<double, double>* apexData() override;
 };
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <memory>
+#include <utility>
+#include <vector>
+#include "Figure.hpp"
+#include "figure_buffer.hpp"
+
+// Ограничивающий прямоугольник со сторонами, параллельными осям
+struct Extent {
+    double minX = 0.0;
+    double minY = 0.0;
+    double maxX = 0.0;
+    double maxY = 0.0;
+    bool empty = true;
+
+    void add(double x, double y);
+    void add(const Figure& fig);
+    void merge(const Extent& other);
+    double width() const;
+    double height() const;
+};
+
+Extent extentOf(const FigureBuffer& figures, unsigned threads = 0);
+Extent extentOf(const std::vector<std::unique_ptr<Figure>>& figures, unsigned threads = 0);
+
+// Выпуклая оболочка (алгоритм Эндрю); вершины против часовой стрелки
+// без повторов и точек на сторонах
+std::vector<std::pair<double, double>> convexHull(std::vector<std::pair<double, double>> points);
+
+// Оболочка всех вершин коллекции: части обрабатываются параллельно
+// (с отсечением точек внутри восьмиугольника крайних точек), затем
+// оболочки частей объединяются
+std::vector<std::pair<double, double>> collectionHull(const FigureBuffer& figures, unsigned threads = 0);
+std::vector<std::pair<double, double>> collectionHull(const std::vector<std::unique_ptr<Figure>>& figures,
+                                                      unsigned threads = 0);
+
+// Площадь многоугольника по формуле Гаусса
+double polygonArea(const std::vector<std::pair<double, double>>& polygon);
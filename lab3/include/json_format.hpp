@@ -0,0 +1,43 @@
+#pragma once
+
+#include <iostream>
+#include <string>
+#include "figure_buffer.hpp"
+
+// JSON-формат коллекции — массив объектов
+//   [{"type": "diamond", "vertices": [[x1, y1], [x2, y2], ...]}, ...]
+// type — имя вида, как в команде add; число вершин должно соответствовать
+// виду (у polygon — не меньше 3). Остальные ключи объекта пропускаются.
+// Ошибки разбора — std::runtime_error с номером строки и столбца (в байтах)
+
+// Разбор документа целиком; фигуры дописываются в out
+size_t parseJson(const char* begin, const char* end, FigureBuffer& out);
+
+// Запись: одна фигура на строку, числа в кратчайшей точной записи.
+// Бесконечные и нечисловые координаты в JSON непредставимы — std::runtime_error
+void writeJson(std::ostream& os, const FigureBuffer& figures);
+
+// Потоковое чтение: документ читается кусками, в памяти держится только
+// текущий кусок и недочитанный хвост последней фигуры
+class JsonReader
+{
+    private:
+        std::istream& is;
+        size_t chunkBytes;
+        std::string buffer;
+        size_t pos = 0;
+        // Где остановился разбор: 0 — до '[', 1 — перед первой фигурой,
+        // 2 — после фигуры, 3 — после ']'
+        int stage = 0;
+        // Позиция начала buffer в документе — для сообщений об ошибках
+        size_t line = 1;
+        size_t column = 1;
+    public:
+        JsonReader(std::istream& input, size_t chunk = 1 << 20);
+
+        // Читает следующий кусок и дописывает в out все фигуры, закончившиеся
+        // в нём. false — документ дочитан до конца
+        bool next(FigureBuffer& out);
+};
+
+FigureBuffer readJson(std::istream& is);
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+#include "figure_buffer.hpp"
+
+// Точка дерева: координаты и номер (обычно — номер фигуры в коллекции)
+struct KdPoint {
+    double x = 0.0;
+    double y = 0.0;
+    size_t id = 0;
+};
+
+// Результат поиска ближайших: номер точки и расстояние до запроса
+struct Neighbor {
+    size_t id = 0;
+    double distance = 0.0;
+};
+
+// Статическое k-d дерево на плоскости. Узлы не хранятся отдельно: точки
+// переставлены так, что медиана диапазона [lo, hi) лежит в середине,
+// левее — точки с меньшей координатой по оси разбиения, правее — с большей.
+// Ось узла выбирается по наибольшему разбросу. Верхние уровни строятся
+// параллельно
+class KdTree
+{
+    private:
+        friend class IncrementalKdTree;
+
+        std::vector<KdPoint> points;
+        std::vector<unsigned char> axes;   // ось узла с медианой в позиции i
+
+        void buildRange(size_t lo, size_t hi, unsigned depth);
+        // Поиск с общей для нескольких деревьев кучей из k лучших
+        void nearestInto(double x, double y, size_t k, std::vector<Neighbor>& heap) const;
+        void withinInto(double x, double y, double radius, std::vector<size_t>& out) const;
+    public:
+        KdTree() = default;
+        explicit KdTree(std::vector<KdPoint> pts, unsigned threads = 0);
+
+        void build(std::vector<KdPoint> pts, unsigned threads = 0);
+        // Центры фигур буфера; id — номер фигуры
+        void build(const FigureBuffer& figures, unsigned threads = 0);
+        void clear();
+
+        size_t size() const;
+        bool empty() const;
+
+        // k ближайших точек по возрастанию расстояния (при равенстве — по id)
+        std::vector<Neighbor> nearest(double x, double y, size_t k) const;
+        // Номера точек на расстоянии не больше radius, по возрастанию
+        std::vector<size_t> within(double x, double y, double radius) const;
+        // Все пары (a, b), a < b, с расстоянием не больше radius, по возрастанию
+        std::vector<std::pair<size_t, size_t>> pairsWithin(double radius, unsigned threads = 0) const;
+
+        // Пакетные запросы: результаты в порядке запросов, запросы делятся между потоками
+        std::vector<std::vector<Neighbor>> nearestBatch(const std::vector<std::pair<double, double>>& queries,
+                                                        size_t k, unsigned threads = 0) const;
+        std::vector<std::vector<size_t>> withinBatch(const std::vector<std::pair<double, double>>& queries,
+                                                     double radius, unsigned threads = 0) const;
+};
+
+// Дерево с добавлением точек (логарифмический метод): новые точки копятся
+// в небольшом буфере, заполненный буфер сливается со статическими деревьями
+// размеров BUFFER * 2^i, как при сложении двоичных чисел. Добавление стоит
+// O(log^2 n) амортизированно, запрос обходит O(log n) деревьев.
+// Удаление не поддерживается: после удалений дерево строится заново
+class IncrementalKdTree
+{
+    private:
+        static const size_t BUFFER = 64;
+
+        std::vector<KdTree> levels;   // levels[i] пусто или содержит BUFFER * 2^i точек
+        std::vector<KdPoint> buffer;
+        size_t count = 0;
+    public:
+        void insert(double x, double y, size_t id);
+        void clear();
+
+        size_t size() const;
+
+        std::vector<Neighbor> nearest(double x, double y, size_t k) const;
+        std::vector<size_t> within(double x, double y, double radius) const;
+};
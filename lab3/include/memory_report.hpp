@@ -0,0 +1,44 @@
+#pragma once
+
+#include <array>
+#include <memory>
+#include <vector>
+#include "Figure.hpp"
+#include "figure_buffer.hpp"
+#include "figure_collection.hpp"
+#include "heap.hpp"
+
+// Память фигур одного вида
+struct KindMemory {
+    size_t count = 0;
+    size_t heapBytes = 0;     // блоки объектов и их массивов вершин с заголовками распределителя
+    size_t objectBytes = 0;   // sizeof объектов, включая указатель на таблицу виртуальных функций
+    size_t vertexBytes = 0;   // сами координаты: 16 байт на вершину
+};
+
+// Разбивка занятой памяти по видам фигур и контейнеру. Размеры блоков
+// берутся у распределителя (см. heap.hpp), поэтому для вектора указателей
+// и плоского буфера отчёт совпадает с приростом кучи байт в байт. У
+// FigureCollection управляющие блоки shared_ptr снаружи не видны и
+// считаются по размеру, измеренному один раз; распределитель иногда
+// отдаёт под них блок на 16 байт больше
+struct MemoryReport {
+    std::array<KindMemory, 4> kinds;   // ромбы, пятиугольники, шестиугольники, многоугольники
+    ContainerMemory container;
+
+    const KindMemory& operator[](FigureKind kind) const;
+    size_t count() const;
+    size_t heapBytes() const;     // фигуры и контейнер
+    size_t vertexBytes() const;
+    size_t overheadBytes() const; // всё, кроме координат
+};
+
+MemoryReport measureMemory(const FigureCollection& figures);
+MemoryReport measureMemory(const std::vector<std::unique_ptr<Figure>>& figures);
+MemoryReport measureMemory(const FigureBuffer& figures);
+
+// Память других версий коллекции (история undo, снимки) сверх неё самой:
+// оглавления, куски и фигуры, общие с figures или с уже учтённой версией,
+// второй раз не считаются
+MemoryReport measureVersions(const FigureCollection& figures,
+                             const std::vector<const FigureCollection*>& versions);
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <exception>
+#include <thread>
+#include <vector>
+
+// Число потоков по умолчанию (0 — по числу ядер)
+inline unsigned resolveThreads(unsigned threads) {
+    if (threads == 0) {
+        threads = std::thread::hardware_concurrency();
+    }
+    return std::max(1u, threads);
+}
+
+// Делит диапазон [0, n) на непрерывные части и вызывает
+// body(begin, end, part) для каждой части в отдельном потоке.
+// Мелкие диапазоны (меньше minPerThread на поток) обрабатываются меньшим числом потоков.
+// Возвращает число частей; исключение первой упавшей части пробрасывается
+template <typename Body>
+size_t parallelFor(size_t n, unsigned threads, Body body, size_t minPerThread = 4096) {
+    size_t parts = std::min<size_t>(resolveThreads(threads), std::max<size_t>(1, n / std::max<size_t>(1, minPerThread)));
+    std::vector<std::exception_ptr> errors(parts);
+    auto run = [&](size_t part) {
+        try {
+            body(n * part / parts, n * (part + 1) / parts, part);
+        } catch (...) {
+            errors[part] = std::current_exception();
+        }
+    };
+    std::vector<std::thread> pool;
+    for (size_t part = 1; part < parts; ++part) {
+        pool.emplace_back(run, part);
+    }
+    run(0);
+    for (auto& t : pool) {
+        t.join();
+    }
+    for (auto& e : errors) {
+        if (e) std::rethrow_exception(e);
+    }
+    return parts;
+}
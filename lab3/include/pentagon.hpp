@@ -12,7 +12,7 @@ class Pentagon : public Figure
         // Конструкторы
         Pentagon();
         Pentagon(const std::array<std::pair<double, double>, 5>& apxs);
-        Pentagon(const Pentagon& other);
+        Pentagon(const Pentagon& other) noexcept;
         // Геттеры
         std::array<std::pair<double, double>, 5> get_apexes();
         void set_apexes(const std::array<std::pair<double, double>, 5>& apxs);
@@ -36,4 +36,9 @@ class Pentagon : public Figure
 
         // Клонирование
         std::unique_ptr<Figure> clone() const override;
+
+        // Вершины
+        size_t apexCount() const override;
+        const std::pair<double, double>* apexData() const override;
+        std::pair<double, double>* apexData() override;
 };
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <vector>
+#include "figure_buffer.hpp"
+#include "validation.hpp"
+
+// Пакет фигур, проходящий через стадии конвейера загрузки
+struct IngestBatch {
+    FigureBuffer figures;
+    std::vector<std::uint32_t> errors;                 // заполняет стадия проверки
+    std::vector<double> areas;                         // заполняет стадия вычислений
+};
+
+struct PipelineOptions {
+    size_t chunkBytes = 1 << 20;   // размер куска входа на пакет
+    size_t queueDepth = 4;         // пакетов в очереди между стадиями
+    bool validate = true;
+    ValidationOptions validation;
+};
+
+// Счётчики стадии: busy — время работы, wait — время ожидания соседей
+struct StageMetrics {
+    const char* name = "";
+    size_t batches = 0;
+    size_t figures = 0;
+    double busySeconds = 0.0;
+    double waitSeconds = 0.0;
+
+    double throughput() const;   // фигур в секунду работы
+};
+
+struct PipelineMetrics {
+    std::array<StageMetrics, 4> stages;   // parse, validate, compute, emit
+    double seconds = 0.0;
+};
+
+// Конвейер: разбор -> проверка -> площади и центры -> выдача.
+// Первые три стадии работают в отдельных потоках и связаны очередями
+// SpscQueue; sink вызывается в вызывающем потоке для каждого пакета по порядку.
+// Исключение любой стадии останавливает конвейер и пробрасывается наружу
+PipelineMetrics runIngestPipeline(std::istream& is, const std::function<void(IngestBatch&)>& sink,
+                                  const PipelineOptions& opts = {});
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <iostream>
+#include <utility>
+#include <vector>
+#include "Figure.hpp"
+
+// Многоугольник с произвольным числом вершин (не меньше трёх)
+class Polygon : public Figure
+{
+    private:
+        std::vector<std::pair<double, double>> apexes;
+    public:
+        // Наибольшее число вершин, принимаемое при вводе: число приходит
+        // извне (оболочка, сервер) и не должно определять размер выделения
+        static const size_t MAX_APEXES = 1 << 20;
+
+        // Конструкторы
+        Polygon();
+        Polygon(const std::vector<std::pair<double, double>>& apxs);
+        Polygon(const Polygon& other);
+        // Геттеры
+        std::vector<std::pair<double, double>> get_apexes() const;
+        void set_apexes(const std::vector<std::pair<double, double>>& apxs);
+
+        // 1. Центр
+        std::pair<double, double> getCenter() const override;
+
+        // 2. Вывод
+        void print(std::ostream& os) const override;
+
+        // 3. Ввод: число вершин, затем координаты
+        void read(std::istream& is) override;
+
+        // 4. Площадь
+        double calculateArea() const override;
+        operator double() const override;
+
+        // Операторы
+        Figure& operator=(const Figure& other) override;
+        Figure& operator=(Figure&& other) noexcept override;
+        bool operator==(const Figure& other) const override;
+
+        // Клонирование
+        std::unique_ptr<Figure> clone() const override;
+
+        // Вершины
+        size_t apexCount() const override;
+        const std::pair<double, double>* apexData() const override;
+        std::pair<double, double>* apexData() override;
+};
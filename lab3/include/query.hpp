@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+#include "area_index.hpp"
+#include "figure_buffer.hpp"
+#include "figure_collection.hpp"
+
+// Язык запросов к коллекции:
+//   select <столбцы> [where <условие>] [limit <n>]
+// Столбцы — поля фигуры или агрегаты, но не вперемешку:
+//   поля:     index, type, area, center.x, center.y, bbox.minx, bbox.miny,
+//             bbox.maxx, bbox.maxy, vertices; center и bbox — группы полей,
+//             * — index, type, area, center
+//   агрегаты: count, count(*), sum(поле), avg(поле), min(поле), max(поле)
+// Условие — сравнения поля с числом (=, !=, <, <=, >, >=),
+//   <поле> between a and b, <поле> in (a, b, ...), соединённые and, or,
+//   not и скобками. Поле type сравнивается с именами видов: type = hexagon
+
+// Поле фигуры; значение type — код FigureKind
+enum class QueryField : std::uint8_t {
+    Index,
+    Type,
+    Area,
+    CenterX,
+    CenterY,
+    MinX,
+    MinY,
+    MaxX,
+    MaxY,
+    Vertices
+};
+
+enum class Aggregate : std::uint8_t {
+    None,
+    Count,
+    Sum,
+    Avg,
+    Min,
+    Max
+};
+
+struct QueryColumn {
+    Aggregate aggregate = Aggregate::None;
+    QueryField field = QueryField::Index;
+    std::string name;
+};
+
+// Узел условия: логическая связка над children или сравнение поля со значениями
+struct Condition {
+    enum class Op { And, Or, Not, Less, LessEqual, Greater, GreaterEqual, Equal, NotEqual, Between, In };
+
+    Op op = Op::And;
+    QueryField field = QueryField::Index;
+    std::vector<double> values;
+    std::vector<Condition> children;
+};
+
+struct Query {
+    std::vector<QueryColumn> columns;
+    bool aggregate = false;
+    bool filtered = false;
+    Condition where;
+    size_t limit = std::numeric_limits<size_t>::max();
+};
+
+// Разбор запроса (std::invalid_argument с позицией ошибки)
+Query parseQuery(const std::string& text);
+
+// Результат: имена столбцов и строки значений (у агрегатов — одна строка;
+// avg, min и max пустого набора — NaN). plan описывает выполнение
+struct QueryResult {
+    std::vector<std::string> columns;
+    std::vector<QueryField> fields;          // поле каждого столбца (для вывода type)
+    std::vector<std::vector<double>> rows;
+    size_t scanned = 0;                      // фигур, прошедших предварительные фильтры
+    std::string plan;
+};
+
+// Один проход по буферу блоками фиксированного размера: в блоке собираются
+// фигуры, прошедшие фильтр по виду, для них один раз вычисляются нужные
+// поля, условие вычисляется по столбцам блока, а строки и агрегаты
+// берутся из тех же столбцов. Блоки обрабатываются параллельно; частичные
+// агрегаты блоков складываются по порядку, так что результат не зависит
+// от числа потоков. ids — номера фигур буфера в коллекции (пусто — по порядку)
+QueryResult runQuery(const Query& query, const FigureBuffer& figures, unsigned threads = 0,
+                     const std::vector<size_t>& ids = {});
+
+// Запрос к коллекции. Ограничения площади из условий верхнего уровня,
+// соединённых and, передаются индексу: если он отбирает меньше половины
+// коллекции, просматриваются только отобранные фигуры, иначе — вся коллекция.
+// Номера отобранных фигур ищутся проходом по коллекции, так что запрос
+// остаётся O(n), но без копирования и вычислений над неотобранными фигурами
+QueryResult runQuery(const Query& query, const FigureCollection& figures, const AreaIndex& index,
+                     unsigned threads = 0);
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <iostream>
+#include <vector>
+#include "figure_buffer.hpp"
+#include "hull.hpp"
+
+// Параметры растеризации
+struct RasterOptions {
+    size_t width = 1024;
+    size_t height = 1024;
+    // Видимая область; пустая — габариты коллекции. Масштаб одинаков по
+    // обеим осям, область выравнивается по центру изображения
+    Extent view;
+    size_t tile = 64;        // сторона квадратной плитки в пикселях
+    unsigned samples = 1;    // отсчётов на пиксель по каждой оси (1 — без сглаживания, до 16)
+    unsigned threads = 0;
+};
+
+// Покрытие пикселей фигурами, 0..1, строки сверху вниз
+struct Raster {
+    size_t width = 0;
+    size_t height = 0;
+    std::vector<float> coverage;
+
+    float at(size_t x, size_t y) const;
+};
+
+// Растеризация: фигуры раскладываются по плиткам, плитки заполняются
+// параллельно. Пиксель покрывается по отсчётам в центрах ячеек сетки
+// samples x samples (правило чёт-нечет), покрытия фигур складываются
+// как полупрозрачные слои: c = c + f * (1 - c). Результат не зависит
+// от числа потоков
+Raster rasterize(const FigureBuffer& figures, const RasterOptions& opts = {});
+
+// Запись в двоичный PGM (P5): фигуры тёмные на белом фоне
+void writePgm(std::ostream& os, const Raster& raster);
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include "shell.hpp"
+
+// Сервер команд поверх Unix-сокета или TCP на 127.0.0.1.
+// Протокол: запрос — одна строка с командой REPL (например,
+// "add diamond 1 0 0 1 -1 0 0 -1"), ответ — вывод команды и строка из одной
+// точки. Запросы можно отправлять пачкой, не дожидаясь ответов: они
+// выполняются по порядку. Все клиенты работают с одной коллекцией;
+// цикл событий на epoll однопоточный, поэтому Shell не нуждается в блокировках.
+// Команды, работающие с файлами (save, load, import, export, render, ingest,
+// stream), выполняются только для клиентов Unix-сокета. Тяжёлые команды
+// (generate, coverage, render) выполняются в том же потоке и на время работы
+// задерживают остальных клиентов; generate и render ограничены по размеру,
+// время coverage растёт с размером коллекции
+class Server
+{
+    private:
+        struct Connection {
+            std::string in;
+            std::string out;
+            size_t scanned = 0;         // начало in до этой позиции без '\n'
+            bool closing = false;
+            std::uint32_t events = 0;   // маска, зарегистрированная в epoll
+        };
+
+        Shell& shell;
+        int listenFd = -1;
+        int epollFd = -1;
+        int boundPort = 0;
+        std::string unixPath;
+        bool remote = false;   // TCP: команды с файлами запрещены
+        bool accepting = true;   // listenFd зарегистрирован в epoll
+        std::chrono::steady_clock::time_point acceptResume;
+        std::atomic<bool> stopping{false};
+        std::unordered_map<int, Connection> connections;
+
+        void acceptClients();
+        void pauseAccepting();
+        void resumeAccepting();
+        void handleInput(int fd, Connection& conn);
+        bool flush(int fd, Connection& conn);
+        void updateEvents(int fd, Connection& conn);
+        void drop(int fd);
+    public:
+        // Адрес: "unix:<путь>" или "tcp:<порт>" (0 — любой свободный)
+        Server(Shell& shellRef, const std::string& address);
+        ~Server();
+        Server(const Server&) = delete;
+        Server& operator=(const Server&) = delete;
+
+        // Цикл обработки событий до вызова stop()
+        void run();
+        // Можно вызывать из другого потока или обработчика сигнала
+        void stop();
+
+        int port() const;
+};
+
+// Клиентское подключение к серверу (блокирующий сокет); std::runtime_error при ошибке
+int connectToServer(const std::string& address);
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <deque>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+#include "Figure.hpp"
+#include "area_index.hpp"
+#include "figure_collection.hpp"
+#include "hull.hpp"
+#include "stats.hpp"
+#include "validation.hpp"
+#include "wal.hpp"
+
+// Коллекция фигур и интерпретатор команд над ней.
+// Используется интерактивным режимом и сервером
+class Shell
+{
+    private:
+        static const size_t HISTORY_LIMIT = 100;
+
+        FigureCollection figures;
+        // Снимки коллекции (snapshot/restore) и состояния до последних
+        // изменений (undo); копии разделяют неизменённые куски с коллекцией
+        std::vector<FigureCollection> snapshots;
+        std::deque<FigureCollection> history;
+        AreaIndex areaIndex;
+        ValidationOptions validation;
+        bool validateInput = false;
+        // Габариты коллекции: расширяются при добавлении, после удаления
+        // или преобразования пересчитываются при следующем запросе
+        Extent extent;
+        bool extentDirty = false;
+        // Выводить ли подсказки для ввода координат
+        bool interactive;
+        // Журнал изменений коллекции (если подключён)
+        std::unique_ptr<WriteAheadLog> wal;
+
+        // Запоминает состояние до изменения для undo
+        void remember(FigureCollection state);
+        // Заменяет коллекцию сохранённым состоянием и перестраивает индекс
+        void reset(const FigureCollection& state);
+        // Записывает в журнал count последних добавленных фигур
+        void logAdded(size_t count);
+        // Пишет в журнал изменения команды, уже применённые к коллекции.
+        // Если запись не удалась, коллекция возвращается к history.back(),
+        // а журнал переписывается по ней; std::runtime_error в обоих случаях
+        void logChange(const std::function<void()>& write);
+        // Переписывает журнал по коллекции после сбоя записи; если и это
+        // не удалось, отключает журнал и бросает std::runtime_error
+        void resyncLog(const std::string& cause);
+    public:
+        explicit Shell(bool interactiveMode = true);
+
+        static void printHelp(std::ostream& os);
+
+        // Выполняет одну команду, читая её аргументы из is.
+        // Возвращает false для quit и в конце ввода
+        bool execute(std::istream& is, std::ostream& os);
+
+        const FigureCollection& collection() const;
+
+        // Восстанавливает коллекцию из журнала и продолжает писать в него
+        // все изменения
+        WalReplay attachLog(const std::string& path, const WalOptions& opts = {});
+        // Граница пачки команд: фиксирует журнал одним fsync (групповая
+        // фиксация) и при необходимости пишет контрольную точку. Сбой
+        // фиксации лечится контрольной точкой; std::runtime_error, только
+        // если журнал пришлось отключить
+        void commit();
+};
+
+// Вывод агрегатов потоковой обработки
+void printStats(std::ostream& os, const FigureStats& stats);
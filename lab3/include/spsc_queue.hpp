@@ -0,0 +1,57 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Ограниченная очередь без блокировок для одного производителя и одного
+// потребителя (кольцевой буфер). Заполненная очередь притормаживает
+// производителя — так реализуется обратное давление между стадиями
+template <typename T>
+class SpscQueue
+{
+    private:
+        std::vector<T> slots;
+        alignas(64) std::atomic<size_t> head{0};   // следующий для чтения
+        alignas(64) std::atomic<size_t> tail{0};   // следующий для записи
+    public:
+        explicit SpscQueue(size_t capacity)
+            : slots(capacity + 1) {}
+
+        bool tryPush(T& value) {
+            size_t t = tail.load(std::memory_order_relaxed);
+            size_t next = (t + 1) % slots.size();
+            if (next == head.load(std::memory_order_acquire)) {
+                return false;
+            }
+            slots[t] = std::move(value);
+            tail.store(next, std::memory_order_release);
+            return true;
+        }
+
+        bool tryPop(T& value) {
+            size_t h = head.load(std::memory_order_relaxed);
+            if (h == tail.load(std::memory_order_acquire)) {
+                return false;
+            }
+            value = std::move(slots[h]);
+            head.store((h + 1) % slots.size(), std::memory_order_release);
+            return true;
+        }
+
+        void push(T value) {
+            while (!tryPush(value)) {
+                std::this_thread::yield();
+            }
+        }
+
+        T pop() {
+            T value;
+            while (!tryPop(value)) {
+                std::this_thread::yield();
+            }
+            return value;
+        }
+};
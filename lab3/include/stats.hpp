@@ -0,0 +1,19 @@
+#pragma once
+
+#include <utility>
+#include "Figure.hpp"
+#include "figure_buffer.hpp"
+
+// Накопитель агрегатов по набору фигур: количество, суммарная площадь, средний центр.
+// Фигуры суммируются в порядке добавления, поэтому результат совпадает с totalArea
+struct FigureStats {
+    size_t count = 0;
+    double totalArea = 0.0;
+    double sumCenterX = 0.0;
+    double sumCenterY = 0.0;
+
+    void add(const Figure& fig);
+    void add(const FigureBuffer& figures);
+    void merge(const FigureStats& other);
+    std::pair<double, double> meanCenter() const;
+};
@@ -0,0 +1,9 @@
+#pragma once
+
+#include <iostream>
+#include "stats.hpp"
+
+// Потоковая агрегация текстового дампа без загрузки коллекции в память.
+// Поток читается кусками по chunkBytes; следующий кусок читается и разбирается
+// в фоновом потоке, пока считается текущий (двойная буферизация)
+FigureStats streamStats(std::istream& is, size_t chunkBytes = 1 << 20);
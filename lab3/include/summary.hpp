@@ -0,0 +1,39 @@
+#pragma once
+
+#include <array>
+#include <memory>
+#include <utility>
+#include <vector>
+#include "Figure.hpp"
+#include "figure_buffer.hpp"
+
+// Статистика площадей и центров для одной группы фигур
+struct KindSummary {
+    size_t count = 0;
+    double sum = 0.0;
+    double min = 0.0;
+    double max = 0.0;
+    double mean = 0.0;
+    double m2 = 0.0;          // сумма квадратов отклонений (алгоритм Уэлфорда)
+    double sumCenterX = 0.0;
+    double sumCenterY = 0.0;
+
+    void add(double area, const std::pair<double, double>& center);
+    void merge(const KindSummary& other);
+    double variance() const;  // дисперсия по генеральной совокупности
+    std::pair<double, double> meanCenter() const;
+};
+
+// Сводка по видам фигур и по всей коллекции
+struct Summary {
+    std::array<KindSummary, 4> kinds;   // ромбы, пятиугольники, шестиугольники, многоугольники
+    KindSummary all;
+
+    const KindSummary& operator[](FigureKind kind) const;
+    void merge(const Summary& other);
+};
+
+// Один проход по коллекции: каждая фигура читается один раз, все метрики
+// считаются вместе; части коллекции обрабатываются параллельно и сливаются
+Summary summarize(const FigureBuffer& figures, unsigned threads = 0);
+Summary summarize(const std::vector<std::unique_ptr<Figure>>& figures, unsigned threads = 0);
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <iostream>
+#include <string>
+#include "figure_buffer.hpp"
+
+// Текстовый формат коллекции — те же строки, что вводятся в REPL:
+//   add diamond x1 y1 x2 y2 x3 y3 x4 y4
+//   add polygon n x1 y1 ... xn yn
+// Пустые строки пропускаются, остальные считаются ошибкой.
+
+// Разбор фрагмента текста из целых строк; фигуры дописываются в out.
+// При ошибке бросает std::runtime_error с номером строки (считая от firstLine)
+size_t parseFigures(const char* begin, const char* end, FigureBuffer& out, size_t firstLine = 1);
+
+// Запись фигур в текстовом формате
+void writeFigures(std::ostream& os, const FigureBuffer& figures);
+
+// Чтение потока кусками по целым строкам
+class ChunkReader
+{
+    private:
+        std::istream& is;
+        size_t chunkBytes;
+        std::string tail;
+        size_t line = 1;
+    public:
+        ChunkReader(std::istream& input, size_t chunk = 1 << 20);
+
+        // Следующий кусок, заканчивающийся концом строки; false в конце потока.
+        // firstLine — номер первой строки куска
+        bool next(std::string& chunk, size_t& firstLine);
+};
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <memory>
+#include <utility>
+#include <vector>
+#include "Figure.hpp"
+#include "figure_buffer.hpp"
+
+// Аффинное преобразование: матрица 2x3
+//   x' = a * x + b * y + tx
+//   y' = c * x + d * y + ty
+struct Affine {
+    double a = 1.0, b = 0.0, tx = 0.0;
+    double c = 0.0, d = 1.0, ty = 0.0;
+
+    std::pair<double, double> apply(const std::pair<double, double>& p) const;
+    double det() const;
+};
+
+// Цепочка преобразований, которая сворачивается в одну матрицу на фигуру.
+// Шаги без точки (rotate(angle), scale(sx, sy)) выполняются относительно
+// собственного центра фигуры (среднего вершин); так как центр переходит
+// в центр, вся цепочка сводится к x' = L * x + M * c + t, где c — исходный центр
+class Transform
+{
+    private:
+        double l[4] = {1.0, 0.0, 0.0, 1.0};
+        double m[4] = {0.0, 0.0, 0.0, 0.0};
+        double t[2] = {0.0, 0.0};
+
+        void absolute(const double s[4], double ux, double uy);
+        void aroundCenter(const double s[4]);
+    public:
+        Transform& translate(double dx, double dy);
+        Transform& rotate(double angle);
+        Transform& rotateAbout(double angle, double px, double py);
+        Transform& scale(double sx, double sy);
+        Transform& scaleAbout(double sx, double sy, double px, double py);
+
+        // Итоговая матрица для фигуры с центром center
+        Affine forCenter(const std::pair<double, double>& center) const;
+        // Нужен ли центр фигуры (есть шаги относительно собственного центра)
+        bool usesCenter() const;
+        // Во сколько раз меняется площадь
+        double areaFactor() const;
+        // Поворот с равномерным масштабом: ромб остаётся ромбом
+        bool isSimilarity() const;
+};
+
+// Применение к одной фигуре, ко всей коллекции и к выбранным индексам.
+// Большие наборы обрабатываются параллельно; фигура без доступа к вершинам —
+// std::invalid_argument
+void applyTransform(Figure& fig, const Transform& tr);
+void applyTransform(std::vector<std::unique_ptr<Figure>>& figures, const Transform& tr, unsigned threads = 0);
+void applyTransform(std::vector<std::unique_ptr<Figure>>& figures, const std::vector<size_t>& selection,
+                    const Transform& tr, unsigned threads = 0);
+void applyTransform(FigureBuffer& figures, const Transform& tr, unsigned threads = 0);
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+#include "Figure.hpp"
+#include "figure_buffer.hpp"
+
+// Причины отказа (битовая маска)
+enum ValidationError : std::uint32_t {
+    VALID = 0,
+    DEGENERATE = 1 << 0,         // нулевая площадь или совпадающие вершины
+    RHOMBUS_SIDES = 1 << 1,      // стороны ромба не равны
+    RHOMBUS_DIAGONALS = 1 << 2,  // диагонали не делятся точкой пересечения пополам
+    SELF_INTERSECTING = 1 << 3,  // несмежные стороны пересекаются
+    NOT_CONVEX = 1 << 4,
+    WRONG_WINDING = 1 << 5,
+    NOT_FINITE = 1 << 6          // координата NaN или бесконечность; остальные проверки не выполняются
+};
+
+enum class Winding {
+    Any,
+    CounterClockwise,
+    Clockwise
+};
+
+struct ValidationOptions {
+    double tolerance = 1e-9;     // относительно размера фигуры
+    bool requireConvex = true;
+    Winding winding = Winding::Any;
+};
+
+// Текстовое описание причин
+std::string describeErrors(std::uint32_t errors);
+
+std::uint32_t validateApexes(FigureKind kind, const double* xs, const double* ys, size_t n,
+                             const ValidationOptions& opts = {});
+std::uint32_t validateApexes(FigureKind kind, const double* xs, const double* ys,
+                             const ValidationOptions& opts = {});
+std::uint32_t validateFigure(const Figure& fig, const ValidationOptions& opts = {});
+
+// Результат пакетной проверки: индексы отклонённых фигур с причинами
+struct ValidationReport {
+    size_t checked = 0;
+    std::vector<std::pair<size_t, std::uint32_t>> failures;
+};
+
+// Параллельная проверка всего буфера
+ValidationReport validateAll(const FigureBuffer& figures, const ValidationOptions& opts = {},
+                             unsigned threads = 0);
+
+// Копия буфера без отклонённых фигур
+FigureBuffer dropInvalid(const FigureBuffer& figures, const ValidationReport& report);
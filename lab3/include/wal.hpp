@@ -0,0 +1,93 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include "Figure.hpp"
+#include "figure_buffer.hpp"
+#include "figure_collection.hpp"
+
+// Журнал упреждающей записи коллекции: добавление, удаление и замена фигуры
+// по индексу. Формат — заголовок "FWAL" и записи
+//   длина (u32) | контрольная сумма FNV-1a (u32) | операция (u8) | данные
+// Координаты пишутся без потерь (биты double).
+
+// Когда записи попадают на диск
+enum class Durability {
+    Off,     // только write(), без fsync: переживает падение процесса, но не ОС
+    Batch,   // групповая фиксация: один fsync на пачку операций (commit())
+    PerOp    // fsync после каждой операции
+};
+
+bool parseDurability(const std::string& name, Durability& durability);
+const char* durabilityName(Durability durability);
+
+struct WalOptions {
+    Durability durability = Durability::Batch;
+    size_t bufferBytes = 1 << 20;       // пачка фиксируется досрочно при таком объёме
+    size_t checkpointRecords = 1 << 16; // минимальная длина журнала для контрольной точки
+};
+
+struct WalReplay {
+    size_t records = 0;      // применено записей
+    size_t validBytes = 0;   // длина корректного начала файла
+    bool tornTail = false;   // в конце файла оборванная или повреждённая запись
+};
+
+// Восстановление: журнал читается целиком и декодируется последовательно,
+// операции применяются к figures. Оборванный хвост (падение во время записи)
+// отбрасывается; std::runtime_error, если корректная запись противоречит коллекции
+WalReplay replayWal(const std::string& path, FigureCollection& figures);
+
+class WriteAheadLog
+{
+    private:
+        std::string path;
+        WalOptions options;
+        int fd = -1;
+
+        std::mutex mutex;
+        std::condition_variable flushed;
+        std::string pending;         // записи, ещё не переданные в файл
+        std::uint64_t appended = 0;  // номер последней добавленной записи
+        std::uint64_t durable = 0;   // номер последней зафиксированной записи
+        bool flushing = false;       // лидер групповой фиксации пишет в файл
+        bool failed = false;         // запись или fsync не удались: файл не согласован до checkpoint
+        size_t records = 0;          // записей в файле с учётом pending
+        size_t syncCount = 0;
+
+        std::uint64_t append(const std::string& payload);
+        void openForAppend(size_t validBytes);
+    public:
+        // Открывает журнал для дописывания после validBytes корректных байт
+        // (результат replayWal); при validBytes == 0 файл создаётся заново
+        WriteAheadLog(const std::string& logPath, const WalOptions& opts = {}, size_t validBytes = 0);
+        ~WriteAheadLog();
+        WriteAheadLog(const WriteAheadLog&) = delete;
+        WriteAheadLog& operator=(const WriteAheadLog&) = delete;
+
+        // Запись операций; возвращают номер записи.
+        // В режиме PerOp возвращаются после fsync. После неудачной записи
+        // или fsync журнал отказывает (std::runtime_error) до checkpoint.
+        // logAdd по массивам — только для видов с фиксированным числом вершин
+        std::uint64_t logAdd(FigureKind kind, const double* xs, const double* ys);
+        std::uint64_t logAdd(const Figure& fig);
+        std::uint64_t logRemove(size_t index);
+        std::uint64_t logAssign(size_t index, const Figure& fig);
+
+        // Групповая фиксация: первый ожидающий поток пишет и синхронизирует
+        // все накопленные записи, остальные ждут его результата
+        void sync(std::uint64_t record);
+        // Зафиксировать всё добавленное
+        void commit();
+
+        // Контрольная точка: журнал переписывается как набор добавлений
+        // текущей коллекции и атомарно подменяется через rename;
+        // снимает отказ после неудачной записи
+        bool checkpointDue(size_t liveFigures) const;
+        void checkpoint(const FigureCollection& figures);
+
+        Durability durability() const;
+        size_t syncs() const;
+};
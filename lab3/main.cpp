@@ -1,110 +1,120 @@
 #include <iostream>
-#include <vector>
-#include <memory>
 #include <string>
-#include "include/diamond.hpp"
-#include "include/pentagon.hpp"
-#include "include/hexagon.hpp"
+#include <fstream>
+#include <csignal>
+#include "include/shell.hpp"
+#include "include/stream.hpp"
+#include "include/server.hpp"
+#include "include/wal.hpp"
 
-// Вспомогательная функция: вывод информации о фигуре
-void printFigureInfo(const Figure& fig) {
-    auto center = fig.getCenter();
-    double area = static_cast<double>(fig);
-    std::cout << "Центр: (" << center.first << ", " << center.second << "), "
-              << "Площадь: " << area << "\n";
+// Потоковый режим: lab3_main --stream <файл|->
+int runStream(const std::string& path) {
+    try {
+        if (path == "-") {
+            printStats(std::cout, streamStats(std::cin));
+        } else {
+            std::ifstream in(path, std::ios::binary);
+            if (!in) {
+                std::cerr << "Не удалось открыть файл: " << path << "\n";
+                return 1;
+            }
+            printStats(std::cout, streamStats(in));
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Ошибка: " << e.what() << "\n";
+        return 1;
+    }
+    return 0;
 }
 
-// Вспомогательная функция: подсчёт общей площади
-double totalArea(const std::vector<std::unique_ptr<Figure>>& figures) {
-    double total = 0.0;
-    for (const auto& fig : figures) {
-        total += static_cast<double>(*fig);
+Server* activeServer = nullptr;
+
+void stopServer(int) {
+    if (activeServer) {
+        activeServer->stop();
     }
-    return total;
 }
 
-// Вспомогательная функция: удаление по индексу
-bool removeFigure(std::vector<std::unique_ptr<Figure>>& figures, size_t index) {
-    if (index >= figures.size()) {
+// Подключение журнала: восстановление коллекции и сообщение о результате
+bool attachLog(Shell& shell, const std::string& path, const WalOptions& opts) {
+    try {
+        WalReplay replay = shell.attachLog(path, opts);
+        std::cout << "Журнал " << path << ": восстановлено операций " << replay.records
+                  << ", фигур " << shell.collection().size()
+                  << ", фиксация " << durabilityName(opts.durability) << "\n";
+        if (replay.tornTail) {
+            std::cout << "Оборванная запись в конце журнала отброшена\n";
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Ошибка: " << e.what() << "\n";
         return false;
     }
-    figures.erase(figures.begin() + index);
     return true;
 }
 
-int main() {
-    std::vector<std::unique_ptr<Figure>> figures;
-    std::string command;
+// Режим сервера: lab3_main [--wal <файл>] --serve unix:<путь> | tcp:<порт>
+int runServer(const std::string& address, const std::string& walPath, const WalOptions& walOptions) {
+    try {
+        Shell shell(false);
+        if (!walPath.empty() && !attachLog(shell, walPath, walOptions)) {
+            return 1;
+        }
+        Server server(shell, address);
+        activeServer = &server;
+        std::signal(SIGINT, stopServer);
+        std::signal(SIGTERM, stopServer);
+        std::cout << "Сервер запущен: " << address << std::endl;
+        server.run();
+        activeServer = nullptr;
+    } catch (const std::exception& e) {
+        std::cerr << "Ошибка: " << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
 
-    std::cout << "Доступные команды:\n"
-              << "  add diamond    — добавить ромб\n"
-              << "  add pentagon   — добавить пятиугольник\n"
-              << "  add hexagon    — добавить шестиугольник\n"
-              << "  list           — вывести все фигуры\n"
-              << "  total          — общая площадь\n"
-              << "  remove <индекс> — удалить фигуру по индексу (начиная с 0)\n"
-              << "  quit           — завершить программу\n\n";
+// Запуск: lab3_main [--wal <файл> [--durability off|batch|op]] [--serve <адрес> | --stream <файл|->]
+int main(int argc, char* argv[]) {
+    std::string walPath;
+    WalOptions walOptions;
+    std::string serveAddress;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--stream" && i + 1 < argc) {
+            return runStream(argv[i + 1]);
+        } else if (arg == "--serve" && i + 1 < argc) {
+            serveAddress = argv[++i];
+        } else if (arg == "--wal" && i + 1 < argc) {
+            walPath = argv[++i];
+        } else if (arg == "--durability" && i + 1 < argc && parseDurability(argv[i + 1], walOptions.durability)) {
+            ++i;
+        } else {
+            std::cerr << "Использование: lab3_main [--wal <файл> [--durability off|batch|op]]"
+                      << " [--serve unix:<путь>|tcp:<порт> | --stream <файл|->]\n";
+            return 1;
+        }
+    }
+    if (!serveAddress.empty()) {
+        return runServer(serveAddress, walPath, walOptions);
+    }
 
+    Shell shell;
+    if (!walPath.empty() && !attachLog(shell, walPath, walOptions)) {
+        return 1;
+    }
+    Shell::printHelp(std::cout);
     while (true) {
         std::cout << "> ";
-        std::cin >> command;
-
-        if (command == "quit") {
-            break;
-        }
-        else if (command == "add") {
-            std::string type;
-            std::cin >> type;
-
-            if (type == "diamond") {
-                auto d = std::make_unique<Diamond>();
-                std::cout << "Введите 4 вершины ромба (x1 y1 x2 y2 ... x4 y4):\n";
-                std::cin >> *d;
-                figures.push_back(std::move(d));
-            }
-            else if (type == "pentagon") {
-                auto p = std::make_unique<Pentagon>();
-                std::cout << "Введите 5 вершин пятиугольника (x1 y1 ... x5 y5):\n";
-                std::cin >> *p;
-                figures.push_back(std::move(p));
-            }
-            else if (type == "hexagon") {
-                auto h = std::make_unique<Hexagon>();
-                std::cout << "Введите 6 вершин шестиугольника (x1 y1 ... x6 y6):\n";
-                std::cin >> *h;
-                figures.push_back(std::move(h));
-            }
-            else {
-                std::cout << "Неизвестный тип фигуры: " << type << "\n";
-            }
-        }
-        else if (command == "list") {
-            if (figures.empty()) {
-                std::cout << "Нет фигур.\n";
-            } else {
-                for (size_t i = 0; i < figures.size(); ++i) {
-                    std::cout << "[" << i << "] ";
-                    printFigureInfo(*figures[i]);
-                }
-            }
-        }
-        else if (command == "total") {
-            std::cout << "Общая площадь: " << totalArea(figures) << "\n";
-        }
-        else if (command == "remove") {
-            size_t index;
-            std::cin >> index;
-            if (removeFigure(figures, index)) {
-                std::cout << "Фигура удалена.\n";
-            } else {
-                std::cout << "Ошибка: индекс вне диапазона [0, " << figures.size() - 1 << "]\n";
-            }
-        }
-        else {
-            std::cout << "Неизвестная команда. Доступные: add, list, total, remove, quit\n";
+        // Ошибки журнала не завершают сеанс: команда отменена или журнал
+        // отключён, об этом сообщает текст исключения
+        try {
+            if (!shell.execute(std::cin, std::cout)) break;
+            shell.commit();
+        } catch (const std::exception& e) {
+            std::cerr << "Ошибка: " << e.what() << "\n";
         }
     }
 
     std::cout << "Выход.\n";
     return 0;
-}
\ No newline at end of file
+}
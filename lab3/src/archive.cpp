@@ -0,0 +1,243 @@
+#include "../include/archive.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iterator>
+#include <stdexcept>
+
+namespace {
+
+const char MAGIC[4] = {'F', 'G', 'A', 'R'};
+const std::uint32_t VERSION = 1;
+const size_t HEADER_SIZE = 32;   // magic, version, precision, blockCount, figureCount
+const size_t INDEX_ENTRY_SIZE = 16;
+
+void putU32(std::string& out, std::uint32_t v) {
+    for (int i = 0; i < 4; ++i) out.push_back(static_cast<char>((v >> (8 * i)) & 0xFF));
+}
+
+void putU64(std::string& out, std::uint64_t v) {
+    for (int i = 0; i < 8; ++i) out.push_back(static_cast<char>((v >> (8 * i)) & 0xFF));
+}
+
+std::uint32_t getU32(const unsigned char* p) {
+    std::uint32_t v = 0;
+    for (int i = 0; i < 4; ++i) v |= static_cast<std::uint32_t>(p[i]) << (8 * i);
+    return v;
+}
+
+std::uint64_t getU64(const unsigned char* p) {
+    std::uint64_t v = 0;
+    for (int i = 0; i < 8; ++i) v |= static_cast<std::uint64_t>(p[i]) << (8 * i);
+    return v;
+}
+
+void putVarint(std::string& out, std::int64_t value) {
+    // zigzag: малые по модулю числа любого знака занимают мало байт
+    std::uint64_t v = (static_cast<std::uint64_t>(value) << 1) ^ static_cast<std::uint64_t>(value >> 63);
+    while (v >= 0x80) {
+        out.push_back(static_cast<char>((v & 0x7F) | 0x80));
+        v >>= 7;
+    }
+    out.push_back(static_cast<char>(v));
+}
+
+std::int64_t getVarint(const unsigned char*& p, const unsigned char* end) {
+    std::uint64_t v = 0;
+    int shift = 0;
+    while (true) {
+        if (p == end || shift > 63) {
+            throw std::runtime_error("Corrupted archive block");
+        }
+        unsigned char byte = *p++;
+        v |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) break;
+        shift += 7;
+    }
+    return static_cast<std::int64_t>(v >> 1) ^ -static_cast<std::int64_t>(v & 1);
+}
+
+// Квантованные координаты ограничены 2^62 по модулю: разность двух таких
+// значений помещается в int64
+std::int64_t quantize(double v, double step) {
+    double q = std::round(v / step);
+    if (!(std::fabs(q) < 0x1p62)) {
+        throw std::invalid_argument("Coordinate does not fit the archive precision");
+    }
+    return static_cast<std::int64_t>(q);
+}
+
+// Сумма по модулю 2^64: в недоверенном архиве она может переполниться
+std::int64_t addDelta(std::int64_t base, std::int64_t delta) {
+    return static_cast<std::int64_t>(static_cast<std::uint64_t>(base) + static_cast<std::uint64_t>(delta));
+}
+
+void encodeBlock(std::string& out, const FigureBuffer& figures, size_t first, size_t last, double step) {
+    // Сначала виды фигур, затем координаты: декодер знает длины заранее
+    for (size_t i = first; i < last; ++i) {
+        out.push_back(static_cast<char>(figures.kind(i)));
+    }
+    for (size_t i = first; i < last; ++i) {
+        const double* xs = figures.xs(i);
+        const double* ys = figures.ys(i);
+        if (figures.kind(i) == FigureKind::Polygon) {
+            putVarint(out, static_cast<std::int64_t>(figures.apexCount(i)));
+        }
+        std::int64_t x0 = quantize(xs[0], step);
+        std::int64_t y0 = quantize(ys[0], step);
+        putVarint(out, x0);
+        putVarint(out, y0);
+        for (size_t j = 1; j < figures.apexCount(i); ++j) {
+            putVarint(out, quantize(xs[j], step) - x0);
+            putVarint(out, quantize(ys[j], step) - y0);
+        }
+    }
+}
+
+} // namespace
+
+void writeArchive(std::ostream& os, const FigureBuffer& figures, const ArchiveOptions& opts) {
+    if (!(opts.precision > 0.0) || opts.blockSize == 0) {
+        throw std::invalid_argument("Invalid archive options");
+    }
+    size_t blockCount = (figures.size() + opts.blockSize - 1) / opts.blockSize;
+
+    std::string out;
+    out.append(MAGIC, 4);
+    putU32(out, VERSION);
+    std::uint64_t stepBits;
+    std::memcpy(&stepBits, &opts.precision, sizeof(stepBits));
+    putU64(out, stepBits);
+    putU32(out, static_cast<std::uint32_t>(blockCount));
+    putU32(out, 0);
+    putU64(out, figures.size());
+
+    std::string index;
+    for (size_t b = 0; b < blockCount; ++b) {
+        size_t first = b * opts.blockSize;
+        size_t last = std::min(first + opts.blockSize, figures.size());
+        size_t offset = out.size();
+        encodeBlock(out, figures, first, last, opts.precision);
+        putU64(index, offset);
+        putU32(index, static_cast<std::uint32_t>(last - first));
+        putU32(index, static_cast<std::uint32_t>(out.size() - offset));
+    }
+    std::uint64_t indexOffset = out.size();
+    out += index;
+    putU64(out, indexOffset);
+
+    os.write(out.data(), static_cast<std::streamsize>(out.size()));
+    if (!os) {
+        throw std::runtime_error("Failed to write archive");
+    }
+}
+
+void writeArchive(std::ostream& os, const std::vector<std::unique_ptr<Figure>>& figures,
+                  const ArchiveOptions& opts) {
+    writeArchive(os, toBuffer(figures), opts);
+}
+
+ArchiveReader::ArchiveReader(std::istream& is)
+    : data(std::istreambuf_iterator<char>(is), std::istreambuf_iterator<char>()) {
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(data.data());
+    if (data.size() < HEADER_SIZE + 8 || std::memcmp(p, MAGIC, 4) != 0) {
+        throw std::runtime_error("Not a figure archive");
+    }
+    if (getU32(p + 4) != VERSION) {
+        throw std::runtime_error("Unsupported archive version");
+    }
+    std::uint64_t stepBits = getU64(p + 8);
+    std::memcpy(&step, &stepBits, sizeof(step));
+    std::uint32_t blockCount = getU32(p + 16);
+    figures = getU64(p + 24);
+
+    // Проверки вычитанием: сумма недоверенных 64-битных полей может переполниться
+    std::uint64_t size = data.size();
+    std::uint64_t indexOffset = getU64(p + size - 8);
+    if (indexOffset > size - 8 || blockCount > (size - 8 - indexOffset) / INDEX_ENTRY_SIZE ||
+        indexOffset + blockCount * INDEX_ENTRY_SIZE + 8 != size) {
+        throw std::runtime_error("Corrupted archive index");
+    }
+    std::uint64_t counted = 0;
+    blocks.reserve(blockCount);
+    for (std::uint32_t b = 0; b < blockCount; ++b) {
+        const unsigned char* e = p + indexOffset + b * INDEX_ENTRY_SIZE;
+        Block block{getU64(e), getU32(e + 8), getU32(e + 12)};
+        if (block.offset > indexOffset || block.bytes > indexOffset - block.offset) {
+            throw std::runtime_error("Corrupted archive index");
+        }
+        counted += block.count;
+        blocks.push_back(block);
+    }
+    if (counted != figures) {
+        throw std::runtime_error("Corrupted archive index");
+    }
+}
+
+size_t ArchiveReader::figureCount() const {
+    return figures;
+}
+
+size_t ArchiveReader::blockCount() const {
+    return blocks.size();
+}
+
+size_t ArchiveReader::blockFigureCount(size_t block) const {
+    return blocks.at(block).count;
+}
+
+double ArchiveReader::precision() const {
+    return step;
+}
+
+void ArchiveReader::readBlock(size_t block, FigureBuffer& out) const {
+    const Block& b = blocks.at(block);
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(data.data()) + b.offset;
+    const unsigned char* end = p + b.bytes;
+    if (b.count > b.bytes) {
+        throw std::runtime_error("Corrupted archive block");
+    }
+    const unsigned char* kinds = p;
+    p += b.count;
+
+    std::vector<double> xs(6);
+    std::vector<double> ys(6);
+    for (std::uint32_t i = 0; i < b.count; ++i) {
+        if (!isValidKind(kinds[i])) {
+            throw std::runtime_error("Corrupted archive block");
+        }
+        FigureKind kind = static_cast<FigureKind>(kinds[i]);
+        size_t n = kindApexCount(kind);
+        if (kind == FigureKind::Polygon) {
+            std::int64_t count = getVarint(p, end);
+            // Каждая вершина занимает не меньше двух байт
+            if (count < 3 || count > (end - p) / 2) {
+                throw std::runtime_error("Corrupted archive block");
+            }
+            n = static_cast<size_t>(count);
+            xs.resize(std::max(xs.size(), n));
+            ys.resize(std::max(ys.size(), n));
+        }
+        std::int64_t x0 = getVarint(p, end);
+        std::int64_t y0 = getVarint(p, end);
+        xs[0] = static_cast<double>(x0) * step;
+        ys[0] = static_cast<double>(y0) * step;
+        for (size_t j = 1; j < n; ++j) {
+            xs[j] = static_cast<double>(addDelta(x0, getVarint(p, end))) * step;
+            ys[j] = static_cast<double>(addDelta(y0, getVarint(p, end))) * step;
+        }
+        out.push(kind, xs.data(), ys.data(), n);
+    }
+}
+
+FigureBuffer ArchiveReader::readAll() const {
+    // Каждая фигура занимает в файле хотя бы байт вида: заголовку
+    // с завышенным числом фигур не доверяем
+    std::uint64_t bound = std::min<std::uint64_t>(figures, data.size());
+    FigureBuffer out;
+    out.reserve(bound, bound * 6);
+    for (size_t b = 0; b < blocks.size(); ++b) {
+        readBlock(b, out);
+    }
+    return out;
+}
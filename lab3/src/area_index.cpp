@@ -0,0 +1,165 @@
+#include "../include/area_index.hpp"
+#include "../include/parallel.hpp"
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+
+bool AreaIndex::Order::operator()(const Entry& a, const Entry& b) const {
+    bool aNan = std::isnan(a.first);
+    bool bNan = std::isnan(b.first);
+    if (aNan != bNan) {
+        return bNan;
+    }
+    if (!aNan && a.first != b.first) {
+        return a.first < b.first;
+    }
+    return std::less<const Figure*>()(a.second, b.second);
+}
+
+void AreaIndex::insert(const Figure& fig) {
+    insert(fig, static_cast<double>(fig));
+}
+
+void AreaIndex::insert(const Figure& fig, double area) {
+    if (areas.emplace(&fig, area).second) {
+        entries.emplace(area, &fig);
+    }
+}
+
+bool AreaIndex::erase(const Figure& fig) {
+    auto it = areas.find(&fig);
+    if (it == areas.end()) {
+        return false;
+    }
+    entries.erase({it->second, &fig});
+    areas.erase(it);
+    return true;
+}
+
+void AreaIndex::clear() {
+    entries.clear();
+    areas.clear();
+}
+
+void AreaIndex::rescale(double factor) {
+    rescale(factor, {});
+}
+
+void AreaIndex::rescale(double factor, const std::unordered_map<const Figure*, const Figure*>& moved) {
+    auto target = [&](const Figure* fig) {
+        auto it = moved.find(fig);
+        return it == moved.end() ? fig : it->second;
+    };
+    std::set<Entry, Order> scaled;
+    if (factor > 0.0) {
+        // Порядок площадей не меняется: перестраиваем дерево за линейное время
+        for (const auto& entry : entries) {
+            scaled.emplace_hint(scaled.end(), entry.first * factor, target(entry.second));
+        }
+    } else {
+        for (const auto& entry : entries) {
+            scaled.emplace(entry.first * factor, target(entry.second));
+        }
+    }
+    entries.swap(scaled);
+    if (moved.empty()) {
+        for (auto& item : areas) {
+            item.second *= factor;
+        }
+        return;
+    }
+    std::unordered_map<const Figure*, double> updated;
+    updated.reserve(areas.size());
+    for (const auto& item : areas) {
+        updated.emplace(target(item.first), item.second * factor);
+    }
+    areas.swap(updated);
+}
+
+void AreaIndex::rescale(const Figure& fig, double factor) {
+    auto it = areas.find(&fig);
+    if (it == areas.end()) {
+        return;
+    }
+    entries.erase({it->second, &fig});
+    it->second *= factor;
+    entries.emplace(it->second, &fig);
+}
+
+void AreaIndex::build(const std::vector<std::unique_ptr<Figure>>& figures, unsigned threads) {
+    std::vector<const Figure*> pointers;
+    pointers.reserve(figures.size());
+    for (const auto& fig : figures) {
+        pointers.push_back(fig.get());
+    }
+    build(pointers, threads);
+}
+
+void AreaIndex::build(const FigureCollection& figures, unsigned threads) {
+    std::vector<const Figure*> pointers;
+    pointers.reserve(figures.size());
+    figures.forEach([&](const Figure& fig) { pointers.push_back(&fig); });
+    build(pointers, threads);
+}
+
+void AreaIndex::build(const std::vector<const Figure*>& figures, unsigned threads) {
+    std::vector<Entry> sorted(figures.size());
+    std::vector<size_t> bounds;
+    size_t parts = parallelFor(figures.size(), threads, [&](size_t begin, size_t end, size_t) {
+        for (size_t i = begin; i < end; ++i) {
+            sorted[i] = {static_cast<double>(*figures[i]), figures[i]};
+        }
+        std::sort(sorted.begin() + begin, sorted.begin() + end, Order());
+    });
+    // Слияние отсортированных частей
+    for (size_t part = 0; part <= parts; ++part) {
+        bounds.push_back(figures.size() * part / parts);
+    }
+    for (size_t width = 1; width < parts; width *= 2) {
+        for (size_t i = 0; i + width < parts; i += 2 * width) {
+            size_t last = std::min(i + 2 * width, parts);
+            std::inplace_merge(sorted.begin() + bounds[i], sorted.begin() + bounds[i + width],
+                               sorted.begin() + bounds[last], Order());
+        }
+    }
+
+    clear();
+    areas.reserve(sorted.size());
+    for (const auto& entry : sorted) {
+        if (areas.emplace(entry.second, entry.first).second) {
+            entries.emplace_hint(entries.end(), entry);
+        }
+    }
+}
+
+size_t AreaIndex::size() const {
+    return entries.size();
+}
+
+std::vector<const Figure*> AreaIndex::top(size_t k) const {
+    std::vector<const Figure*> result;
+    auto it = entries.rbegin();
+    while (it != entries.rend() && std::isnan(it->first)) ++it;
+    for (; it != entries.rend() && result.size() < k; ++it) {
+        result.push_back(it->second);
+    }
+    return result;
+}
+
+std::vector<const Figure*> AreaIndex::bottom(size_t k) const {
+    std::vector<const Figure*> result;
+    for (auto it = entries.begin(); it != entries.end() && result.size() < k && !std::isnan(it->first); ++it) {
+        result.push_back(it->second);
+    }
+    return result;
+}
+
+std::vector<const Figure*> AreaIndex::range(double lo, double hi) const {
+    std::vector<const Figure*> result;
+    auto it = entries.lower_bound({lo, nullptr});
+    for (; it != entries.end() && it->first <= hi; ++it) {
+        result.push_back(it->second);
+    }
+    return result;
+}
@@ -0,0 +1,710 @@
+#include "../include/arrow_ipc.hpp"
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <functional>
+#include <limits>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+const char MAGIC[8] = {'A', 'R', 'R', 'O', 'W', '1', 0, 0};
+const std::uint32_t CONTINUATION = 0xFFFFFFFF;
+const std::int16_t METADATA_V5 = 4;
+
+// Объединение MessageHeader
+const std::uint8_t HEADER_SCHEMA = 1;
+const std::uint8_t HEADER_DICTIONARY = 2;
+const std::uint8_t HEADER_RECORD_BATCH = 3;
+
+// Объединение Type
+const std::uint8_t TYPE_INT = 2;
+const std::uint8_t TYPE_FLOATING_POINT = 3;
+const std::uint8_t TYPE_LIST = 12;
+const std::uint8_t TYPE_STRUCT = 13;
+const std::int16_t PRECISION_DOUBLE = 2;
+
+// Узлы и буферы записи в порядке обхода полей схемы:
+// type (validity, data), vertices (validity, offsets), struct (validity),
+// x (validity, data), y (validity, data)
+const size_t NODES = 5;
+const size_t BUFFERS = 9;
+
+size_t align8(size_t n) {
+    return (n + 7) & ~size_t(7);
+}
+
+// Построитель FlatBuffers. Объекты пишутся от корня к листьям: смещение
+// на дочерний объект беззнаковое и указывает только вперёд, поэтому на
+// месте ссылки оставляется заглушка, которая заполняется после записи
+// потомка. Таблица вида добавляется перед своей таблицей
+class FlatBuilder
+{
+    public:
+        using Ref = std::function<size_t(FlatBuilder&)>;
+
+        // Поле таблицы: скаляр размера size или ссылка child
+        struct Slot {
+            unsigned id;
+            unsigned size;
+            std::uint64_t value;
+            Ref child;
+        };
+
+        static Slot scalar(unsigned id, unsigned size, std::uint64_t value) {
+            return Slot{id, size, value, nullptr};
+        }
+        static Slot ref(unsigned id, Ref child) {
+            return Slot{id, 4, 0, std::move(child)};
+        }
+
+        size_t table(const std::vector<Slot>& slots) {
+            // Поля по убыванию размера ложатся без лишних дыр; начало
+            // таблицы выровнено на 8
+            std::vector<size_t> order(slots.size());
+            for (size_t i = 0; i < order.size(); ++i) order[i] = i;
+            std::stable_sort(order.begin(), order.end(),
+                             [&](size_t a, size_t b) { return slots[a].size > slots[b].size; });
+            std::vector<size_t> where(slots.size());
+            size_t inline_ = 4;
+            unsigned fields = 0;
+            for (size_t i : order) {
+                inline_ = (inline_ + slots[i].size - 1) / slots[i].size * slots[i].size;
+                where[i] = inline_;
+                inline_ += slots[i].size;
+                fields = std::max(fields, slots[i].id + 1);
+            }
+
+            pad(2);
+            size_t vtable = buf.size();
+            put<std::uint16_t>(static_cast<std::uint16_t>(4 + 2 * fields));
+            put<std::uint16_t>(static_cast<std::uint16_t>(inline_));
+            std::vector<std::uint16_t> offsets(fields, 0);
+            for (size_t i = 0; i < slots.size(); ++i) {
+                offsets[slots[i].id] = static_cast<std::uint16_t>(where[i]);
+            }
+            for (std::uint16_t off : offsets) {
+                put(off);
+            }
+            pad(8);
+            size_t start = buf.size();
+            buf.append(inline_, '\0');
+            std::int32_t back = static_cast<std::int32_t>(start - vtable);
+            std::memcpy(&buf[start], &back, 4);
+            for (size_t i = 0; i < slots.size(); ++i) {
+                if (!slots[i].child) {
+                    std::memcpy(&buf[start + where[i]], &slots[i].value, slots[i].size);
+                }
+            }
+            for (size_t i = 0; i < slots.size(); ++i) {
+                if (slots[i].child) {
+                    size_t target = slots[i].child(*this);
+                    patch(start + where[i], target);
+                }
+            }
+            return start;
+        }
+
+        size_t string(const std::string& s) {
+            size_t at = put(static_cast<std::uint32_t>(s.size()));
+            buf += s;
+            buf.push_back('\0');
+            return at;
+        }
+
+        // Вектор структур с выравниванием 8
+        size_t structs(const void* items, size_t count, size_t itemSize) {
+            pad(8);
+            buf.append(4, '\0');
+            size_t at = put(static_cast<std::uint32_t>(count));
+            if (count > 0) {
+                buf.append(static_cast<const char*>(items), count * itemSize);
+            }
+            return at;
+        }
+
+        size_t tables(const std::vector<Ref>& items) {
+            size_t at = put(static_cast<std::uint32_t>(items.size()));
+            std::vector<size_t> slots;
+            for (size_t i = 0; i < items.size(); ++i) {
+                slots.push_back(put<std::uint32_t>(0));
+            }
+            for (size_t i = 0; i < items.size(); ++i) {
+                patch(slots[i], items[i](*this));
+            }
+            return at;
+        }
+
+        // Буфер с корневой таблицей root, дополненный до кратного 8 размера
+        std::string finish(const Ref& root) {
+            buf.clear();
+            size_t at = put<std::uint32_t>(0);
+            patch(at, root(*this));
+            pad(8);
+            return std::move(buf);
+        }
+    private:
+        std::string buf;
+
+        void pad(size_t alignment) {
+            buf.append((alignment - buf.size() % alignment) % alignment, '\0');
+        }
+        template <typename T>
+        size_t put(T v) {
+            pad(sizeof(T));
+            size_t at = buf.size();
+            buf.append(reinterpret_cast<const char*>(&v), sizeof(T));
+            return at;
+        }
+        void patch(size_t at, size_t target) {
+            std::uint32_t rel = static_cast<std::uint32_t>(target - at);
+            std::memcpy(&buf[at], &rel, 4);
+        }
+};
+
+using Ref = FlatBuilder::Ref;
+using Slot = FlatBuilder::Slot;
+
+Ref table(std::vector<Slot> slots) {
+    return [slots](FlatBuilder& b) { return b.table(slots); };
+}
+
+Ref field(const std::string& name, std::uint8_t type, Ref typeTable, std::vector<Ref> children) {
+    return table({
+        FlatBuilder::ref(0, [name](FlatBuilder& b) { return b.string(name); }),
+        FlatBuilder::scalar(1, 1, 0),                 // nullable = false
+        FlatBuilder::scalar(2, 1, type),
+        FlatBuilder::ref(3, typeTable),
+        FlatBuilder::ref(5, [children](FlatBuilder& b) { return b.tables(children); })
+    });
+}
+
+Ref schemaTable() {
+    Ref uint8Type = table({FlatBuilder::scalar(0, 4, 8), FlatBuilder::scalar(1, 1, 0)});
+    Ref doubleType = table({FlatBuilder::scalar(0, 2, PRECISION_DOUBLE)});
+    Ref point = field("item", TYPE_STRUCT, table({}), {
+        field("x", TYPE_FLOATING_POINT, doubleType, {}),
+        field("y", TYPE_FLOATING_POINT, doubleType, {})
+    });
+    Ref fields = [=](FlatBuilder& b) {
+        return b.tables({
+            field("type", TYPE_INT, uint8Type, {}),
+            field("vertices", TYPE_LIST, table({}), {point})
+        });
+    };
+    return table({FlatBuilder::scalar(0, 2, 0), FlatBuilder::ref(1, fields)});
+}
+
+std::string messageBytes(std::uint8_t header, Ref body, size_t bodyLength) {
+    FlatBuilder b;
+    return b.finish(table({
+        FlatBuilder::scalar(0, 2, METADATA_V5),
+        FlatBuilder::scalar(1, 1, header),
+        FlatBuilder::ref(2, body),
+        FlatBuilder::scalar(3, 8, bodyLength)
+    }));
+}
+
+// Блок оглавления файла (структура Block)
+struct Block {
+    std::int64_t offset;
+    std::int32_t metaDataLength;
+    std::int32_t padding;
+    std::int64_t bodyLength;
+};
+
+struct BufferSpec {
+    std::int64_t offset;
+    std::int64_t length;
+};
+
+struct FieldNode {
+    std::int64_t length;
+    std::int64_t nullCount;
+};
+
+class ArrowWriter
+{
+    private:
+        std::ostream& os;
+        size_t written = 0;
+    public:
+        explicit ArrowWriter(std::ostream& out) : os(out) {}
+
+        size_t position() const {
+            return written;
+        }
+        void write(const void* p, size_t n) {
+            os.write(static_cast<const char*>(p), static_cast<std::streamsize>(n));
+            written += n;
+        }
+        void pad() {
+            static const char zeros[8] = {};
+            write(zeros, align8(written) - written);
+        }
+        // Сообщение: признак продолжения, длина метаданных, метаданные.
+        // Возвращает длину вместе с префиксом
+        size_t message(const std::string& meta) {
+            std::int32_t length = static_cast<std::int32_t>(meta.size());
+            write(&CONTINUATION, 4);
+            write(&length, 4);
+            write(meta.data(), meta.size());
+            return 8 + meta.size();
+        }
+};
+
+// ---- Чтение ----
+
+void corrupted() {
+    throw std::runtime_error("Corrupted Arrow data");
+}
+
+template <typename T>
+T load(const unsigned char* base, size_t size, size_t at) {
+    if (at > size || size - at < sizeof(T)) corrupted();
+    T v;
+    std::memcpy(&v, base + at, sizeof(T));
+    return v;
+}
+
+// Таблица FlatBuffers с проверкой всех смещений по границам буфера
+struct FlatTable {
+    const unsigned char* base = nullptr;
+    size_t size = 0;
+    size_t pos = 0;
+
+    static FlatTable root(const unsigned char* base, size_t size) {
+        FlatTable t{base, size, 0};
+        t.pos = t.follow(0);
+        return t;
+    }
+
+    size_t follow(size_t at) const {
+        size_t target = at + load<std::uint32_t>(base, size, at);
+        if (target >= size) corrupted();
+        return target;
+    }
+
+    // Положение поля id в буфере или 0, если поля нет
+    size_t field(unsigned id) const {
+        std::int64_t vtable = static_cast<std::int64_t>(pos) - load<std::int32_t>(base, size, pos);
+        if (vtable < 0 || static_cast<size_t>(vtable) >= size) corrupted();
+        size_t vt = static_cast<size_t>(vtable);
+        std::uint16_t vsize = load<std::uint16_t>(base, size, vt);
+        std::uint16_t tsize = load<std::uint16_t>(base, size, vt + 2);
+        if (vsize < 4 || pos + tsize > size) corrupted();
+        if (4 + 2 * id + 2 > vsize) return 0;
+        std::uint16_t off = load<std::uint16_t>(base, size, vt + 4 + 2 * id);
+        if (off >= tsize && off != 0) corrupted();
+        return off ? pos + off : 0;
+    }
+
+    template <typename T>
+    T scalar(unsigned id, T fallback) const {
+        size_t at = field(id);
+        return at ? load<T>(base, size, at) : fallback;
+    }
+
+    bool table(unsigned id, FlatTable& out) const {
+        size_t at = field(id);
+        if (!at) return false;
+        out = FlatTable{base, size, follow(at)};
+        return true;
+    }
+
+    // Начало элементов и их число; false, если вектора нет
+    bool vector(unsigned id, size_t itemSize, size_t& items, size_t& count) const {
+        size_t at = field(id);
+        if (!at) return false;
+        size_t v = follow(at);
+        count = load<std::uint32_t>(base, size, v);
+        items = v + 4;
+        if (count > (size - items) / itemSize) corrupted();
+        return true;
+    }
+
+    // i-я таблица вектора таблиц
+    FlatTable element(size_t items, size_t i) const {
+        return FlatTable{base, size, follow(items + 4 * i)};
+    }
+};
+
+std::vector<FlatTable> children(const FlatTable& field) {
+    std::vector<FlatTable> out;
+    size_t items, count;
+    if (field.vector(5, 4, items, count)) {
+        for (size_t i = 0; i < count; ++i) out.push_back(field.element(items, i));
+    }
+    return out;
+}
+
+bool isDouble(const FlatTable& field) {
+    FlatTable type;
+    return field.scalar<std::uint8_t>(2, 0) == TYPE_FLOATING_POINT && field.table(3, type) &&
+           type.scalar<std::int16_t>(0, 0) == PRECISION_DOUBLE && children(field).empty();
+}
+
+void checkSchema(const FlatTable& schema) {
+    bool ok = schema.scalar<std::int16_t>(0, 0) == 0;   // little-endian
+    size_t items, count;
+    if (ok && schema.vector(1, 4, items, count) && count == 2) {
+        FlatTable kind = schema.element(items, 0);
+        FlatTable vertices = schema.element(items, 1);
+        FlatTable type, unused;
+        ok = kind.scalar<std::uint8_t>(2, 0) == TYPE_INT && kind.table(3, type) &&
+             type.scalar<std::int32_t>(0, 0) == 8 && !type.scalar<std::uint8_t>(1, 0) &&
+             !kind.table(4, unused) && !vertices.table(4, unused) &&
+             vertices.scalar<std::uint8_t>(2, 0) == TYPE_LIST;
+        std::vector<FlatTable> item = children(vertices);
+        ok = ok && item.size() == 1 && item[0].scalar<std::uint8_t>(2, 0) == TYPE_STRUCT;
+        std::vector<FlatTable> xy = ok ? children(item[0]) : std::vector<FlatTable>{};
+        ok = ok && xy.size() == 2 && isDouble(xy[0]) && isDouble(xy[1]);
+    } else {
+        ok = false;
+    }
+    if (!ok) {
+        throw std::runtime_error("Unsupported Arrow schema: expected "
+                                 "type: uint8, vertices: list<struct<x: double, y: double>>");
+    }
+}
+
+struct Message {
+    std::uint8_t type = 0;
+    FlatTable header;
+    size_t body = 0;
+    size_t bodyLength = 0;
+    size_t end = 0;   // 0 — признак конца потока
+};
+
+// Сообщение, начинающееся в позиции at
+Message readMessage(const unsigned char* data, size_t bytes, size_t at) {
+    Message m;
+    std::uint32_t length = load<std::uint32_t>(data, bytes, at);
+    size_t meta = at + 4;
+    if (length == CONTINUATION) {
+        length = load<std::uint32_t>(data, bytes, meta);
+        meta += 4;
+    }
+    if (length == 0) {
+        return m;
+    }
+    if (length > bytes - meta) corrupted();
+    FlatTable message = FlatTable::root(data + meta, length);
+    std::int16_t version = message.scalar<std::int16_t>(0, 0);
+    std::int64_t bodyLength = message.scalar<std::int64_t>(3, 0);
+    m.type = message.scalar<std::uint8_t>(1, 0);
+    if (version < 3 || !message.table(2, m.header)) {
+        throw std::runtime_error("Unsupported Arrow metadata version");
+    }
+    m.body = meta + length;
+    if (bodyLength < 0 || static_cast<std::uint64_t>(bodyLength) > bytes - m.body) corrupted();
+    m.bodyLength = static_cast<size_t>(bodyLength);
+    m.end = m.body + m.bodyLength;
+    return m;
+}
+
+// Указатель на буфер записи: на месте, если он выровнен, иначе копия
+template <typename T>
+const T* bufferAt(const unsigned char* p, size_t count,
+                  std::vector<std::vector<std::uint64_t>>& copies, bool& inPlace) {
+    if (reinterpret_cast<std::uintptr_t>(p) % alignof(T) == 0) {
+        return reinterpret_cast<const T*>(p);
+    }
+    inPlace = false;
+    copies.emplace_back((count * sizeof(T) + 7) / 8);
+    std::memcpy(copies.back().data(), p, count * sizeof(T));
+    return reinterpret_cast<const T*>(copies.back().data());
+}
+
+ArrowBatchView decodeBatch(const Message& m, const unsigned char* data,
+                           std::vector<std::vector<std::uint64_t>>& copies, bool& inPlace) {
+    const FlatTable& batch = m.header;
+    FlatTable unused;
+    if (batch.table(3, unused)) {
+        throw std::runtime_error("Compressed Arrow record batches are not supported");
+    }
+    std::int64_t length = batch.scalar<std::int64_t>(0, 0);
+    size_t nodeItems, nodeCount, bufferItems, bufferCount;
+    if (!batch.vector(1, sizeof(FieldNode), nodeItems, nodeCount) || nodeCount != NODES ||
+        !batch.vector(2, sizeof(BufferSpec), bufferItems, bufferCount) || bufferCount != BUFFERS) {
+        throw std::runtime_error("Arrow record batch does not match the figure schema");
+    }
+    FieldNode nodes[NODES];
+    std::memcpy(nodes, batch.base + nodeItems, sizeof(nodes));
+    for (const FieldNode& node : nodes) {
+        if (node.nullCount != 0) {
+            throw std::runtime_error("Null values in Arrow figure data are not supported");
+        }
+    }
+    std::int64_t apexes = nodes[2].length;
+    if (length < 0 || nodes[0].length != length || nodes[1].length != length || apexes < 0 ||
+        nodes[3].length != apexes || nodes[4].length != apexes) {
+        corrupted();
+    }
+    BufferSpec buffers[BUFFERS];
+    std::memcpy(buffers, batch.base + bufferItems, sizeof(buffers));
+    for (const BufferSpec& b : buffers) {
+        if (b.offset < 0 || b.length < 0 || static_cast<std::uint64_t>(b.offset) > m.bodyLength ||
+            static_cast<std::uint64_t>(b.length) > m.bodyLength - b.offset) {
+            corrupted();
+        }
+    }
+    size_t n = static_cast<size_t>(length);
+    size_t v = static_cast<size_t>(apexes);
+    if (static_cast<size_t>(buffers[1].length) < n ||
+        static_cast<size_t>(buffers[3].length) / 4 < n + 1 ||
+        static_cast<size_t>(buffers[6].length) / 8 < v ||
+        static_cast<size_t>(buffers[8].length) / 8 < v) {
+        corrupted();
+    }
+    const unsigned char* body = data + m.body;
+    ArrowBatchView view;
+    view.length = n;
+    view.kinds = body + buffers[1].offset;
+    view.offsets = bufferAt<std::int32_t>(body + buffers[3].offset, n + 1, copies, inPlace);
+    view.xs = bufferAt<double>(body + buffers[6].offset, v, copies, inPlace);
+    view.ys = bufferAt<double>(body + buffers[8].offset, v, copies, inPlace);
+    for (size_t i = 0; i < n; ++i) {
+        if (view.offsets[i] < 0 || view.offsets[i] > view.offsets[i + 1]) corrupted();
+    }
+    if (static_cast<size_t>(view.offsets[n]) > v) corrupted();
+    return view;
+}
+
+} // namespace
+
+void writeArrow(std::ostream& os, const FigureBuffer& figures, const ArrowOptions& opts) {
+    if (opts.batchSize == 0) {
+        throw std::invalid_argument("Arrow batch size must be positive");
+    }
+    ArrowWriter out(os);
+    if (opts.file) {
+        out.write(MAGIC, sizeof(MAGIC));
+    }
+    out.message(messageBytes(HEADER_SCHEMA, schemaTable(), 0));
+
+    std::vector<Block> blocks;
+    std::vector<std::int32_t> offsets;
+    std::vector<std::uint8_t> kinds;
+    const size_t maxApexes = static_cast<size_t>(std::numeric_limits<std::int32_t>::max());
+    for (size_t first = 0; first < figures.size(); ) {
+        // Запись ограничена batchSize фигурами и 2^31 - 1 вершинами (смещения int32)
+        size_t last = first;
+        size_t base = figures.xs(first) - figures.xs(0);
+        size_t apexes = 0;
+        while (last < figures.size() && last - first < opts.batchSize &&
+               apexes + figures.apexCount(last) <= maxApexes) {
+            apexes += figures.apexCount(last++);
+        }
+        if (last == first) {
+            throw std::runtime_error("Figure has too many vertices for an Arrow list");
+        }
+        size_t n = last - first;
+        kinds.resize(n);
+        offsets.resize(n + 1);
+        offsets[0] = 0;
+        for (size_t i = 0; i < n; ++i) {
+            kinds[i] = static_cast<std::uint8_t>(figures.kind(first + i));
+            offsets[i + 1] = offsets[i] + static_cast<std::int32_t>(figures.apexCount(first + i));
+        }
+
+        BufferSpec buffers[BUFFERS];
+        FieldNode nodes[NODES] = {{static_cast<std::int64_t>(n), 0}, {static_cast<std::int64_t>(n), 0},
+                                  {static_cast<std::int64_t>(apexes), 0}, {static_cast<std::int64_t>(apexes), 0},
+                                  {static_cast<std::int64_t>(apexes), 0}};
+        const size_t sizes[BUFFERS] = {0, n, 0, 4 * (n + 1), 0, 0, 8 * apexes, 0, 8 * apexes};
+        size_t bodyLength = 0;
+        for (size_t i = 0; i < BUFFERS; ++i) {
+            buffers[i] = BufferSpec{static_cast<std::int64_t>(bodyLength), static_cast<std::int64_t>(sizes[i])};
+            bodyLength += align8(sizes[i]);
+        }
+        Ref batch = [&](FlatBuilder& b) {
+            return b.table({
+                FlatBuilder::scalar(0, 8, n),
+                FlatBuilder::ref(1, [&](FlatBuilder& v) { return v.structs(nodes, NODES, sizeof(FieldNode)); }),
+                FlatBuilder::ref(2, [&](FlatBuilder& v) { return v.structs(buffers, BUFFERS, sizeof(BufferSpec)); })
+            });
+        };
+        Block block{static_cast<std::int64_t>(out.position()), 0, 0, static_cast<std::int64_t>(bodyLength)};
+        block.metaDataLength = static_cast<std::int32_t>(out.message(messageBytes(HEADER_RECORD_BATCH, batch, bodyLength)));
+        blocks.push_back(block);
+
+        // Тело: массивы координат пишутся прямо из буфера фигур
+        out.write(kinds.data(), n);
+        out.pad();
+        out.write(offsets.data(), 4 * (n + 1));
+        out.pad();
+        out.write(figures.xs(0) + base, 8 * apexes);
+        out.write(figures.ys(0) + base, 8 * apexes);
+        first = last;
+    }
+    const std::uint32_t eos[2] = {CONTINUATION, 0};
+    out.write(eos, sizeof(eos));
+
+    if (opts.file) {
+        FlatBuilder b;
+        std::string footer = b.finish(table({
+            FlatBuilder::scalar(0, 2, METADATA_V5),
+            FlatBuilder::ref(1, schemaTable()),
+            FlatBuilder::ref(2, [](FlatBuilder& v) { return v.structs(nullptr, 0, sizeof(Block)); }),
+            FlatBuilder::ref(3, [&](FlatBuilder& v) { return v.structs(blocks.data(), blocks.size(), sizeof(Block)); })
+        }));
+        std::int32_t length = static_cast<std::int32_t>(footer.size());
+        out.write(footer.data(), footer.size());
+        out.write(&length, 4);
+        out.write(MAGIC, 6);
+    }
+    if (!os) {
+        throw std::runtime_error("Failed to write Arrow data");
+    }
+}
+
+ArrowReader::ArrowReader(std::istream& is) {
+    size_t used = 0;
+    while (is) {
+        if (storage.size() * 8 - used < (1 << 16)) {
+            storage.resize(std::max<size_t>(storage.size() * 2, (used + (1 << 16)) / 8 + 1));
+        }
+        is.read(reinterpret_cast<char*>(storage.data()) + used,
+                static_cast<std::streamsize>(storage.size() * 8 - used));
+        used += static_cast<size_t>(is.gcount());
+    }
+    data = reinterpret_cast<const unsigned char*>(storage.data());
+    bytes = used;
+    parse();
+}
+
+ArrowReader::ArrowReader(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Cannot open file: " + path);
+    }
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+        ::close(fd);
+        throw std::runtime_error("Cannot stat file: " + path);
+    }
+    bytes = static_cast<size_t>(st.st_size);
+    if (bytes > 0) {
+        mapped = ::mmap(nullptr, bytes, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    ::close(fd);
+    if (mapped == MAP_FAILED) {
+        mapped = nullptr;
+        throw std::runtime_error("Cannot map file: " + path);
+    }
+    data = static_cast<const unsigned char*>(mapped);
+    try {
+        parse();
+    } catch (...) {
+        if (mapped) ::munmap(mapped, bytes);
+        throw;
+    }
+}
+
+ArrowReader::~ArrowReader() {
+    if (mapped) {
+        ::munmap(mapped, bytes);
+    }
+}
+
+void ArrowReader::parse() {
+    bool file = bytes >= 8 && std::memcmp(data, MAGIC, 6) == 0;
+    if (file) {
+        // Файл: записи берутся по оглавлению в конце
+        if (bytes < 8 + 10 || std::memcmp(data + bytes - 6, MAGIC, 6) != 0) corrupted();
+        std::uint32_t length = load<std::uint32_t>(data, bytes, bytes - 10);
+        if (length > bytes - 18) corrupted();
+        FlatTable footer = FlatTable::root(data + bytes - 10 - length, length);
+        FlatTable schema;
+        if (!footer.table(1, schema)) corrupted();
+        checkSchema(schema);
+        size_t items, count;
+        if (footer.vector(2, sizeof(Block), items, count) && count > 0) {
+            throw std::runtime_error("Dictionary-encoded Arrow data is not supported");
+        }
+        if (footer.vector(3, sizeof(Block), items, count)) {
+            for (size_t i = 0; i < count; ++i) {
+                Block block;
+                std::memcpy(&block, footer.base + items + i * sizeof(Block), sizeof(Block));
+                if (block.offset < 0 || static_cast<std::uint64_t>(block.offset) >= bytes) corrupted();
+                Message m = readMessage(data, bytes, static_cast<size_t>(block.offset));
+                if (m.type != HEADER_RECORD_BATCH) corrupted();
+                batches.push_back(decodeBatch(m, data, copies, inPlace));
+            }
+        }
+    } else {
+        bool schemaSeen = false;
+        for (size_t at = 0; at < bytes; ) {
+            Message m = readMessage(data, bytes, at);
+            if (m.end == 0) break;
+            if (m.type == HEADER_SCHEMA) {
+                checkSchema(m.header);
+                schemaSeen = true;
+            } else if (m.type == HEADER_DICTIONARY) {
+                throw std::runtime_error("Dictionary-encoded Arrow data is not supported");
+            } else if (m.type == HEADER_RECORD_BATCH) {
+                if (!schemaSeen) corrupted();
+                batches.push_back(decodeBatch(m, data, copies, inPlace));
+            }
+            at = m.end;
+        }
+        if (!schemaSeen) {
+            throw std::runtime_error("Arrow stream has no schema");
+        }
+    }
+    for (const ArrowBatchView& b : batches) {
+        figures += b.length;
+    }
+}
+
+size_t ArrowReader::figureCount() const {
+    return figures;
+}
+
+size_t ArrowReader::batchCount() const {
+    return batches.size();
+}
+
+const ArrowBatchView& ArrowReader::batch(size_t i) const {
+    if (i >= batches.size()) {
+        throw std::out_of_range("Arrow batch index out of range");
+    }
+    return batches[i];
+}
+
+bool ArrowReader::zeroCopy() const {
+    return inPlace;
+}
+
+void ArrowReader::readBatch(size_t i, FigureBuffer& out) const {
+    const ArrowBatchView& b = batch(i);
+    for (size_t j = 0; j < b.length; ++j) {
+        size_t first = static_cast<size_t>(b.offsets[j]);
+        size_t n = static_cast<size_t>(b.offsets[j + 1]) - first;
+        if (!isValidKind(b.kinds[j])) {
+            throw std::runtime_error("Unknown figure type code in Arrow data: " + std::to_string(b.kinds[j]));
+        }
+        FigureKind kind = static_cast<FigureKind>(b.kinds[j]);
+        if (kind == FigureKind::Polygon ? n < 3 : n != kindApexCount(kind)) {
+            throw std::runtime_error("Wrong vertex count for " + std::string(kindName(kind)) + " in Arrow data");
+        }
+        out.push(kind, b.xs + first, b.ys + first, n);
+    }
+}
+
+FigureBuffer ArrowReader::readAll() const {
+    FigureBuffer out;
+    size_t apexes = 0;
+    for (const ArrowBatchView& b : batches) {
+        apexes += static_cast<size_t>(b.offsets[b.length] - b.offsets[0]);
+    }
+    out.reserve(figures, apexes);
+    for (size_t i = 0; i < batches.size(); ++i) {
+        readBatch(i, out);
+    }
+    return out;
+}
@@ -0,0 +1,117 @@
+#include "../include/bulk_loader.hpp"
+#include "../include/text_format.hpp"
+#include <algorithm>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+// Не делим вход мельче, чем на куски такого размера
+const size_t MIN_CHUNK = 1 << 16;
+
+} // namespace
+
+FigureBuffer parseFiguresParallel(const char* begin, const char* end, unsigned threads) {
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    size_t total = static_cast<size_t>(end - begin);
+    size_t chunks = std::min<size_t>(threads, std::max<size_t>(1, total / MIN_CHUNK));
+
+    // Границы кусков сдвигаются вперёд до ближайшего перевода строки
+    std::vector<const char*> bounds{begin};
+    for (size_t i = 1; i < chunks; ++i) {
+        const char* p = std::max(begin + total * i / chunks, bounds.back());
+        const char* eol = static_cast<const char*>(std::memchr(p, '\n', end - p));
+        bounds.push_back(eol ? eol + 1 : end);
+    }
+    bounds.push_back(end);
+
+    std::vector<FigureBuffer> parts(chunks);
+    std::vector<std::exception_ptr> errors(chunks);
+    auto work = [&](size_t i) {
+        try {
+            parseFigures(bounds[i], bounds[i + 1], parts[i]);
+        } catch (...) {
+            errors[i] = std::current_exception();
+        }
+    };
+    std::vector<std::thread> pool;
+    for (size_t i = 1; i < chunks; ++i) {
+        pool.emplace_back(work, i);
+    }
+    work(0);
+    for (auto& t : pool) {
+        t.join();
+    }
+
+    for (size_t i = 0; i < chunks; ++i) {
+        if (errors[i]) {
+            if (i == 0) {
+                std::rethrow_exception(errors[i]);
+            }
+            // Повторный разбор с верным номером первой строки куска
+            size_t firstLine = 1 + static_cast<size_t>(std::count(begin, bounds[i], '\n'));
+            FigureBuffer scratch;
+            parseFigures(bounds[i], bounds[i + 1], scratch, firstLine);
+            std::rethrow_exception(errors[i]);
+        }
+    }
+
+    size_t figures = 0;
+    size_t apexes = 0;
+    for (const auto& part : parts) {
+        figures += part.size();
+        apexes += part.apexTotal();
+    }
+    FigureBuffer out;
+    out.reserve(figures, apexes);
+    for (const auto& part : parts) {
+        out.append(part);
+    }
+    return out;
+}
+
+FigureBuffer loadFigures(const std::string& path, unsigned threads) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Cannot open " + path);
+    }
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+        ::close(fd);
+        throw std::runtime_error("Cannot stat " + path);
+    }
+    size_t size = static_cast<size_t>(st.st_size);
+    if (size == 0) {
+        ::close(fd);
+        return FigureBuffer();
+    }
+    void* data = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (data == MAP_FAILED) {
+        // Например, для каналов: читаем обычным образом
+        std::ifstream in(path, std::ios::binary);
+        std::string text((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        return parseFiguresParallel(text.data(), text.data() + text.size(), threads);
+    }
+    ::madvise(data, size, MADV_SEQUENTIAL);
+    const char* begin = static_cast<const char*>(data);
+    try {
+        FigureBuffer out = parseFiguresParallel(begin, begin + size, threads);
+        ::munmap(data, size);
+        return out;
+    } catch (...) {
+        ::munmap(data, size);
+        throw;
+    }
+}
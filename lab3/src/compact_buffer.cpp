@@ -0,0 +1,258 @@
+#include "../include/compact_buffer.hpp"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <stdexcept>
+
+namespace {
+
+const double PI = 3.14159265358979323846;
+
+// Единичные вершины правильного n-угольника: cos и sin угла 2πk/n
+struct UnitPolygon {
+    std::array<double, 6> cos;
+    std::array<double, 6> sin;
+    double areaFactor;   // n/2 · sin(2π/n)
+};
+
+const UnitPolygon& unitPolygon(FigureKind kind) {
+    static const std::array<UnitPolygon, 2> units = [] {
+        std::array<UnitPolygon, 2> u{};
+        for (size_t m = 0; m < 2; ++m) {
+            size_t n = 5 + m;
+            for (size_t k = 0; k < n; ++k) {
+                u[m].cos[k] = std::cos(2.0 * PI * k / n);
+                u[m].sin[k] = std::sin(2.0 * PI * k / n);
+            }
+            u[m].areaFactor = 0.5 * n * std::sin(2.0 * PI / n);
+        }
+        return u;
+    }();
+    return units[kind == FigureKind::Pentagon ? 0 : 1];
+}
+
+bool isRegularKind(FigureKind kind) {
+    return kind == FigureKind::Pentagon || kind == FigureKind::Hexagon;
+}
+
+} // namespace
+
+double RegularShape::radius() const {
+    return std::hypot(rc, rs);
+}
+
+double RegularShape::phase() const {
+    return std::atan2(rs, rc);
+}
+
+void expandRegular(FigureKind kind, const RegularShape& shape, double* xs, double* ys) {
+    const UnitPolygon& u = unitPolygon(kind);
+    for (size_t k = 0; k < kindApexCount(kind); ++k) {
+        xs[k] = shape.cx + shape.rc * u.cos[k] - shape.rs * u.sin[k];
+        ys[k] = shape.cy + shape.rs * u.cos[k] + shape.rc * u.sin[k];
+    }
+}
+
+double regularArea(FigureKind kind, const RegularShape& shape) {
+    return unitPolygon(kind).areaFactor * (shape.rc * shape.rc + shape.rs * shape.rs);
+}
+
+bool detectRegular(FigureKind kind, const double* xs, const double* ys, double tolerance, RegularShape& out) {
+    if (!isRegularKind(kind)) return false;
+    size_t n = kindApexCount(kind);
+    RegularShape shape;
+    for (size_t k = 0; k < n; ++k) {
+        shape.cx += xs[k];
+        shape.cy += ys[k];
+    }
+    shape.cx /= n;
+    shape.cy /= n;
+    shape.rc = xs[0] - shape.cx;
+    shape.rs = ys[0] - shape.cy;
+    double r2 = shape.rc * shape.rc + shape.rs * shape.rs;
+    if (!(r2 > 0.0) || !std::isfinite(r2)) return false;
+
+    // Сравнение квадратов расстояний: без корня на вершину
+    double ex[6], ey[6];
+    expandRegular(kind, shape, ex, ey);
+    double limit = tolerance * tolerance * r2;
+    for (size_t k = 0; k < n; ++k) {
+        double dx = ex[k] - xs[k];
+        double dy = ey[k] - ys[k];
+        if (!(dx * dx + dy * dy <= limit)) return false;
+    }
+    out = shape;
+    return true;
+}
+
+CompactBuffer::CompactBuffer(double tolerance) : tolerance(tolerance) {}
+
+void CompactBuffer::push(FigureKind kind, const double* xs, const double* ys, size_t n) {
+    if (shapes.size() >= REGULAR || others.size() >= REGULAR) {
+        throw std::length_error("CompactBuffer holds at most 2^31 figures of each representation");
+    }
+    RegularShape shape;
+    if (detectRegular(kind, xs, ys, tolerance, shape)) {
+        refs.push_back(static_cast<std::uint32_t>(shapes.size()) | REGULAR);
+        shapes.push_back(shape);
+    } else {
+        refs.push_back(static_cast<std::uint32_t>(others.size()));
+        others.push(kind, xs, ys, n);
+    }
+    kinds.push_back(kind);
+}
+
+void CompactBuffer::append(const FigureBuffer& figures) {
+    // Место под параметры — по числу пяти- и шестиугольников: на данных,
+    // где правильных фигур большинство, массив не перевыделяется
+    size_t candidates = 0;
+    for (size_t i = 0; i < figures.size(); ++i) {
+        candidates += isRegularKind(figures.kind(i));
+    }
+    kinds.reserve(kinds.size() + figures.size());
+    refs.reserve(refs.size() + figures.size());
+    shapes.reserve(shapes.size() + candidates);
+    for (size_t i = 0; i < figures.size(); ++i) {
+        push(figures.kind(i), figures.xs(i), figures.ys(i), figures.apexCount(i));
+    }
+}
+
+void CompactBuffer::clear() {
+    kinds.clear();
+    refs.clear();
+    shapes.clear();
+    others.clear();
+}
+
+size_t CompactBuffer::size() const {
+    return kinds.size();
+}
+
+size_t CompactBuffer::regularCount() const {
+    return shapes.size();
+}
+
+FigureKind CompactBuffer::kind(size_t i) const {
+    return kinds[i];
+}
+
+size_t CompactBuffer::apexCount(size_t i) const {
+    return isRegular(i) ? kindApexCount(kinds[i]) : others.apexCount(refs[i]);
+}
+
+bool CompactBuffer::isRegular(size_t i) const {
+    return (refs[i] & REGULAR) != 0;
+}
+
+const RegularShape& CompactBuffer::shape(size_t i) const {
+    return shapes[refs[i] & ~REGULAR];
+}
+
+double CompactBuffer::area(size_t i) const {
+    return isRegular(i) ? regularArea(kinds[i], shape(i)) : others.area(refs[i]);
+}
+
+std::pair<double, double> CompactBuffer::center(size_t i) const {
+    if (isRegular(i)) {
+        const RegularShape& s = shape(i);
+        return {s.cx, s.cy};
+    }
+    return others.center(refs[i]);
+}
+
+void CompactBuffer::areas(double* out) const {
+    const double pentagon = unitPolygon(FigureKind::Pentagon).areaFactor;
+    const double hexagon = unitPolygon(FigureKind::Hexagon).areaFactor;
+    for (size_t i = 0; i < size(); ++i) {
+        if (isRegular(i)) {
+            const RegularShape& s = shape(i);
+            out[i] = (kinds[i] == FigureKind::Pentagon ? pentagon : hexagon) * (s.rc * s.rc + s.rs * s.rs);
+        } else {
+            out[i] = others.area(refs[i]);
+        }
+    }
+}
+
+void CompactBuffer::vertices(size_t i, double* xs, double* ys) const {
+    if (isRegular(i)) {
+        expandRegular(kinds[i], shape(i), xs, ys);
+        return;
+    }
+    size_t ref = refs[i];
+    const double* srcX = others.xs(ref);
+    const double* srcY = others.ys(ref);
+    std::copy(srcX, srcX + others.apexCount(ref), xs);
+    std::copy(srcY, srcY + others.apexCount(ref), ys);
+}
+
+std::unique_ptr<Figure> CompactBuffer::materialize(size_t i) const {
+    if (!isRegular(i)) {
+        return others.materialize(refs[i]);
+    }
+    double xs[6], ys[6];
+    expandRegular(kinds[i], shape(i), xs, ys);
+    return makeFigure(kinds[i], xs, ys);
+}
+
+FigureBuffer CompactBuffer::expand() const {
+    FigureBuffer out;
+    out.reserve(size(), others.apexTotal() + 6 * shapes.size());
+    double xs[6], ys[6];
+    for (size_t i = 0; i < size(); ++i) {
+        if (isRegular(i)) {
+            expandRegular(kinds[i], shape(i), xs, ys);
+            out.push(kinds[i], xs, ys);
+        } else {
+            size_t ref = refs[i];
+            out.push(kinds[i], others.xs(ref), others.ys(ref), others.apexCount(ref));
+        }
+    }
+    return out;
+}
+
+ContainerMemory CompactBuffer::memoryUsage() const {
+    ContainerMemory mem = others.memoryUsage();
+    mem.addBuffer(kinds);
+    mem.addBuffer(refs);
+    mem.addBuffer(shapes);
+    return mem;
+}
+
+CompactBuffer toCompact(const FigureBuffer& figures, double tolerance) {
+    CompactBuffer out(tolerance);
+    out.append(figures);
+    return out;
+}
+
+CompactEstimate estimateCompact(const FigureCollection& figures, double tolerance) {
+    CompactEstimate est;
+    size_t apexes = 0;
+    size_t regularApexes = 0;
+    RegularShape shape;
+    double xs[6], ys[6];
+    figures.forEach([&](const Figure& fig) {
+        size_t n = fig.apexCount();
+        FigureKind kind = kindOf(fig);
+        ++est.figures;
+        apexes += n;
+        if (!isRegularKind(kind)) return;
+        const std::pair<double, double>* apxs = fig.apexData();
+        for (size_t k = 0; k < n; ++k) {
+            xs[k] = apxs[k].first;
+            ys[k] = apxs[k].second;
+        }
+        if (detectRegular(kind, xs, ys, tolerance, shape)) {
+            ++est.regular;
+            regularApexes += n;
+        }
+    });
+    // Раскладка FigureBuffer: виды, смещения (на одно больше фигур), x и y
+    auto flat = [](size_t count, size_t points) {
+        return count * sizeof(FigureKind) + (count + 1) * sizeof(size_t) + 2 * points * sizeof(double);
+    };
+    est.flatBytes = flat(est.figures, apexes);
+    est.compactBytes = est.figures * (sizeof(FigureKind) + sizeof(std::uint32_t)) +
+                       est.regular * sizeof(RegularShape) +
+                       flat(est.figures - est.regular, apexes - regularApexes);
+    return est;
+}
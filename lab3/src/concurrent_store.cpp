@@ -0,0 +1,189 @@
+#include "../include/concurrent_store.hpp"
+#include "../include/parallel.hpp"
+#include <stdexcept>
+#include <unordered_map>
+
+namespace {
+
+std::atomic<std::uint64_t> instances{0};
+
+} // namespace
+
+ConcurrentStore::ConcurrentStore(unsigned shardCount)
+    : instance(instances.fetch_add(1)) {
+    shardCount = resolveThreads(shardCount);
+    for (unsigned i = 0; i < shardCount; ++i) {
+        shards.push_back(std::make_unique<Shard>());
+    }
+}
+
+ConcurrentStore::~ConcurrentStore() {
+    for (auto& shard : shards) {
+        std::uint64_t count = shard->count.load();
+        for (std::uint64_t i = 0; i < count; ++i) {
+            delete slotAt(*shard, i).figure.load();
+        }
+        for (size_t p = 0; p < PAGES; ++p) {
+            Page* page = shard->pages[p].load();
+            if (!page) continue;
+            for (size_t c = 0; c < PAGE; ++c) {
+                delete[] (*page)[c].load();
+            }
+            delete[] page;
+        }
+    }
+}
+
+ConcurrentStore::Slot& ConcurrentStore::slotAt(const Shard& shard, std::uint64_t slot) const {
+    size_t chunk = slot / CHUNK;
+    Page& page = *shard.pages[chunk / PAGE].load(std::memory_order_acquire);
+    return page[chunk % PAGE].load(std::memory_order_acquire)[slot % CHUNK];
+}
+
+std::uint32_t ConcurrentStore::writerShard() {
+    // Каждый поток пишет в «свой» шард, поэтому писатели почти не конкурируют.
+    // Шард запоминается отдельно для каждого хранилища; кэш потока
+    // сбрасывается, если в нём накопились давно удалённые хранилища
+    thread_local std::unordered_map<std::uint64_t, std::uint32_t> affinity;
+    auto it = affinity.find(instance);
+    if (it == affinity.end()) {
+        if (affinity.size() >= AFFINITY_CACHE) {
+            affinity.clear();
+        }
+        it = affinity.emplace(instance, nextShard.fetch_add(1)).first;
+    }
+    return it->second % static_cast<std::uint32_t>(shards.size());
+}
+
+FigureId ConcurrentStore::add(std::unique_ptr<Figure> fig) {
+    std::uint32_t s = writerShard();
+    Shard& shard = *shards[s];
+
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    std::uint64_t slot = shard.count.load(std::memory_order_relaxed);
+    size_t chunk = slot / CHUNK;
+    if (chunk >= PAGE * PAGES) {
+        throw std::length_error("ConcurrentStore shard is full");
+    }
+    std::atomic<Page*>& pageRef = shard.pages[chunk / PAGE];
+    if (!pageRef.load(std::memory_order_relaxed)) {
+        Page* page = new Page[1];
+        for (size_t c = 0; c < PAGE; ++c) {
+            (*page)[c].store(nullptr, std::memory_order_relaxed);
+        }
+        pageRef.store(page, std::memory_order_release);
+    }
+    std::atomic<Slot*>& chunkRef = (*pageRef.load(std::memory_order_relaxed))[chunk % PAGE];
+    if (!chunkRef.load(std::memory_order_relaxed)) {
+        chunkRef.store(new Slot[CHUNK], std::memory_order_release);
+    }
+    slotAt(shard, slot).figure.store(fig.release(), std::memory_order_relaxed);
+    // Публикация: снимок, увидевший новую длину, увидит и содержимое слота
+    shard.count.store(slot + 1, std::memory_order_release);
+    return {s, slot};
+}
+
+bool ConcurrentStore::remove(FigureId id) {
+    if (id.shard >= shards.size() || id.slot >= shards[id.shard]->count.load(std::memory_order_acquire)) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(removeMutex);
+    Slot& slot = slotAt(*shards[id.shard], id.slot);
+    if (slot.removed.load(std::memory_order_relaxed) != UINT64_MAX) {
+        return false;
+    }
+    // Сначала помечаем слот, затем публикуем версию: снимок с версией >= rv
+    // гарантированно увидит пометку
+    std::uint64_t rv = version.load(std::memory_order_relaxed) + 1;
+    slot.removed.store(rv, std::memory_order_relaxed);
+    version.store(rv, std::memory_order_release);
+    retired.emplace_back(id, rv);
+    return true;
+}
+
+FigureSnapshot ConcurrentStore::snapshot() {
+    std::lock_guard<std::mutex> lock(registryMutex);
+    std::uint64_t v = version.load(std::memory_order_acquire);
+    readers.insert(v);
+    std::vector<std::uint64_t> counts;
+    counts.reserve(shards.size());
+    for (const auto& shard : shards) {
+        counts.push_back(shard->count.load(std::memory_order_acquire));
+    }
+    return FigureSnapshot(this, v, std::move(counts));
+}
+
+void ConcurrentStore::release(std::uint64_t snapshotVersion) {
+    std::lock_guard<std::mutex> lock(registryMutex);
+    readers.erase(readers.find(snapshotVersion));
+}
+
+size_t ConcurrentStore::collect() {
+    std::lock_guard<std::mutex> registry(registryMutex);
+    std::lock_guard<std::mutex> lock(removeMutex);
+    // Фигура с версией удаления rv невидима снимкам с версией >= rv
+    std::uint64_t oldest = readers.empty() ? version.load() : *readers.begin();
+    size_t freed = 0;
+    size_t kept = 0;
+    for (const auto& item : retired) {
+        if (item.second <= oldest) {
+            delete slotAt(*shards[item.first.shard], item.first.slot).figure.exchange(nullptr);
+            ++freed;
+        } else {
+            retired[kept++] = item;
+        }
+    }
+    retired.resize(kept);
+    return freed;
+}
+
+FigureSnapshot::FigureSnapshot(ConcurrentStore* owner, std::uint64_t ver, std::vector<std::uint64_t> shardCounts)
+    : store(owner), version(ver), counts(std::move(shardCounts)) {}
+
+FigureSnapshot::FigureSnapshot(FigureSnapshot&& other) noexcept
+    : store(other.store), version(other.version), counts(std::move(other.counts)) {
+    other.store = nullptr;
+}
+
+FigureSnapshot& FigureSnapshot::operator=(FigureSnapshot&& other) noexcept {
+    if (this != &other) {
+        if (store) {
+            store->release(version);
+        }
+        store = other.store;
+        version = other.version;
+        counts = std::move(other.counts);
+        other.store = nullptr;
+    }
+    return *this;
+}
+
+FigureSnapshot::~FigureSnapshot() {
+    if (store) {
+        store->release(version);
+    }
+}
+
+void FigureSnapshot::forEach(const std::function<void(FigureId, const Figure&)>& visit) const {
+    for (std::uint32_t s = 0; s < counts.size(); ++s) {
+        const ConcurrentStore::Shard& shard = *store->shards[s];
+        for (std::uint64_t i = 0; i < counts[s]; ++i) {
+            const ConcurrentStore::Slot& slot = store->slotAt(shard, i);
+            if (slot.removed.load(std::memory_order_acquire) > version) {
+                visit({s, i}, *slot.figure.load(std::memory_order_relaxed));
+            }
+        }
+    }
+}
+
+size_t FigureSnapshot::size() const {
+    size_t n = 0;
+    forEach([&n](FigureId, const Figure&) { ++n; });
+    return n;
+}
+
+double FigureSnapshot::totalArea() const {
+    double total = 0.0;
+    forEach([&total](FigureId, const Figure& fig) { total += static_cast<double>(fig); });
+    return total;
+}
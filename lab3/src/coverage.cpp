@@ -0,0 +1,378 @@
+#include "../include/coverage.hpp"
+#include "../include/parallel.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <numeric>
+
+namespace {
+
+struct Box {
+    double minX;
+    double minY;
+    double maxX;
+    double maxY;
+};
+
+// Ребро, направленное слева направо; вертикальные рёбра не хранятся
+struct Edge {
+    double x0;
+    double y0;
+    double x1;
+    double y1;
+    std::uint32_t figure;   // номер фигуры среди фигур ячейки
+    bool below;             // целиком ниже ячейки: влияет только на чётность
+};
+
+// Рабочие массивы, переиспользуемые между ячейками одного потока
+struct Scratch {
+    std::vector<Edge> edges;
+    std::vector<double> events;
+    std::vector<double> xs;
+    std::vector<size_t> active;
+    std::vector<std::pair<double, std::uint32_t>> cut;
+    std::vector<char> inside;
+};
+
+Box boxOf(const FigureBuffer& figures, size_t i) {
+    const double* xs = figures.xs(i);
+    const double* ys = figures.ys(i);
+    Box b{xs[0], ys[0], xs[0], ys[0]};
+    for (size_t j = 1; j < figures.apexCount(i); ++j) {
+        b.minX = std::min(b.minX, xs[j]);
+        b.maxX = std::max(b.maxX, xs[j]);
+        b.minY = std::min(b.minY, ys[j]);
+        b.maxY = std::max(b.maxY, ys[j]);
+    }
+    return b;
+}
+
+bool overlaps(const Box& a, const Box& b) {
+    return a.minX <= b.maxX && b.minX <= a.maxX && a.minY <= b.maxY && b.minY <= a.maxY;
+}
+
+// Общая точка отрезков pq и rs; false, если её нет
+// (параллельные и лежащие на одной прямой отрезки порядок не меняют)
+bool crossing(double px, double py, double qx, double qy,
+              double rx, double ry, double sx, double sy, double& x, double& y) {
+    double dx1 = qx - px, dy1 = qy - py;
+    double dx2 = sx - rx, dy2 = sy - ry;
+    double d = dx1 * dy2 - dy1 * dx2;
+    if (d == 0.0) {
+        return false;
+    }
+    double t = ((rx - px) * dy2 - (ry - py) * dx2) / d;
+    double u = ((rx - px) * dy1 - (ry - py) * dx1) / d;
+    if (t < 0.0 || t > 1.0 || u < 0.0 || u > 1.0) {
+        return false;
+    }
+    x = px + t * dx1;
+    y = py + t * dy1;
+    return true;
+}
+
+// Абсциссы пересечений рёбер фигур a и b (при a == b — несоседних рёбер),
+// лежащих в прямоугольнике window
+void crossings(const FigureBuffer& figures, size_t a, size_t b, const Box& window, std::vector<double>& out) {
+    size_t na = figures.apexCount(a);
+    size_t nb = figures.apexCount(b);
+    const double* ax = figures.xs(a);
+    const double* ay = figures.ys(a);
+    const double* bx = figures.xs(b);
+    const double* by = figures.ys(b);
+    for (size_t i = 0; i < na; ++i) {
+        size_t i1 = (i + 1) % na;
+        for (size_t j = a == b ? i + 2 : 0; j < nb; ++j) {
+            size_t j1 = (j + 1) % nb;
+            if (a == b && j1 == i) continue;
+            double x, y;
+            if (crossing(ax[i], ay[i], ax[i1], ay[i1], bx[j], by[j], bx[j1], by[j1], x, y) &&
+                x >= window.minX && x <= window.maxX && y >= window.minY && y <= window.maxY) {
+                out.push_back(x);
+            }
+        }
+    }
+}
+
+// Площадь объединения фигур members внутри прямоугольника cell.
+// Полосы — между абсциссами вершин, пересечений рёбер и пересечений рёбер
+// с горизонтальными сторонами ячейки: внутри полосы длина покрытой части
+// сечения линейна по x
+double cellArea(const FigureBuffer& figures, const std::vector<Box>& boxes,
+                const std::uint32_t* members, size_t count, const Box& cell, Scratch& s) {
+    if (count == 1) {
+        size_t i = members[0];
+        const Box& b = boxes[i];
+        bool contained = b.minX >= cell.minX && b.maxX <= cell.maxX && b.minY >= cell.minY && b.maxY <= cell.maxY;
+        s.xs.clear();
+        if (contained && figures.apexCount(i) >= 4) {
+            crossings(figures, i, i, cell, s.xs);
+        }
+        if (contained && s.xs.empty()) {
+            // Простая фигура целиком в ячейке: формула Гаусса
+            return apexArea(FigureKind::Polygon, figures.xs(i), figures.ys(i), figures.apexCount(i));
+        }
+    }
+
+    s.edges.clear();
+    s.events.assign({cell.minX, cell.maxX});
+    for (size_t k = 0; k < count; ++k) {
+        size_t i = members[k];
+        size_t n = figures.apexCount(i);
+        const double* xs = figures.xs(i);
+        const double* ys = figures.ys(i);
+        for (size_t j = 0; j < n; ++j) {
+            size_t j1 = (j + 1) % n;
+            // Вершины вне ячейки полос не порождают: ниже ячейки меняется
+            // только набор рёбер, но не чётность, выше — ничего не видно
+            if (ys[j] >= cell.minY && ys[j] <= cell.maxY) {
+                s.events.push_back(xs[j]);
+            }
+            Edge e = xs[j] < xs[j1] ? Edge{xs[j], ys[j], xs[j1], ys[j1], static_cast<std::uint32_t>(k), false}
+                                    : Edge{xs[j1], ys[j1], xs[j], ys[j], static_cast<std::uint32_t>(k), false};
+            if (e.x0 == e.x1) {
+                // Вертикальное ребро, проходящее через ячейку, задаёт границу
+                // полосы, даже если его концы лежат выше и ниже ячейки
+                if (std::max(e.y0, e.y1) > cell.minY && std::min(e.y0, e.y1) < cell.maxY) {
+                    s.events.push_back(e.x0);
+                }
+                continue;
+            }
+            if (e.x1 <= cell.minX || e.x0 >= cell.maxX) continue;
+            if (std::min(e.y0, e.y1) >= cell.maxY) continue;
+            e.below = std::max(e.y0, e.y1) <= cell.minY;
+            for (double y : {cell.minY, cell.maxY}) {
+                if ((e.y0 < y && y < e.y1) || (e.y1 < y && y < e.y0)) {
+                    s.events.push_back(e.x0 + (y - e.y0) * (e.x1 - e.x0) / (e.y1 - e.y0));
+                }
+            }
+            s.edges.push_back(e);
+        }
+        for (size_t q = k; q < count; ++q) {
+            size_t other = members[q];
+            if (q != k && !overlaps(boxes[i], boxes[other])) continue;
+            if (q == k && n < 4) continue;
+            crossings(figures, i, other, cell, s.events);
+        }
+    }
+    std::sort(s.edges.begin(), s.edges.end(), [](const Edge& a, const Edge& b) { return a.x0 < b.x0; });
+    std::sort(s.events.begin(), s.events.end());
+    s.events.erase(std::unique(s.events.begin(), s.events.end()), s.events.end());
+    auto first = std::lower_bound(s.events.begin(), s.events.end(), cell.minX);
+    auto last = std::upper_bound(first, s.events.end(), cell.maxX);
+
+    s.active.clear();
+    s.inside.assign(count, 0);
+    size_t next = 0;
+    double area = 0.0;
+    for (auto it = first; it + 1 < last; ++it) {
+        double a = it[0];
+        double b = it[1];
+        double m = 0.5 * (a + b);
+        while (next < s.edges.size() && s.edges[next].x0 < m) {
+            s.active.push_back(next++);
+        }
+        s.active.erase(std::remove_if(s.active.begin(), s.active.end(),
+                                      [&](size_t e) { return s.edges[e].x1 <= m; }),
+                       s.active.end());
+        // Рёбра ниже ячейки только переключают чётность своих фигур;
+        // рёбра выше ячейки не хранятся, поэтому фигура может остаться
+        // «внутри» до конца сечения
+        size_t covering = 0;
+        s.cut.clear();
+        for (size_t e : s.active) {
+            const Edge& edge = s.edges[e];
+            if (edge.below) {
+                s.inside[edge.figure] ^= 1;
+                s.inside[edge.figure] ? ++covering : --covering;
+            } else {
+                s.cut.emplace_back(edge.y0 + (m - edge.x0) * (edge.y1 - edge.y0) / (edge.x1 - edge.x0), edge.figure);
+            }
+        }
+        std::sort(s.cut.begin(), s.cut.end());
+        // Покрыта точка, лежащая внутри хотя бы одной фигуры; длина берётся в пределах ячейки
+        double start = cell.minY;
+        double length = 0.0;
+        for (const auto& c : s.cut) {
+            s.inside[c.second] ^= 1;
+            if (s.inside[c.second]) {
+                if (covering++ == 0) start = c.first;
+            } else if (--covering == 0) {
+                length += std::max(0.0, std::min(c.first, cell.maxY) - std::max(start, cell.minY));
+            }
+        }
+        if (covering > 0) {
+            length += std::max(0.0, cell.maxY - std::max(start, cell.minY));
+            for (size_t e : s.active) {
+                s.inside[s.edges[e].figure] = 0;
+            }
+        }
+        area += (b - a) * length;
+    }
+    return area;
+}
+
+// Пересекает ли отрезок прямоугольник r (касание считается)
+bool segmentTouches(const Box& r, double x0, double y0, double x1, double y1) {
+    if (std::max(x0, x1) < r.minX || std::min(x0, x1) > r.maxX ||
+        std::max(y0, y1) < r.minY || std::min(y0, y1) > r.maxY) {
+        return false;
+    }
+    // Все углы строго по одну сторону от прямой — пересечения нет
+    double dx = x1 - x0;
+    double dy = y1 - y0;
+    int below = 0;
+    int above = 0;
+    for (double cx : {r.minX, r.maxX}) {
+        for (double cy : {r.minY, r.maxY}) {
+            double side = dx * (cy - y0) - dy * (cx - x0);
+            below += side < 0.0;
+            above += side > 0.0;
+        }
+    }
+    return below != 4 && above != 4;
+}
+
+// Число рёбер фигуры i, проходящих через r
+size_t edgesIn(const FigureBuffer& figures, size_t i, const Box& r) {
+    size_t n = figures.apexCount(i);
+    const double* xs = figures.xs(i);
+    const double* ys = figures.ys(i);
+    size_t count = 0;
+    for (size_t j = 0, k = n - 1; j < n; k = j++) {
+        count += segmentTouches(r, xs[k], ys[k], xs[j], ys[j]);
+    }
+    return count;
+}
+
+// Точка внутри фигуры по правилу чёт-нечет
+bool contains(const FigureBuffer& figures, size_t i, double x, double y) {
+    size_t n = figures.apexCount(i);
+    const double* xs = figures.xs(i);
+    const double* ys = figures.ys(i);
+    bool inside = false;
+    for (size_t j = 0, k = n - 1; j < n; k = j++) {
+        if ((ys[j] > y) != (ys[k] > y) && x < xs[j] + (y - ys[j]) * (xs[k] - xs[j]) / (ys[k] - ys[j])) {
+            inside = !inside;
+        }
+    }
+    return inside;
+}
+
+// Пока в области много рёбер нескольких фигур, она делится на четыре части.
+// Фигура без рёбер в части либо покрывает её целиком, либо не задевает, так
+// что в части остаются только фигуры, чьи границы через неё проходят.
+// Полосы cellArea считаются уже в листьях с ограниченным числом рёбер, и
+// время определяется числом точек пересечения, а не кубом числа
+// перекрывающихся фигур
+const size_t LEAF_EDGES = 48;
+const int MAX_SPLITS = 16;
+
+double regionArea(const FigureBuffer& figures, const std::vector<Box>& boxes,
+                  const std::uint32_t* members, size_t count, const Box& region, int depth, Scratch& s) {
+    size_t edges = 0;
+    for (size_t k = 0; k < count && edges <= LEAF_EDGES; ++k) {
+        edges += edgesIn(figures, members[k], region);
+    }
+    if (count < 2 || edges <= LEAF_EDGES || depth == MAX_SPLITS) {
+        return cellArea(figures, boxes, members, count, region, s);
+    }
+    double midX = 0.5 * (region.minX + region.maxX);
+    double midY = 0.5 * (region.minY + region.maxY);
+    const Box parts[4] = {
+        {region.minX, region.minY, midX, midY}, {midX, region.minY, region.maxX, midY},
+        {region.minX, midY, midX, region.maxY}, {midX, midY, region.maxX, region.maxY}
+    };
+    std::vector<std::uint32_t> inner;
+    double area = 0.0;
+    for (const Box& part : parts) {
+        inner.clear();
+        bool covered = false;
+        double px = 0.5 * (part.minX + part.maxX);
+        double py = 0.5 * (part.minY + part.maxY);
+        for (size_t k = 0; k < count && !covered; ++k) {
+            std::uint32_t i = members[k];
+            if (!overlaps(boxes[i], part)) continue;
+            if (edgesIn(figures, i, part) > 0) {
+                inner.push_back(i);
+            } else {
+                covered = contains(figures, i, px, py);
+            }
+        }
+        if (covered) {
+            area += (part.maxX - part.minX) * (part.maxY - part.minY);
+        } else if (!inner.empty()) {
+            area += regionArea(figures, boxes, inner.data(), inner.size(), part, depth + 1, s);
+        }
+    }
+    return area;
+}
+
+} // namespace
+
+double unionArea(const FigureBuffer& figures, unsigned threads) {
+    size_t n = figures.size();
+    if (n == 0) {
+        return 0.0;
+    }
+    std::vector<Box> boxes(n);
+    parallelFor(n, threads, [&](size_t begin, size_t end, size_t) {
+        for (size_t i = begin; i < end; ++i) {
+            boxes[i] = boxOf(figures, i);
+        }
+    });
+
+    // Сетка с ячейкой в два среднеквадратичных размера фигуры: большинство
+    // фигур попадает в 1–4 ячейки, а крупные фигуры в сумме занимают O(n) ячеек
+    Box all = boxes[0];
+    double squares = 0.0;
+    for (const Box& b : boxes) {
+        all.minX = std::min(all.minX, b.minX);
+        all.minY = std::min(all.minY, b.minY);
+        all.maxX = std::max(all.maxX, b.maxX);
+        all.maxY = std::max(all.maxY, b.maxY);
+        double size = std::max(b.maxX - b.minX, b.maxY - b.minY);
+        squares += size * size;
+    }
+    double span = std::max(all.maxX - all.minX, all.maxY - all.minY);
+    double cell = std::max(2.0 * std::sqrt(squares / n), span / (1 << 20));
+    if (!(cell > 0.0)) {
+        cell = 1.0;
+    }
+    const std::uint64_t cols = static_cast<std::uint64_t>((all.maxX - all.minX) / cell) + 1;
+    auto column = [&](double x) { return static_cast<std::uint64_t>((x - all.minX) / cell); };
+    auto row = [&](double y) { return static_cast<std::uint64_t>((y - all.minY) / cell); };
+
+    std::vector<std::pair<std::uint64_t, std::uint32_t>> cells;
+    for (size_t i = 0; i < n; ++i) {
+        for (std::uint64_t cy = row(boxes[i].minY); cy <= row(boxes[i].maxY); ++cy) {
+            for (std::uint64_t cx = column(boxes[i].minX); cx <= column(boxes[i].maxX); ++cx) {
+                cells.emplace_back(cy * cols + cx, static_cast<std::uint32_t>(i));
+            }
+        }
+    }
+    std::sort(cells.begin(), cells.end());
+    std::vector<size_t> groups{0};
+    std::vector<std::uint32_t> members(cells.size());
+    for (size_t k = 0; k < cells.size(); ++k) {
+        members[k] = cells[k].second;
+        if (k + 1 == cells.size() || cells[k + 1].first != cells[k].first) groups.push_back(k + 1);
+    }
+
+    // Ячейки независимы и распределяются между потоками; площади ячеек
+    // складываются по порядку, так что результат не зависит от числа потоков
+    std::vector<double> areas(groups.size() - 1);
+    parallelFor(areas.size(), threads, [&](size_t begin, size_t end, size_t) {
+        Scratch scratch;
+        for (size_t g = begin; g < end; ++g) {
+            std::uint64_t key = cells[groups[g]].first;
+            Box rect;
+            rect.minX = all.minX + static_cast<double>(key % cols) * cell;
+            rect.minY = all.minY + static_cast<double>(key / cols) * cell;
+            rect.maxX = rect.minX + cell;
+            rect.maxY = rect.minY + cell;
+            areas[g] = regionArea(figures, boxes, &members[groups[g]], groups[g + 1] - groups[g], rect, 0, scratch);
+        }
+    }, 64);
+    return std::accumulate(areas.begin(), areas.end(), 0.0);
+}
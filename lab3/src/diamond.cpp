@@ -94,10 +94,21 @@ bool Diamond::operator==(const Figure& other) const {
     return true;
 }
 
-Diamond::Diamond(const Diamond& other)
+Diamond::Diamond(const Diamond& other) noexcept
     : apexes(other.apexes) {}
 
 std::unique_ptr<Figure> Diamond::clone() const {
     return std::make_unique<Diamond>(*this);
 }
 
+size_t Diamond::apexCount() const {
+    return apexes.size();
+}
+
+const std::pair<double, double>* Diamond::apexData() const {
+    return apexes.data();
+}
+
+std::pair<double, double>* Diamond::apexData() {
+    return apexes.data();
+}
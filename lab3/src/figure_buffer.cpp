@@ -0,0 +1,418 @@
+#include "../include/figure_buffer.hpp"
+#include "../include/diamond.hpp"
+#include "../include/pentagon.hpp"
+#include "../include/hexagon.hpp"
+#include "../include/polygon.hpp"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <tuple>
+
+size_t kindApexCount(FigureKind kind) {
+    return kind == FigureKind::Polygon ? 0 : static_cast<size_t>(kind);
+}
+
+size_t kindSlot(FigureKind kind) {
+    return kind == FigureKind::Polygon ? 3 : kindApexCount(kind) - 4;
+}
+
+const char* kindName(FigureKind kind) {
+    switch (kind) {
+        case FigureKind::Diamond: return "diamond";
+        case FigureKind::Pentagon: return "pentagon";
+        case FigureKind::Hexagon: return "hexagon";
+        case FigureKind::Polygon: return "polygon";
+    }
+    return "unknown";
+}
+
+bool parseKind(const std::string& name, FigureKind& kind) {
+    if (name == "diamond") {
+        kind = FigureKind::Diamond;
+    } else if (name == "pentagon") {
+        kind = FigureKind::Pentagon;
+    } else if (name == "hexagon") {
+        kind = FigureKind::Hexagon;
+    } else if (name == "polygon") {
+        kind = FigureKind::Polygon;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool isValidKind(std::uint8_t code) {
+    return code == 0 || (code >= 4 && code <= 6);
+}
+
+FigureKind kindOf(const Figure& fig) {
+    if (dynamic_cast<const Diamond*>(&fig)) return FigureKind::Diamond;
+    if (dynamic_cast<const Pentagon*>(&fig)) return FigureKind::Pentagon;
+    if (dynamic_cast<const Hexagon*>(&fig)) return FigureKind::Hexagon;
+    return FigureKind::Polygon;
+}
+
+const std::pair<double, double>* requireApexes(const Figure& fig) {
+    if (fig.apexCount() == 0 || !fig.apexData()) {
+        throw std::invalid_argument("Figure does not expose its vertices");
+    }
+    return fig.apexData();
+}
+
+template <size_t N>
+static std::array<std::pair<double, double>, N> gather(const double* xs, const double* ys) {
+    std::array<std::pair<double, double>, N> apxs;
+    for (size_t i = 0; i < N; ++i) {
+        apxs[i] = {xs[i], ys[i]};
+    }
+    return apxs;
+}
+
+std::unique_ptr<Figure> makeFigure(FigureKind kind, const double* xs, const double* ys, size_t n) {
+    if (kind != FigureKind::Polygon && n != kindApexCount(kind)) {
+        throw std::invalid_argument("Wrong vertex count for figure kind");
+    }
+    switch (kind) {
+        case FigureKind::Diamond: return std::make_unique<Diamond>(gather<4>(xs, ys));
+        case FigureKind::Pentagon: return std::make_unique<Pentagon>(gather<5>(xs, ys));
+        case FigureKind::Hexagon: return std::make_unique<Hexagon>(gather<6>(xs, ys));
+        case FigureKind::Polygon: {
+            std::vector<std::pair<double, double>> apxs(n);
+            for (size_t i = 0; i < n; ++i) {
+                apxs[i] = {xs[i], ys[i]};
+            }
+            return std::make_unique<Polygon>(apxs);
+        }
+    }
+    throw std::invalid_argument("Unknown figure kind");
+}
+
+std::unique_ptr<Figure> makeFigure(FigureKind kind, const double* xs, const double* ys) {
+    return makeFigure(kind, xs, ys, kindApexCount(kind));
+}
+
+double apexArea(FigureKind kind, const double* xs, const double* ys) {
+    return apexArea(kind, xs, ys, kindApexCount(kind));
+}
+
+std::pair<double, double> apexCenter(FigureKind kind, const double* xs, const double* ys) {
+    return apexCenter(kind, xs, ys, kindApexCount(kind));
+}
+
+double apexArea(FigureKind kind, const double* xs, const double* ys, size_t n) {
+    if (kind == FigureKind::Diamond) {
+        // Через диагонали, как в Diamond::calculateArea
+        double d1 = std::sqrt((xs[0] - xs[2]) * (xs[0] - xs[2]) + (ys[0] - ys[2]) * (ys[0] - ys[2]));
+        double d2 = std::sqrt((xs[1] - xs[3]) * (xs[1] - xs[3]) + (ys[1] - ys[3]) * (ys[1] - ys[3]));
+        return (d1 * d2) / 2.0;
+    }
+    // Формула Гаусса
+    double area = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+        size_t j = (i + 1) % n;
+        area += xs[i] * ys[j];
+        area -= xs[j] * ys[i];
+    }
+    return std::abs(area) / 2.0;
+}
+
+std::pair<double, double> apexCenter(FigureKind, const double* xs, const double* ys, size_t n) {
+    double sum_x = 0.0;
+    double sum_y = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+        sum_x += xs[i];
+        sum_y += ys[i];
+    }
+    return {sum_x / n, sum_y / n};
+}
+
+std::pair<double, double> apexCentroid(FigureKind kind, const double* xs, const double* ys, size_t n) {
+    // Моменты считаются относительно первой вершины: вдали от начала
+    // координат так теряется меньше знаков
+    double twice = 0.0;
+    double mx = 0.0;
+    double my = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+        size_t j = (i + 1) % n;
+        double ax = xs[i] - xs[0];
+        double ay = ys[i] - ys[0];
+        double bx = xs[j] - xs[0];
+        double by = ys[j] - ys[0];
+        double c = ax * by - bx * ay;
+        twice += c;
+        mx += (ax + bx) * c;
+        my += (ay + by) * c;
+    }
+    if (twice == 0.0) {
+        return apexCenter(kind, xs, ys, n);
+    }
+    return {xs[0] + mx / (3.0 * twice), ys[0] + my / (3.0 * twice)};
+}
+
+void FigureBuffer::push(FigureKind kind, const double* xs, const double* ys) {
+    push(kind, xs, ys, kindApexCount(kind));
+}
+
+void FigureBuffer::push(FigureKind kind, const double* xs, const double* ys, size_t n) {
+    kinds.push_back(kind);
+    xcoords.insert(xcoords.end(), xs, xs + n);
+    ycoords.insert(ycoords.end(), ys, ys + n);
+    offsets.push_back(xcoords.size());
+}
+
+void FigureBuffer::push(const Figure& fig) {
+    const std::pair<double, double>* apxs = requireApexes(fig);
+    FigureKind kind = kindOf(fig);
+    kinds.push_back(kind);
+    for (size_t i = 0; i < fig.apexCount(); ++i) {
+        xcoords.push_back(apxs[i].first);
+        ycoords.push_back(apxs[i].second);
+    }
+    offsets.push_back(xcoords.size());
+}
+
+void FigureBuffer::append(const FigureBuffer& other) {
+    size_t base = xcoords.size();
+    kinds.insert(kinds.end(), other.kinds.begin(), other.kinds.end());
+    xcoords.insert(xcoords.end(), other.xcoords.begin(), other.xcoords.end());
+    ycoords.insert(ycoords.end(), other.ycoords.begin(), other.ycoords.end());
+    for (size_t i = 1; i < other.offsets.size(); ++i) {
+        offsets.push_back(base + other.offsets[i]);
+    }
+}
+
+void FigureBuffer::reserve(size_t figures, size_t apexes) {
+    kinds.reserve(figures);
+    offsets.reserve(figures + 1);
+    xcoords.reserve(apexes);
+    ycoords.reserve(apexes);
+}
+
+void FigureBuffer::clear() {
+    kinds.clear();
+    offsets.assign(1, 0);
+    xcoords.clear();
+    ycoords.clear();
+}
+
+size_t FigureBuffer::size() const {
+    return kinds.size();
+}
+
+bool FigureBuffer::empty() const {
+    return kinds.empty();
+}
+
+size_t FigureBuffer::apexTotal() const {
+    return xcoords.size();
+}
+
+FigureKind FigureBuffer::kind(size_t i) const {
+    return kinds[i];
+}
+
+size_t FigureBuffer::apexCount(size_t i) const {
+    return offsets[i + 1] - offsets[i];
+}
+
+const double* FigureBuffer::xs(size_t i) const {
+    return xcoords.data() + offsets[i];
+}
+
+const double* FigureBuffer::ys(size_t i) const {
+    return ycoords.data() + offsets[i];
+}
+
+double* FigureBuffer::xs(size_t i) {
+    return xcoords.data() + offsets[i];
+}
+
+double* FigureBuffer::ys(size_t i) {
+    return ycoords.data() + offsets[i];
+}
+
+double FigureBuffer::area(size_t i) const {
+    return apexArea(kinds[i], xs(i), ys(i), apexCount(i));
+}
+
+std::pair<double, double> FigureBuffer::center(size_t i) const {
+    return apexCenter(kinds[i], xs(i), ys(i), apexCount(i));
+}
+
+std::pair<double, double> FigureBuffer::centroid(size_t i) const {
+    return apexCentroid(kinds[i], xs(i), ys(i), apexCount(i));
+}
+
+std::unique_ptr<Figure> FigureBuffer::materialize(size_t i) const {
+    return makeFigure(kinds[i], xs(i), ys(i), apexCount(i));
+}
+
+std::vector<std::unique_ptr<Figure>> FigureBuffer::materializeAll() const {
+    std::vector<std::unique_ptr<Figure>> figures;
+    figures.reserve(size());
+    for (size_t i = 0; i < size(); ++i) {
+        figures.push_back(materialize(i));
+    }
+    return figures;
+}
+
+ContainerMemory FigureBuffer::memoryUsage() const {
+    ContainerMemory mem;
+    mem.addBuffer(kinds);
+    mem.addBuffer(offsets);
+    mem.addBuffer(xcoords);
+    mem.addBuffer(ycoords);
+    return mem;
+}
+
+void batchAreas(const FigureBuffer& figures, double* out) {
+    // Группы: ромбы (площадь по диагоналям) отдельно, остальные по числу вершин
+    std::vector<std::vector<size_t>> groups;
+    std::vector<size_t> diamonds;
+    for (size_t i = 0; i < figures.size(); ++i) {
+        if (figures.kind(i) == FigureKind::Diamond) {
+            diamonds.push_back(i);
+            continue;
+        }
+        size_t n = figures.apexCount(i);
+        if (groups.size() <= n) groups.resize(n + 1);
+        groups[n].push_back(i);
+    }
+
+    // Координаты блока фигур по вершинам: x[j * BLOCK + k] — вершина j фигуры k
+    const size_t BLOCK = 256;
+    std::vector<double> x;
+    std::vector<double> y;
+    double acc[BLOCK];
+    auto gather = [&](const std::vector<size_t>& group, size_t first, size_t count, size_t n) {
+        x.resize(n * BLOCK);
+        y.resize(n * BLOCK);
+        for (size_t k = 0; k < count; ++k) {
+            const double* xs = figures.xs(group[first + k]);
+            const double* ys = figures.ys(group[first + k]);
+            for (size_t j = 0; j < n; ++j) {
+                x[j * BLOCK + k] = xs[j];
+                y[j * BLOCK + k] = ys[j];
+            }
+        }
+    };
+
+    for (size_t first = 0; first < diamonds.size(); first += BLOCK) {
+        size_t count = std::min(BLOCK, diamonds.size() - first);
+        gather(diamonds, first, count, 4);
+        const double* x0 = &x[0];
+        const double* x1 = &x[BLOCK];
+        const double* x2 = &x[2 * BLOCK];
+        const double* x3 = &x[3 * BLOCK];
+        const double* y0 = &y[0];
+        const double* y1 = &y[BLOCK];
+        const double* y2 = &y[2 * BLOCK];
+        const double* y3 = &y[3 * BLOCK];
+        for (size_t k = 0; k < count; ++k) {
+            double d1 = std::sqrt((x0[k] - x2[k]) * (x0[k] - x2[k]) + (y0[k] - y2[k]) * (y0[k] - y2[k]));
+            double d2 = std::sqrt((x1[k] - x3[k]) * (x1[k] - x3[k]) + (y1[k] - y3[k]) * (y1[k] - y3[k]));
+            acc[k] = (d1 * d2) / 2.0;
+        }
+        for (size_t k = 0; k < count; ++k) {
+            out[diamonds[first + k]] = acc[k];
+        }
+    }
+
+    for (size_t n = 0; n < groups.size(); ++n) {
+        const std::vector<size_t>& group = groups[n];
+        for (size_t first = 0; first < group.size(); first += BLOCK) {
+            size_t count = std::min(BLOCK, group.size() - first);
+            gather(group, first, count, n);
+            std::fill(acc, acc + count, 0.0);
+            // Тот же порядок слагаемых, что и в apexArea
+            for (size_t j = 0; j < n; ++j) {
+                const double* xj = &x[j * BLOCK];
+                const double* yj = &y[j * BLOCK];
+                const double* xn = &x[((j + 1) % n) * BLOCK];
+                const double* yn = &y[((j + 1) % n) * BLOCK];
+                for (size_t k = 0; k < count; ++k) {
+                    acc[k] += xj[k] * yn[k];
+                    acc[k] -= xn[k] * yj[k];
+                }
+            }
+            for (size_t k = 0; k < count; ++k) {
+                out[group[first + k]] = std::abs(acc[k]) / 2.0;
+            }
+        }
+    }
+}
+
+namespace {
+
+// Площадь и центр масс одной фигуры за один проход по рёбрам. N — число
+// вершин, известное при компиляции (0 — берётся n), так что цикл у
+// фиксированных видов разворачивается. Слагаемые площади и моментов идут
+// в том же порядке, что и в apexArea и apexCentroid
+template <size_t N>
+void areaCentroid(FigureKind kind, const double* xs, const double* ys, size_t n,
+                  double& area, double& cx, double& cy) {
+    if (N != 0) n = N;
+    double shoelace = 0.0;
+    double twice = 0.0;
+    double mx = 0.0;
+    double my = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+        size_t j = i + 1 == n ? 0 : i + 1;
+        shoelace += xs[i] * ys[j];
+        shoelace -= xs[j] * ys[i];
+        double ax = xs[i] - xs[0];
+        double ay = ys[i] - ys[0];
+        double bx = xs[j] - xs[0];
+        double by = ys[j] - ys[0];
+        double c = ax * by - bx * ay;
+        twice += c;
+        mx += (ax + bx) * c;
+        my += (ay + by) * c;
+    }
+    area = kind == FigureKind::Diamond ? apexArea(kind, xs, ys, n) : std::abs(shoelace) / 2.0;
+    if (twice != 0.0) {
+        cx = xs[0] + mx / (3.0 * twice);
+        cy = ys[0] + my / (3.0 * twice);
+    } else {
+        std::tie(cx, cy) = apexCenter(kind, xs, ys, n);
+    }
+}
+
+} // namespace
+
+void batchAreaCentroids(const FigureBuffer& figures, double* areas, double* cx, double* cy) {
+    for (size_t i = 0; i < figures.size(); ++i) {
+        const double* xs = figures.xs(i);
+        const double* ys = figures.ys(i);
+        switch (figures.kind(i)) {
+            case FigureKind::Diamond:
+                areaCentroid<4>(FigureKind::Diamond, xs, ys, 4, areas[i], cx[i], cy[i]);
+                break;
+            case FigureKind::Pentagon:
+                areaCentroid<5>(FigureKind::Pentagon, xs, ys, 5, areas[i], cx[i], cy[i]);
+                break;
+            case FigureKind::Hexagon:
+                areaCentroid<6>(FigureKind::Hexagon, xs, ys, 6, areas[i], cx[i], cy[i]);
+                break;
+            default:
+                areaCentroid<0>(FigureKind::Polygon, xs, ys, figures.apexCount(i), areas[i], cx[i], cy[i]);
+                break;
+        }
+    }
+}
+
+FigureBuffer toBuffer(const std::vector<std::unique_ptr<Figure>>& figures) {
+    FigureBuffer buf;
+    buf.reserve(figures.size(), figures.size() * 6);
+    for (const auto& fig : figures) {
+        buf.push(*fig);
+    }
+    return buf;
+}
+
+FigureBuffer toBuffer(const FigureCollection& figures) {
+    FigureBuffer buf;
+    buf.reserve(figures.size(), figures.size() * 6);
+    figures.forEach([&](const Figure& fig) { buf.push(fig); });
+    return buf;
+}
@@ -0,0 +1,212 @@
+#include "../include/figure_collection.hpp"
+#include "../include/diamond.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <malloc.h>
+#include <new>
+#include <stdexcept>
+#include <unordered_set>
+
+FigureCollection::FigureCollection()
+    : spine(std::make_shared<Spine>()) {}
+
+FigureCollection::Spine& FigureCollection::ownSpine() {
+    if (spine.use_count() > 1) {
+        spine = std::make_shared<Spine>(*spine);
+    }
+    return *spine;
+}
+
+FigureCollection::Chunk& FigureCollection::ownChunk(size_t chunk) {
+    std::shared_ptr<Chunk>& ptr = ownSpine().chunks[chunk];
+    if (ptr.use_count() > 1) {
+        ptr = std::make_shared<Chunk>(*ptr);
+    }
+    return *ptr;
+}
+
+void FigureCollection::locate(size_t i, size_t& chunk, size_t& pos) const {
+    if (i >= size()) {
+        throw std::out_of_range("Figure index out of range");
+    }
+    const std::vector<size_t>& ends = spine->ends;
+    chunk = static_cast<size_t>(std::upper_bound(ends.begin(), ends.end(), i) - ends.begin());
+    pos = chunk == 0 ? i : i - ends[chunk - 1];
+}
+
+size_t FigureCollection::size() const {
+    return spine->ends.empty() ? 0 : spine->ends.back();
+}
+
+bool FigureCollection::empty() const {
+    return size() == 0;
+}
+
+const Figure& FigureCollection::operator[](size_t i) const {
+    size_t chunk, pos;
+    locate(i, chunk, pos);
+    return *(*spine->chunks[chunk])[pos];
+}
+
+Figure& FigureCollection::mutate(size_t i) {
+    size_t chunk, pos;
+    locate(i, chunk, pos);
+    std::shared_ptr<Figure>& fig = ownChunk(chunk)[pos];
+    if (fig.use_count() > 1) {
+        fig = fig->clone();
+    }
+    return *fig;
+}
+
+const Figure& FigureCollection::push_back(std::unique_ptr<Figure> fig) {
+    Spine& s = ownSpine();
+    if (s.chunks.empty() || s.chunks.back()->size() >= CHUNK) {
+        s.chunks.push_back(std::make_shared<Chunk>());
+        s.chunks.back()->reserve(CHUNK);
+        s.ends.push_back(size());
+    }
+    Chunk& last = ownChunk(s.chunks.size() - 1);
+    last.push_back(std::move(fig));
+    ++s.ends.back();
+    return *last.back();
+}
+
+void FigureCollection::assign(size_t i, std::unique_ptr<Figure> fig) {
+    size_t chunk, pos;
+    locate(i, chunk, pos);
+    ownChunk(chunk)[pos] = std::move(fig);
+}
+
+void FigureCollection::erase(size_t i) {
+    size_t chunk, pos;
+    locate(i, chunk, pos);
+    Spine& s = ownSpine();
+    Chunk& c = ownChunk(chunk);
+    c.erase(c.begin() + static_cast<std::ptrdiff_t>(pos));
+    for (size_t k = chunk; k < s.ends.size(); ++k) {
+        --s.ends[k];
+    }
+    if (c.empty()) {
+        s.chunks.erase(s.chunks.begin() + static_cast<std::ptrdiff_t>(chunk));
+        s.ends.erase(s.ends.begin() + static_cast<std::ptrdiff_t>(chunk));
+    }
+}
+
+void FigureCollection::clear() {
+    spine = std::make_shared<Spine>();
+}
+
+CollectionDiff FigureCollection::diff(const FigureCollection& before) const {
+    CollectionDiff result;
+    if (spine == before.spine) {
+        return result;
+    }
+    // Куски, общие для обоих состояний, содержат одни и те же фигуры
+    std::unordered_set<const Chunk*> oldChunks;
+    for (const auto& chunk : before.spine->chunks) {
+        oldChunks.insert(chunk.get());
+    }
+    std::unordered_set<const Chunk*> shared;
+    for (const auto& chunk : spine->chunks) {
+        if (oldChunks.count(chunk.get())) {
+            shared.insert(chunk.get());
+        }
+    }
+
+    std::unordered_set<const Figure*> oldFigures;
+    for (const auto& chunk : before.spine->chunks) {
+        if (shared.count(chunk.get())) continue;
+        for (const auto& fig : *chunk) {
+            oldFigures.insert(fig.get());
+        }
+    }
+    for (const auto& chunk : spine->chunks) {
+        if (shared.count(chunk.get())) continue;
+        for (const auto& fig : *chunk) {
+            if (oldFigures.erase(fig.get()) == 0) {
+                ++result.added;
+            }
+        }
+    }
+    result.removed = oldFigures.size();
+    return result;
+}
+
+namespace {
+
+// Управляющий блок shared_ptr в libstdc++: таблица виртуальных функций
+// и два счётчика ссылок перед объектом или указателем на него
+const size_t CONTROL_HEADER = sizeof(void*) + 2 * sizeof(int);
+
+// Блок, который распределитель выдаёт под запрос bytes байт (размер
+// считается так же, как в blockSize: полезная часть плюс заголовок)
+size_t requestBlock(size_t bytes) {
+    void* p = std::malloc(bytes);
+    if (!p) {
+        throw std::bad_alloc();
+    }
+    size_t size = malloc_usable_size(p) + sizeof(size_t);
+    std::free(p);
+    return size;
+}
+
+// Размер скрытого блока по нескольким замерам: распределитель может отдать
+// под отдельный замер освобождённый блок большего размера. Для указателя,
+// владеющего отдельно выделенным объектом, блок объекта вычитается.
+// Без учёта кучи (heap_hooks не подключён) замерять нечем: берётся блок
+// под запрос размера estimate
+template <typename Make>
+size_t probeBlock(Make make, bool separateObject, size_t estimate) {
+    if (!heapTracking()) {
+        return requestBlock(estimate);
+    }
+    std::vector<decltype(make())> keep;
+    keep.reserve(4);
+    size_t best = static_cast<size_t>(-1);
+    for (int k = 0; k < 4; ++k) {
+        size_t bytes = static_cast<size_t>(heapDelta([&] { keep.push_back(make()); }));
+        if (separateObject) bytes -= blockSize(keep.back().get());
+        best = std::min(best, bytes);
+    }
+    return best;
+}
+
+} // namespace
+
+ContainerMemory FigureCollection::memoryUsage() const {
+    std::unordered_set<const void*> seen;
+    return memoryUsage(seen, [](const Figure&) {});
+}
+
+ContainerMemory FigureCollection::memoryUsage(std::unordered_set<const void*>& seen,
+                                              const std::function<void(const Figure&)>& onFigure) const {
+    // Блоки make_shared и управляющий блок shared_ptr, созданного из
+    // unique_ptr, снаружи не видны; их размер измеряется один раз по куче
+    static const size_t spineBlock = probeBlock([] { return std::make_shared<Spine>(); }, false,
+                                                CONTROL_HEADER + sizeof(Spine));
+    static const size_t chunkBlock = probeBlock([] { return std::make_shared<Chunk>(); }, false,
+                                                CONTROL_HEADER + sizeof(Chunk));
+    static const size_t controlBlock = probeBlock([] {
+        return std::shared_ptr<Figure>(std::unique_ptr<Figure>(std::make_unique<Diamond>()));
+    }, true, CONTROL_HEADER + sizeof(Figure*));
+
+    ContainerMemory mem;
+    if (!seen.insert(spine.get()).second) {
+        return mem;
+    }
+    mem.heapBytes += spineBlock;
+    mem.addBuffer(spine->chunks);
+    mem.addBuffer(spine->ends);
+    for (const auto& chunk : spine->chunks) {
+        if (!seen.insert(chunk.get()).second) continue;
+        mem.heapBytes += chunkBlock;
+        mem.addBuffer(*chunk);
+        // Копия куска разделяет фигуры (и их управляющие блоки) с оригиналом
+        for (const auto& fig : *chunk) {
+            if (!seen.insert(fig.get()).second) continue;
+            mem.heapBytes += controlBlock;
+            onFigure(*fig);
+        }
+    }
+    return mem;
+}
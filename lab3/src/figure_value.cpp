@@ -0,0 +1,54 @@
+#include "../include/figure_value.hpp"
+#include "../include/diamond.hpp"
+#include "../include/pentagon.hpp"
+#include <typeinfo>
+
+static_assert(FigureValue::fitsInline<Diamond>, "Diamond must fit into FigureValue");
+static_assert(FigureValue::fitsInline<Pentagon>, "Pentagon must fit into FigureValue");
+static_assert(FigureValue::fitsInline<Hexagon>, "Hexagon must fit into FigureValue");
+
+void FigureValue::adoptHeap(Figure* fig) noexcept {
+    ::new (static_cast<void*>(storage)) Figure*(fig);
+    ops = &heapOps;
+}
+
+const FigureValue::Ops FigureValue::heapOps = {
+    [](const FigureValue& from, FigureValue& to) {
+        to.adoptHeap(from.get().clone().release());
+    },
+    [](FigureValue& from, FigureValue& to) noexcept {
+        to.adoptHeap(&from.get());
+        from.ops = nullptr;
+    },
+    [](FigureValue& value) noexcept {
+        delete &value.get();
+        value.ops = nullptr;
+    },
+    [](const FigureValue& value) {
+        return *std::launder(reinterpret_cast<Figure* const*>(value.storage));
+    },
+    [](const FigureValue& value) {
+        return value.get().calculateArea();
+    },
+    [](const FigureValue& value) {
+        return value.get().getCenter();
+    },
+    false
+};
+
+FigureValue FigureValue::copyOf(const Figure& fig) {
+    // Сравнение typeid, а не dynamic_cast: наследника Diamond нельзя срезать до Diamond
+    const std::type_info& type = typeid(fig);
+    if (type == typeid(Diamond)) return FigureValue(static_cast<const Diamond&>(fig));
+    if (type == typeid(Pentagon)) return FigureValue(static_cast<const Pentagon&>(fig));
+    if (type == typeid(Hexagon)) return FigureValue(static_cast<const Hexagon&>(fig));
+    return adopt(fig.clone());
+}
+
+FigureValue FigureValue::adopt(std::unique_ptr<Figure> fig) {
+    FigureValue value;
+    if (fig) {
+        value.adoptHeap(fig.release());
+    }
+    return value;
+}
@@ -0,0 +1,326 @@
+#include "../include/generator.hpp"
+#include "../include/parallel.hpp"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+
+const size_t BLOCK = 8192;   // фигур в блоке со своим потоком случайных чисел
+const double PI = 3.14159265358979323846;
+
+std::uint64_t mix64(std::uint64_t z) {
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+// splitmix64: состояние — счётчик, выход — его перемешивание.
+// Потоки с разными начальными состояниями независимы
+class Random
+{
+    private:
+        std::uint64_t state;
+    public:
+        explicit Random(std::uint64_t seed) : state(seed) {}
+
+        std::uint64_t next() {
+            state += 0x9e3779b97f4a7c15ULL;
+            return mix64(state);
+        }
+        // Равномерно в [0, 1)
+        double uniform() {
+            return static_cast<double>(next() >> 11) * 0x1.0p-53;
+        }
+        double uniform(double lo, double hi) {
+            return lo + (hi - lo) * uniform();
+        }
+        // Стандартное нормальное (преобразование Бокса — Мюллера, одна половина пары)
+        double normal() {
+            double u = 1.0 - uniform();
+            return std::sqrt(-2.0 * std::log(u)) * std::cos(2.0 * PI * uniform());
+        }
+};
+
+Random stream(std::uint64_t seed, std::uint64_t id) {
+    return Random(mix64(seed ^ mix64(id + 0x632be59bd9b4e019ULL)));
+}
+
+enum Shape {
+    DIAMOND,
+    PENTAGON,
+    IRREGULAR_PENTAGON,
+    HEXAGON,
+    IRREGULAR_HEXAGON,
+    SHAPES
+};
+
+const char* const SHAPE_NAMES[SHAPES] = {
+    "diamond", "pentagon", "irregular-pentagon", "hexagon", "irregular-hexagon"
+};
+
+double& weight(GeneratorOptions& opts, size_t shape) {
+    double* weights[SHAPES] = {&opts.diamonds, &opts.pentagons, &opts.irregularPentagons,
+                               &opts.hexagons, &opts.irregularHexagons};
+    return *weights[shape];
+}
+
+double parseNumber(const std::string& key, const std::string& value) {
+    std::istringstream in(value);
+    double x;
+    char extra;
+    if (!(in >> x) || in >> extra || !std::isfinite(x)) {
+        throw std::invalid_argument("Invalid value for '" + key + "': " + value);
+    }
+    return x;
+}
+
+std::uint64_t parseCount(const std::string& key, const std::string& value) {
+    std::istringstream in(value);
+    unsigned long long x;
+    char extra;
+    if (value.empty() || value[0] == '-' || !(in >> x) || in >> extra) {
+        throw std::invalid_argument("Invalid value for '" + key + "': " + value);
+    }
+    return x;
+}
+
+void parseMix(GeneratorOptions& opts, const std::string& value) {
+    for (size_t s = 0; s < SHAPES; ++s) {
+        weight(opts, s) = 0.0;
+    }
+    std::istringstream in(value);
+    std::string item;
+    while (std::getline(in, item, ',')) {
+        size_t colon = item.find(':');
+        std::string name = item.substr(0, colon);
+        size_t s = 0;
+        while (s < SHAPES && name != SHAPE_NAMES[s]) ++s;
+        if (s == SHAPES) {
+            throw std::invalid_argument("Unknown figure type in mix: " + name);
+        }
+        double w = colon == std::string::npos ? 1.0 : parseNumber("mix", item.substr(colon + 1));
+        if (w < 0) {
+            throw std::invalid_argument("Negative weight in mix: " + item);
+        }
+        weight(opts, s) = w;
+    }
+}
+
+// Нормированные накопленные веса видов
+std::array<double, SHAPES> cumulativeWeights(const GeneratorOptions& opts) {
+    const double weights[SHAPES] = {opts.diamonds, opts.pentagons, opts.irregularPentagons,
+                                    opts.hexagons, opts.irregularHexagons};
+    std::array<double, SHAPES> cumulative;
+    double sum = 0.0;
+    for (size_t s = 0; s < SHAPES; ++s) {
+        double w = weights[s];
+        if (!(w >= 0) || !std::isfinite(w)) {
+            throw std::invalid_argument("Figure type weights must be finite and non-negative");
+        }
+        sum += w;
+        cumulative[s] = sum;
+    }
+    if (!(sum > 0)) {
+        throw std::invalid_argument("At least one figure type must have a positive weight");
+    }
+    for (double& c : cumulative) {
+        c /= sum;
+    }
+    cumulative[SHAPES - 1] = 1.0;
+    return cumulative;
+}
+
+// Вершины выпуклой фигуры вида shape с центром (cx, cy) и размером r,
+// против часовой стрелки
+void shapeApexes(Shape shape, double cx, double cy, double r, Random& rng, double* xs, double* ys) {
+    double turn = rng.uniform(0.0, 2.0 * PI);
+    double c = std::cos(turn);
+    double s = std::sin(turn);
+    if (shape == DIAMOND) {
+        // Диагонали перпендикулярны и делятся центром пополам
+        double b = r * rng.uniform(0.25, 1.0);
+        xs[0] = cx + r * c;  ys[0] = cy + r * s;
+        xs[1] = cx - b * s;  ys[1] = cy + b * c;
+        xs[2] = cx - r * c;  ys[2] = cy - r * s;
+        xs[3] = cx + b * s;  ys[3] = cy - b * c;
+        return;
+    }
+    size_t n = shape == PENTAGON || shape == IRREGULAR_PENTAGON ? 5 : 6;
+    if (shape == PENTAGON || shape == HEXAGON) {
+        // Поворот таблицы единичных вершин: без тригонометрии на вершину
+        static const std::array<std::array<double, 12>, 2> unit = [] {
+            std::array<std::array<double, 12>, 2> u{};
+            for (size_t m = 0; m < 2; ++m) {
+                for (size_t k = 0; k < 5 + m; ++k) {
+                    u[m][2 * k] = std::cos(2.0 * PI * k / (5 + m));
+                    u[m][2 * k + 1] = std::sin(2.0 * PI * k / (5 + m));
+                }
+            }
+            return u;
+        }();
+        const std::array<double, 12>& u = unit[n - 5];
+        double rc = r * c;
+        double rs = r * s;
+        for (size_t k = 0; k < n; ++k) {
+            xs[k] = cx + rc * u[2 * k] - rs * u[2 * k + 1];
+            ys[k] = cy + rs * u[2 * k] + rc * u[2 * k + 1];
+        }
+        return;
+    }
+    // Неправильная: точки эллипса с полуосями r и b, идущие по возрастанию
+    // параметра, всегда образуют строго выпуклый многоугольник. Промежутки
+    // между параметрами не меньше трети среднего, так что фигура не вырождается
+    double b = r * rng.uniform(0.5, 1.0);
+    double gaps[6];
+    double total = 0.0;
+    for (size_t k = 0; k < n; ++k) {
+        gaps[k] = rng.uniform(0.5, 1.5);
+        total += gaps[k];
+    }
+    double t = 0.0;
+    for (size_t k = 0; k < n; ++k) {
+        double ex = r * std::cos(t);
+        double ey = b * std::sin(t);
+        xs[k] = cx + ex * c - ey * s;
+        ys[k] = cy + ex * s + ey * c;
+        t += 2.0 * PI * gaps[k] / total;
+    }
+}
+
+} // namespace
+
+void setGeneratorOption(GeneratorOptions& opts, const std::string& option) {
+    size_t eq = option.find('=');
+    if (eq == std::string::npos) {
+        throw std::invalid_argument("Expected key=value: " + option);
+    }
+    std::string key = option.substr(0, eq);
+    std::string value = option.substr(eq + 1);
+    if (key == "seed") {
+        opts.seed = parseCount(key, value);
+    } else if (key == "count") {
+        opts.count = parseCount(key, value);
+    } else if (key == "mix") {
+        parseMix(opts, value);
+    } else if (key == "layout") {
+        if (value == "uniform") {
+            opts.layout = Layout::Uniform;
+        } else if (value == "clustered") {
+            opts.layout = Layout::Clustered;
+        } else {
+            throw std::invalid_argument("Unknown layout: " + value);
+        }
+    } else if (key == "sizes") {
+        if (value == "uniform") {
+            opts.sizes = SizeLaw::Uniform;
+        } else if (value == "zipf") {
+            opts.sizes = SizeLaw::Zipf;
+        } else {
+            throw std::invalid_argument("Unknown size law: " + value);
+        }
+    } else if (key == "world") {
+        opts.world = parseNumber(key, value);
+    } else if (key == "clusters") {
+        opts.clusters = parseCount(key, value);
+    } else if (key == "spread") {
+        opts.spread = parseNumber(key, value);
+    } else if (key == "min") {
+        opts.minSize = parseNumber(key, value);
+    } else if (key == "max") {
+        opts.maxSize = parseNumber(key, value);
+    } else if (key == "zipf") {
+        opts.zipf = parseNumber(key, value);
+    } else if (key == "threads") {
+        opts.threads = static_cast<unsigned>(parseCount(key, value));
+    } else {
+        throw std::invalid_argument("Unknown generator option: " + key);
+    }
+}
+
+FigureBuffer generateFigures(const GeneratorOptions& opts) {
+    const std::array<double, SHAPES> cumulative = cumulativeWeights(opts);
+    if (!(opts.minSize > 0) || !(opts.maxSize >= opts.minSize) || !std::isfinite(opts.maxSize)) {
+        throw std::invalid_argument("Figure sizes must satisfy 0 < min <= max");
+    }
+    if (!(opts.world > 0) || !std::isfinite(opts.world)) {
+        throw std::invalid_argument("World size must be positive");
+    }
+    if (opts.layout == Layout::Clustered && (opts.clusters == 0 || !(opts.spread >= 0))) {
+        throw std::invalid_argument("Clustered layout needs clusters > 0 and spread >= 0");
+    }
+
+    // Центры кластеров — из отдельного потока, общего для всех блоков
+    std::vector<std::pair<double, double>> centers;
+    if (opts.layout == Layout::Clustered) {
+        Random rng = stream(opts.seed, ~0ULL);
+        for (size_t k = 0; k < opts.clusters; ++k) {
+            double x = rng.uniform(-opts.world, opts.world);
+            centers.emplace_back(x, rng.uniform(-opts.world, opts.world));
+        }
+    }
+    const double ratio = opts.maxSize / opts.minSize;
+    const double power = 1.0 - opts.zipf;
+    const double sigma = opts.spread * opts.world;
+
+    size_t blocks = (opts.count + BLOCK - 1) / BLOCK;
+    std::vector<FigureBuffer> parts(blocks);
+    parallelFor(blocks, opts.threads, [&](size_t begin, size_t end, size_t) {
+        double xs[6], ys[6];
+        for (size_t block = begin; block < end; ++block) {
+            Random rng = stream(opts.seed, block);
+            size_t count = std::min(BLOCK, opts.count - block * BLOCK);
+            FigureBuffer& out = parts[block];
+            out.reserve(count, count * 6);
+            for (size_t i = 0; i < count; ++i) {
+                double u = rng.uniform();
+                size_t shape = 0;
+                while (u >= cumulative[shape] && shape + 1 < SHAPES) ++shape;
+
+                double cx, cy;
+                if (opts.layout == Layout::Uniform) {
+                    cx = rng.uniform(-opts.world, opts.world);
+                    cy = rng.uniform(-opts.world, opts.world);
+                } else {
+                    const auto& c = centers[rng.next() % centers.size()];
+                    cx = c.first + sigma * rng.normal();
+                    cy = c.second + sigma * rng.normal();
+                }
+
+                double r;
+                if (opts.sizes == SizeLaw::Uniform) {
+                    r = rng.uniform(opts.minSize, opts.maxSize);
+                } else {
+                    // Обращение функции распределения плотности ~ x^-zipf на [1, ratio]
+                    double v = rng.uniform();
+                    double rank = std::abs(power) < 1e-12
+                                      ? std::pow(ratio, v)
+                                      : std::pow((std::pow(ratio, power) - 1.0) * v + 1.0, 1.0 / power);
+                    r = std::max(opts.minSize, opts.maxSize / rank);
+                }
+
+                Shape kind = static_cast<Shape>(shape);
+                shapeApexes(kind, cx, cy, r, rng, xs, ys);
+                out.push(kind == DIAMOND ? FigureKind::Diamond
+                         : kind == PENTAGON || kind == IRREGULAR_PENTAGON ? FigureKind::Pentagon
+                                                                         : FigureKind::Hexagon,
+                         xs, ys);
+            }
+        }
+    }, 1);
+
+    FigureBuffer figures;
+    size_t apexes = 0;
+    for (const FigureBuffer& part : parts) {
+        apexes += part.apexTotal();
+    }
+    figures.reserve(opts.count, apexes);
+    for (FigureBuffer& part : parts) {
+        figures.append(part);
+        part = FigureBuffer();
+    }
+    return figures;
+}
@@ -0,0 +1,67 @@
+#include "../include/heap.hpp"
+#include <atomic>
+#include <cstdlib>
+#include <malloc.h>
+
+namespace {
+
+std::atomic<size_t> liveBytes{0};
+std::atomic<size_t> liveBlocks{0};
+std::atomic<size_t> peakBytes{0};
+std::atomic<size_t> allocations{0};
+thread_local long long threadBytes = 0;
+
+// Размер блока glibc: полезная часть и слово заголовка перед ней
+size_t chunkSize(void* p) {
+    return malloc_usable_size(p) + sizeof(size_t);
+}
+
+} // namespace
+
+void* heapTrack(void* p) {
+    if (p) {
+        size_t size = chunkSize(p);
+        size_t live = liveBytes.fetch_add(size, std::memory_order_relaxed) + size;
+        liveBlocks.fetch_add(1, std::memory_order_relaxed);
+        allocations.fetch_add(1, std::memory_order_relaxed);
+        threadBytes += static_cast<long long>(size);
+        size_t peak = peakBytes.load(std::memory_order_relaxed);
+        while (live > peak && !peakBytes.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {}
+    }
+    return p;
+}
+
+void heapRelease(void* p) {
+    if (p) {
+        size_t size = chunkSize(p);
+        liveBytes.fetch_sub(size, std::memory_order_relaxed);
+        liveBlocks.fetch_sub(1, std::memory_order_relaxed);
+        threadBytes -= static_cast<long long>(size);
+        std::free(p);
+    }
+}
+
+HeapStats heapStats() {
+    HeapStats stats;
+    stats.liveBytes = liveBytes.load(std::memory_order_relaxed);
+    stats.liveBlocks = liveBlocks.load(std::memory_order_relaxed);
+    stats.peakBytes = peakBytes.load(std::memory_order_relaxed);
+    stats.allocations = allocations.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void resetHeapPeak() {
+    peakBytes.store(liveBytes.load(std::memory_order_relaxed), std::memory_order_relaxed);
+}
+
+size_t blockSize(const void* p) {
+    return p ? chunkSize(const_cast<void*>(p)) : 0;
+}
+
+long long threadHeapBytes() {
+    return threadBytes;
+}
+
+bool heapTracking() {
+    return allocations.load(std::memory_order_relaxed) != 0;
+}
@@ -0,0 +1,49 @@
+#include "../include/heap.hpp"
+#include <cstdlib>
+#include <new>
+
+// Замена глобальных operator new/delete для учёта кучи. Собирается
+// отдельной объектной библиотекой heap_hooks и подключается только к
+// программам, которым нужен учёт: в остальных выделение памяти обходится
+// без атомарных счётчиков
+
+namespace {
+
+void* allocate(size_t size) {
+    void* p = heapTrack(std::malloc(size ? size : 1));
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void* allocateAligned(size_t size, std::align_val_t align) {
+    size_t a = static_cast<size_t>(align);
+    // aligned_alloc требует размер, кратный выравниванию
+    void* p = heapTrack(std::aligned_alloc(a, (size + a - 1) / a * a));
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+} // namespace
+
+void* operator new(size_t size) { return allocate(size); }
+void* operator new[](size_t size) { return allocate(size); }
+void* operator new(size_t size, std::align_val_t align) { return allocateAligned(size, align); }
+void* operator new[](size_t size, std::align_val_t align) { return allocateAligned(size, align); }
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    return heapTrack(std::malloc(size ? size : 1));
+}
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+    return heapTrack(std::malloc(size ? size : 1));
+}
+
+void operator delete(void* p) noexcept { heapRelease(p); }
+void operator delete[](void* p) noexcept { heapRelease(p); }
+void operator delete(void* p, size_t) noexcept { heapRelease(p); }
+void operator delete[](void* p, size_t) noexcept { heapRelease(p); }
+void operator delete(void* p, std::align_val_t) noexcept { heapRelease(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { heapRelease(p); }
+void operator delete(void* p, size_t, std::align_val_t) noexcept { heapRelease(p); }
+void operator delete[](void* p, size_t, std::align_val_t) noexcept { heapRelease(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { heapRelease(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { heapRelease(p); }
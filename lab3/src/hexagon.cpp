@@ -93,9 +93,21 @@ bool Hexagon::operator==(const Figure& other) const {
     return true;
 }
 
-Hexagon::Hexagon(const Hexagon& other) 
+Hexagon::Hexagon(const Hexagon& other) noexcept
     : apexes(other.apexes) {}
 
 std::unique_ptr<Figure> Hexagon::clone() const {
     return std::make_unique<Hexagon>(*this);
-}
\ No newline at end of file
+}
+
+size_t Hexagon::apexCount() const {
+    return apexes.size();
+}
+
+const std::pair<double, double>* Hexagon::apexData() const {
+    return apexes.data();
+}
+
+std::pair<double, double>* Hexagon::apexData() {
+    return apexes.data();
+}
@@ -0,0 +1,190 @@
+#include "../include/hull.hpp"
+#include "../include/parallel.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+using Point = std::pair<double, double>;
+
+double cross(const Point& o, const Point& a, const Point& b) {
+    return (a.first - o.first) * (b.second - o.second) - (a.second - o.second) * (b.first - o.first);
+}
+
+// Отсечение Экла-Туссена: точки строго внутри многоугольника из крайних
+// точек по направлениям x, y, x+y, x-y не могут лежать на оболочке
+std::vector<Point> hullOfRange(const double* xs, const double* ys, size_t n) {
+    if (n == 0) {
+        return {};
+    }
+    size_t ext[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+    auto key = [&](size_t i, int dir) {
+        switch (dir) {
+            case 0: return xs[i];
+            case 1: return xs[i] + ys[i];
+            case 2: return ys[i];
+            case 3: return ys[i] - xs[i];
+            case 4: return -xs[i];
+            case 5: return -xs[i] - ys[i];
+            case 6: return -ys[i];
+            default: return xs[i] - ys[i];
+        }
+    };
+    for (size_t i = 1; i < n; ++i) {
+        for (int dir = 0; dir < 8; ++dir) {
+            if (key(i, dir) > key(ext[dir], dir)) ext[dir] = i;
+        }
+    }
+    std::vector<Point> octagon;
+    for (int dir = 0; dir < 8; ++dir) {
+        octagon.emplace_back(xs[ext[dir]], ys[ext[dir]]);
+    }
+    octagon = convexHull(octagon);
+
+    std::vector<Point> candidates;
+    for (size_t i = 0; i < n; ++i) {
+        Point p{xs[i], ys[i]};
+        bool inside = octagon.size() >= 3;
+        for (size_t k = 0; k < octagon.size() && inside; ++k) {
+            inside = cross(octagon[k], octagon[(k + 1) % octagon.size()], p) > 0.0;
+        }
+        if (!inside) {
+            candidates.push_back(p);
+        }
+    }
+    return convexHull(std::move(candidates));
+}
+
+template <typename Visit>
+Extent extentParallel(size_t n, unsigned threads, Visit visit) {
+    std::vector<Extent> partial(resolveThreads(threads));
+    size_t parts = parallelFor(n, threads, [&](size_t begin, size_t end, size_t part) {
+        for (size_t i = begin; i < end; ++i) {
+            visit(i, partial[part]);
+        }
+    });
+    Extent result;
+    for (size_t part = 0; part < parts; ++part) {
+        result.merge(partial[part]);
+    }
+    return result;
+}
+
+} // namespace
+
+void Extent::add(double x, double y) {
+    if (empty) {
+        minX = maxX = x;
+        minY = maxY = y;
+        empty = false;
+        return;
+    }
+    minX = std::min(minX, x);
+    maxX = std::max(maxX, x);
+    minY = std::min(minY, y);
+    maxY = std::max(maxY, y);
+}
+
+void Extent::add(const Figure& fig) {
+    const std::pair<double, double>* apxs = fig.apexData();
+    for (size_t i = 0; i < fig.apexCount(); ++i) {
+        add(apxs[i].first, apxs[i].second);
+    }
+}
+
+void Extent::merge(const Extent& other) {
+    if (other.empty) {
+        return;
+    }
+    add(other.minX, other.minY);
+    add(other.maxX, other.maxY);
+}
+
+double Extent::width() const {
+    return empty ? 0.0 : maxX - minX;
+}
+
+double Extent::height() const {
+    return empty ? 0.0 : maxY - minY;
+}
+
+Extent extentOf(const FigureBuffer& figures, unsigned threads) {
+    return extentParallel(figures.size(), threads, [&](size_t i, Extent& local) {
+        const double* xs = figures.xs(i);
+        const double* ys = figures.ys(i);
+        for (size_t j = 0; j < figures.apexCount(i); ++j) {
+            local.add(xs[j], ys[j]);
+        }
+    });
+}
+
+Extent extentOf(const std::vector<std::unique_ptr<Figure>>& figures, unsigned threads) {
+    return extentParallel(figures.size(), threads, [&](size_t i, Extent& local) {
+        local.add(*figures[i]);
+    });
+}
+
+std::vector<Point> convexHull(std::vector<Point> points) {
+    std::sort(points.begin(), points.end());
+    points.erase(std::unique(points.begin(), points.end()), points.end());
+    if (points.size() < 3) {
+        return points;
+    }
+    std::vector<Point> hull(2 * points.size());
+    size_t k = 0;
+    for (size_t i = 0; i < points.size(); ++i) {
+        while (k >= 2 && cross(hull[k - 2], hull[k - 1], points[i]) <= 0.0) --k;
+        hull[k++] = points[i];
+    }
+    for (size_t i = points.size() - 1, lower = k + 1; i-- > 0;) {
+        while (k >= lower && cross(hull[k - 2], hull[k - 1], points[i]) <= 0.0) --k;
+        hull[k++] = points[i];
+    }
+    hull.resize(k - 1);
+    return hull;
+}
+
+std::vector<Point> collectionHull(const FigureBuffer& figures, unsigned threads) {
+    std::vector<std::vector<Point>> partial(resolveThreads(threads));
+    size_t parts = parallelFor(figures.size(), threads, [&](size_t begin, size_t end, size_t part) {
+        if (begin == end) return;
+        size_t count = figures.xs(end - 1) + figures.apexCount(end - 1) - figures.xs(begin);
+        partial[part] = hullOfRange(figures.xs(begin), figures.ys(begin), count);
+    }, 1024);
+    std::vector<Point> merged;
+    for (size_t part = 0; part < parts; ++part) {
+        merged.insert(merged.end(), partial[part].begin(), partial[part].end());
+    }
+    return convexHull(std::move(merged));
+}
+
+std::vector<Point> collectionHull(const std::vector<std::unique_ptr<Figure>>& figures, unsigned threads) {
+    std::vector<std::vector<Point>> partial(resolveThreads(threads));
+    size_t parts = parallelFor(figures.size(), threads, [&](size_t begin, size_t end, size_t part) {
+        std::vector<double> xs;
+        std::vector<double> ys;
+        for (size_t i = begin; i < end; ++i) {
+            const std::pair<double, double>* apxs = figures[i]->apexData();
+            for (size_t j = 0; j < figures[i]->apexCount(); ++j) {
+                xs.push_back(apxs[j].first);
+                ys.push_back(apxs[j].second);
+            }
+        }
+        partial[part] = hullOfRange(xs.data(), ys.data(), xs.size());
+    }, 1024);
+    std::vector<Point> merged;
+    for (size_t part = 0; part < parts; ++part) {
+        merged.insert(merged.end(), partial[part].begin(), partial[part].end());
+    }
+    return convexHull(std::move(merged));
+}
+
+double polygonArea(const std::vector<Point>& polygon) {
+    double area = 0.0;
+    for (size_t i = 0; i < polygon.size(); ++i) {
+        size_t j = (i + 1) % polygon.size();
+        area += polygon[i].first * polygon[j].second;
+        area -= polygon[j].first * polygon[i].second;
+    }
+    return std::abs(area) / 2.0;
+}
@@ -0,0 +1,473 @@
+#include "../include/json_format.hpp"
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+const int MAX_DEPTH = 64;   // вложенность пропускаемых значений
+
+// Кусок закончился посреди фигуры: разбор продолжится со следующим куском
+struct Incomplete {};
+
+bool isSpace(char c) {
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+bool isDigit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+// Пропуск пробельных символов. Между лексемами обычно ноль или один
+// пробел, поэтому блоки по 16 байт проверяются только на длинных отступах
+const char* skipSpaces(const char* p, const char* end) {
+    if (p < end && !isSpace(*p)) {
+        return p;
+    }
+#ifdef __SSE2__
+    const __m128i space = _mm_set1_epi8(' ');
+    const __m128i newline = _mm_set1_epi8('\n');
+    const __m128i ret = _mm_set1_epi8('\r');
+    const __m128i tab = _mm_set1_epi8('\t');
+    while (end - p >= 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        __m128i ws = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, space), _mm_cmpeq_epi8(v, newline)),
+                                  _mm_or_si128(_mm_cmpeq_epi8(v, ret), _mm_cmpeq_epi8(v, tab)));
+        unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(ws));
+        if (mask != 0xFFFF) {
+            return p + __builtin_ctz(~mask);
+        }
+        p += 16;
+    }
+#endif
+    while (p < end && isSpace(*p)) ++p;
+    return p;
+}
+
+// Первая кавычка, обратная косая черта или управляющий символ строки
+const char* stringStop(const char* p, const char* end) {
+#ifdef __SSE2__
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i slash = _mm_set1_epi8('\\');
+    const __m128i control = _mm_set1_epi8(0x1F);
+    while (end - p >= 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        __m128i stop = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, quote), _mm_cmpeq_epi8(v, slash)),
+                                    _mm_cmpeq_epi8(_mm_min_epu8(v, control), v));
+        unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(stop));
+        if (mask != 0) {
+            return p + __builtin_ctz(mask);
+        }
+        p += 16;
+    }
+#endif
+    while (p < end && *p != '"' && *p != '\\' && static_cast<unsigned char>(*p) >= 0x20) ++p;
+    return p;
+}
+
+bool kindByName(std::string_view name, FigureKind& kind) {
+    for (FigureKind k : {FigureKind::Diamond, FigureKind::Pentagon, FigureKind::Hexagon, FigureKind::Polygon}) {
+        if (name == kindName(k)) {
+            kind = k;
+            return true;
+        }
+    }
+    return false;
+}
+
+void appendUtf8(std::string& out, unsigned code) {
+    if (code < 0x80) {
+        out.push_back(static_cast<char>(code));
+    } else if (code < 0x800) {
+        out.push_back(static_cast<char>(0xC0 | (code >> 6)));
+        out.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+    } else if (code < 0x10000) {
+        out.push_back(static_cast<char>(0xE0 | (code >> 12)));
+        out.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+    } else {
+        out.push_back(static_cast<char>(0xF0 | (code >> 18)));
+        out.push_back(static_cast<char>(0x80 | ((code >> 12) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+    }
+}
+
+// Разбор фрагмента документа. Фигура добавляется в буфер только целиком;
+// если фрагмент кончился раньше (и он не последний), разбор откатывается
+// к началу фигуры
+class Parser
+{
+    public:
+        const char* p;
+
+        Parser(const char* begin, const char* stop, bool lastChunk, size_t line, size_t column)
+            : p(begin), base(begin), end(stop), last(lastChunk), baseLine(line), baseColumn(column) {}
+
+        size_t run(int& stage, FigureBuffer& out) {
+            size_t count = 0;
+            const char* mark = p;
+            try {
+                while (true) {
+                    mark = p;
+                    if (stage == 0) {
+                        if (peek() != '[') fail(p, "expected '[' starting the figure array");
+                        ++p;
+                        stage = 1;
+                    } else if (stage == 1) {
+                        if (peek() == ']') {
+                            ++p;
+                            stage = 3;
+                        } else {
+                            figure(out);
+                            ++count;
+                            stage = 2;
+                        }
+                    } else if (stage == 2) {
+                        char c = peek();
+                        if (c == ']') {
+                            ++p;
+                            stage = 3;
+                        } else if (c == ',') {
+                            ++p;
+                            figure(out);
+                            ++count;
+                        } else {
+                            fail(p, "expected ',' or ']' after a figure");
+                        }
+                    } else {
+                        p = skipSpaces(p, end);
+                        if (p != end) fail(p, "unexpected characters after the figure array");
+                        return count;
+                    }
+                }
+            } catch (const Incomplete&) {
+                p = mark;
+            }
+            return count;
+        }
+
+        // Строка и столбец позиции at
+        std::pair<size_t, size_t> locate(const char* at) const {
+            size_t lines = static_cast<size_t>(std::count(base, at, '\n'));
+            if (lines == 0) {
+                return {baseLine, baseColumn + static_cast<size_t>(at - base)};
+            }
+            const char* lineStart = at;
+            while (lineStart[-1] != '\n') --lineStart;
+            return {baseLine + lines, static_cast<size_t>(at - lineStart) + 1};
+        }
+    private:
+        const char* base;
+        const char* end;
+        bool last;
+        size_t baseLine;
+        size_t baseColumn;
+        std::vector<double> xs;
+        std::vector<double> ys;
+        std::string scratch;
+
+        [[noreturn]] void fail(const char* at, const std::string& what) const {
+            auto where = locate(at);
+            throw std::runtime_error("JSON line " + std::to_string(where.first) + ", column " +
+                                     std::to_string(where.second) + ": " + what);
+        }
+
+        // Конец фрагмента: в последнем куске это ошибка, иначе нужен следующий
+        [[noreturn]] void ran(const char* at) const {
+            if (last) fail(at, "unexpected end of input");
+            throw Incomplete();
+        }
+
+        char peek() {
+            p = skipSpaces(p, end);
+            if (p == end) ran(p);
+            return *p;
+        }
+
+        void expect(char c, const char* what) {
+            if (peek() != c) fail(p, what);
+            ++p;
+        }
+
+        // Строка в кавычках; p стоит на открывающей кавычке. Строка без
+        // экранирования возвращается без копирования
+        std::string_view string() {
+            const char* start = p++;
+            const char* q = stringStop(p, end);
+            if (q < end && *q == '"') {
+                std::string_view s(p, static_cast<size_t>(q - p));
+                p = q + 1;
+                return s;
+            }
+            scratch.clear();
+            while (true) {
+                if (q == end) {
+                    if (last) fail(start, "unterminated string");
+                    throw Incomplete();
+                }
+                scratch.append(p, q);
+                if (*q == '"') {
+                    p = q + 1;
+                    return scratch;
+                }
+                if (*q != '\\') fail(q, "control character in string");
+                p = escape(q);
+                q = stringStop(p, end);
+            }
+        }
+
+        // Экранированная последовательность, начинающаяся в at
+        const char* escape(const char* at) {
+            if (end - at < 2) ran(at);
+            char c = at[1];
+            const char* simple = "\"\\/bfnrt";
+            const char* decoded = "\"\\/\b\f\n\r\t";
+            if (const char* k = c ? std::strchr(simple, c) : nullptr) {
+                scratch.push_back(decoded[k - simple]);
+                return at + 2;
+            }
+            if (c != 'u') fail(at, "invalid escape sequence");
+            unsigned code = hex4(at);
+            const char* next = at + 6;
+            if (code >= 0xD800 && code < 0xDC00 && end - next >= 2 && next[0] == '\\' && next[1] == 'u') {
+                unsigned low = hex4(next);
+                if (low >= 0xDC00 && low < 0xE000) {
+                    code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                    next += 6;
+                }
+            }
+            appendUtf8(scratch, code);
+            return next;
+        }
+
+        unsigned hex4(const char* at) {
+            if (end - at < 6) ran(at);
+            unsigned code = 0;
+            auto res = std::from_chars(at + 2, at + 6, code, 16);
+            if (res.ptr != at + 6) fail(at, "invalid \\u escape");
+            return code;
+        }
+
+        // Число по грамматике JSON: -?(0|[1-9][0-9]*)(.[0-9]+)?([eE][+-]?[0-9]+)?
+        double number() {
+            peek();
+            const char* start = p;
+            const char* q = p;
+            auto digits = [&]() {
+                const char* from = q;
+                while (q < end && isDigit(*q)) ++q;
+                if (q == end && !last) throw Incomplete();
+                if (q == from) fail(q == end ? start : q, "expected a number");
+            };
+            if (*q == '-') ++q;
+            if (q < end && *q == '0') {
+                ++q;
+                if (q == end && !last) throw Incomplete();
+            } else {
+                digits();
+            }
+            if (q < end && *q == '.') {
+                ++q;
+                digits();
+            }
+            if (q < end && (*q == 'e' || *q == 'E')) {
+                ++q;
+                if (q < end && (*q == '+' || *q == '-')) ++q;
+                digits();
+            }
+            double v;
+            auto res = std::from_chars(start, q, v);
+            if (res.ec == std::errc::result_out_of_range) fail(start, "number out of range");
+            if (res.ec != std::errc() || res.ptr != q) fail(start, "expected a number");
+            p = q;
+            return v;
+        }
+
+        void literal(const char* word) {
+            size_t n = std::strlen(word);
+            size_t have = std::min(n, static_cast<size_t>(end - p));
+            if (std::memcmp(p, word, have) != 0) fail(p, "unexpected character");
+            if (have < n) ran(p);
+            p += n;
+        }
+
+        // Значение неизвестного ключа
+        void skipValue(int depth) {
+            if (depth > MAX_DEPTH) fail(p, "nesting too deep");
+            char c = peek();
+            if (c == '"') {
+                string();
+            } else if (c == '{' || c == '[') {
+                char close = c == '{' ? '}' : ']';
+                ++p;
+                if (peek() == close) {
+                    ++p;
+                    return;
+                }
+                while (true) {
+                    if (c == '{') {
+                        if (peek() != '"') fail(p, "expected key string");
+                        string();
+                        expect(':', "expected ':' after key");
+                    }
+                    skipValue(depth + 1);
+                    char next = peek();
+                    ++p;
+                    if (next == close) return;
+                    if (next != ',') fail(p - 1, c == '{' ? "expected ',' or '}'" : "expected ',' or ']'");
+                }
+            } else if (c == 't') {
+                literal("true");
+            } else if (c == 'f') {
+                literal("false");
+            } else if (c == 'n') {
+                literal("null");
+            } else if (c == '-' || isDigit(c)) {
+                number();
+            } else {
+                fail(p, "unexpected character");
+            }
+        }
+
+        void vertices() {
+            expect('[', "expected '[' starting the vertex list");
+            if (peek() == ']') {
+                ++p;
+                return;
+            }
+            while (true) {
+                expect('[', "expected a vertex [x, y]");
+                double x = number();
+                expect(',', "expected ',' between vertex coordinates");
+                double y = number();
+                expect(']', "expected ']' after two vertex coordinates");
+                xs.push_back(x);
+                ys.push_back(y);
+                char c = peek();
+                ++p;
+                if (c == ']') return;
+                if (c != ',') fail(p - 1, "expected ',' or ']' in the vertex list");
+            }
+        }
+
+        void figure(FigureBuffer& out) {
+            if (peek() != '{') fail(p, "expected '{' starting a figure");
+            const char* start = p++;
+            const char* listAt = nullptr;
+            bool typed = false;
+            FigureKind kind = FigureKind::Polygon;
+            xs.clear();
+            ys.clear();
+            if (peek() != '}') {
+                while (true) {
+                    if (peek() != '"') fail(p, "expected key string");
+                    const char* keyAt = p;
+                    std::string_view key = string();
+                    expect(':', "expected ':' after key");
+                    if (key == "type") {
+                        if (typed) fail(keyAt, "duplicate key 'type'");
+                        if (peek() != '"') fail(p, "expected figure type string");
+                        const char* at = p;
+                        std::string_view name = string();
+                        if (!kindByName(name, kind)) {
+                            fail(at, "unknown figure type '" + std::string(name) + "'");
+                        }
+                        typed = true;
+                    } else if (key == "vertices") {
+                        if (listAt) fail(keyAt, "duplicate key 'vertices'");
+                        listAt = skipSpaces(p, end);
+                        vertices();
+                    } else {
+                        skipValue(0);
+                    }
+                    char c = peek();
+                    ++p;
+                    if (c == '}') break;
+                    if (c != ',') fail(p - 1, "expected ',' or '}' in a figure");
+                }
+            } else {
+                ++p;
+            }
+            if (!typed || !listAt) fail(start, "figure needs both 'type' and 'vertices'");
+            size_t n = xs.size();
+            if (kind == FigureKind::Polygon ? n < 3 : n != kindApexCount(kind)) {
+                fail(listAt, std::string(kindName(kind)) + " needs " +
+                                 (kind == FigureKind::Polygon ? "at least 3" : std::to_string(kindApexCount(kind))) +
+                                 " vertices, got " + std::to_string(n));
+            }
+            out.push(kind, xs.data(), ys.data(), n);
+        }
+};
+
+} // namespace
+
+size_t parseJson(const char* begin, const char* end, FigureBuffer& out) {
+    Parser parser(begin, end, true, 1, 1);
+    int stage = 0;
+    return parser.run(stage, out);
+}
+
+void writeJson(std::ostream& os, const FigureBuffer& figures) {
+    std::string out = "[";
+    char num[32];
+    for (size_t i = 0; i < figures.size(); ++i) {
+        out += i ? ",\n{\"type\":\"" : "\n{\"type\":\"";
+        out += kindName(figures.kind(i));
+        out += "\",\"vertices\":[";
+        const double* xs = figures.xs(i);
+        const double* ys = figures.ys(i);
+        for (size_t j = 0; j < figures.apexCount(i); ++j) {
+            if (!std::isfinite(xs[j]) || !std::isfinite(ys[j])) {
+                throw std::runtime_error("Figure " + std::to_string(i) + " has a non-finite coordinate");
+            }
+            out += j ? ",[" : "[";
+            out.append(num, std::to_chars(num, num + sizeof(num), xs[j]).ptr);
+            out += ',';
+            out.append(num, std::to_chars(num, num + sizeof(num), ys[j]).ptr);
+            out += ']';
+        }
+        out += "]}";
+        if (out.size() > (1 << 16)) {
+            os.write(out.data(), static_cast<std::streamsize>(out.size()));
+            out.clear();
+        }
+    }
+    out += figures.empty() ? "]\n" : "\n]\n";
+    os.write(out.data(), static_cast<std::streamsize>(out.size()));
+}
+
+JsonReader::JsonReader(std::istream& input, size_t chunk)
+    : is(input), chunkBytes(std::max<size_t>(chunk, 1)) {}
+
+bool JsonReader::next(FigureBuffer& out) {
+    buffer.erase(0, pos);
+    pos = 0;
+    size_t old = buffer.size();
+    buffer.resize(old + chunkBytes);
+    is.read(&buffer[old], static_cast<std::streamsize>(chunkBytes));
+    buffer.resize(old + static_cast<size_t>(is.gcount()));
+    bool last = !is;
+
+    Parser parser(buffer.data(), buffer.data() + buffer.size(), last, line, column);
+    parser.run(stage, out);
+    auto where = parser.locate(parser.p);
+    line = where.first;
+    column = where.second;
+    pos = static_cast<size_t>(parser.p - buffer.data());
+    return !last;
+}
+
+FigureBuffer readJson(std::istream& is) {
+    FigureBuffer out;
+    JsonReader reader(is);
+    while (reader.next(out)) {}
+    return out;
+}
@@ -0,0 +1,303 @@
+#include "../include/kdtree.hpp"
+#include "../include/parallel.hpp"
+#include <algorithm>
+#include <cmath>
+#include <future>
+
+namespace {
+
+// Диапазоны не длиннее LEAF просматриваются целиком
+const size_t LEAF = 8;
+// Поддеревья меньше этого размера строятся в текущем потоке
+const size_t PARALLEL_MIN = 1 << 14;
+
+// Порядок кандидатов: по квадрату расстояния, затем по номеру
+bool closer(const Neighbor& a, const Neighbor& b) {
+    return a.distance < b.distance || (a.distance == b.distance && a.id < b.id);
+}
+
+double dist2(const KdPoint& p, double x, double y) {
+    double dx = p.x - x;
+    double dy = p.y - y;
+    return dx * dx + dy * dy;
+}
+
+// heap — куча с худшим из k лучших кандидатов в вершине; distance — квадрат
+void offer(std::vector<Neighbor>& heap, size_t k, const Neighbor& cand) {
+    if (heap.size() < k) {
+        heap.push_back(cand);
+        std::push_heap(heap.begin(), heap.end(), closer);
+    } else if (closer(cand, heap.front())) {
+        std::pop_heap(heap.begin(), heap.end(), closer);
+        heap.back() = cand;
+        std::push_heap(heap.begin(), heap.end(), closer);
+    }
+}
+
+std::vector<Neighbor> finish(std::vector<Neighbor> heap) {
+    std::sort_heap(heap.begin(), heap.end(), closer);
+    for (Neighbor& n : heap) {
+        n.distance = std::sqrt(n.distance);
+    }
+    return heap;
+}
+
+// Диапазон дерева и нижняя граница квадрата расстояния до его точек
+struct Pending {
+    size_t lo;
+    size_t hi;
+    double gap;
+};
+
+unsigned parallelDepth(unsigned threads) {
+    unsigned depth = 0;
+    while ((1u << depth) < resolveThreads(threads)) ++depth;
+    return depth;
+}
+
+} // namespace
+
+KdTree::KdTree(std::vector<KdPoint> pts, unsigned threads) {
+    build(std::move(pts), threads);
+}
+
+void KdTree::build(std::vector<KdPoint> pts, unsigned threads) {
+    points = std::move(pts);
+    axes.assign(points.size(), 0);
+    buildRange(0, points.size(), parallelDepth(threads));
+}
+
+void KdTree::build(const FigureBuffer& figures, unsigned threads) {
+    std::vector<KdPoint> pts(figures.size());
+    parallelFor(figures.size(), threads, [&](size_t begin, size_t end, size_t) {
+        for (size_t i = begin; i < end; ++i) {
+            auto c = figures.center(i);
+            pts[i] = {c.first, c.second, i};
+        }
+    });
+    build(std::move(pts), threads);
+}
+
+void KdTree::buildRange(size_t lo, size_t hi, unsigned depth) {
+    if (hi - lo <= LEAF) {
+        return;
+    }
+    double minX = points[lo].x, maxX = minX;
+    double minY = points[lo].y, maxY = minY;
+    for (size_t i = lo + 1; i < hi; ++i) {
+        minX = std::min(minX, points[i].x);
+        maxX = std::max(maxX, points[i].x);
+        minY = std::min(minY, points[i].y);
+        maxY = std::max(maxY, points[i].y);
+    }
+    unsigned char axis = (maxX - minX) >= (maxY - minY) ? 0 : 1;
+    size_t mid = lo + (hi - lo) / 2;
+    auto first = points.begin();
+    if (axis == 0) {
+        std::nth_element(first + lo, first + mid, first + hi,
+                         [](const KdPoint& a, const KdPoint& b) { return a.x < b.x; });
+    } else {
+        std::nth_element(first + lo, first + mid, first + hi,
+                         [](const KdPoint& a, const KdPoint& b) { return a.y < b.y; });
+    }
+    axes[mid] = axis;
+
+    if (depth > 0 && hi - lo >= PARALLEL_MIN) {
+        auto left = std::async(std::launch::async, [=] { buildRange(lo, mid, depth - 1); });
+        buildRange(mid + 1, hi, depth - 1);
+        left.get();
+    } else {
+        buildRange(lo, mid, 0);
+        buildRange(mid + 1, hi, 0);
+    }
+}
+
+void KdTree::clear() {
+    points.clear();
+    axes.clear();
+}
+
+size_t KdTree::size() const {
+    return points.size();
+}
+
+bool KdTree::empty() const {
+    return points.empty();
+}
+
+void KdTree::nearestInto(double x, double y, size_t k, std::vector<Neighbor>& heap) const {
+    if (points.empty() || k == 0) {
+        return;
+    }
+    std::vector<Pending> stack{{0, points.size(), 0.0}};
+    while (!stack.empty()) {
+        Pending node = stack.back();
+        stack.pop_back();
+        // Равные расстояния не отсекаются: кандидат с меньшим id может оказаться лучше
+        if (heap.size() == k && node.gap > heap.front().distance) {
+            continue;
+        }
+        if (node.hi - node.lo <= LEAF) {
+            for (size_t i = node.lo; i < node.hi; ++i) {
+                offer(heap, k, {points[i].id, dist2(points[i], x, y)});
+            }
+            continue;
+        }
+        size_t mid = node.lo + (node.hi - node.lo) / 2;
+        const KdPoint& p = points[mid];
+        offer(heap, k, {p.id, dist2(p, x, y)});
+        double d = axes[mid] == 0 ? x - p.x : y - p.y;
+        Pending left{node.lo, mid, node.gap};
+        Pending right{mid + 1, node.hi, node.gap};
+        // Дальняя половина кладётся первой, чтобы ближняя обошлась раньше
+        if (d < 0) {
+            right.gap = std::max(node.gap, d * d);
+            stack.push_back(right);
+            stack.push_back(left);
+        } else {
+            left.gap = std::max(node.gap, d * d);
+            stack.push_back(left);
+            stack.push_back(right);
+        }
+    }
+}
+
+void KdTree::withinInto(double x, double y, double radius, std::vector<size_t>& out) const {
+    if (points.empty() || radius < 0) {
+        return;
+    }
+    double r2 = radius * radius;
+    std::vector<Pending> stack{{0, points.size(), 0.0}};
+    while (!stack.empty()) {
+        Pending node = stack.back();
+        stack.pop_back();
+        if (node.hi - node.lo <= LEAF) {
+            for (size_t i = node.lo; i < node.hi; ++i) {
+                if (dist2(points[i], x, y) <= r2) out.push_back(points[i].id);
+            }
+            continue;
+        }
+        size_t mid = node.lo + (node.hi - node.lo) / 2;
+        const KdPoint& p = points[mid];
+        if (dist2(p, x, y) <= r2) out.push_back(p.id);
+        double d = axes[mid] == 0 ? x - p.x : y - p.y;
+        double gap = std::max(node.gap, d * d);
+        if (d < 0 || gap <= r2) stack.push_back({node.lo, mid, d < 0 ? node.gap : gap});
+        if (d >= 0 || gap <= r2) stack.push_back({mid + 1, node.hi, d >= 0 ? node.gap : gap});
+    }
+}
+
+std::vector<Neighbor> KdTree::nearest(double x, double y, size_t k) const {
+    std::vector<Neighbor> heap;
+    nearestInto(x, y, k, heap);
+    return finish(std::move(heap));
+}
+
+std::vector<size_t> KdTree::within(double x, double y, double radius) const {
+    std::vector<size_t> out;
+    withinInto(x, y, radius, out);
+    std::sort(out.begin(), out.end());
+    return out;
+}
+
+std::vector<std::pair<size_t, size_t>> KdTree::pairsWithin(double radius, unsigned threads) const {
+    std::vector<std::vector<std::pair<size_t, size_t>>> partial(resolveThreads(threads));
+    parallelFor(points.size(), threads, [&](size_t begin, size_t end, size_t part) {
+        std::vector<size_t> found;
+        for (size_t i = begin; i < end; ++i) {
+            found.clear();
+            withinInto(points[i].x, points[i].y, radius, found);
+            // Каждая пара находится дважды, оставляется та, что с меньшим id слева
+            for (size_t j : found) {
+                if (points[i].id < j) partial[part].emplace_back(points[i].id, j);
+            }
+        }
+    }, 1024);
+    std::vector<std::pair<size_t, size_t>> pairs;
+    for (auto& p : partial) {
+        pairs.insert(pairs.end(), p.begin(), p.end());
+    }
+    std::sort(pairs.begin(), pairs.end());
+    return pairs;
+}
+
+std::vector<std::vector<Neighbor>> KdTree::nearestBatch(const std::vector<std::pair<double, double>>& queries,
+                                                        size_t k, unsigned threads) const {
+    std::vector<std::vector<Neighbor>> results(queries.size());
+    parallelFor(queries.size(), threads, [&](size_t begin, size_t end, size_t) {
+        for (size_t i = begin; i < end; ++i) {
+            results[i] = nearest(queries[i].first, queries[i].second, k);
+        }
+    }, 256);
+    return results;
+}
+
+std::vector<std::vector<size_t>> KdTree::withinBatch(const std::vector<std::pair<double, double>>& queries,
+                                                     double radius, unsigned threads) const {
+    std::vector<std::vector<size_t>> results(queries.size());
+    parallelFor(queries.size(), threads, [&](size_t begin, size_t end, size_t) {
+        for (size_t i = begin; i < end; ++i) {
+            results[i] = within(queries[i].first, queries[i].second, radius);
+        }
+    }, 256);
+    return results;
+}
+
+void IncrementalKdTree::insert(double x, double y, size_t id) {
+    buffer.push_back({x, y, id});
+    ++count;
+    if (buffer.size() < BUFFER) {
+        return;
+    }
+    // Перенос: буфер и все занятые младшие уровни сливаются в первый свободный
+    std::vector<KdPoint> carry;
+    carry.swap(buffer);
+    for (size_t i = 0;; ++i) {
+        if (i == levels.size()) {
+            levels.emplace_back();
+        }
+        if (levels[i].empty()) {
+            levels[i].build(std::move(carry));
+            break;
+        }
+        carry.insert(carry.end(), levels[i].points.begin(), levels[i].points.end());
+        levels[i].clear();
+    }
+}
+
+void IncrementalKdTree::clear() {
+    levels.clear();
+    buffer.clear();
+    count = 0;
+}
+
+size_t IncrementalKdTree::size() const {
+    return count;
+}
+
+std::vector<Neighbor> IncrementalKdTree::nearest(double x, double y, size_t k) const {
+    std::vector<Neighbor> heap;
+    if (k == 0) {
+        return heap;
+    }
+    for (const KdPoint& p : buffer) {
+        offer(heap, k, {p.id, dist2(p, x, y)});
+    }
+    // Старшие уровни крупнее — с них граница k-го соседа быстрее сужается
+    for (auto it = levels.rbegin(); it != levels.rend(); ++it) {
+        it->nearestInto(x, y, k, heap);
+    }
+    return finish(std::move(heap));
+}
+
+std::vector<size_t> IncrementalKdTree::within(double x, double y, double radius) const {
+    std::vector<size_t> out;
+    for (const KdPoint& p : buffer) {
+        if (radius >= 0 && dist2(p, x, y) <= radius * radius) out.push_back(p.id);
+    }
+    for (const KdTree& tree : levels) {
+        tree.withinInto(x, y, radius, out);
+    }
+    std::sort(out.begin(), out.end());
+    return out;
+}
@@ -0,0 +1,108 @@
+#include "../include/memory_report.hpp"
+#include "../include/diamond.hpp"
+#include "../include/pentagon.hpp"
+#include "../include/hexagon.hpp"
+#include "../include/polygon.hpp"
+
+namespace {
+
+size_t objectSize(FigureKind kind) {
+    switch (kind) {
+        case FigureKind::Diamond: return sizeof(Diamond);
+        case FigureKind::Pentagon: return sizeof(Pentagon);
+        case FigureKind::Hexagon: return sizeof(Hexagon);
+        case FigureKind::Polygon: return sizeof(Polygon);
+    }
+    return 0;
+}
+
+// Объект фигуры выделен отдельным блоком; у многоугольника вершины
+// лежат ещё в одном блоке. Для классов, не известных библиотеке (они
+// учитываются как многоугольники), известен только блок объекта
+void addFigure(MemoryReport& report, const Figure& fig) {
+    FigureKind kind = kindOf(fig);
+    bool known = kind != FigureKind::Polygon || dynamic_cast<const Polygon*>(&fig);
+    KindMemory& mem = report.kinds[kindSlot(kind)];
+    ++mem.count;
+    mem.heapBytes += blockSize(&fig);
+    if (known) {
+        mem.objectBytes += objectSize(kind);
+    }
+    if (known && kind == FigureKind::Polygon) {
+        mem.heapBytes += blockSize(fig.apexData());
+    }
+    mem.vertexBytes += fig.apexCount() * sizeof(std::pair<double, double>);
+}
+
+} // namespace
+
+const KindMemory& MemoryReport::operator[](FigureKind kind) const {
+    return kinds[kindSlot(kind)];
+}
+
+size_t MemoryReport::count() const {
+    size_t total = 0;
+    for (const KindMemory& k : kinds) {
+        total += k.count;
+    }
+    return total;
+}
+
+size_t MemoryReport::heapBytes() const {
+    size_t total = container.heapBytes;
+    for (const KindMemory& k : kinds) {
+        total += k.heapBytes;
+    }
+    return total;
+}
+
+size_t MemoryReport::vertexBytes() const {
+    size_t total = 0;
+    for (const KindMemory& k : kinds) {
+        total += k.vertexBytes;
+    }
+    return total;
+}
+
+size_t MemoryReport::overheadBytes() const {
+    return heapBytes() - vertexBytes();
+}
+
+MemoryReport measureMemory(const FigureCollection& figures) {
+    MemoryReport report;
+    figures.forEach([&](const Figure& fig) { addFigure(report, fig); });
+    report.container = figures.memoryUsage();
+    return report;
+}
+
+MemoryReport measureVersions(const FigureCollection& figures,
+                             const std::vector<const FigureCollection*>& versions) {
+    MemoryReport report;
+    std::unordered_set<const void*> seen;
+    figures.memoryUsage(seen, [](const Figure&) {});
+    for (const FigureCollection* version : versions) {
+        report.container.add(version->memoryUsage(seen, [&](const Figure& fig) { addFigure(report, fig); }));
+    }
+    return report;
+}
+
+MemoryReport measureMemory(const std::vector<std::unique_ptr<Figure>>& figures) {
+    MemoryReport report;
+    for (const auto& fig : figures) {
+        addFigure(report, *fig);
+    }
+    report.container.addBuffer(figures);
+    return report;
+}
+
+MemoryReport measureMemory(const FigureBuffer& figures) {
+    // Фигуры не выделяются по отдельности: вся память — массивы буфера
+    MemoryReport report;
+    for (size_t i = 0; i < figures.size(); ++i) {
+        KindMemory& mem = report.kinds[kindSlot(figures.kind(i))];
+        ++mem.count;
+        mem.vertexBytes += figures.apexCount(i) * sizeof(std::pair<double, double>);
+    }
+    report.container = figures.memoryUsage();
+    return report;
+}
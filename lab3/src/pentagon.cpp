@@ -92,9 +92,21 @@ bool Pentagon::operator==(const Figure& other) const {
     return true;
 }
 
-Pentagon::Pentagon(const Pentagon& other) 
+Pentagon::Pentagon(const Pentagon& other) noexcept 
     : apexes(other.apexes) {}
 
 std::unique_ptr<Figure> Pentagon::clone() const {
     return std::make_unique<Pentagon>(*this);
-}
\ No newline at end of file
+}
+
+size_t Pentagon::apexCount() const {
+    return apexes.size();
+}
+
+const std::pair<double, double>* Pentagon::apexData() const {
+    return apexes.data();
+}
+
+std::pair<double, double>* Pentagon::apexData() {
+    return apexes.data();
+}
@@ -0,0 +1,145 @@
+#include "../include/pipeline.hpp"
+#include "../include/spsc_queue.hpp"
+#include "../include/text_format.hpp"
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <memory>
+#include <string>
+#include <thread>
+
+namespace {
+
+using BatchPtr = std::unique_ptr<IngestBatch>;
+using Clock = std::chrono::steady_clock;
+
+double since(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+} // namespace
+
+double StageMetrics::throughput() const {
+    return busySeconds > 0.0 ? figures / busySeconds : 0.0;
+}
+
+PipelineMetrics runIngestPipeline(std::istream& is, const std::function<void(IngestBatch&)>& sink,
+                                  const PipelineOptions& opts) {
+    PipelineMetrics metrics;
+    metrics.stages[0].name = "parse";
+    metrics.stages[1].name = "validate";
+    metrics.stages[2].name = "compute";
+    metrics.stages[3].name = "emit";
+    auto started = Clock::now();
+
+    size_t depth = opts.queueDepth > 0 ? opts.queueDepth : 1;
+    SpscQueue<BatchPtr> parsed(depth);
+    SpscQueue<BatchPtr> validated(depth);
+    SpscQueue<BatchPtr> computed(depth);
+    std::atomic<bool> failed{false};
+    std::exception_ptr errors[4];
+
+    std::thread parser([&]() {
+        StageMetrics& m = metrics.stages[0];
+        try {
+            ChunkReader reader(is, opts.chunkBytes);
+            std::string chunk;
+            size_t firstLine = 0;
+            while (!failed.load()) {
+                auto t0 = Clock::now();
+                if (!reader.next(chunk, firstLine)) break;
+                auto batch = std::make_unique<IngestBatch>();
+                parseFigures(chunk.data(), chunk.data() + chunk.size(), batch->figures, firstLine);
+                m.busySeconds += since(t0);
+                ++m.batches;
+                m.figures += batch->figures.size();
+                auto t1 = Clock::now();
+                parsed.push(std::move(batch));
+                m.waitSeconds += since(t1);
+            }
+        } catch (...) {
+            errors[0] = std::current_exception();
+            failed = true;
+        }
+        parsed.push(nullptr);
+    });
+
+    // Промежуточная стадия: после сбоя продолжает вычитывать вход, чтобы
+    // не заблокировать соседей, но пакеты дальше не передаёт
+    auto middle = [&](size_t stage, SpscQueue<BatchPtr>& in, SpscQueue<BatchPtr>& out,
+                      const std::function<void(IngestBatch&)>& work) {
+        StageMetrics& m = metrics.stages[stage];
+        while (true) {
+            auto t0 = Clock::now();
+            BatchPtr batch = in.pop();
+            m.waitSeconds += since(t0);
+            if (!batch) break;
+            if (failed.load()) continue;
+            try {
+                auto t1 = Clock::now();
+                work(*batch);
+                m.busySeconds += since(t1);
+                ++m.batches;
+                m.figures += batch->figures.size();
+            } catch (...) {
+                errors[stage] = std::current_exception();
+                failed = true;
+                continue;
+            }
+            auto t2 = Clock::now();
+            out.push(std::move(batch));
+            m.waitSeconds += since(t2);
+        }
+        out.push(nullptr);
+    };
+
+    std::thread validator([&]() {
+        middle(1, parsed, validated, [&opts](IngestBatch& batch) {
+            const FigureBuffer& figures = batch.figures;
+            batch.errors.assign(figures.size(), VALID);
+            if (!opts.validate) return;
+            for (size_t i = 0; i < figures.size(); ++i) {
+                batch.errors[i] = validateApexes(figures.kind(i), figures.xs(i), figures.ys(i),
+                                                 figures.apexCount(i), opts.validation);
+            }
+        });
+    });
+
+    std::thread calculator([&]() {
+        middle(2, validated, computed, [](IngestBatch& batch) {
+            const FigureBuffer& figures = batch.figures;
+            batch.areas.resize(figures.size());
+            for (size_t i = 0; i < figures.size(); ++i) {
+                batch.areas[i] = figures.area(i);
+            }
+        });
+    });
+
+    StageMetrics& emit = metrics.stages[3];
+    while (true) {
+        auto t0 = Clock::now();
+        BatchPtr batch = computed.pop();
+        emit.waitSeconds += since(t0);
+        if (!batch) break;
+        if (failed.load()) continue;
+        try {
+            auto t1 = Clock::now();
+            sink(*batch);
+            emit.busySeconds += since(t1);
+            ++emit.batches;
+            emit.figures += batch->figures.size();
+        } catch (...) {
+            errors[3] = std::current_exception();
+            failed = true;
+        }
+    }
+
+    parser.join();
+    validator.join();
+    calculator.join();
+    for (auto& e : errors) {
+        if (e) std::rethrow_exception(e);
+    }
+    metrics.seconds = since(started);
+    return metrics;
+}
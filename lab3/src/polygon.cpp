@@ -0,0 +1,122 @@
+#include <cmath>
+#include <stdexcept>
+#include "../include/polygon.hpp"
+
+Polygon::Polygon() {
+    // Треугольник с вершинами (0,0), (1,0), (0,1)
+    apexes = {{0.0, 0.0}, {1.0, 0.0}, {0.0, 1.0}};
+}
+
+Polygon::Polygon(const std::vector<std::pair<double, double>>& apxs) {
+    set_apexes(apxs);
+}
+
+Polygon::Polygon(const Polygon& other)
+    : apexes(other.apexes) {}
+
+std::vector<std::pair<double, double>> Polygon::get_apexes() const {
+    return apexes;
+}
+
+void Polygon::set_apexes(const std::vector<std::pair<double, double>>& apxs) {
+    if (apxs.size() < 3) {
+        throw std::invalid_argument("Polygon needs at least 3 vertices");
+    }
+    apexes = apxs;
+}
+
+void Polygon::print(std::ostream& os) const {
+    os << "Вершины: ";
+    for (size_t i = 0; i < apexes.size(); i++) {
+        os << apexes[i].first << "," << apexes[i].second;
+        if (i + 1 < apexes.size()) {
+            os << ";";
+        }
+    }
+}
+
+void Polygon::read(std::istream& is) {
+    size_t n;
+    if (!(is >> n) || n < 3 || n > MAX_APEXES) {
+        is.setstate(std::ios::failbit);
+        return;
+    }
+    // Вектор растёт по мере чтения: выделяется память только под вершины,
+    // которые действительно пришли
+    std::vector<std::pair<double, double>> apxs;
+    std::pair<double, double> a;
+    for (size_t i = 0; i < n && is >> a.first >> a.second; ++i) {
+        apxs.push_back(a);
+    }
+    if (is) {
+        apexes = std::move(apxs);
+    }
+}
+
+// Формула Гаусса
+double Polygon::calculateArea() const {
+    size_t n = apexes.size();
+    double area = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+        size_t j = (i + 1) % n;
+        area += apexes[i].first * apexes[j].second;
+        area -= apexes[j].first * apexes[i].second;
+    }
+    return std::abs(area) / 2.0;
+}
+
+std::pair<double, double> Polygon::getCenter() const {
+    double sum_x = 0.0;
+    double sum_y = 0.0;
+    for (const auto& a : apexes) {
+        sum_x += a.first;
+        sum_y += a.second;
+    }
+    return {sum_x / apexes.size(), sum_y / apexes.size()};
+}
+
+Polygon::operator double() const {
+    return calculateArea();
+}
+
+Figure& Polygon::operator=(const Figure& other) {
+    if (this != &other) {
+        const Polygon* poly = dynamic_cast<const Polygon*>(&other);
+        if (!poly) {
+            throw std::invalid_argument("Cannot assign non-Polygon to Polygon");
+        }
+        this->apexes = poly->apexes;
+    }
+    return *this;
+}
+
+Figure& Polygon::operator=(Figure&& other) noexcept {
+    if (this != &other) {
+        Polygon* poly = dynamic_cast<Polygon*>(&other);
+        if (poly) {
+            this->apexes = std::move(poly->apexes);
+        }
+    }
+    return *this;
+}
+
+bool Polygon::operator==(const Figure& other) const {
+    const Polygon* poly = dynamic_cast<const Polygon*>(&other);
+    return poly && apexes == poly->apexes;
+}
+
+std::unique_ptr<Figure> Polygon::clone() const {
+    return std::make_unique<Polygon>(*this);
+}
+
+size_t Polygon::apexCount() const {
+    return apexes.size();
+}
+
+const std::pair<double, double>* Polygon::apexData() const {
+    return apexes.data();
+}
+
+std::pair<double, double>* Polygon::apexData() {
+    return apexes.data();
+}
@@ -0,0 +1,719 @@
+#include "../include/query.hpp"
+#include "../include/parallel.hpp"
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cmath>
+#include <numeric>
+#include <sstream>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace {
+
+const size_t FIELDS = 10;
+const size_t BLOCK = 256;   // фигур в блоке: столбцы блока помещаются в L1
+
+const char* const FIELD_NAMES[FIELDS] = {
+    "index", "type", "area", "center.x", "center.y",
+    "bbox.minx", "bbox.miny", "bbox.maxx", "bbox.maxy", "vertices"
+};
+
+const char* const AGGREGATE_NAMES[] = {"", "count", "sum", "avg", "min", "max"};
+
+const int MAX_DEPTH = 64;   // вложенность not и скобок в условии
+// Относительный запас границ площади при отборе по индексу
+const double INDEX_SLACK = 1e-9;
+
+size_t slot(QueryField field) {
+    return static_cast<size_t>(field);
+}
+
+// ---- Разбор ----
+
+struct Token {
+    enum Kind { Word, Number, Symbol, End };
+    Kind kind = End;
+    std::string text;
+    double number = 0.0;
+    size_t pos = 0;
+};
+
+std::vector<Token> tokenize(const std::string& text) {
+    std::vector<Token> tokens;
+    size_t i = 0;
+    auto fail = [&](size_t at) {
+        throw std::invalid_argument("Query: unexpected character '" + std::string(1, text[at]) +
+                                    "' at position " + std::to_string(at + 1));
+    };
+    while (i < text.size()) {
+        char c = text[i];
+        if (std::isspace(static_cast<unsigned char>(c))) {
+            ++i;
+            continue;
+        }
+        Token t;
+        t.pos = i;
+        char next = i + 1 < text.size() ? text[i + 1] : '\0';
+        if (std::isalpha(static_cast<unsigned char>(c)) || c == '_') {
+            t.kind = Token::Word;
+            while (i < text.size() && (std::isalnum(static_cast<unsigned char>(text[i])) || text[i] == '_' || text[i] == '.')) {
+                t.text.push_back(static_cast<char>(std::tolower(static_cast<unsigned char>(text[i++]))));
+            }
+        } else if (std::isdigit(static_cast<unsigned char>(c)) || c == '.' ||
+                   ((c == '-' || c == '+') && (std::isdigit(static_cast<unsigned char>(next)) || next == '.'))) {
+            t.kind = Token::Number;
+            size_t start = c == '+' ? i + 1 : i;
+            auto res = std::from_chars(text.data() + start, text.data() + text.size(), t.number);
+            if (res.ec != std::errc()) fail(i);
+            i = static_cast<size_t>(res.ptr - text.data());
+            t.text = text.substr(t.pos, i - t.pos);
+        } else {
+            t.kind = Token::Symbol;
+            std::string two = text.substr(i, 2);
+            if (two == "<=" || two == ">=" || two == "!=" || two == "<>" || two == "==") {
+                t.text = two == "<>" ? "!=" : two == "==" ? "=" : two;
+                i += 2;
+            } else if (std::string("()*,=<>").find(c) != std::string::npos) {
+                t.text = std::string(1, c);
+                ++i;
+            } else {
+                fail(i);
+            }
+        }
+        tokens.push_back(t);
+    }
+    Token end;
+    end.pos = text.size();
+    tokens.push_back(end);
+    return tokens;
+}
+
+class QueryParser
+{
+    private:
+        const std::vector<Token>& tokens;
+        size_t at = 0;
+        int depth = 0;
+
+        [[noreturn]] void fail(const std::string& what) const {
+            const Token& t = tokens[at];
+            throw std::invalid_argument("Query: " + what + " at position " + std::to_string(t.pos + 1) +
+                                        (t.kind == Token::End ? " (end of query)" : " ('" + t.text + "')"));
+        }
+
+        bool is(const char* text) const {
+            return tokens[at].kind != Token::End && tokens[at].kind != Token::Number && tokens[at].text == text;
+        }
+
+        bool accept(const char* text) {
+            if (!is(text)) return false;
+            ++at;
+            return true;
+        }
+
+        void expect(const char* text) {
+            if (!accept(text)) fail(std::string("expected '") + text + "'");
+        }
+
+        bool isField() const {
+            if (tokens[at].kind != Token::Word) return false;
+            for (const char* name : FIELD_NAMES) {
+                if (tokens[at].text == name) return true;
+            }
+            return false;
+        }
+
+        QueryField field() {
+            if (!isField()) fail("expected a field (area, center.x, bbox.minx, type, ...)");
+            size_t i = 0;
+            while (tokens[at].text != FIELD_NAMES[i]) ++i;
+            ++at;
+            return static_cast<QueryField>(i);
+        }
+
+        // Число или, для поля type, имя вида
+        double value(QueryField f) {
+            const Token& t = tokens[at];
+            if (f == QueryField::Type) {
+                FigureKind kind;
+                if (t.kind != Token::Word || !parseKind(t.text, kind)) fail("expected a figure type");
+                ++at;
+                return static_cast<double>(kind);
+            }
+            if (t.kind != Token::Number) fail("expected a number");
+            ++at;
+            return t.number;
+        }
+
+        Condition comparison() {
+            Condition c;
+            c.field = field();
+            if (accept("between")) {
+                c.op = Condition::Op::Between;
+                c.values.push_back(value(c.field));
+                expect("and");
+                c.values.push_back(value(c.field));
+                return c;
+            }
+            if (accept("in")) {
+                c.op = Condition::Op::In;
+                expect("(");
+                do {
+                    c.values.push_back(value(c.field));
+                } while (accept(","));
+                expect(")");
+                return c;
+            }
+            const std::pair<const char*, Condition::Op> ops[] = {
+                {"=", Condition::Op::Equal}, {"!=", Condition::Op::NotEqual},
+                {"<", Condition::Op::Less}, {"<=", Condition::Op::LessEqual},
+                {">", Condition::Op::Greater}, {">=", Condition::Op::GreaterEqual}
+            };
+            for (const auto& op : ops) {
+                if (accept(op.first)) {
+                    if (c.field == QueryField::Type && op.second != Condition::Op::Equal &&
+                        op.second != Condition::Op::NotEqual) {
+                        --at;
+                        fail("type supports only =, != and in");
+                    }
+                    c.op = op.second;
+                    c.values.push_back(value(c.field));
+                    return c;
+                }
+            }
+            fail("expected a comparison");
+        }
+
+        Condition unary() {
+            if (!is("not") && !is("(")) {
+                return comparison();
+            }
+            // Разбор рекурсивный: глубина ограничена, чтобы длинная цепочка
+            // not или скобок не переполнила стек
+            if (++depth > MAX_DEPTH) fail("condition nested too deep");
+            Condition c;
+            if (accept("not")) {
+                c.op = Condition::Op::Not;
+                c.children.push_back(unary());
+            } else {
+                expect("(");
+                c = disjunction();
+                expect(")");
+            }
+            --depth;
+            return c;
+        }
+
+        Condition chain(Condition::Op op, const char* word, Condition (QueryParser::*operand)()) {
+            Condition first = (this->*operand)();
+            if (!is(word)) return first;
+            Condition c;
+            c.op = op;
+            c.children.push_back(std::move(first));
+            while (accept(word)) {
+                c.children.push_back((this->*operand)());
+            }
+            return c;
+        }
+
+        Condition conjunction() {
+            return chain(Condition::Op::And, "and", &QueryParser::unary);
+        }
+
+        Condition disjunction() {
+            return chain(Condition::Op::Or, "or", &QueryParser::conjunction);
+        }
+
+        void column(Query& q) {
+            auto add = [&](Aggregate a, QueryField f, std::string name) {
+                q.columns.push_back(QueryColumn{a, f, std::move(name)});
+            };
+            if (accept("*")) {
+                for (QueryField f : {QueryField::Index, QueryField::Type, QueryField::Area,
+                                     QueryField::CenterX, QueryField::CenterY}) {
+                    add(Aggregate::None, f, FIELD_NAMES[slot(f)]);
+                }
+                return;
+            }
+            if (accept("count")) {
+                if (accept("(")) {
+                    expect("*");
+                    expect(")");
+                }
+                add(Aggregate::Count, QueryField::Index, "count");
+                return;
+            }
+            for (Aggregate a : {Aggregate::Sum, Aggregate::Avg, Aggregate::Min, Aggregate::Max}) {
+                const char* name = AGGREGATE_NAMES[static_cast<size_t>(a)];
+                if (is(name) && tokens[at + 1].text == "(") {
+                    at += 2;
+                    QueryField f = field();
+                    expect(")");
+                    add(a, f, std::string(name) + "(" + FIELD_NAMES[slot(f)] + ")");
+                    return;
+                }
+            }
+            if (accept("center")) {
+                add(Aggregate::None, QueryField::CenterX, "center.x");
+                add(Aggregate::None, QueryField::CenterY, "center.y");
+                return;
+            }
+            if (accept("bbox")) {
+                for (QueryField f : {QueryField::MinX, QueryField::MinY, QueryField::MaxX, QueryField::MaxY}) {
+                    add(Aggregate::None, f, FIELD_NAMES[slot(f)]);
+                }
+                return;
+            }
+            QueryField f = field();
+            add(Aggregate::None, f, FIELD_NAMES[slot(f)]);
+        }
+    public:
+        explicit QueryParser(const std::vector<Token>& input) : tokens(input) {}
+
+        Query parse() {
+            Query q;
+            expect("select");
+            size_t first = at;
+            do {
+                column(q);
+            } while (accept(","));
+            bool plain = false;
+            for (const QueryColumn& c : q.columns) {
+                (c.aggregate == Aggregate::None ? plain : q.aggregate) = true;
+            }
+            if (plain && q.aggregate) {
+                at = first;
+                fail("cannot mix aggregates and per-figure columns");
+            }
+            if (accept("where")) {
+                q.where = disjunction();
+                q.filtered = true;
+            }
+            if (accept("limit")) {
+                const Token& t = tokens[at];
+                if (t.kind != Token::Number || t.number < 0 || t.number != std::floor(t.number)) {
+                    fail("expected a non-negative integer");
+                }
+                // Приведение числа больше size_t не определено
+                const double most = static_cast<double>(std::numeric_limits<size_t>::max());
+                q.limit = t.number >= most ? std::numeric_limits<size_t>::max() : static_cast<size_t>(t.number);
+                ++at;
+            }
+            if (tokens[at].kind != Token::End) fail("unexpected token");
+            return q;
+        }
+};
+
+// ---- Выполнение ----
+
+// Столбцы полей для фигур блока
+struct Block {
+    size_t count = 0;
+    size_t rows[BLOCK];
+    double column[FIELDS][BLOCK];
+};
+
+struct Accumulator {
+    size_t count = 0;
+    double sum = 0.0;
+    double min = std::numeric_limits<double>::infinity();
+    double max = -std::numeric_limits<double>::infinity();
+
+    void merge(const Accumulator& other) {
+        count += other.count;
+        sum += other.sum;
+        min = std::min(min, other.min);
+        max = std::max(max, other.max);
+    }
+    double result(Aggregate a) const {
+        const double nan = std::numeric_limits<double>::quiet_NaN();
+        switch (a) {
+            case Aggregate::Count: return static_cast<double>(count);
+            case Aggregate::Sum: return sum;
+            case Aggregate::Avg: return count ? sum / count : nan;
+            case Aggregate::Min: return count ? min : nan;
+            case Aggregate::Max: return count ? max : nan;
+            default: return nan;
+        }
+    }
+};
+
+void markFields(const Condition& c, bool* need) {
+    if (c.op == Condition::Op::And || c.op == Condition::Op::Or || c.op == Condition::Op::Not) {
+        for (const Condition& child : c.children) markFields(child, need);
+    } else {
+        need[slot(c.field)] = true;
+    }
+}
+
+// Условия верхнего уровня, соединённые and
+std::vector<const Condition*> conjuncts(const Query& q) {
+    std::vector<const Condition*> out;
+    if (!q.filtered) return out;
+    if (q.where.op == Condition::Op::And) {
+        for (const Condition& c : q.where.children) out.push_back(&c);
+    } else {
+        out.push_back(&q.where);
+    }
+    return out;
+}
+
+// Множество видов, которому равносильно условие (бит на код вида):
+// type =, type in, type != и их or. false — условие не только о виде
+bool kindSet(const Condition& c, unsigned& kinds) {
+    if (c.op == Condition::Op::Or) {
+        kinds = 0;
+        for (const Condition& child : c.children) {
+            unsigned part;
+            if (!kindSet(child, part)) return false;
+            kinds |= part;
+        }
+        return true;
+    }
+    if (c.op == Condition::Op::And || c.op == Condition::Op::Not || c.field != QueryField::Type) {
+        return false;
+    }
+    kinds = 0;
+    for (double v : c.values) kinds |= 1u << static_cast<unsigned>(v);
+    if (c.op == Condition::Op::NotEqual) kinds = ~kinds & 0xFFu;
+    return true;
+}
+
+// Виды, допустимые по условиям верхнего уровня
+unsigned kindMask(const Query& q) {
+    unsigned mask = 0xFF;
+    for (const Condition* c : conjuncts(q)) {
+        unsigned kinds;
+        if (kindSet(*c, kinds)) mask &= kinds;
+    }
+    return mask;
+}
+
+void computeColumns(const FigureBuffer& figures, const std::vector<size_t>& ids, const bool* need, Block& b) {
+    for (size_t k = 0; k < b.count; ++k) {
+        size_t i = b.rows[k];
+        b.column[slot(QueryField::Index)][k] = static_cast<double>(ids.empty() ? i : ids[i]);
+        b.column[slot(QueryField::Type)][k] = static_cast<double>(figures.kind(i));
+        b.column[slot(QueryField::Vertices)][k] = static_cast<double>(figures.apexCount(i));
+    }
+    if (need[slot(QueryField::Area)]) {
+        for (size_t k = 0; k < b.count; ++k) {
+            b.column[slot(QueryField::Area)][k] = figures.area(b.rows[k]);
+        }
+    }
+    if (need[slot(QueryField::CenterX)] || need[slot(QueryField::CenterY)]) {
+        for (size_t k = 0; k < b.count; ++k) {
+            auto c = figures.center(b.rows[k]);
+            b.column[slot(QueryField::CenterX)][k] = c.first;
+            b.column[slot(QueryField::CenterY)][k] = c.second;
+        }
+    }
+    if (need[slot(QueryField::MinX)] || need[slot(QueryField::MinY)] ||
+        need[slot(QueryField::MaxX)] || need[slot(QueryField::MaxY)]) {
+        for (size_t k = 0; k < b.count; ++k) {
+            size_t i = b.rows[k];
+            const double* xs = figures.xs(i);
+            const double* ys = figures.ys(i);
+            double minX = xs[0], maxX = xs[0], minY = ys[0], maxY = ys[0];
+            for (size_t j = 1; j < figures.apexCount(i); ++j) {
+                minX = std::min(minX, xs[j]);
+                maxX = std::max(maxX, xs[j]);
+                minY = std::min(minY, ys[j]);
+                maxY = std::max(maxY, ys[j]);
+            }
+            b.column[slot(QueryField::MinX)][k] = minX;
+            b.column[slot(QueryField::MinY)][k] = minY;
+            b.column[slot(QueryField::MaxX)][k] = maxX;
+            b.column[slot(QueryField::MaxY)][k] = maxY;
+        }
+    }
+}
+
+// Условие над столбцами блока: out[k] — 1, если строка k проходит.
+// Сравнения — простые циклы по столбцу, которые компилятор векторизует
+void evaluate(const Condition& c, const Block& b, unsigned char* out) {
+    const size_t n = b.count;
+    if (c.op == Condition::Op::And || c.op == Condition::Op::Or) {
+        evaluate(c.children[0], b, out);
+        unsigned char other[BLOCK];
+        for (size_t i = 1; i < c.children.size(); ++i) {
+            evaluate(c.children[i], b, other);
+            if (c.op == Condition::Op::And) {
+                for (size_t k = 0; k < n; ++k) out[k] &= other[k];
+            } else {
+                for (size_t k = 0; k < n; ++k) out[k] |= other[k];
+            }
+        }
+        return;
+    }
+    if (c.op == Condition::Op::Not) {
+        evaluate(c.children[0], b, out);
+        for (size_t k = 0; k < n; ++k) out[k] ^= 1;
+        return;
+    }
+    const double* x = b.column[slot(c.field)];
+    const double v = c.values[0];
+    switch (c.op) {
+        case Condition::Op::Less:
+            for (size_t k = 0; k < n; ++k) out[k] = x[k] < v;
+            break;
+        case Condition::Op::LessEqual:
+            for (size_t k = 0; k < n; ++k) out[k] = x[k] <= v;
+            break;
+        case Condition::Op::Greater:
+            for (size_t k = 0; k < n; ++k) out[k] = x[k] > v;
+            break;
+        case Condition::Op::GreaterEqual:
+            for (size_t k = 0; k < n; ++k) out[k] = x[k] >= v;
+            break;
+        case Condition::Op::Equal:
+            for (size_t k = 0; k < n; ++k) out[k] = x[k] == v;
+            break;
+        case Condition::Op::NotEqual:
+            for (size_t k = 0; k < n; ++k) out[k] = x[k] != v;
+            break;
+        case Condition::Op::Between: {
+            const double hi = c.values[1];
+            for (size_t k = 0; k < n; ++k) out[k] = (x[k] >= v) & (x[k] <= hi);
+            break;
+        }
+        case Condition::Op::In:
+            for (size_t k = 0; k < n; ++k) out[k] = 0;
+            for (double w : c.values) {
+                for (size_t k = 0; k < n; ++k) out[k] |= x[k] == w;
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+std::string number(double v) {
+    std::ostringstream ss;
+    ss << v;
+    return ss.str();
+}
+
+std::string describe(const Condition& c) {
+    if (c.op == Condition::Op::And || c.op == Condition::Op::Or) {
+        std::string out = "(";
+        for (size_t i = 0; i < c.children.size(); ++i) {
+            if (i) out += c.op == Condition::Op::And ? " and " : " or ";
+            out += describe(c.children[i]);
+        }
+        return out + ")";
+    }
+    if (c.op == Condition::Op::Not) {
+        return "not " + describe(c.children[0]);
+    }
+    auto value = [&](double v) {
+        return c.field == QueryField::Type ? std::string(kindName(static_cast<FigureKind>(v))) : number(v);
+    };
+    std::string out = FIELD_NAMES[slot(c.field)];
+    switch (c.op) {
+        case Condition::Op::Between:
+            return out + " between " + value(c.values[0]) + " and " + value(c.values[1]);
+        case Condition::Op::In: {
+            out += " in (";
+            for (size_t i = 0; i < c.values.size(); ++i) {
+                out += (i ? ", " : "") + value(c.values[i]);
+            }
+            return out + ")";
+        }
+        case Condition::Op::Less: return out + " < " + value(c.values[0]);
+        case Condition::Op::LessEqual: return out + " <= " + value(c.values[0]);
+        case Condition::Op::Greater: return out + " > " + value(c.values[0]);
+        case Condition::Op::GreaterEqual: return out + " >= " + value(c.values[0]);
+        case Condition::Op::Equal: return out + " = " + value(c.values[0]);
+        default: return out + " != " + value(c.values[0]);
+    }
+}
+
+} // namespace
+
+Query parseQuery(const std::string& text) {
+    std::vector<Token> tokens = tokenize(text);
+    return QueryParser(tokens).parse();
+}
+
+QueryResult runQuery(const Query& query, const FigureBuffer& figures, unsigned threads,
+                     const std::vector<size_t>& ids) {
+    QueryResult result;
+    for (const QueryColumn& c : query.columns) {
+        result.columns.push_back(c.name);
+        result.fields.push_back(c.aggregate == Aggregate::Count ? QueryField::Index : c.field);
+    }
+    bool need[FIELDS] = {};
+    for (const QueryColumn& c : query.columns) {
+        if (c.aggregate != Aggregate::Count) need[slot(c.field)] = true;
+    }
+    if (query.filtered) {
+        markFields(query.where, need);
+    }
+    const unsigned mask = kindMask(query);
+    const size_t columns = query.columns.size();
+    const size_t blocks = (figures.size() + BLOCK - 1) / BLOCK;
+
+    // Частичные результаты блоков: агрегаты или значения строк подряд
+    std::vector<Accumulator> partial(query.aggregate ? blocks * columns : 0);
+    std::vector<std::vector<double>> emitted(query.aggregate ? 0 : blocks);
+    std::vector<size_t> scanned(blocks, 0);
+    std::vector<size_t> produced(resolveThreads(threads), 0);
+
+    parallelFor(blocks, threads, [&](size_t begin, size_t end, size_t part) {
+        Block b;
+        unsigned char pass[BLOCK];
+        for (size_t block = begin; block < end && produced[part] < query.limit; ++block) {
+            // Фильтр по виду — до вычисления полей
+            b.count = 0;
+            size_t last = std::min(figures.size(), (block + 1) * BLOCK);
+            for (size_t i = block * BLOCK; i < last; ++i) {
+                b.rows[b.count] = i;
+                b.count += (mask >> static_cast<unsigned>(figures.kind(i))) & 1u;
+            }
+            scanned[block] = b.count;
+            if (b.count == 0) continue;
+            computeColumns(figures, ids, need, b);
+            if (query.filtered) {
+                evaluate(query.where, b, pass);
+            } else {
+                std::fill(pass, pass + b.count, 1);
+            }
+
+            if (query.aggregate) {
+                Accumulator* acc = &partial[block * columns];
+                for (size_t c = 0; c < columns; ++c) {
+                    const double* x = b.column[slot(query.columns[c].field)];
+                    Accumulator& a = acc[c];
+                    for (size_t k = 0; k < b.count; ++k) {
+                        if (!pass[k]) continue;
+                        ++a.count;
+                        a.sum += x[k];
+                        a.min = std::min(a.min, x[k]);
+                        a.max = std::max(a.max, x[k]);
+                    }
+                }
+            } else {
+                std::vector<double>& out = emitted[block];
+                for (size_t k = 0; k < b.count && produced[part] < query.limit; ++k) {
+                    if (!pass[k]) continue;
+                    for (size_t c = 0; c < columns; ++c) {
+                        out.push_back(b.column[slot(query.columns[c].field)][k]);
+                    }
+                    ++produced[part];
+                }
+            }
+        }
+    }, 16);
+
+    result.scanned = std::accumulate(scanned.begin(), scanned.end(), size_t(0));
+    if (query.aggregate) {
+        std::vector<Accumulator> total(columns);
+        for (size_t block = 0; block < blocks; ++block) {
+            for (size_t c = 0; c < columns; ++c) {
+                total[c].merge(partial[block * columns + c]);
+            }
+        }
+        std::vector<double> row;
+        for (size_t c = 0; c < columns; ++c) {
+            row.push_back(total[c].result(query.columns[c].aggregate));
+        }
+        result.rows.push_back(row);
+    } else {
+        for (const std::vector<double>& values : emitted) {
+            for (size_t k = 0; k + columns <= values.size() && result.rows.size() < query.limit; k += columns) {
+                result.rows.emplace_back(values.begin() + k, values.begin() + k + columns);
+            }
+        }
+    }
+
+    std::string plan = "проход блоками по " + std::to_string(BLOCK) + " фигур";
+    if (mask != 0xFF) {
+        plan += "; виды:";
+        for (FigureKind k : {FigureKind::Diamond, FigureKind::Pentagon, FigureKind::Hexagon, FigureKind::Polygon}) {
+            if ((mask >> static_cast<unsigned>(k)) & 1u) plan += std::string(" ") + kindName(k);
+        }
+    }
+    plan += "; поля:";
+    for (size_t f = 0; f < FIELDS; ++f) {
+        if (need[f]) plan += std::string(" ") + FIELD_NAMES[f];
+    }
+    if (query.filtered) {
+        plan += "; условие: " + describe(query.where);
+    }
+    result.plan = plan;
+    return result;
+}
+
+QueryResult runQuery(const Query& query, const FigureCollection& figures, const AreaIndex& index,
+                     unsigned threads) {
+    // Границы площади из условий верхнего уровня
+    double lo = -std::numeric_limits<double>::infinity();
+    double hi = std::numeric_limits<double>::infinity();
+    bool bounded = false;
+    for (const Condition* c : conjuncts(query)) {
+        if (c->field != QueryField::Area) continue;
+        switch (c->op) {
+            case Condition::Op::Less:
+            case Condition::Op::LessEqual:
+                hi = std::min(hi, c->values[0]);
+                break;
+            case Condition::Op::Greater:
+            case Condition::Op::GreaterEqual:
+                lo = std::max(lo, c->values[0]);
+                break;
+            case Condition::Op::Equal:
+            case Condition::Op::Between:
+            case Condition::Op::In:
+                lo = std::max(lo, *std::min_element(c->values.begin(), c->values.end()));
+                hi = std::min(hi, *std::max_element(c->values.begin(), c->values.end()));
+                break;
+            default:
+                continue;
+        }
+        bounded = true;
+    }
+
+    if (bounded && index.size() == figures.size()) {
+        // После transform площади в индексе умножены на коэффициент, а не
+        // пересчитаны по вершинам, и могут отличаться в последних битах:
+        // отбираем с запасом, точное условие проверит просмотр отобранных
+        double from = lo - INDEX_SLACK * std::fabs(lo);
+        double to = hi + INDEX_SLACK * std::fabs(hi);
+        std::vector<const Figure*> found = lo <= hi ? index.range(from, to) : std::vector<const Figure*>{};
+        if (found.size() * 2 < figures.size()) {
+            // Индекс упорядочен по площади; строки выводятся в порядке коллекции,
+            // поэтому отобранным фигурам находятся их номера. Номеров индекс
+            // не хранит (удаление сдвигает их), так что это проход по всей
+            // коллекции: O(n) сравнений адресов без чтения вершин
+            std::unordered_map<const Figure*, size_t> slots;
+            for (size_t k = 0; k < found.size(); ++k) {
+                slots.emplace(found[k], k);
+            }
+            std::vector<size_t> positions(found.size());
+            size_t i = 0;
+            figures.forEach([&](const Figure& fig) {
+                auto it = slots.find(&fig);
+                if (it != slots.end()) positions[it->second] = i;
+                ++i;
+            });
+            std::vector<size_t> order(found.size());
+            std::iota(order.begin(), order.end(), size_t(0));
+            std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return positions[a] < positions[b]; });
+            FigureBuffer selected;
+            std::vector<size_t> ids;
+            for (size_t k : order) {
+                selected.push(*found[k]);
+                ids.push_back(positions[k]);
+            }
+            QueryResult result = runQuery(query, selected, threads, ids);
+            result.plan = "индекс площади [" + number(lo) + ", " + number(hi) + "]: " + std::to_string(found.size()) +
+                          " из " + std::to_string(figures.size()) + " фигур, номера проходом по коллекции O(n); " + result.plan;
+            return result;
+        }
+    }
+    QueryResult result = runQuery(query, toBuffer(figures), threads);
+    result.plan = "полный просмотр " + std::to_string(figures.size()) + " фигур; " + result.plan;
+    return result;
+}
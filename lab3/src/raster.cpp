@@ -0,0 +1,238 @@
+#include "../include/raster.hpp"
+#include "../include/parallel.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+
+// Фигуры с числом вершин не больше этого хранятся в плитках целиком
+const size_t INLINE_APEXES = 8;
+// Признак записи-ссылки на фигуру буфера
+const std::uint32_t REFERENCE = 1u << 31;
+
+// Преобразование мировых координат в пиксельные (ось y направлена вниз)
+struct View {
+    double minX;
+    double maxY;
+    double scale;
+    double offX;
+    double offY;
+
+    double px(double x) const { return (x - minX) * scale + offX; }
+    double py(double y) const { return (maxY - y) * scale + offY; }
+};
+
+View makeView(const Extent& ext, size_t width, size_t height) {
+    double w = ext.width();
+    double h = ext.height();
+    double scale = 1.0;
+    if (w > 0 && h > 0) {
+        scale = std::min(width / w, height / h);
+    } else if (w > 0) {
+        scale = width / w;
+    } else if (h > 0) {
+        scale = height / h;
+    }
+    return {ext.minX, ext.maxY, scale, (width - w * scale) / 2.0, (height - h * scale) / 2.0};
+}
+
+// Первый отсчёт с центром не левее v: отсчёт k лежит в (k + 0.5) / samples
+long long firstSample(double v, unsigned samples) {
+    return static_cast<long long>(std::ceil(v * samples - 0.5));
+}
+
+} // namespace
+
+float Raster::at(size_t x, size_t y) const {
+    return coverage[y * width + x];
+}
+
+Raster rasterize(const FigureBuffer& figures, const RasterOptions& opts) {
+    if (opts.width == 0 || opts.height == 0 || opts.tile == 0) {
+        throw std::invalid_argument("Raster size must be positive");
+    }
+    if (opts.width > SIZE_MAX / sizeof(float) / opts.height) {
+        throw std::invalid_argument("Raster size is too large");
+    }
+    if (opts.samples < 1 || opts.samples > 16) {
+        throw std::invalid_argument("Samples per axis must be in [1, 16]");
+    }
+    Raster raster;
+    raster.width = opts.width;
+    raster.height = opts.height;
+    raster.coverage.assign(opts.width * opts.height, 0.0f);
+
+    Extent ext = opts.view.empty ? extentOf(figures, opts.threads) : opts.view;
+    if (ext.empty || figures.empty()) {
+        return raster;
+    }
+    const View view = makeView(ext, opts.width, opts.height);
+    const size_t T = opts.tile;
+    const size_t tilesX = (opts.width + T - 1) / T;
+    const size_t tilesY = (opts.height + T - 1) / T;
+    const long long W = static_cast<long long>(opts.width);
+    const long long H = static_cast<long long>(opts.height);
+
+    // Раскладка по плиткам: у каждой части свои потоки записей, части идут
+    // по возрастанию номеров фигур, так что порядок наложения фиксирован.
+    // Запись — число вершин и их пиксельные координаты (float), чтобы при
+    // заполнении плитки читать память подряд, а не обходить буфер вразброс.
+    // Многоугольники с числом вершин больше INLINE_APEXES хранятся номером
+    std::vector<std::vector<std::vector<std::uint32_t>>> bins(resolveThreads(opts.threads));
+    size_t parts = parallelFor(figures.size(), opts.threads, [&](size_t begin, size_t end, size_t part) {
+        auto& own = bins[part];
+        own.resize(tilesX * tilesY);
+        float pts[2 * INLINE_APEXES];
+        for (size_t i = begin; i < end; ++i) {
+            size_t n = figures.apexCount(i);
+            const double* xs = figures.xs(i);
+            const double* ys = figures.ys(i);
+            double minX = view.px(xs[0]), maxX = minX;
+            double minY = view.py(ys[0]), maxY = minY;
+            for (size_t j = 0; j < n; ++j) {
+                double x = view.px(xs[j]);
+                double y = view.py(ys[j]);
+                minX = std::min(minX, x);
+                maxX = std::max(maxX, x);
+                minY = std::min(minY, y);
+                maxY = std::max(maxY, y);
+                if (n <= INLINE_APEXES) {
+                    pts[2 * j] = static_cast<float>(x);
+                    pts[2 * j + 1] = static_cast<float>(y);
+                }
+            }
+            if (maxX < 0 || maxY < 0 || minX >= W || minY >= H) {
+                continue;
+            }
+            size_t cx0 = static_cast<size_t>(std::max(0.0, minX)) / T;
+            size_t cx1 = static_cast<size_t>(std::min<double>(W - 1, maxX)) / T;
+            size_t cy0 = static_cast<size_t>(std::max(0.0, minY)) / T;
+            size_t cy1 = static_cast<size_t>(std::min<double>(H - 1, maxY)) / T;
+            for (size_t ty = cy0; ty <= cy1; ++ty) {
+                for (size_t tx = cx0; tx <= cx1; ++tx) {
+                    auto& stream = own[ty * tilesX + tx];
+                    if (n <= INLINE_APEXES) {
+                        stream.push_back(static_cast<std::uint32_t>(n));
+                        size_t at = stream.size();
+                        stream.resize(at + 2 * n);
+                        std::memcpy(&stream[at], pts, 2 * n * sizeof(float));
+                    } else {
+                        stream.push_back(static_cast<std::uint32_t>(n) | REFERENCE);
+                        stream.push_back(static_cast<std::uint32_t>(i));
+                    }
+                }
+            }
+        }
+    });
+
+    // Плитки раздаются потокам по одной через общий счётчик: плотность
+    // фигур по изображению бывает очень неравномерной
+    const unsigned s = opts.samples;
+    const float perSample = 1.0f / static_cast<float>(s * s);
+    std::atomic<size_t> nextTile{0};
+    parallelFor(resolveThreads(opts.threads), opts.threads, [&](size_t, size_t, size_t) {
+        std::vector<double> px;
+        std::vector<double> py;
+        std::vector<double> crossings;
+        std::vector<std::uint16_t> counts;
+        for (size_t t = nextTile++; t < tilesX * tilesY; t = nextTile++) {
+            long long x0 = static_cast<long long>(t % tilesX * T);
+            long long y0 = static_cast<long long>(t / tilesX * T);
+            long long x1 = std::min(W, x0 + static_cast<long long>(T));
+            long long y1 = std::min(H, y0 + static_cast<long long>(T));
+            for (size_t part = 0; part < parts; ++part) {
+                if (bins[part].empty()) continue;
+                const std::vector<std::uint32_t>& stream = bins[part][t];
+                for (size_t at = 0; at < stream.size();) {
+                    size_t n = stream[at] & ~REFERENCE;
+                    px.resize(n);
+                    py.resize(n);
+                    if (stream[at] & REFERENCE) {
+                        size_t i = stream[at + 1];
+                        for (size_t j = 0; j < n; ++j) {
+                            px[j] = view.px(figures.xs(i)[j]);
+                            py[j] = view.py(figures.ys(i)[j]);
+                        }
+                        at += 2;
+                    } else {
+                        float pts[2 * INLINE_APEXES];
+                        std::memcpy(pts, &stream[at + 1], 2 * n * sizeof(float));
+                        for (size_t j = 0; j < n; ++j) {
+                            px[j] = pts[2 * j];
+                            py[j] = pts[2 * j + 1];
+                        }
+                        at += 1 + 2 * n;
+                    }
+                    auto [minX, maxX] = std::minmax_element(px.begin(), px.end());
+                    auto [minY, maxY] = std::minmax_element(py.begin(), py.end());
+                    long long fx0 = std::max(x0, static_cast<long long>(std::floor(*minX)));
+                    long long fx1 = std::min(x1, static_cast<long long>(std::floor(*maxX)) + 1);
+                    long long fy0 = std::max(y0, static_cast<long long>(std::floor(*minY)));
+                    long long fy1 = std::min(y1, static_cast<long long>(std::floor(*maxY)) + 1);
+                    if (fx0 >= fx1 || fy0 >= fy1) continue;
+                    long long cols = fx1 - fx0;
+                    counts.assign(static_cast<size_t>(cols * (fy1 - fy0)), 0);
+
+                    // Строки отсчётов внутри плитки и габаритов фигуры
+                    long long r0 = std::max(firstSample(*minY, s), fy0 * s);
+                    long long r1 = std::min(firstSample(*maxY, s), fy1 * s);
+                    for (long long r = r0; r < r1; ++r) {
+                        double y = (r + 0.5) / s;
+                        crossings.clear();
+                        for (size_t j = 0; j < n; ++j) {
+                            size_t k = (j + 1) % n;
+                            if ((py[j] <= y && y < py[k]) || (py[k] <= y && y < py[j])) {
+                                crossings.push_back(px[j] + (y - py[j]) * (px[k] - px[j]) / (py[k] - py[j]));
+                            }
+                        }
+                        std::sort(crossings.begin(), crossings.end());
+                        std::uint16_t* row = &counts[static_cast<size_t>((r / s - fy0) * cols)];
+                        for (size_t c = 0; c + 1 < crossings.size(); c += 2) {
+                            long long k0 = std::max(firstSample(crossings[c], s), fx0 * s);
+                            long long k1 = std::min(firstSample(crossings[c + 1], s), fx1 * s);
+                            if (k0 >= k1) continue;
+                            // Крайние пиксели отрезка покрыты частично, средние — всеми отсчётами строки
+                            long long p0 = k0 / s;
+                            long long p1 = (k1 - 1) / s;
+                            if (p0 == p1) {
+                                row[p0 - fx0] += static_cast<std::uint16_t>(k1 - k0);
+                                continue;
+                            }
+                            row[p0 - fx0] += static_cast<std::uint16_t>((p0 + 1) * s - k0);
+                            for (long long p = p0 + 1; p < p1; ++p) {
+                                row[p - fx0] += static_cast<std::uint16_t>(s);
+                            }
+                            row[p1 - fx0] += static_cast<std::uint16_t>(k1 - p1 * s);
+                        }
+                    }
+
+                    for (long long y = fy0; y < fy1; ++y) {
+                        float* dst = &raster.coverage[static_cast<size_t>(y * W + fx0)];
+                        const std::uint16_t* src = &counts[static_cast<size_t>((y - fy0) * cols)];
+                        for (long long x = 0; x < cols; ++x) {
+                            float f = src[x] * perSample;
+                            dst[x] += f * (1.0f - dst[x]);
+                        }
+                    }
+                }
+            }
+        }
+    }, 1);
+    return raster;
+}
+
+void writePgm(std::ostream& os, const Raster& raster) {
+    os << "P5\n" << raster.width << " " << raster.height << "\n255\n";
+    std::vector<unsigned char> row(raster.width);
+    for (size_t y = 0; y < raster.height; ++y) {
+        for (size_t x = 0; x < raster.width; ++x) {
+            float c = std::min(1.0f, std::max(0.0f, raster.at(x, y)));
+            row[x] = static_cast<unsigned char>(std::lround(255.0f * (1.0f - c)));
+        }
+        os.write(reinterpret_cast<const char*>(row.data()), static_cast<std::streamsize>(row.size()));
+    }
+}
@@ -0,0 +1,353 @@
+#include "../include/server.hpp"
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+
+// Не читаем новые запросы клиента, пока он не заберёт ответы
+const size_t MAX_PENDING_OUTPUT = 1 << 20;
+// Строка без перевода строки длиннее этого — ошибка протокола: отвечаем
+// и закрываем соединение, не накапливая буфер без конца
+const size_t MAX_LINE = 1 << 20;
+// Пауза в приёме соединений после исчерпания дескрипторов
+const std::chrono::milliseconds ACCEPT_BACKOFF(1000);
+
+// Команды, читающие или пишущие файлы по пути от клиента. По TCP их может
+// вызвать любой локальный пользователь, поэтому они доступны только через
+// Unix-сокет, доступ к которому ограничен правами на файл сокета
+bool touchesFiles(const std::string& command) {
+    static const char* const commands[] = {
+        "save", "load", "import", "export", "render", "ingest", "stream"
+    };
+    for (const char* c : commands) {
+        if (command == c) return true;
+    }
+    return false;
+}
+
+[[noreturn]] void fail(const std::string& what) {
+    throw std::runtime_error(what + ": " + std::strerror(errno));
+}
+
+void setNonBlocking(int fd) {
+    int flags = ::fcntl(fd, F_GETFL, 0);
+    ::fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+}
+
+// Разбор адреса в sockaddr; возвращает длину адреса
+socklen_t parseAddress(const std::string& address, sockaddr_storage& storage, int& family) {
+    std::memset(&storage, 0, sizeof(storage));
+    if (address.rfind("unix:", 0) == 0) {
+        std::string path = address.substr(5);
+        sockaddr_un* addr = reinterpret_cast<sockaddr_un*>(&storage);
+        if (path.empty() || path.size() >= sizeof(addr->sun_path)) {
+            throw std::invalid_argument("Invalid unix socket path");
+        }
+        addr->sun_family = AF_UNIX;
+        std::memcpy(addr->sun_path, path.c_str(), path.size() + 1);
+        family = AF_UNIX;
+        return sizeof(sockaddr_un);
+    }
+    if (address.rfind("tcp:", 0) == 0) {
+        std::string port = address.substr(4);
+        if (port.empty() || port.size() > 5 ||
+            port.find_first_not_of("0123456789") != std::string::npos ||
+            std::stoul(port) > 65535) {
+            throw std::invalid_argument("TCP port must be a number from 0 to 65535");
+        }
+        sockaddr_in* addr = reinterpret_cast<sockaddr_in*>(&storage);
+        addr->sin_family = AF_INET;
+        addr->sin_port = htons(static_cast<uint16_t>(std::stoul(port)));
+        addr->sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        family = AF_INET;
+        return sizeof(sockaddr_in);
+    }
+    throw std::invalid_argument("Address must be unix:<path> or tcp:<port>");
+}
+
+} // namespace
+
+Server::Server(Shell& shellRef, const std::string& address)
+    : shell(shellRef) {
+    sockaddr_storage storage;
+    int family;
+    socklen_t len = parseAddress(address, storage, family);
+    if (family == AF_UNIX) {
+        unixPath = address.substr(5);
+        ::unlink(unixPath.c_str());
+    }
+    remote = family != AF_UNIX;
+
+    listenFd = ::socket(family, SOCK_STREAM, 0);
+    if (listenFd < 0) fail("socket");
+    int one = 1;
+    ::setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    if (::bind(listenFd, reinterpret_cast<sockaddr*>(&storage), len) != 0) {
+        ::close(listenFd);
+        fail("bind");
+    }
+    if (::listen(listenFd, SOMAXCONN) != 0) {
+        ::close(listenFd);
+        fail("listen");
+    }
+    if (family == AF_INET) {
+        sockaddr_in bound;
+        socklen_t boundLen = sizeof(bound);
+        ::getsockname(listenFd, reinterpret_cast<sockaddr*>(&bound), &boundLen);
+        boundPort = ntohs(bound.sin_port);
+    }
+    setNonBlocking(listenFd);
+
+    epollFd = ::epoll_create1(0);
+    if (epollFd < 0) {
+        ::close(listenFd);
+        fail("epoll_create1");
+    }
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.fd = listenFd;
+    ::epoll_ctl(epollFd, EPOLL_CTL_ADD, listenFd, &ev);
+}
+
+Server::~Server() {
+    for (auto& item : connections) {
+        ::close(item.first);
+    }
+    ::close(epollFd);
+    ::close(listenFd);
+    if (!unixPath.empty()) {
+        ::unlink(unixPath.c_str());
+    }
+}
+
+void Server::run() {
+    std::vector<epoll_event> events(256);
+    while (!stopping.load()) {
+        if (!accepting && std::chrono::steady_clock::now() >= acceptResume) {
+            resumeAccepting();
+        }
+        int n = ::epoll_wait(epollFd, events.data(), static_cast<int>(events.size()), 200);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            fail("epoll_wait");
+        }
+        // Сначала выполняем запросы всех готовых клиентов, затем один раз
+        // фиксируем журнал и только после этого отправляем ответы
+        std::vector<int> ready;
+        for (int i = 0; i < n; ++i) {
+            int fd = events[i].data.fd;
+            if (fd == listenFd) {
+                acceptClients();
+                continue;
+            }
+            auto it = connections.find(fd);
+            if (it == connections.end()) continue;
+            if (events[i].events & (EPOLLHUP | EPOLLERR)) {
+                drop(fd);
+                continue;
+            }
+            if (events[i].events & EPOLLIN) {
+                handleInput(fd, it->second);
+                if (connections.find(fd) == connections.end()) continue;
+            }
+            ready.push_back(fd);
+        }
+        try {
+            shell.commit();
+        } catch (const std::exception& e) {
+            // Журнал отключён; клиенты продолжают работать с коллекцией в памяти
+            std::cerr << "Ошибка: " << e.what() << "\n";
+        }
+        for (int fd : ready) {
+            auto it = connections.find(fd);
+            if (it == connections.end()) continue;
+            if (!flush(fd, it->second)) {
+                drop(fd);
+                continue;
+            }
+            updateEvents(fd, it->second);
+        }
+    }
+}
+
+void Server::stop() {
+    stopping.store(true);
+}
+
+int Server::port() const {
+    return boundPort;
+}
+
+void Server::acceptClients() {
+    while (true) {
+        int fd = ::accept(listenFd, nullptr, nullptr);
+        if (fd < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) return;
+            // Клиент отключился, не дождавшись accept, — берём следующего
+            if (errno == EINTR || errno == ECONNABORTED || errno == EPROTO) continue;
+            // Дескрипторы или память кончились: listenFd остаётся готовым, и
+            // epoll без паузы крутил бы цикл вхолостую. Снимаем его с
+            // ожидания до закрытия какого-нибудь соединения или до таймаута
+            std::cerr << "Ошибка: accept: " << std::strerror(errno) << "\n";
+            pauseAccepting();
+            return;
+        }
+        setNonBlocking(fd);
+        int one = 1;
+        ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        connections[fd].events = EPOLLIN;
+        epoll_event ev{};
+        ev.events = EPOLLIN;
+        ev.data.fd = fd;
+        ::epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &ev);
+    }
+}
+
+void Server::pauseAccepting() {
+    ::epoll_ctl(epollFd, EPOLL_CTL_DEL, listenFd, nullptr);
+    accepting = false;
+    acceptResume = std::chrono::steady_clock::now() + ACCEPT_BACKOFF;
+}
+
+void Server::resumeAccepting() {
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.fd = listenFd;
+    ::epoll_ctl(epollFd, EPOLL_CTL_ADD, listenFd, &ev);
+    accepting = true;
+}
+
+void Server::handleInput(int fd, Connection& conn) {
+    if (conn.closing) {
+        return;   // после quit или ошибки протокола запросы не выполняем
+    }
+    char buf[65536];
+    while (conn.out.size() < MAX_PENDING_OUTPUT && conn.in.size() <= MAX_LINE) {
+        ssize_t got = ::read(fd, buf, sizeof(buf));
+        if (got > 0) {
+            conn.in.append(buf, static_cast<size_t>(got));
+            continue;
+        }
+        if (got == 0) {
+            conn.closing = true;   // клиент закрыл запись; ответим на то, что есть
+        } else if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+            drop(fd);
+            return;
+        }
+        break;
+    }
+
+    // Выполняем все полные строки по порядку; поиск перевода строки
+    // продолжается с места, до которого буфер уже просмотрен
+    size_t start = 0;
+    size_t from = conn.scanned;
+    while (true) {
+        size_t eol = conn.in.find('\n', from);
+        if (eol == std::string::npos) break;
+        std::string line = conn.in.substr(start, eol - start);
+        start = eol + 1;
+        from = start;
+        std::string first;
+        if (!(std::istringstream(line) >> first)) {
+            conn.out += ".\n";
+            continue;
+        }
+        std::istringstream request(line);
+        std::ostringstream response;
+        bool keep = true;
+        if (remote && touchesFiles(first)) {
+            conn.out += "Ошибка: команда " + first + " работает с файлами и доступна только через unix-сокет\n.\n";
+            continue;
+        }
+        try {
+            keep = shell.execute(request, response);
+        } catch (const std::exception& e) {
+            response << "Ошибка: " << e.what() << "\n";
+        }
+        conn.out += response.str();
+        conn.out += ".\n";
+        if (!keep) {
+            conn.closing = true;
+            start = conn.in.size();
+            break;
+        }
+    }
+    conn.in.erase(0, start);
+    conn.scanned = conn.in.size();
+
+    if (conn.in.size() > MAX_LINE) {
+        conn.out += "Ошибка: строка длиннее " + std::to_string(MAX_LINE) + " байт\n.\n";
+        conn.closing = true;
+        conn.in.clear();
+        conn.scanned = 0;
+    }
+}
+
+bool Server::flush(int fd, Connection& conn) {
+    while (!conn.out.empty()) {
+        ssize_t sent = ::send(fd, conn.out.data(), conn.out.size(), MSG_NOSIGNAL);
+        if (sent > 0) {
+            conn.out.erase(0, static_cast<size_t>(sent));
+            continue;
+        }
+        if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+            return true;
+        }
+        return false;
+    }
+    return !conn.closing;
+}
+
+void Server::updateEvents(int fd, Connection& conn) {
+    bool reading = !conn.closing && conn.out.size() < MAX_PENDING_OUTPUT;
+    std::uint32_t wanted = (reading ? static_cast<std::uint32_t>(EPOLLIN) : 0u) |
+                           (conn.out.empty() ? 0u : static_cast<std::uint32_t>(EPOLLOUT));
+    if (wanted == conn.events) {
+        return;
+    }
+    conn.events = wanted;
+    epoll_event ev{};
+    ev.events = wanted;
+    ev.data.fd = fd;
+    ::epoll_ctl(epollFd, EPOLL_CTL_MOD, fd, &ev);
+}
+
+void Server::drop(int fd) {
+    ::epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+    ::close(fd);
+    connections.erase(fd);
+    if (!accepting) {
+        resumeAccepting();   // освободился дескриптор
+    }
+}
+
+int connectToServer(const std::string& address) {
+    sockaddr_storage storage;
+    int family;
+    socklen_t len = parseAddress(address, storage, family);
+    int fd = ::socket(family, SOCK_STREAM, 0);
+    if (fd < 0) fail("socket");
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&storage), len) != 0) {
+        ::close(fd);
+        fail("connect");
+    }
+    if (family == AF_INET) {
+        int one = 1;
+        ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    }
+    return fd;
+}
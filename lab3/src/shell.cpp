@@ -0,0 +1,902 @@
+#include "../include/shell.hpp"
+#include "../include/diamond.hpp"
+#include "../include/pentagon.hpp"
+#include "../include/hexagon.hpp"
+#include "../include/polygon.hpp"
+#include "../include/archive.hpp"
+#include "../include/stream.hpp"
+#include "../include/bulk_loader.hpp"
+#include "../include/summary.hpp"
+#include "../include/transform.hpp"
+#include "../include/pipeline.hpp"
+#include "../include/coverage.hpp"
+#include "../include/memory_report.hpp"
+#include "../include/compact_buffer.hpp"
+#include "../include/raster.hpp"
+#include "../include/generator.hpp"
+#include "../include/arrow_ipc.hpp"
+#include "../include/json_format.hpp"
+#include "../include/query.hpp"
+#include "../include/parallel.hpp"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+
+// Команды выполняются в потоке вызывающего (у сервера — единственном),
+// поэтому размер одной команды generate ограничен
+const size_t MAX_GENERATE = 1000000;
+// Большие размеры render уменьшаются до этих пределов
+const size_t MAX_RASTER_SIDE = 8192;
+const size_t MAX_RASTER_SAMPLES = 16;
+
+// Вспомогательная функция: разбор положительного целого без знака и мусора
+bool parsePositive(const std::string& token, size_t& value) {
+    if (token.empty() || token.size() > 18 || token.find_first_not_of("0123456789") != std::string::npos) {
+        return false;
+    }
+    value = std::stoull(token);
+    return value > 0;
+}
+
+// Вспомогательная функция: вывод информации о фигуре
+void printFigureInfo(std::ostream& os, const Figure& fig) {
+    auto center = fig.getCenter();
+    double area = static_cast<double>(fig);
+    os << "Центр: (" << center.first << ", " << center.second << "), "
+       << "Площадь: " << area << "\n";
+}
+
+// Вспомогательная функция: подсчёт общей площади
+double totalArea(const FigureCollection& figures) {
+    double total = 0.0;
+    figures.forEach([&](const Figure& fig) {
+        total += static_cast<double>(fig);
+    });
+    return total;
+}
+
+// Вспомогательная функция: вывод результата запроса к индексу площадей
+void printFigures(std::ostream& os, const std::vector<const Figure*>& found) {
+    if (found.empty()) {
+        os << "Нет фигур.\n";
+    }
+    for (const Figure* fig : found) {
+        os << *fig << " — ";
+        printFigureInfo(os, *fig);
+    }
+}
+
+// Вспомогательная функция: вывод причин отказа проверки (не более limit фигур)
+void printFailures(std::ostream& os, const ValidationReport& report, size_t limit = 10) {
+    for (size_t i = 0; i < report.failures.size() && i < limit; ++i) {
+        os << "  [" << report.failures[i].first << "] " << describeErrors(report.failures[i].second) << "\n";
+    }
+    if (report.failures.size() > limit) {
+        os << "  ... и ещё " << report.failures.size() - limit << "\n";
+    }
+}
+
+// Вспомогательная функция: добавление загруженных фигур в коллекцию.
+// При включённой проверке (validation != nullptr) некорректные фигуры отбрасываются
+size_t ingest(std::ostream& os, FigureCollection& figures, AreaIndex& index, Extent& extent,
+              const FigureBuffer& loaded, const ValidationOptions* validation) {
+    const FigureBuffer* accepted = &loaded;
+    FigureBuffer filtered;
+    if (validation) {
+        ValidationReport report = validateAll(loaded, *validation);
+        if (!report.failures.empty()) {
+            os << "Отклонено фигур: " << report.failures.size() << "\n";
+            printFailures(os, report);
+            filtered = dropInvalid(loaded, report);
+            accepted = &filtered;
+        }
+    }
+    // Фигуры добавляются в копию (она разделяет куски с коллекцией) и
+    // подменяют коллекцию только целиком: исключение посреди разбора
+    // оставляет коллекцию, индекс и габариты прежними
+    FigureCollection next = figures;
+    for (size_t i = 0; i < accepted->size(); ++i) {
+        next.push_back(accepted->materialize(i));
+    }
+    figures = std::move(next);
+    index.build(figures);
+    extent.merge(extentOf(*accepted));
+    return accepted->size();
+}
+
+// Вспомогательная функция: аргументы команды до конца строки. false, если
+// какой-то не прочитан или после них остались лишние слова
+template <typename... Args>
+bool readArgs(std::istream& is, Args&... args) {
+    std::string line;
+    std::getline(is, line);
+    std::istringstream in(line);
+    std::string extra;
+    return static_cast<bool>((in >> ... >> args)) && !(in >> extra);
+}
+
+// Вспомогательная функция: формат файла по расширению
+bool hasExtension(const std::string& path, const std::string& ext) {
+    return path.size() >= ext.size() && path.compare(path.size() - ext.size(), ext.size(), ext) == 0;
+}
+
+bool isArrowPath(const std::string& path) {
+    return hasExtension(path, ".arrow") || hasExtension(path, ".arrows") || hasExtension(path, ".feather");
+}
+
+// Вспомогательная функция: разбор цепочки преобразований
+//   translate <dx> <dy> | rotate <градусы> [at <x> <y>] | scale <sx> [<sy>] [at <x> <y>]
+// и необязательного списка индексов "on <i> <j> ..."
+bool parseTransform(std::istream& is, Transform& tr, std::vector<size_t>& selection) {
+    std::vector<std::string> tokens;
+    std::string token;
+    while (is >> token) {
+        tokens.push_back(token);
+    }
+    size_t pos = 0;
+    auto number = [&](double& v) {
+        if (pos >= tokens.size()) return false;
+        std::istringstream ss(tokens[pos]);
+        if (!(ss >> v) || !ss.eof()) return false;
+        ++pos;
+        return true;
+    };
+    auto point = [&](double& px, double& py, bool& given) {
+        given = pos < tokens.size() && tokens[pos] == "at";
+        if (!given) return true;
+        ++pos;
+        return number(px) && number(py);
+    };
+    bool any = false;
+    while (pos < tokens.size() && tokens[pos] != "on") {
+        std::string op = tokens[pos++];
+        double a, b, px, py;
+        bool at;
+        if (op == "translate") {
+            if (!number(a) || !number(b)) return false;
+            tr.translate(a, b);
+        } else if (op == "rotate") {
+            if (!number(a) || !point(px, py, at)) return false;
+            a *= M_PI / 180.0;
+            at ? tr.rotateAbout(a, px, py) : tr.rotate(a);
+        } else if (op == "scale") {
+            if (!number(a)) return false;
+            if (!number(b)) b = a;
+            if (!point(px, py, at)) return false;
+            at ? tr.scaleAbout(a, b, px, py) : tr.scale(a, b);
+        } else {
+            return false;
+        }
+        any = true;
+    }
+    if (pos < tokens.size()) {
+        ++pos;
+        double idx;
+        while (number(idx)) {
+            if (idx < 0) return false;
+            selection.push_back(static_cast<size_t>(idx));
+        }
+        if (pos != tokens.size() || selection.empty()) return false;
+    }
+    return any;
+}
+
+// Вспомогательная функция: преобразование фигур с обновлением индекса площадей.
+// Площадь многоугольника меняется ровно в |det| раз; площадь ромба считается
+// по диагоналям, поэтому при неподобном преобразовании она пересчитывается.
+// Фигуры, общие со снимками и историей, копируются перед изменением и меняют
+// адрес в индексе; при подобном преобразовании всей коллекции индекс
+// масштабируется целиком с переносом записей на копии
+std::vector<size_t> transformFigures(FigureCollection& figures, AreaIndex& index, const std::vector<size_t>& selection,
+                                     const Transform& tr) {
+    std::vector<size_t> targets = selection;
+    if (targets.empty()) {
+        targets.resize(figures.size());
+        for (size_t i = 0; i < targets.size(); ++i) targets[i] = i;
+    } else {
+        std::sort(targets.begin(), targets.end());
+        targets.erase(std::unique(targets.begin(), targets.end()), targets.end());
+        if (targets.back() >= figures.size()) {
+            throw std::out_of_range("Figure index out of range");
+        }
+    }
+
+    std::vector<const Figure*> before(targets.size());
+    std::vector<Figure*> after(targets.size());
+    for (size_t k = 0; k < targets.size(); ++k) {
+        before[k] = &figures[targets[k]];
+        after[k] = &figures.mutate(targets[k]);
+    }
+    parallelFor(after.size(), 0, [&](size_t begin, size_t end, size_t) {
+        for (size_t k = begin; k < end; ++k) {
+            applyTransform(*after[k], tr);
+        }
+    });
+
+    double factor = tr.areaFactor();
+    if (selection.empty() && tr.isSimilarity()) {
+        std::unordered_map<const Figure*, const Figure*> moved;
+        for (size_t k = 0; k < targets.size(); ++k) {
+            if (before[k] != after[k]) moved.emplace(before[k], after[k]);
+        }
+        index.rescale(factor, moved);
+        return targets;
+    }
+    for (size_t k = 0; k < targets.size(); ++k) {
+        const Figure& fig = *after[k];
+        if (before[k] != after[k]) {
+            index.erase(*before[k]);
+            index.insert(fig);
+        } else if (tr.isSimilarity() || !dynamic_cast<const Diamond*>(&fig)) {
+            index.rescale(fig, factor);
+        } else {
+            index.erase(fig);
+            index.insert(fig);
+        }
+    }
+    return targets;
+}
+
+// Вспомогательная функция: сводка по видам фигур
+void printSummary(std::ostream& os, const Summary& summary) {
+    const std::pair<const char*, const KindSummary*> rows[] = {
+        {"Ромбы", &summary[FigureKind::Diamond]},
+        {"Пятиугольники", &summary[FigureKind::Pentagon]},
+        {"Шестиугольники", &summary[FigureKind::Hexagon]},
+        {"Многоугольники", &summary[FigureKind::Polygon]},
+        {"Всего", &summary.all},
+    };
+    for (const auto& row : rows) {
+        const KindSummary& s = *row.second;
+        os << row.first << ": количество " << s.count;
+        if (s.count > 0) {
+            auto center = s.meanCenter();
+            os << ", сумма " << s.sum << ", мин " << s.min << ", макс " << s.max
+               << ", среднее " << s.mean << ", дисперсия " << s.variance()
+               << ", средний центр (" << center.first << ", " << center.second << ")";
+        }
+        os << "\n";
+    }
+}
+
+// Вспомогательная функция: занятая память по видам фигур и куча процесса
+void printMemory(std::ostream& os, const MemoryReport& report, const HeapStats& heap) {
+    const std::pair<const char*, FigureKind> rows[] = {
+        {"Ромбы", FigureKind::Diamond},
+        {"Пятиугольники", FigureKind::Pentagon},
+        {"Шестиугольники", FigureKind::Hexagon},
+        {"Многоугольники", FigureKind::Polygon},
+    };
+    for (const auto& row : rows) {
+        const KindMemory& k = report[row.second];
+        os << row.first << ": количество " << k.count;
+        if (k.count > 0) {
+            os << ", в куче " << k.heapBytes << " байт (" << k.heapBytes / k.count << " на фигуру)"
+               << ", объекты " << k.objectBytes << ", вершины " << k.vertexBytes;
+        }
+        os << "\n";
+    }
+    const ContainerMemory& c = report.container;
+    os << "Контейнер: в куче " << c.heapBytes << " байт, ёмкость массивов " << c.capacityBytes
+       << ", занято " << c.usedBytes << "\n"
+       << "Всего: " << report.heapBytes() << " байт, из них координаты " << report.vertexBytes()
+       << ", накладные расходы " << report.overheadBytes();
+    if (report.count() > 0) {
+        os << " (" << report.overheadBytes() / report.count() << " на фигуру)";
+    }
+    os << "\n"
+       << "Куча процесса: " << heap.liveBytes << " байт в " << heap.liveBlocks << " блоках, пик "
+       << heap.peakBytes << ", выделений " << heap.allocations << "\n";
+}
+
+// Вспомогательная функция: метрики стадий конвейера загрузки
+void printPipelineMetrics(std::ostream& os, const PipelineMetrics& metrics) {
+    os << "Время: " << metrics.seconds << " с\n";
+    for (const StageMetrics& m : metrics.stages) {
+        os << "  " << m.name << ": пакетов " << m.batches << ", фигур " << m.figures
+           << ", работа " << m.busySeconds << " с, ожидание " << m.waitSeconds << " с, "
+           << m.throughput() << " фигур/с\n";
+    }
+}
+
+// Вспомогательная функция: таблица результата запроса
+void printQueryResult(std::ostream& os, const QueryResult& result) {
+    for (size_t c = 0; c < result.columns.size(); ++c) {
+        os << (c ? "  " : "") << result.columns[c];
+    }
+    os << "\n";
+    for (const std::vector<double>& row : result.rows) {
+        for (size_t c = 0; c < row.size(); ++c) {
+            os << (c ? "  " : "");
+            if (std::isnan(row[c])) {
+                os << "-";
+            } else if (result.fields[c] == QueryField::Type) {
+                os << kindName(static_cast<FigureKind>(row[c]));
+            } else {
+                os << row[c];
+            }
+        }
+        os << "\n";
+    }
+    os << "Строк: " << result.rows.size() << "\n";
+}
+
+} // namespace
+
+// Вспомогательная функция: вывод агрегатов потоковой обработки
+void printStats(std::ostream& os, const FigureStats& stats) {
+    auto center = stats.meanCenter();
+    os << "Фигур: " << stats.count << "\n"
+       << "Общая площадь: " << stats.totalArea << "\n"
+       << "Средний центр: (" << center.first << ", " << center.second << ")\n";
+}
+
+Shell::Shell(bool interactiveMode)
+    : interactive(interactiveMode) {}
+
+void Shell::remember(FigureCollection state) {
+    history.push_back(std::move(state));
+    if (history.size() > HISTORY_LIMIT) {
+        history.pop_front();
+    }
+}
+
+void Shell::reset(const FigureCollection& state) {
+    figures = state;
+    areaIndex.build(figures);
+    extentDirty = true;
+    if (wal) {
+        try {
+            wal->checkpoint(figures);
+        } catch (const std::exception& e) {
+            resyncLog(e.what());
+        }
+    }
+}
+
+void Shell::logAdded(size_t count) {
+    logChange([&]() {
+        for (size_t i = figures.size() - count; i < figures.size(); ++i) {
+            wal->logAdd(figures[i]);
+        }
+    });
+}
+
+void Shell::logChange(const std::function<void()>& write) {
+    if (!wal) return;
+    std::string cause;
+    try {
+        write();
+        return;
+    } catch (const std::exception& e) {
+        cause = e.what();
+    }
+    // Часть записей могла попасть в файл: откатываем коллекцию и
+    // переписываем журнал целиком, чтобы память и файл не разошлись
+    figures = history.back();
+    history.pop_back();
+    areaIndex.build(figures);
+    extentDirty = true;
+    resyncLog(cause);
+    throw std::runtime_error("Write-ahead log failed (" + cause + "), command undone");
+}
+
+void Shell::resyncLog(const std::string& cause) {
+    try {
+        wal->checkpoint(figures);
+        return;
+    } catch (const std::exception&) {
+    }
+    wal.reset();
+    throw std::runtime_error("Write-ahead log failed (" + cause + "), logging stopped");
+}
+
+WalReplay Shell::attachLog(const std::string& path, const WalOptions& opts) {
+    wal.reset();
+    FigureCollection restored;
+    WalReplay replay = replayWal(path, restored);
+    history.clear();
+    figures = restored;
+    areaIndex.build(figures);
+    extentDirty = true;
+    wal = std::make_unique<WriteAheadLog>(path, opts, replay.validBytes);
+    return replay;
+}
+
+void Shell::commit() {
+    if (!wal) return;
+    try {
+        wal->commit();
+        if (wal->checkpointDue(figures.size())) {
+            wal->checkpoint(figures);
+        }
+    } catch (const std::exception& e) {
+        resyncLog(e.what());
+    }
+}
+
+void Shell::printHelp(std::ostream& os) {
+    os << "Доступные команды:\n"
+       << "  add diamond    — добавить ромб\n"
+       << "  add pentagon   — добавить пятиугольник\n"
+       << "  add hexagon    — добавить шестиугольник\n"
+       << "  add polygon <n> — добавить многоугольник из n вершин\n"
+       << "  list           — вывести все фигуры\n"
+       << "  total          — общая площадь\n"
+       << "  coverage       — покрытая площадь без учёта перекрытий дважды (время растёт с размером коллекции)\n"
+       << "  count          — число фигур\n"
+       << "  remove <индекс> — удалить фигуру по индексу (начиная с 0)\n"
+       << "  summary        — статистика площадей и центров по видам фигур\n"
+       << "  mem            — занятая память по видам фигур, накладные расходы, пик кучи и размер компактного хранения\n"
+       << "  transform <шаги> [on <индексы>] — translate dx dy, rotate град [at x y], scale sx [sy] [at x y]\n"
+       << "  validate [on [допуск] | off] — проверить коллекцию или включить проверку при вводе\n"
+       << "  extent         — ограничивающий прямоугольник коллекции\n"
+       << "  hull           — выпуклая оболочка всех вершин и её площадь\n"
+       << "  render <файл> [ширина высота [отсчёты]] — нарисовать коллекцию в PGM (до 8192 x 8192, до 16 отсчётов)\n"
+       << "  top <k>        — k фигур с наибольшей площадью\n"
+       << "  bottom <k>     — k фигур с наименьшей площадью\n"
+       << "  range <a> <b>  — фигуры с площадью от a до b\n"
+       << "  select <столбцы> [where <условие>] [limit n] — запрос к коллекции (select count, avg(area) where type = hexagon)\n"
+       << "  explain select ... — план выполнения запроса\n"
+       << "  save <файл> [точность] — сохранить фигуры в сжатый архив\n"
+       << "  load <файл>    — добавить фигуры из архива\n"
+       << "  import <файл>  — добавить фигуры из текстового дампа (параллельный разбор), Arrow (.arrow, .arrows) или JSON (.json)\n"
+       << "  export <файл>  — выгрузить фигуры в Arrow IPC (файл .arrow или поток .arrows) или в JSON (.json)\n"
+       << "  generate <n> [ключ=значение ...] — добавить n случайных фигур, не более 1000000 (seed, mix, layout, sizes, ...)\n"
+       << "  ingest <файл>  — добавить фигуры из текстового дампа конвейером разбор → проверка → вычисление\n"
+       << "  stream <файл>  — общая площадь и средний центр текстового дампа без загрузки в память\n"
+       << "  snapshot       — сохранить снимок коллекции\n"
+       << "  restore <id>   — вернуться к снимку\n"
+       << "  diff <id>      — число фигур, отличающихся от снимка\n"
+       << "  undo           — отменить последнее изменение коллекции\n"
+       << "  quit           — завершить программу\n\n";
+}
+
+bool Shell::execute(std::istream& is, std::ostream& os) {
+    std::string command;
+    if (!(is >> command)) {
+        return false;
+    }
+
+    if (command == "quit") {
+        return false;
+    }
+    else if (command == "add") {
+        std::string type;
+        is >> type;
+
+        std::unique_ptr<Figure> fig;
+        if (type == "diamond") {
+            fig = std::make_unique<Diamond>();
+            if (interactive) {
+                os << "Введите 4 вершины ромба (x1 y1 x2 y2 ... x4 y4):\n";
+            }
+        }
+        else if (type == "pentagon") {
+            fig = std::make_unique<Pentagon>();
+            if (interactive) {
+                os << "Введите 5 вершин пятиугольника (x1 y1 ... x5 y5):\n";
+            }
+        }
+        else if (type == "hexagon") {
+            fig = std::make_unique<Hexagon>();
+            if (interactive) {
+                os << "Введите 6 вершин шестиугольника (x1 y1 ... x6 y6):\n";
+            }
+        }
+        else if (type == "polygon") {
+            fig = std::make_unique<Polygon>();
+            if (interactive) {
+                os << "Введите число вершин и их координаты (n x1 y1 ... xn yn):\n";
+            }
+        }
+        else {
+            os << "Неизвестный тип фигуры: " << type << "\n";
+            return true;
+        }
+        if (!(is >> *fig)) {
+            is.clear();
+            std::string rest;
+            std::getline(is, rest);
+            os << "Ошибка: неверные координаты\n";
+            return true;
+        }
+        if (validateInput) {
+            std::uint32_t errors = validateFigure(*fig, validation);
+            if (errors != VALID) {
+                os << "Фигура отклонена: " << describeErrors(errors) << "\n";
+                return true;
+            }
+        }
+        remember(figures);
+        const Figure& added = figures.push_back(std::move(fig));
+        areaIndex.insert(added);
+        extent.add(added);
+        logChange([&]() { wal->logAdd(added); });
+    }
+    else if (command == "list") {
+        if (figures.empty()) {
+            os << "Нет фигур.\n";
+        } else {
+            size_t i = 0;
+            figures.forEach([&](const Figure& fig) {
+                os << "[" << i++ << "] ";
+                printFigureInfo(os, fig);
+            });
+        }
+    }
+    else if (command == "total") {
+        os << "Общая площадь: " << totalArea(figures) << "\n";
+    }
+    else if (command == "coverage") {
+        double total = totalArea(figures);
+        double covered = unionArea(toBuffer(figures));
+        os << "Покрытая площадь: " << covered << " (сумма площадей: " << total
+           << ", перекрытия: " << total - covered << ")\n";
+    }
+    else if (command == "remove") {
+        size_t index;
+        if (!readArgs(is, index)) {
+            os << "Ошибка: ожидается номер фигуры\n";
+        } else if (figures.empty()) {
+            os << "Ошибка: нет фигур\n";
+        } else if (index < figures.size()) {
+            remember(figures);
+            areaIndex.erase(figures[index]);
+            figures.erase(index);
+            extentDirty = true;
+            logChange([&]() { wal->logRemove(index); });
+            os << "Фигура удалена.\n";
+        } else {
+            os << "Ошибка: индекс вне диапазона [0, " << figures.size() - 1 << "]\n";
+        }
+    }
+    else if (command == "summary") {
+        printSummary(os, summarize(toBuffer(figures)));
+    }
+    else if (command == "mem") {
+        printMemory(os, measureMemory(figures), heapStats());
+        std::vector<const FigureCollection*> versions;
+        for (const FigureCollection& state : history) versions.push_back(&state);
+        for (const FigureCollection& state : snapshots) versions.push_back(&state);
+        MemoryReport extra = measureVersions(figures, versions);
+        os << "История и снимки (" << versions.size() << "): ещё " << extra.heapBytes()
+           << " байт, фигур вне коллекции " << extra.count() << "\n";
+        // Оценка по счётчикам: копии коллекции исказили бы пик кучи
+        CompactEstimate compact = estimateCompact(figures);
+        os << "Плоский буфер: " << compact.flatBytes << " байт, компактное хранение: "
+           << compact.compactBytes << " байт (правильных фигур " << compact.regular
+           << " из " << compact.figures << ")\n";
+    }
+    else if (command == "validate") {
+        std::string line;
+        std::getline(is, line);
+        std::istringstream args(line);
+        std::string mode;
+        args >> mode;
+        if (mode == "on") {
+            double tolerance;
+            if (args >> tolerance) {
+                validation.tolerance = tolerance;
+            }
+            validateInput = true;
+            os << "Проверка при вводе включена (допуск " << validation.tolerance << ")\n";
+        } else if (mode == "off") {
+            validateInput = false;
+            os << "Проверка при вводе выключена\n";
+        } else {
+            ValidationReport report = validateAll(toBuffer(figures), validation);
+            os << "Проверено фигур: " << report.checked
+               << ", некорректных: " << report.failures.size() << "\n";
+            printFailures(os, report);
+        }
+    }
+    else if (command == "transform") {
+        std::string line;
+        std::getline(is, line);
+        std::istringstream args(line);
+        Transform tr;
+        std::vector<size_t> selection;
+        if (!parseTransform(args, tr, selection)) {
+            os << "Ошибка: неверная цепочка преобразований\n";
+            return true;
+        }
+        try {
+            FigureCollection previous = figures;
+            std::vector<size_t> changed = transformFigures(figures, areaIndex, selection, tr);
+            remember(std::move(previous));
+            extentDirty = true;
+            logChange([&]() {
+                for (size_t i : changed) {
+                    wal->logAssign(i, figures[i]);
+                }
+            });
+            os << "Преобразовано фигур: " << changed.size() << "\n";
+        } catch (const std::exception& e) {
+            os << "Ошибка: " << e.what() << "\n";
+        }
+    }
+    else if (command == "extent") {
+        if (extentDirty) {
+            extent = extentOf(toBuffer(figures));
+            extentDirty = false;
+        }
+        if (extent.empty) {
+            os << "Нет фигур.\n";
+        } else {
+            os << "Габариты: x [" << extent.minX << ", " << extent.maxX << "], y ["
+               << extent.minY << ", " << extent.maxY << "], "
+               << extent.width() << " x " << extent.height() << "\n";
+        }
+    }
+    else if (command == "hull") {
+        auto hull = collectionHull(toBuffer(figures));
+        if (hull.empty()) {
+            os << "Нет фигур.\n";
+        } else {
+            os << "Оболочка (" << hull.size() << " вершин):";
+            for (const auto& p : hull) {
+                os << " (" << p.first << ", " << p.second << ")";
+            }
+            os << "\nПлощадь оболочки: " << polygonArea(hull) << "\n";
+        }
+    }
+    else if (command == "render") {
+        std::string path;
+        std::string rest;
+        RasterOptions opts;
+        is >> path;
+        std::getline(is, rest);
+        std::istringstream args(rest);
+        std::vector<std::string> tokens;
+        std::string token;
+        while (args >> token) tokens.push_back(token);
+        size_t sizes[3] = {opts.width, opts.height, opts.samples};
+        bool valid = !path.empty() && tokens.size() != 1 && tokens.size() <= 3;
+        for (size_t i = 0; valid && i < tokens.size(); ++i) {
+            valid = parsePositive(tokens[i], sizes[i]);
+        }
+        if (!valid) {
+            os << "Ошибка: ожидается render <файл> [ширина высота [отсчёты]] с положительными целыми\n";
+            return true;
+        }
+        opts.width = std::min(sizes[0], MAX_RASTER_SIDE);
+        opts.height = std::min(sizes[1], MAX_RASTER_SIDE);
+        opts.samples = static_cast<unsigned>(std::min(sizes[2], MAX_RASTER_SAMPLES));
+        try {
+            Raster raster = rasterize(toBuffer(figures), opts);
+            std::ofstream out(path, std::ios::binary);
+            writePgm(out, raster);
+            if (!out) {
+                throw std::runtime_error("Cannot write " + path);
+            }
+            os << "Изображение " << raster.width << " x " << raster.height << " записано в " << path << "\n";
+        } catch (const std::exception& e) {
+            os << "Ошибка: " << e.what() << "\n";
+        }
+    }
+    else if (command == "top" || command == "bottom") {
+        size_t k;
+        if (!readArgs(is, k)) {
+            os << "Ошибка: ожидается число фигур\n";
+            return true;
+        }
+        printFigures(os, command == "top" ? areaIndex.top(k) : areaIndex.bottom(k));
+    }
+    else if (command == "range") {
+        double lo, hi;
+        if (!readArgs(is, lo, hi)) {
+            os << "Ошибка: ожидаются границы площади: range <от> <до>\n";
+            return true;
+        }
+        printFigures(os, areaIndex.range(lo, hi));
+    }
+    else if (command == "select" || command == "explain") {
+        std::string line;
+        std::getline(is, line);
+        try {
+            if (command == "select") {
+                printQueryResult(os, runQuery(parseQuery("select" + line), figures, areaIndex));
+            } else {
+                QueryResult result = runQuery(parseQuery(line), figures, areaIndex);
+                os << "План: " << result.plan << "\n"
+                   << "Просмотрено фигур: " << result.scanned << ", строк: " << result.rows.size() << "\n";
+            }
+        } catch (const std::exception& e) {
+            os << "Ошибка: " << e.what() << "\n";
+        }
+    }
+    else if (command == "save") {
+        std::string path;
+        ArchiveOptions opts;
+        std::string rest;
+        is >> path;
+        std::getline(is, rest);
+        std::istringstream(rest) >> opts.precision;
+        std::ofstream out(path, std::ios::binary);
+        try {
+            writeArchive(out, toBuffer(figures), opts);
+            os << "Сохранено фигур: " << figures.size() << "\n";
+        } catch (const std::exception& e) {
+            os << "Ошибка: " << e.what() << "\n";
+        }
+    }
+    else if (command == "load") {
+        std::string path;
+        is >> path;
+        std::ifstream in(path, std::ios::binary);
+        try {
+            ArchiveReader reader(in);
+            FigureBuffer loaded = reader.readAll();
+            remember(figures);
+            size_t added = ingest(os, figures, areaIndex, extent, loaded, validateInput ? &validation : nullptr);
+            logAdded(added);
+            os << "Загружено фигур: " << added << "\n";
+        } catch (const std::exception& e) {
+            os << "Ошибка: " << e.what() << "\n";
+        }
+    }
+    else if (command == "import") {
+        std::string path;
+        is >> path;
+        try {
+            FigureBuffer loaded;
+            if (isArrowPath(path)) {
+                loaded = ArrowReader(path).readAll();
+            } else if (hasExtension(path, ".json")) {
+                std::ifstream in(path, std::ios::binary);
+                if (!in) {
+                    throw std::runtime_error("Cannot open " + path);
+                }
+                loaded = readJson(in);
+            } else {
+                loaded = loadFigures(path);
+            }
+            remember(figures);
+            size_t added = ingest(os, figures, areaIndex, extent, loaded, validateInput ? &validation : nullptr);
+            logAdded(added);
+            os << "Загружено фигур: " << added << "\n";
+        } catch (const std::exception& e) {
+            os << "Ошибка: " << e.what() << "\n";
+        }
+    }
+    else if (command == "export") {
+        std::string path;
+        is >> path;
+        std::ofstream out(path, std::ios::binary);
+        try {
+            if (!out) {
+                throw std::runtime_error("Cannot open file: " + path);
+            }
+            if (hasExtension(path, ".json")) {
+                writeJson(out, toBuffer(figures));
+            } else {
+                ArrowOptions opts;
+                opts.file = !hasExtension(path, ".arrows");
+                writeArrow(out, toBuffer(figures), opts);
+            }
+            os << "Выгружено фигур: " << figures.size() << "\n";
+        } catch (const std::exception& e) {
+            os << "Ошибка: " << e.what() << "\n";
+        }
+    }
+    else if (command == "generate") {
+        GeneratorOptions opts;
+        std::string line;
+        std::getline(is, line);
+        std::istringstream args(line);
+        std::string token;
+        try {
+            if (!(args >> token)) {
+                throw std::invalid_argument("Expected figure count");
+            }
+            setGeneratorOption(opts, "count=" + token);
+            while (args >> token) {
+                setGeneratorOption(opts, token);
+            }
+            if (opts.count > MAX_GENERATE || opts.clusters > MAX_GENERATE) {
+                throw std::invalid_argument("At most " + std::to_string(MAX_GENERATE) +
+                                            " figures and clusters per command");
+            }
+            FigureBuffer generated = generateFigures(opts);
+            remember(figures);
+            size_t added = ingest(os, figures, areaIndex, extent, generated, validateInput ? &validation : nullptr);
+            logAdded(added);
+            os << "Создано фигур: " << added << "\n";
+        } catch (const std::exception& e) {
+            os << "Ошибка: " << e.what() << "\n";
+        }
+    }
+    else if (command == "ingest") {
+        std::string path;
+        is >> path;
+        std::ifstream in(path, std::ios::binary);
+        if (!in) {
+            os << "Не удалось открыть файл: " << path << "\n";
+            return true;
+        }
+        PipelineOptions opts;
+        opts.validate = validateInput;
+        opts.validation = validation;
+        size_t added = 0;
+        size_t rejected = 0;
+        remember(figures);
+        try {
+            PipelineMetrics metrics = runIngestPipeline(in, [&](IngestBatch& batch) {
+                for (size_t i = 0; i < batch.figures.size(); ++i) {
+                    if (batch.errors[i] != VALID) {
+                        ++rejected;
+                        continue;
+                    }
+                    const Figure& fig = figures.push_back(batch.figures.materialize(i));
+                    areaIndex.insert(fig, batch.areas[i]);
+                    extent.add(fig);
+                    ++added;
+                }
+            }, opts);
+            os << "Загружено фигур: " << added << ", отклонено: " << rejected << "\n";
+            printPipelineMetrics(os, metrics);
+        } catch (const std::exception& e) {
+            os << "Ошибка: " << e.what() << " (загружено фигур: " << added << ")\n";
+        }
+        logAdded(added);
+    }
+    else if (command == "stream") {
+        std::string path;
+        is >> path;
+        std::ifstream in(path, std::ios::binary);
+        if (!in) {
+            os << "Не удалось открыть файл: " << path << "\n";
+            return true;
+        }
+        try {
+            printStats(os, streamStats(in));
+        } catch (const std::exception& e) {
+            os << "Ошибка: " << e.what() << "\n";
+        }
+    }
+    else if (command == "snapshot") {
+        snapshots.push_back(figures);
+        os << "Снимок " << snapshots.size() - 1 << " сохранён (фигур: " << figures.size() << ")\n";
+    }
+    else if (command == "restore" || command == "diff") {
+        size_t id;
+        if (!(is >> id) || id >= snapshots.size()) {
+            is.clear();
+            os << "Ошибка: нет такого снимка\n";
+        } else if (command == "restore") {
+            remember(figures);
+            reset(snapshots[id]);
+            os << "Восстановлен снимок " << id << " (фигур: " << figures.size() << ")\n";
+        } else {
+            CollectionDiff diff = figures.diff(snapshots[id]);
+            os << "Относительно снимка " << id << ": новых или изменённых фигур " << diff.added
+               << ", удалённых или изменённых " << diff.removed << "\n";
+        }
+    }
+    else if (command == "undo") {
+        if (history.empty()) {
+            os << "Нечего отменять.\n";
+        } else {
+            FigureCollection previous = std::move(history.back());
+            history.pop_back();
+            reset(previous);
+            os << "Отменено (фигур: " << figures.size() << ")\n";
+        }
+    }
+    else if (command == "count") {
+        os << "Фигур: " << figures.size() << "\n";
+    }
+    else {
+        os << "Неизвестная команда. Доступные: add, list, total, coverage, count, summary, mem, remove, validate, transform, extent, hull, render, top, bottom, range, select, explain, save, load, import, export, generate, ingest, stream, snapshot, restore, diff, undo, quit\n";
+    }
+    return true;
+}
+
+const FigureCollection& Shell::collection() const {
+    return figures;
+}
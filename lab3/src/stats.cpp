@@ -0,0 +1,33 @@
+#include "../include/stats.hpp"
+
+void FigureStats::add(const Figure& fig) {
+    auto center = fig.getCenter();
+    ++count;
+    totalArea += static_cast<double>(fig);
+    sumCenterX += center.first;
+    sumCenterY += center.second;
+}
+
+void FigureStats::add(const FigureBuffer& figures) {
+    for (size_t i = 0; i < figures.size(); ++i) {
+        auto center = figures.center(i);
+        totalArea += figures.area(i);
+        sumCenterX += center.first;
+        sumCenterY += center.second;
+    }
+    count += figures.size();
+}
+
+void FigureStats::merge(const FigureStats& other) {
+    count += other.count;
+    totalArea += other.totalArea;
+    sumCenterX += other.sumCenterX;
+    sumCenterY += other.sumCenterY;
+}
+
+std::pair<double, double> FigureStats::meanCenter() const {
+    if (count == 0) {
+        return {0.0, 0.0};
+    }
+    return {sumCenterX / count, sumCenterY / count};
+}
@@ -0,0 +1,33 @@
+#include "../include/stream.hpp"
+#include "../include/text_format.hpp"
+#include <future>
+#include <string>
+
+FigureStats streamStats(std::istream& is, size_t chunkBytes) {
+    ChunkReader reader(is, chunkBytes);
+    std::string chunk;
+
+    // Возвращает false, когда поток закончился
+    auto load = [&reader, &chunk](FigureBuffer& buf) {
+        size_t firstLine = 0;
+        buf.clear();
+        if (!reader.next(chunk, firstLine)) {
+            return false;
+        }
+        parseFigures(chunk.data(), chunk.data() + chunk.size(), buf, firstLine);
+        return true;
+    };
+
+    FigureStats stats;
+    FigureBuffer buffers[2];
+    size_t current = 0;
+    bool more = load(buffers[current]);
+    while (more) {
+        FigureBuffer& next = buffers[current ^ 1];
+        auto pending = std::async(std::launch::async, load, std::ref(next));
+        stats.add(buffers[current]);
+        more = pending.get();
+        current ^= 1;
+    }
+    return stats;
+}
@@ -0,0 +1,115 @@
+#include "../include/summary.hpp"
+#include "../include/parallel.hpp"
+#include <algorithm>
+
+namespace {
+
+template <typename Visit>
+Summary summarizeParallel(size_t n, unsigned threads, Visit visit) {
+    std::vector<Summary> partial(resolveThreads(threads));
+    size_t parts = parallelFor(n, threads, [&](size_t begin, size_t end, size_t part) {
+        Summary& local = partial[part];
+        for (size_t i = begin; i < end; ++i) {
+            visit(i, local);
+        }
+    });
+    Summary result;
+    for (size_t part = 0; part < parts; ++part) {
+        result.merge(partial[part]);
+    }
+    for (const auto& kind : result.kinds) {
+        result.all.merge(kind);
+    }
+    return result;
+}
+
+} // namespace
+
+void KindSummary::add(double area, const std::pair<double, double>& center) {
+    ++count;
+    sum += area;
+    if (count == 1) {
+        min = max = area;
+    } else {
+        min = std::min(min, area);
+        max = std::max(max, area);
+    }
+    double delta = area - mean;
+    mean += delta / count;
+    m2 += delta * (area - mean);
+    sumCenterX += center.first;
+    sumCenterY += center.second;
+}
+
+void KindSummary::merge(const KindSummary& other) {
+    if (other.count == 0) {
+        return;
+    }
+    if (count == 0) {
+        *this = other;
+        return;
+    }
+    // Параллельная формула Чана для дисперсии
+    size_t total = count + other.count;
+    double delta = other.mean - mean;
+    mean += delta * other.count / total;
+    m2 += other.m2 + delta * delta * (static_cast<double>(count) * other.count / total);
+    count = total;
+    sum += other.sum;
+    min = std::min(min, other.min);
+    max = std::max(max, other.max);
+    sumCenterX += other.sumCenterX;
+    sumCenterY += other.sumCenterY;
+}
+
+double KindSummary::variance() const {
+    return count == 0 ? 0.0 : m2 / count;
+}
+
+std::pair<double, double> KindSummary::meanCenter() const {
+    if (count == 0) {
+        return {0.0, 0.0};
+    }
+    return {sumCenterX / count, sumCenterY / count};
+}
+
+const KindSummary& Summary::operator[](FigureKind kind) const {
+    return kinds[kindSlot(kind)];
+}
+
+void Summary::merge(const Summary& other) {
+    for (size_t i = 0; i < kinds.size(); ++i) {
+        kinds[i].merge(other.kinds[i]);
+    }
+    all.merge(other.all);
+}
+
+Summary summarize(const FigureBuffer& figures, unsigned threads) {
+    return summarizeParallel(figures.size(), threads, [&](size_t i, Summary& local) {
+        FigureKind kind = figures.kind(i);
+        const double* xs = figures.xs(i);
+        const double* ys = figures.ys(i);
+        size_t n = figures.apexCount(i);
+        local.kinds[kindSlot(kind)].add(apexArea(kind, xs, ys, n), apexCenter(kind, xs, ys, n));
+    });
+}
+
+Summary summarize(const std::vector<std::unique_ptr<Figure>>& figures, unsigned threads) {
+    return summarizeParallel(figures.size(), threads, [&](size_t i, Summary& local) {
+        const Figure& fig = *figures[i];
+        FigureKind kind = kindOf(fig);
+        if (kind == FigureKind::Polygon) {
+            local.kinds[kindSlot(kind)].add(fig.calculateArea(), fig.getCenter());
+            return;
+        }
+        // Координаты читаются напрямую, без отдельных виртуальных вызовов на каждую метрику
+        double xs[6];
+        double ys[6];
+        const std::pair<double, double>* apxs = fig.apexData();
+        for (size_t j = 0; j < kindApexCount(kind); ++j) {
+            xs[j] = apxs[j].first;
+            ys[j] = apxs[j].second;
+        }
+        local.kinds[kindSlot(kind)].add(apexArea(kind, xs, ys), apexCenter(kind, xs, ys));
+    });
+}
@@ -0,0 +1,142 @@
+#include "../include/text_format.hpp"
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+
+bool isSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+const char* skipSpaces(const char* p, const char* end) {
+    while (p < end && isSpace(*p)) ++p;
+    return p;
+}
+
+const char* wordEnd(const char* p, const char* end) {
+    while (p < end && !isSpace(*p)) ++p;
+    return p;
+}
+
+[[noreturn]] void fail(size_t line, const std::string& what) {
+    throw std::runtime_error("Line " + std::to_string(line) + ": " + what);
+}
+
+} // namespace
+
+size_t parseFigures(const char* begin, const char* end, FigureBuffer& out, size_t firstLine) {
+    size_t line = firstLine;
+    size_t count = 0;
+    std::vector<double> xs(6);
+    std::vector<double> ys(6);
+    const char* p = begin;
+    while (p < end) {
+        const char* eol = static_cast<const char*>(std::memchr(p, '\n', end - p));
+        if (!eol) eol = end;
+
+        const char* q = skipSpaces(p, eol);
+        if (q != eol) {
+            const char* w = wordEnd(q, eol);
+            if (std::string(q, w) != "add") {
+                fail(line, "expected 'add'");
+            }
+            q = skipSpaces(w, eol);
+            w = wordEnd(q, eol);
+            FigureKind kind;
+            if (!parseKind(std::string(q, w), kind)) {
+                fail(line, "unknown figure type '" + std::string(q, w) + "'");
+            }
+            q = w;
+            size_t n = kindApexCount(kind);
+            if (kind == FigureKind::Polygon) {
+                q = skipSpaces(q, eol);
+                auto res = std::from_chars(q, eol, n);
+                if (res.ec != std::errc() || (res.ptr != eol && !isSpace(*res.ptr)) || n < 3) {
+                    fail(line, "expected vertex count of at least 3");
+                }
+                // Вершина занимает в строке не меньше четырёх символов ("x y ")
+                if (n > static_cast<size_t>(eol - q) / 4) {
+                    fail(line, "expected " + std::to_string(2 * n) + " coordinates");
+                }
+                q = res.ptr;
+                xs.resize(std::max(xs.size(), n));
+                ys.resize(std::max(ys.size(), n));
+            }
+            for (size_t i = 0; i < n; ++i) {
+                for (double* v : {&xs[i], &ys[i]}) {
+                    q = skipSpaces(q, eol);
+                    auto res = std::from_chars(q, eol, *v);
+                    if (res.ec != std::errc() || (res.ptr != eol && !isSpace(*res.ptr))) {
+                        fail(line, "expected " + std::to_string(2 * n) + " coordinates");
+                    }
+                    q = res.ptr;
+                }
+            }
+            if (skipSpaces(q, eol) != eol) {
+                fail(line, "unexpected trailing characters");
+            }
+            out.push(kind, xs.data(), ys.data(), n);
+            ++count;
+        }
+        p = eol + 1;
+        ++line;
+    }
+    return count;
+}
+
+void writeFigures(std::ostream& os, const FigureBuffer& figures) {
+    std::string out;
+    char num[32];
+    for (size_t i = 0; i < figures.size(); ++i) {
+        out += "add ";
+        out += kindName(figures.kind(i));
+        if (figures.kind(i) == FigureKind::Polygon) {
+            out += ' ';
+            out.append(num, std::to_chars(num, num + sizeof(num), figures.apexCount(i)).ptr);
+        }
+        const double* xs = figures.xs(i);
+        const double* ys = figures.ys(i);
+        for (size_t j = 0; j < figures.apexCount(i); ++j) {
+            for (double v : {xs[j], ys[j]}) {
+                out += ' ';
+                out.append(num, std::to_chars(num, num + sizeof(num), v).ptr);
+            }
+        }
+        out += '\n';
+        if (out.size() > (1 << 16)) {
+            os.write(out.data(), static_cast<std::streamsize>(out.size()));
+            out.clear();
+        }
+    }
+    os.write(out.data(), static_cast<std::streamsize>(out.size()));
+}
+
+ChunkReader::ChunkReader(std::istream& input, size_t chunk)
+    : is(input), chunkBytes(std::max<size_t>(chunk, 1)) {}
+
+bool ChunkReader::next(std::string& chunk, size_t& firstLine) {
+    chunk.swap(tail);
+    tail.clear();
+    while (is) {
+        size_t old = chunk.size();
+        chunk.resize(old + chunkBytes);
+        is.read(&chunk[old], static_cast<std::streamsize>(chunkBytes));
+        chunk.resize(old + static_cast<size_t>(is.gcount()));
+        // В хвосте перевода строки нет, так что достаточно искать в новых данных
+        if (chunk.find('\n', old) != std::string::npos) break;
+    }
+    if (is) {
+        size_t cut = chunk.rfind('\n');
+        tail.assign(chunk, cut + 1, std::string::npos);
+        chunk.resize(cut + 1);
+    }
+    if (chunk.empty()) {
+        return false;
+    }
+    firstLine = line;
+    line += static_cast<size_t>(std::count(chunk.begin(), chunk.end(), '\n'));
+    return true;
+}
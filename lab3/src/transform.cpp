@@ -0,0 +1,178 @@
+#include "../include/transform.hpp"
+#include "../include/parallel.hpp"
+#include <cmath>
+#include <stdexcept>
+
+namespace {
+
+// Произведение матриц 2x2 в построчной записи: out = x * y
+void mul(const double x[4], const double y[4], double out[4]) {
+    double r[4] = {
+        x[0] * y[0] + x[1] * y[2], x[0] * y[1] + x[1] * y[3],
+        x[2] * y[0] + x[3] * y[2], x[2] * y[1] + x[3] * y[3],
+    };
+    for (int i = 0; i < 4; ++i) out[i] = r[i];
+}
+
+// Применение матрицы к массивам координат
+void transformApexes(const Affine& A, double* xs, double* ys, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        double x = xs[i];
+        double y = ys[i];
+        xs[i] = A.a * x + A.b * y + A.tx;
+        ys[i] = A.c * x + A.d * y + A.ty;
+    }
+}
+
+void transformApexes(const Affine& A, std::pair<double, double>* apxs, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        apxs[i] = A.apply(apxs[i]);
+    }
+}
+
+std::pair<double, double> centerOf(const std::pair<double, double>* apxs, size_t n) {
+    double sum_x = 0.0;
+    double sum_y = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+        sum_x += apxs[i].first;
+        sum_y += apxs[i].second;
+    }
+    return {sum_x / n, sum_y / n};
+}
+
+} // namespace
+
+std::pair<double, double> Affine::apply(const std::pair<double, double>& p) const {
+    return {a * p.first + b * p.second + tx, c * p.first + d * p.second + ty};
+}
+
+double Affine::det() const {
+    return a * d - b * c;
+}
+
+void Transform::absolute(const double s[4], double ux, double uy) {
+    // x -> S * x + u:  L' = S L,  M' = S M,  t' = S t + u
+    mul(s, l, l);
+    mul(s, m, m);
+    double t0 = s[0] * t[0] + s[1] * t[1] + ux;
+    double t1 = s[2] * t[0] + s[3] * t[1] + uy;
+    t[0] = t0;
+    t[1] = t1;
+}
+
+void Transform::aroundCenter(const double s[4]) {
+    // x -> S (x - c') + c', где c' = (L + M) c + t — текущий центр:
+    //   L' = S L,  M' = (L + M) - S L,  t' = t
+    double sl[4];
+    mul(s, l, sl);
+    for (int i = 0; i < 4; ++i) {
+        m[i] = l[i] + m[i] - sl[i];
+        l[i] = sl[i];
+    }
+}
+
+Transform& Transform::translate(double dx, double dy) {
+    const double id[4] = {1.0, 0.0, 0.0, 1.0};
+    absolute(id, dx, dy);
+    return *this;
+}
+
+Transform& Transform::rotate(double angle) {
+    const double r[4] = {std::cos(angle), -std::sin(angle), std::sin(angle), std::cos(angle)};
+    aroundCenter(r);
+    return *this;
+}
+
+Transform& Transform::rotateAbout(double angle, double px, double py) {
+    const double r[4] = {std::cos(angle), -std::sin(angle), std::sin(angle), std::cos(angle)};
+    absolute(r, px - (r[0] * px + r[1] * py), py - (r[2] * px + r[3] * py));
+    return *this;
+}
+
+Transform& Transform::scale(double sx, double sy) {
+    const double s[4] = {sx, 0.0, 0.0, sy};
+    aroundCenter(s);
+    return *this;
+}
+
+Transform& Transform::scaleAbout(double sx, double sy, double px, double py) {
+    const double s[4] = {sx, 0.0, 0.0, sy};
+    absolute(s, px - sx * px, py - sy * py);
+    return *this;
+}
+
+Affine Transform::forCenter(const std::pair<double, double>& center) const {
+    Affine A;
+    A.a = l[0];
+    A.b = l[1];
+    A.c = l[2];
+    A.d = l[3];
+    A.tx = m[0] * center.first + m[1] * center.second + t[0];
+    A.ty = m[2] * center.first + m[3] * center.second + t[1];
+    return A;
+}
+
+bool Transform::usesCenter() const {
+    return m[0] != 0.0 || m[1] != 0.0 || m[2] != 0.0 || m[3] != 0.0;
+}
+
+double Transform::areaFactor() const {
+    return std::abs(l[0] * l[3] - l[1] * l[2]);
+}
+
+bool Transform::isSimilarity() const {
+    // Столбцы ортогональны и одной длины
+    const double eps = 1e-12;
+    double dot = l[0] * l[1] + l[2] * l[3];
+    double n0 = l[0] * l[0] + l[2] * l[2];
+    double n1 = l[1] * l[1] + l[3] * l[3];
+    return std::abs(dot) <= eps * (n0 + n1) && std::abs(n0 - n1) <= eps * (n0 + n1);
+}
+
+void applyTransform(Figure& fig, const Transform& tr) {
+    requireApexes(fig);
+    std::pair<double, double>* apxs = fig.apexData();
+    size_t n = fig.apexCount();
+    std::pair<double, double> center = tr.usesCenter() ? centerOf(apxs, n) : std::pair<double, double>{0.0, 0.0};
+    transformApexes(tr.forCenter(center), apxs, n);
+}
+
+void applyTransform(std::vector<std::unique_ptr<Figure>>& figures, const Transform& tr, unsigned threads) {
+    parallelFor(figures.size(), threads, [&](size_t begin, size_t end, size_t) {
+        for (size_t i = begin; i < end; ++i) {
+            applyTransform(*figures[i], tr);
+        }
+    });
+}
+
+void applyTransform(std::vector<std::unique_ptr<Figure>>& figures, const std::vector<size_t>& selection,
+                    const Transform& tr, unsigned threads) {
+    for (size_t i : selection) {
+        if (i >= figures.size()) {
+            throw std::out_of_range("Figure index out of range");
+        }
+    }
+    parallelFor(selection.size(), threads, [&](size_t begin, size_t end, size_t) {
+        for (size_t k = begin; k < end; ++k) {
+            applyTransform(*figures[selection[k]], tr);
+        }
+    });
+}
+
+void applyTransform(FigureBuffer& figures, const Transform& tr, unsigned threads) {
+    if (!tr.usesCenter()) {
+        // Одна матрица на все вершины: сплошной проход по массивам x и y
+        Affine A = tr.forCenter({0.0, 0.0});
+        parallelFor(figures.size(), threads, [&](size_t begin, size_t end, size_t) {
+            if (begin == end) return;
+            size_t count = figures.xs(end - 1) + figures.apexCount(end - 1) - figures.xs(begin);
+            transformApexes(A, figures.xs(begin), figures.ys(begin), count);
+        });
+        return;
+    }
+    parallelFor(figures.size(), threads, [&](size_t begin, size_t end, size_t) {
+        for (size_t i = begin; i < end; ++i) {
+            transformApexes(tr.forCenter(figures.center(i)), figures.xs(i), figures.ys(i), figures.apexCount(i));
+        }
+    });
+}
@@ -0,0 +1,193 @@
+#include "../include/validation.hpp"
+#include "../include/parallel.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+double cross(double ax, double ay, double bx, double by) {
+    return ax * by - ay * bx;
+}
+
+// Пересечение отрезков pq и rs (включая касание) с допуском eps на площадь
+bool segmentsIntersect(double px, double py, double qx, double qy,
+                       double rx, double ry, double sx, double sy, double eps) {
+    double d1 = cross(qx - px, qy - py, rx - px, ry - py);
+    double d2 = cross(qx - px, qy - py, sx - px, sy - py);
+    double d3 = cross(sx - rx, sy - ry, px - rx, py - ry);
+    double d4 = cross(sx - rx, sy - ry, qx - rx, qy - ry);
+    if (((d1 > eps && d2 < -eps) || (d1 < -eps && d2 > eps)) &&
+        ((d3 > eps && d4 < -eps) || (d3 < -eps && d4 > eps))) {
+        return true;
+    }
+    // Коллинеарные случаи: точка лежит на другом отрезке
+    auto onSegment = [eps](double ax, double ay, double bx, double by, double cx, double cy, double d) {
+        return std::abs(d) <= eps &&
+               std::min(ax, bx) - eps <= cx && cx <= std::max(ax, bx) + eps &&
+               std::min(ay, by) - eps <= cy && cy <= std::max(ay, by) + eps;
+    };
+    return onSegment(px, py, qx, qy, rx, ry, d1) || onSegment(px, py, qx, qy, sx, sy, d2) ||
+           onSegment(rx, ry, sx, sy, px, py, d3) || onSegment(rx, ry, sx, sy, qx, qy, d4);
+}
+
+} // namespace
+
+std::string describeErrors(std::uint32_t errors) {
+    if (errors == VALID) {
+        return "ok";
+    }
+    static const std::pair<std::uint32_t, const char*> names[] = {
+        {DEGENERATE, "degenerate"},
+        {RHOMBUS_SIDES, "unequal rhombus sides"},
+        {RHOMBUS_DIAGONALS, "diagonals do not bisect each other"},
+        {SELF_INTERSECTING, "self-intersecting"},
+        {NOT_CONVEX, "not convex"},
+        {WRONG_WINDING, "wrong winding"},
+        {NOT_FINITE, "non-finite coordinates"},
+    };
+    std::string out;
+    for (const auto& name : names) {
+        if (errors & name.first) {
+            if (!out.empty()) out += ", ";
+            out += name.second;
+        }
+    }
+    return out;
+}
+
+std::uint32_t validateApexes(FigureKind kind, const double* xs, const double* ys,
+                             const ValidationOptions& opts) {
+    return validateApexes(kind, xs, ys, kindApexCount(kind), opts);
+}
+
+std::uint32_t validateApexes(FigureKind kind, const double* xs, const double* ys, size_t n,
+                             const ValidationOptions& opts) {
+    std::uint32_t errors = VALID;
+    for (size_t i = 0; i < n; ++i) {
+        if (!std::isfinite(xs[i]) || !std::isfinite(ys[i])) {
+            return NOT_FINITE;
+        }
+    }
+    if (n < 3) {
+        return DEGENERATE;
+    }
+
+    // Масштаб фигуры — длина наибольшей стороны; допуски относительные
+    double fixed[6];
+    std::vector<double> heap;
+    double* len = fixed;
+    if (n > 6) {
+        heap.resize(n);
+        len = heap.data();
+    }
+    double scale = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+        size_t j = (i + 1) % n;
+        len[i] = std::hypot(xs[j] - xs[i], ys[j] - ys[i]);
+        scale = std::max(scale, len[i]);
+    }
+    double eps = opts.tolerance * scale;
+    double epsArea = opts.tolerance * scale * scale;
+
+    double area2 = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+        size_t j = (i + 1) % n;
+        area2 += xs[i] * ys[j] - xs[j] * ys[i];
+    }
+    bool degenerate = scale == 0.0 || std::abs(area2) <= epsArea;
+    for (size_t i = 0; i < n && !degenerate; ++i) {
+        degenerate = len[i] <= eps;
+    }
+    if (degenerate) {
+        return DEGENERATE;
+    }
+
+    if (kind == FigureKind::Diamond) {
+        double lo = *std::min_element(len, len + 4);
+        double hi = *std::max_element(len, len + 4);
+        if (hi - lo > eps) {
+            errors |= RHOMBUS_SIDES;
+        }
+        if (std::hypot(xs[0] + xs[2] - xs[1] - xs[3], ys[0] + ys[2] - ys[1] - ys[3]) > 2.0 * eps) {
+            errors |= RHOMBUS_DIAGONALS;
+        }
+    }
+
+    // Несмежные стороны не должны пересекаться
+    for (size_t i = 0; i < n; ++i) {
+        for (size_t j = i + 2; j < n; ++j) {
+            if (i == 0 && j == n - 1) continue;
+            if (segmentsIntersect(xs[i], ys[i], xs[(i + 1) % n], ys[(i + 1) % n],
+                                  xs[j], ys[j], xs[(j + 1) % n], ys[(j + 1) % n], epsArea)) {
+                errors |= SELF_INTERSECTING;
+            }
+        }
+    }
+
+    if (opts.requireConvex) {
+        bool pos = false;
+        bool neg = false;
+        for (size_t i = 0; i < n; ++i) {
+            size_t j = (i + 1) % n;
+            size_t k = (i + 2) % n;
+            double turn = cross(xs[j] - xs[i], ys[j] - ys[i], xs[k] - xs[j], ys[k] - ys[j]);
+            pos = pos || turn > epsArea;
+            neg = neg || turn < -epsArea;
+        }
+        if (pos && neg) {
+            errors |= NOT_CONVEX;
+        }
+    }
+
+    if ((opts.winding == Winding::CounterClockwise && area2 < 0.0) ||
+        (opts.winding == Winding::Clockwise && area2 > 0.0)) {
+        errors |= WRONG_WINDING;
+    }
+    return errors;
+}
+
+std::uint32_t validateFigure(const Figure& fig, const ValidationOptions& opts) {
+    FigureKind kind = kindOf(fig);
+    const std::pair<double, double>* apxs = fig.apexData();
+    size_t n = fig.apexCount();
+    std::vector<double> xs(n);
+    std::vector<double> ys(n);
+    for (size_t i = 0; i < n; ++i) {
+        xs[i] = apxs[i].first;
+        ys[i] = apxs[i].second;
+    }
+    return validateApexes(kind, xs.data(), ys.data(), n, opts);
+}
+
+ValidationReport validateAll(const FigureBuffer& figures, const ValidationOptions& opts, unsigned threads) {
+    std::vector<std::vector<std::pair<size_t, std::uint32_t>>> partial(resolveThreads(threads));
+    size_t parts = parallelFor(figures.size(), threads, [&](size_t begin, size_t end, size_t part) {
+        for (size_t i = begin; i < end; ++i) {
+            std::uint32_t errors = validateApexes(figures.kind(i), figures.xs(i), figures.ys(i),
+                                                  figures.apexCount(i), opts);
+            if (errors != VALID) {
+                partial[part].emplace_back(i, errors);
+            }
+        }
+    });
+    ValidationReport report;
+    report.checked = figures.size();
+    for (size_t part = 0; part < parts; ++part) {
+        report.failures.insert(report.failures.end(), partial[part].begin(), partial[part].end());
+    }
+    return report;
+}
+
+FigureBuffer dropInvalid(const FigureBuffer& figures, const ValidationReport& report) {
+    FigureBuffer out;
+    out.reserve(figures.size() - report.failures.size(), figures.apexTotal());
+    size_t next = 0;
+    for (size_t i = 0; i < figures.size(); ++i) {
+        if (next < report.failures.size() && report.failures[next].first == i) {
+            ++next;
+            continue;
+        }
+        out.push(figures.kind(i), figures.xs(i), figures.ys(i), figures.apexCount(i));
+    }
+    return out;
+}
@@ -0,0 +1,408 @@
+#include "../include/wal.hpp"
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <vector>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+const char MAGIC[4] = {'F', 'W', 'A', 'L'};
+const std::uint32_t VERSION = 1;
+const size_t HEADER_SIZE = 8;          // magic, version
+const size_t RECORD_HEADER_SIZE = 8;   // длина, контрольная сумма
+
+enum Op : std::uint8_t {
+    OP_ADD = 1,
+    OP_REMOVE = 2,
+    OP_ASSIGN = 3
+};
+
+[[noreturn]] void fail(const std::string& what) {
+    throw std::runtime_error(what + ": " + std::strerror(errno));
+}
+
+void putU32(std::string& out, std::uint32_t v) {
+    for (int i = 0; i < 4; ++i) out.push_back(static_cast<char>((v >> (8 * i)) & 0xFF));
+}
+
+void putU64(std::string& out, std::uint64_t v) {
+    for (int i = 0; i < 8; ++i) out.push_back(static_cast<char>((v >> (8 * i)) & 0xFF));
+}
+
+void putDouble(std::string& out, double v) {
+    std::uint64_t bits;
+    std::memcpy(&bits, &v, sizeof(bits));
+    putU64(out, bits);
+}
+
+std::uint32_t getU32(const unsigned char* p) {
+    std::uint32_t v = 0;
+    for (int i = 0; i < 4; ++i) v |= static_cast<std::uint32_t>(p[i]) << (8 * i);
+    return v;
+}
+
+std::uint64_t getU64(const unsigned char* p) {
+    std::uint64_t v = 0;
+    for (int i = 0; i < 8; ++i) v |= static_cast<std::uint64_t>(p[i]) << (8 * i);
+    return v;
+}
+
+double getDouble(const unsigned char* p) {
+    std::uint64_t bits = getU64(p);
+    double v;
+    std::memcpy(&v, &bits, sizeof(v));
+    return v;
+}
+
+std::uint32_t checksum(const char* p, size_t n) {
+    std::uint32_t h = 2166136261u;
+    for (size_t i = 0; i < n; ++i) {
+        h ^= static_cast<unsigned char>(p[i]);
+        h *= 16777619u;
+    }
+    return h;
+}
+
+std::string header() {
+    std::string out(MAGIC, sizeof(MAGIC));
+    putU32(out, VERSION);
+    return out;
+}
+
+// Полная запись: заголовок записи и данные
+void frame(std::string& out, const std::string& payload) {
+    putU32(out, static_cast<std::uint32_t>(payload.size()));
+    putU32(out, checksum(payload.data(), payload.size()));
+    out += payload;
+}
+
+// Вид фигуры, для многоугольника ещё число вершин (u32), затем координаты
+void putFigure(std::string& out, FigureKind kind, const double* xs, const double* ys, size_t n) {
+    out.push_back(static_cast<char>(kind));
+    if (kind == FigureKind::Polygon) {
+        putU32(out, static_cast<std::uint32_t>(n));
+    }
+    for (size_t i = 0; i < n; ++i) {
+        putDouble(out, xs[i]);
+        putDouble(out, ys[i]);
+    }
+}
+
+void putFigure(std::string& out, const Figure& fig) {
+    const std::pair<double, double>* apxs = requireApexes(fig);
+    FigureKind kind = kindOf(fig);
+    out.push_back(static_cast<char>(kind));
+    if (kind == FigureKind::Polygon) {
+        putU32(out, static_cast<std::uint32_t>(fig.apexCount()));
+    }
+    for (size_t i = 0; i < fig.apexCount(); ++i) {
+        putDouble(out, apxs[i].first);
+        putDouble(out, apxs[i].second);
+    }
+}
+
+// Разбор фигуры из данных записи; false, если размер не сходится
+bool getFigure(const unsigned char* p, size_t size, FigureKind& kind,
+               std::vector<double>& xs, std::vector<double>& ys) {
+    if (size < 1 || !isValidKind(p[0])) return false;
+    kind = static_cast<FigureKind>(p[0]);
+    size_t n = kindApexCount(kind);
+    size_t head = 1;
+    if (kind == FigureKind::Polygon) {
+        if (size < 5) return false;
+        n = getU32(p + 1);
+        head = 5;
+        if (n < 3) return false;
+    }
+    if ((size - head) / 16 != n || (size - head) % 16 != 0) return false;
+    xs.resize(n);
+    ys.resize(n);
+    for (size_t i = 0; i < n; ++i) {
+        xs[i] = getDouble(p + head + 16 * i);
+        ys[i] = getDouble(p + head + 8 + 16 * i);
+    }
+    return true;
+}
+
+void writeAll(int fd, const char* data, size_t size) {
+    while (size > 0) {
+        ssize_t done = ::write(fd, data, size);
+        if (done < 0) {
+            if (errno == EINTR) continue;
+            fail("WAL write failed");
+        }
+        data += done;
+        size -= static_cast<size_t>(done);
+    }
+}
+
+void syncDirectory(const std::string& path) {
+    size_t slash = path.rfind('/');
+    std::string dir = slash == std::string::npos ? "." : (slash == 0 ? "/" : path.substr(0, slash));
+    int fd = ::open(dir.c_str(), O_RDONLY | O_DIRECTORY);
+    if (fd >= 0) {
+        ::fsync(fd);
+        ::close(fd);
+    }
+}
+
+} // namespace
+
+bool parseDurability(const std::string& name, Durability& durability) {
+    if (name == "off") {
+        durability = Durability::Off;
+    } else if (name == "batch") {
+        durability = Durability::Batch;
+    } else if (name == "op") {
+        durability = Durability::PerOp;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+const char* durabilityName(Durability durability) {
+    switch (durability) {
+        case Durability::Off: return "off";
+        case Durability::Batch: return "batch";
+        case Durability::PerOp: return "op";
+    }
+    return "unknown";
+}
+
+WalReplay replayWal(const std::string& path, FigureCollection& figures) {
+    WalReplay result;
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        return result;
+    }
+    std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    if (data.size() < HEADER_SIZE) {
+        result.tornTail = !data.empty();
+        return result;
+    }
+    if (std::memcmp(data.data(), MAGIC, sizeof(MAGIC)) != 0 ||
+        getU32(reinterpret_cast<const unsigned char*>(data.data()) + 4) != VERSION) {
+        throw std::runtime_error("Not a write-ahead log: " + path);
+    }
+
+    const unsigned char* base = reinterpret_cast<const unsigned char*>(data.data());
+    size_t pos = HEADER_SIZE;
+    std::vector<double> xs;
+    std::vector<double> ys;
+    FigureKind kind;
+    while (pos + RECORD_HEADER_SIZE <= data.size()) {
+        size_t size = getU32(base + pos);
+        std::uint32_t sum = getU32(base + pos + 4);
+        const unsigned char* p = base + pos + RECORD_HEADER_SIZE;
+        if (size == 0 || size > data.size() - pos - RECORD_HEADER_SIZE ||
+            checksum(reinterpret_cast<const char*>(p), size) != sum) {
+            break;
+        }
+        // Запись цела: ошибки ниже — несогласованный журнал, а не оборванный хвост
+        std::uint8_t op = p[0];
+        ++p;
+        --size;
+        if (op == OP_ADD && getFigure(p, size, kind, xs, ys)) {
+            figures.push_back(makeFigure(kind, xs.data(), ys.data(), xs.size()));
+        } else if (op == OP_REMOVE && size == 8 && getU64(p) < figures.size()) {
+            figures.erase(static_cast<size_t>(getU64(p)));
+        } else if (op == OP_ASSIGN && size > 8 && getFigure(p + 8, size - 8, kind, xs, ys) &&
+                   getU64(p) < figures.size()) {
+            figures.assign(static_cast<size_t>(getU64(p)), makeFigure(kind, xs.data(), ys.data(), xs.size()));
+        } else {
+            throw std::runtime_error("Inconsistent write-ahead log record " + std::to_string(result.records + 1));
+        }
+        pos += RECORD_HEADER_SIZE + 1 + size;
+        ++result.records;
+    }
+    result.validBytes = pos;
+    result.tornTail = pos != data.size();
+    return result;
+}
+
+WriteAheadLog::WriteAheadLog(const std::string& logPath, const WalOptions& opts, size_t validBytes)
+    : path(logPath), options(opts) {
+    openForAppend(validBytes);
+}
+
+WriteAheadLog::~WriteAheadLog() {
+    try {
+        commit();
+    } catch (...) {
+    }
+    if (fd >= 0) {
+        ::close(fd);
+    }
+}
+
+void WriteAheadLog::openForAppend(size_t validBytes) {
+    fd = ::open(path.c_str(), O_WRONLY | O_CREAT, 0644);
+    if (fd < 0) {
+        fail("Cannot open " + path);
+    }
+    if (validBytes < HEADER_SIZE) {
+        std::string head = header();
+        if (::ftruncate(fd, 0) != 0) fail("Cannot truncate " + path);
+        writeAll(fd, head.data(), head.size());
+        validBytes = head.size();
+    } else if (::ftruncate(fd, static_cast<off_t>(validBytes)) != 0) {
+        fail("Cannot truncate " + path);
+    }
+    if (::lseek(fd, static_cast<off_t>(validBytes), SEEK_SET) < 0) {
+        fail("Cannot seek " + path);
+    }
+}
+
+std::uint64_t WriteAheadLog::append(const std::string& payload) {
+    std::uint64_t record;
+    bool full;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (failed) {
+            throw std::runtime_error("WAL is unusable after a failed write until checkpoint");
+        }
+        frame(pending, payload);
+        record = ++appended;
+        ++records;
+        full = pending.size() >= options.bufferBytes;
+    }
+    if (options.durability == Durability::PerOp || full) {
+        sync(record);
+    }
+    return record;
+}
+
+std::uint64_t WriteAheadLog::logAdd(FigureKind kind, const double* xs, const double* ys) {
+    std::string payload(1, static_cast<char>(OP_ADD));
+    putFigure(payload, kind, xs, ys, kindApexCount(kind));
+    return append(payload);
+}
+
+std::uint64_t WriteAheadLog::logAdd(const Figure& fig) {
+    std::string payload(1, static_cast<char>(OP_ADD));
+    putFigure(payload, fig);
+    return append(payload);
+}
+
+std::uint64_t WriteAheadLog::logRemove(size_t index) {
+    std::string payload(1, static_cast<char>(OP_REMOVE));
+    putU64(payload, index);
+    return append(payload);
+}
+
+std::uint64_t WriteAheadLog::logAssign(size_t index, const Figure& fig) {
+    std::string payload(1, static_cast<char>(OP_ASSIGN));
+    putU64(payload, index);
+    putFigure(payload, fig);
+    return append(payload);
+}
+
+void WriteAheadLog::sync(std::uint64_t record) {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (durable < record) {
+        if (flushing) {
+            flushed.wait(lock);
+            continue;
+        }
+        if (failed) {
+            throw std::runtime_error("WAL is unusable after a failed write until checkpoint");
+        }
+        // Этот поток становится лидером и фиксирует всё накопленное
+        flushing = true;
+        std::string batch;
+        batch.swap(pending);
+        std::uint64_t target = appended;
+        lock.unlock();
+        try {
+            writeAll(fd, batch.data(), batch.size());
+            if (options.durability != Durability::Off && ::fdatasync(fd) != 0) {
+                fail("WAL sync failed");
+            }
+        } catch (...) {
+            // Часть пачки могла попасть в файл, а после ошибки fsync нельзя
+            // доверять и уже записанному: повторять запись нельзя, журнал
+            // отказывает до checkpoint, который перепишет его по коллекции
+            lock.lock();
+            failed = true;
+            flushing = false;
+            flushed.notify_all();
+            throw;
+        }
+        lock.lock();
+        ++syncCount;
+        durable = target;
+        flushing = false;
+        flushed.notify_all();
+    }
+}
+
+void WriteAheadLog::commit() {
+    std::uint64_t record;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        record = appended;
+    }
+    sync(record);
+}
+
+bool WriteAheadLog::checkpointDue(size_t liveFigures) const {
+    return records >= options.checkpointRecords && records > 2 * liveFigures;
+}
+
+void WriteAheadLog::checkpoint(const FigureCollection& figures) {
+    std::unique_lock<std::mutex> lock(mutex);
+    flushed.wait(lock, [this]() { return !flushing; });
+    std::string tmp = path + ".tmp";
+    int out = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (out < 0) {
+        fail("Cannot create " + tmp);
+    }
+    try {
+        std::string data = header();
+        std::string payload;
+        figures.forEach([&](const Figure& fig) {
+            payload.assign(1, static_cast<char>(OP_ADD));
+            putFigure(payload, fig);
+            frame(data, payload);
+            if (data.size() >= (1 << 20)) {
+                writeAll(out, data.data(), data.size());
+                data.clear();
+            }
+        });
+        writeAll(out, data.data(), data.size());
+        if (::fsync(out) != 0) {
+            fail("Cannot sync " + tmp);
+        }
+    } catch (...) {
+        ::close(out);
+        ::unlink(tmp.c_str());
+        throw;
+    }
+    // Операции из pending уже отражены в коллекции, поэтому отбрасываются
+    if (::rename(tmp.c_str(), path.c_str()) != 0) {
+        ::close(out);
+        fail("Cannot replace " + path);
+    }
+    syncDirectory(path);
+    ::close(fd);
+    fd = out;
+    pending.clear();
+    durable = appended;
+    failed = false;
+    records = figures.size();
+    ++syncCount;
+}
+
+Durability WriteAheadLog::durability() const {
+    return options.durability;
+}
+
+size_t WriteAheadLog::syncs() const {
+    return syncCount;
+}
@@ -6,6 +6,44 @@
 #include "../include/diamond.hpp"
 #include "../include/pentagon.hpp"
 #include "../include/hexagon.hpp"
+#include "../include/archive.hpp"
+#include "../include/text_format.hpp"
+#include "../include/stream.hpp"
+#include "../include/bulk_loader.hpp"
+#include "../include/area_index.hpp"
+#include "../include/summary.hpp"
+#include "../include/transform.hpp"
+#include "../include/validation.hpp"
+#include "../include/hull.hpp"
+#include "../include/concurrent_store.hpp"
+#include "../include/shell.hpp"
+#include "../include/server.hpp"
+#include "../include/pipeline.hpp"
+#include "../include/figure_collection.hpp"
+#include "../include/wal.hpp"
+#include "../include/figure_value.hpp"
+#include "../include/polygon.hpp"
+#include "../include/kdtree.hpp"
+#include "../include/raster.hpp"
+#include "../include/coverage.hpp"
+#include "../include/memory_report.hpp"
+#include "../include/generator.hpp"
+#include "../include/arrow_ipc.hpp"
+#include "../include/json_format.hpp"
+#include "../include/query.hpp"
+#include "../include/compact_buffer.hpp"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <optional>
+#include <algorithm>
+#include <csignal>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <thread>
+#include <atomic>
 
 // Вспомогательная функция для сравнения вершин с точностью
 template<typename T>
@@ -219,4 +257,2245 @@ TEST(FigureTest, ClonePolymorphic) {
     auto d2 = d1->clone();
     EXPECT_TRUE(dynamic_cast<Diamond*>(d2.get()) != nullptr);
     EXPECT_NEAR(static_cast<double>(*d1), static_cast<double>(*d2), 1e-9);
-}
\ No newline at end of file
+}
+
+// =============== ARCHIVE TESTS ===============
+
+TEST(ArchiveTest, RoundTrip) {
+    std::vector<std::unique_ptr<Figure>> figures;
+    figures.push_back(std::make_unique<Diamond>());
+    figures.push_back(std::make_unique<Pentagon>());
+    figures.push_back(std::make_unique<Hexagon>());
+
+    ArchiveOptions opts;
+    opts.precision = 1e-6;
+    opts.blockSize = 2;
+    std::stringstream ss;
+    writeArchive(ss, figures, opts);
+
+    ArchiveReader reader(ss);
+    EXPECT_EQ(reader.figureCount(), 3u);
+    EXPECT_EQ(reader.blockCount(), 2u);
+    auto restored = reader.readAll().materializeAll();
+    ASSERT_EQ(restored.size(), 3u);
+    for (size_t i = 0; i < figures.size(); ++i) {
+        EXPECT_EQ(kindOf(*restored[i]), kindOf(*figures[i]));
+        EXPECT_NEAR(static_cast<double>(*restored[i]), static_cast<double>(*figures[i]), 1e-5);
+    }
+}
+
+TEST(ArchiveTest, RandomAccessBlock) {
+    FigureBuffer buf;
+    for (int i = 0; i < 10; ++i) {
+        double xs[4] = {i + 1.0, i + 0.0, i - 1.0, i + 0.0};
+        double ys[4] = {0, 1, 0, -1};
+        buf.push(FigureKind::Diamond, xs, ys);
+    }
+    ArchiveOptions opts;
+    opts.precision = 0.5;
+    opts.blockSize = 4;
+    std::stringstream ss;
+    writeArchive(ss, buf, opts);
+
+    ArchiveReader reader(ss);
+    ASSERT_EQ(reader.blockCount(), 3u);
+    FigureBuffer block;
+    reader.readBlock(2, block);
+    ASSERT_EQ(block.size(), 2u);
+    EXPECT_NEAR(block.center(1).first, 9.0, 1e-9);
+}
+
+TEST(ArchiveTest, Quantization) {
+    std::array<std::pair<double, double>, 4> verts = {{{1.04,0}, {0,1.04}, {-1.04,0}, {0,-1.04}}};
+    std::vector<std::unique_ptr<Figure>> figures;
+    figures.push_back(std::make_unique<Diamond>(verts));
+    ArchiveOptions opts;
+    opts.precision = 0.1;
+    std::stringstream ss;
+    writeArchive(ss, figures, opts);
+    auto restored = ArchiveReader(ss).readAll();
+    EXPECT_NEAR(restored.xs(0)[0], 1.0, 1e-9);
+}
+
+TEST(ArchiveTest, RejectsUnrepresentableCoordinates) {
+    const double ys[4] = {0, 1, 0, -1};
+    for (double far : {1e300, -1e20, std::numeric_limits<double>::quiet_NaN(),
+                       std::numeric_limits<double>::infinity()}) {
+        FigureBuffer buf;
+        const double xs[4] = {far, 0, -1, 0};
+        buf.push(FigureKind::Diamond, xs, ys);
+        std::stringstream ss;
+        EXPECT_THROW(writeArchive(ss, buf), std::invalid_argument);
+    }
+    // Крайние допустимые координаты по разные стороны от нуля
+    FigureBuffer buf;
+    const double xs[4] = {4e18, 0, -4e18, 0};
+    buf.push(FigureKind::Diamond, xs, ys);
+    ArchiveOptions opts;
+    opts.precision = 1.0;
+    std::stringstream ss;
+    writeArchive(ss, buf, opts);
+    EXPECT_EQ(ArchiveReader(ss).readAll().xs(0)[2], -4e18);
+}
+
+TEST(ArchiveTest, RejectsGarbage) {
+    std::stringstream ss("not an archive at all, definitely not");
+    EXPECT_THROW(ArchiveReader reader(ss), std::runtime_error);
+}
+
+// Архив с подменёнными полями: суммы в проверках индекса переполнились бы
+TEST(ArchiveTest, RejectsOverflowingIndex) {
+    FigureBuffer buf;
+    const double xs[4] = {1, 0, -1, 0};
+    const double ys[4] = {0, 1, 0, -1};
+    buf.push(FigureKind::Diamond, xs, ys);
+    std::stringstream ss;
+    writeArchive(ss, buf);
+    const std::string valid = ss.str();
+    auto putU64At = [](std::string& data, size_t pos, std::uint64_t v) {
+        for (int i = 0; i < 8; ++i) data[pos + i] = static_cast<char>((v >> (8 * i)) & 0xFF);
+    };
+    auto putU32At = [](std::string& data, size_t pos, std::uint32_t v) {
+        for (int i = 0; i < 4; ++i) data[pos + i] = static_cast<char>((v >> (8 * i)) & 0xFF);
+    };
+    auto read = [](const std::string& data) {
+        std::stringstream in(data);
+        ArchiveReader(in).readAll();
+    };
+    size_t size = valid.size();
+    size_t indexOffset = size - 8 - 16;
+
+    // Огромное число блоков и смещение индекса, дающие в сумме размер файла
+    std::string blocks = valid;
+    putU32At(blocks, 16, 0xFFFFFFFFu);
+    putU64At(blocks, size - 8, size - 8 - 16 * std::uint64_t(0xFFFFFFFFu));
+    EXPECT_THROW(read(blocks), std::runtime_error);
+
+    // Блок, конец которого «заворачивается» через 2^64
+    std::string block = valid;
+    putU64At(block, indexOffset, ~std::uint64_t(0));
+    putU32At(block, indexOffset + 12, 1);
+    EXPECT_THROW(read(block), std::runtime_error);
+
+    // Завышенное число фигур: ошибка разбора, а не попытка выделить память
+    std::string count = valid;
+    putU64At(count, 24, 0xFFFFFFFFu);
+    putU32At(count, indexOffset + 8, 0xFFFFFFFFu);
+    EXPECT_THROW(read(count), std::runtime_error);
+}
+
+// =============== STREAMING TESTS ===============
+
+TEST(StreamTest, ParseFigures) {
+    std::string text = "add diamond 1 0 0 1 -1 0 0 -1\n\n  add pentagon 1 0 0 1 -1 0 0 -1 0.5 0.5\r\n";
+    FigureBuffer buf;
+    EXPECT_EQ(parseFigures(text.data(), text.data() + text.size(), buf), 2u);
+    EXPECT_EQ(buf.kind(1), FigureKind::Pentagon);
+    EXPECT_NEAR(buf.xs(1)[4], 0.5, 1e-12);
+}
+
+TEST(StreamTest, ParseErrorReportsLine) {
+    std::string text = "add diamond 1 0 0 1 -1 0 0 -1\nadd hexagon 1 2 3\n";
+    FigureBuffer buf;
+    try {
+        parseFigures(text.data(), text.data() + text.size(), buf);
+        FAIL();
+    } catch (const std::runtime_error& e) {
+        EXPECT_EQ(std::string(e.what()).rfind("Line 2:", 0), 0u);
+    }
+}
+
+TEST(StreamTest, MatchesInMemoryTotal) {
+    std::vector<std::unique_ptr<Figure>> figures;
+    FigureBuffer buf;
+    for (int i = 0; i < 1000; ++i) {
+        double s = 1.0 + i * 0.37;
+        figures.push_back(std::make_unique<Diamond>(std::array<std::pair<double, double>, 4>{{
+            {s, 0.1}, {0.3, s}, {-s, 0.2}, {0.1, -s}}}));
+        figures.push_back(std::make_unique<Pentagon>());
+        figures.push_back(std::make_unique<Hexagon>());
+    }
+    for (const auto& fig : figures) buf.push(*fig);
+    std::stringstream text;
+    writeFigures(text, buf);
+
+    double total = 0.0;
+    for (const auto& fig : figures) total += static_cast<double>(*fig);
+
+    FigureStats stats = streamStats(text, 4096);
+    EXPECT_EQ(stats.count, figures.size());
+    EXPECT_EQ(stats.totalArea, total);
+}
+
+// =============== BULK LOADER TESTS ===============
+
+TEST(BulkLoaderTest, ParallelMatchesSerial) {
+    FigureBuffer buf;
+    for (int i = 0; i < 5000; ++i) {
+        double xs[6] = {i + 0.0, 1, 2, 3, 4, 5};
+        double ys[6] = {0, 1, 0.5, 2, 3, -i + 0.25};
+        buf.push(static_cast<FigureKind>(4 + i % 3), xs, ys);
+    }
+    std::stringstream ss;
+    writeFigures(ss, buf);
+    std::string text = ss.str();
+
+    FigureBuffer loaded = parseFiguresParallel(text.data(), text.data() + text.size(), 4);
+    ASSERT_EQ(loaded.size(), buf.size());
+    for (size_t i = 0; i < buf.size(); ++i) {
+        ASSERT_EQ(loaded.kind(i), buf.kind(i));
+        EXPECT_EQ(loaded.xs(i)[0], buf.xs(i)[0]);
+        EXPECT_EQ(loaded.ys(i)[buf.apexCount(i) - 1], buf.ys(i)[buf.apexCount(i) - 1]);
+    }
+}
+
+TEST(BulkLoaderTest, ErrorLineIsGlobal) {
+    std::string text;
+    for (int i = 0; i < 20000; ++i) {
+        text += "add diamond 1 0 0 1 -1 0 0 -1\n";
+    }
+    text += "add square 0 0\n";
+    try {
+        parseFiguresParallel(text.data(), text.data() + text.size(), 4);
+        FAIL();
+    } catch (const std::runtime_error& e) {
+        EXPECT_EQ(std::string(e.what()).rfind("Line 20001:", 0), 0u);
+    }
+}
+
+// =============== AREA INDEX TESTS ===============
+
+static std::unique_ptr<Figure> diamondWithArea(double area) {
+    // Ромб с диагоналями 2 и area
+    double h = area / 2.0;
+    return std::make_unique<Diamond>(std::array<std::pair<double, double>, 4>{{{1,0}, {0,h}, {-1,0}, {0,-h}}});
+}
+
+TEST(AreaIndexTest, TopBottomRange) {
+    std::vector<std::unique_ptr<Figure>> figures;
+    AreaIndex index;
+    for (int a : {5, 1, 4, 2, 3}) {
+        figures.push_back(diamondWithArea(a));
+        index.insert(*figures.back());
+    }
+    auto top = index.top(2);
+    ASSERT_EQ(top.size(), 2u);
+    EXPECT_NEAR(static_cast<double>(*top[0]), 5.0, 1e-9);
+    EXPECT_NEAR(static_cast<double>(*top[1]), 4.0, 1e-9);
+
+    auto bottom = index.bottom(10);
+    ASSERT_EQ(bottom.size(), 5u);
+    EXPECT_NEAR(static_cast<double>(*bottom[0]), 1.0, 1e-9);
+
+    auto range = index.range(1.5, 4.5);
+    ASSERT_EQ(range.size(), 3u);
+    EXPECT_NEAR(static_cast<double>(*range[2]), 4.0, 1e-9);
+}
+
+TEST(AreaIndexTest, Erase) {
+    std::vector<std::unique_ptr<Figure>> figures;
+    AreaIndex index;
+    for (int a : {1, 2, 3}) {
+        figures.push_back(diamondWithArea(a));
+        index.insert(*figures.back());
+    }
+    EXPECT_TRUE(index.erase(*figures[2]));
+    EXPECT_FALSE(index.erase(*figures[2]));
+    EXPECT_EQ(index.size(), 2u);
+    EXPECT_EQ(index.top(1)[0], figures[1].get());
+}
+
+TEST(AreaIndexTest, NaNAreasStayOutOfQueries) {
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    std::vector<std::unique_ptr<Figure>> figures;
+    for (double a : {3.0, nan, 1.0, nan, 2.0}) {
+        figures.push_back(diamondWithArea(a));
+    }
+    AreaIndex built;
+    built.build(figures, 2);
+    AreaIndex inserted;
+    for (const auto& fig : figures) {
+        inserted.insert(*fig);
+    }
+    for (AreaIndex* index : {&built, &inserted}) {
+        EXPECT_EQ(index->size(), 5u);
+        ASSERT_EQ(index->top(10).size(), 3u);
+        EXPECT_EQ(index->top(1)[0], figures[0].get());
+        ASSERT_EQ(index->bottom(10).size(), 3u);
+        EXPECT_EQ(index->bottom(10)[2], figures[0].get());
+        EXPECT_EQ(index->range(-1e300, 1e300).size(), 3u);
+        EXPECT_TRUE(index->erase(*figures[1]));
+        EXPECT_FALSE(index->erase(*figures[1]));
+        index->rescale(2.0);
+        EXPECT_EQ(index->size(), 4u);
+        EXPECT_EQ(index->range(5.5, 6.5).size(), 1u);
+        EXPECT_TRUE(index->erase(*figures[3]));
+    }
+}
+
+TEST(AreaIndexTest, ParallelBuild) {
+    std::vector<std::unique_ptr<Figure>> figures;
+    for (int i = 0; i < 20000; ++i) {
+        figures.push_back(diamondWithArea((i * 7919) % 20000 + 1));
+    }
+    AreaIndex index;
+    index.build(figures, 4);
+    EXPECT_EQ(index.size(), figures.size());
+    auto bottom = index.bottom(20000);
+    for (size_t i = 1; i < bottom.size(); ++i) {
+        ASSERT_LE(static_cast<double>(*bottom[i - 1]), static_cast<double>(*bottom[i]));
+    }
+    EXPECT_NEAR(static_cast<double>(*index.top(1)[0]), 20000.0, 1e-9);
+}
+
+// =============== SUMMARY TESTS ===============
+
+TEST(SummaryTest, GroupByKind) {
+    std::vector<std::unique_ptr<Figure>> figures;
+    for (int a : {2, 4, 6}) {
+        figures.push_back(diamondWithArea(a));
+    }
+    figures.push_back(std::make_unique<Hexagon>());
+
+    Summary s = summarize(figures, 1);
+    const KindSummary& d = s[FigureKind::Diamond];
+    EXPECT_EQ(d.count, 3u);
+    EXPECT_NEAR(d.sum, 12.0, 1e-9);
+    EXPECT_NEAR(d.min, 2.0, 1e-9);
+    EXPECT_NEAR(d.max, 6.0, 1e-9);
+    EXPECT_NEAR(d.mean, 4.0, 1e-9);
+    EXPECT_NEAR(d.variance(), 8.0 / 3.0, 1e-9);
+    EXPECT_EQ(s[FigureKind::Pentagon].count, 0u);
+    EXPECT_EQ(s[FigureKind::Hexagon].count, 1u);
+    EXPECT_EQ(s.all.count, 4u);
+    EXPECT_NEAR(s.all.sum, 12.0 + 3.0 * std::sqrt(3.0) / 2.0, 1e-9);
+}
+
+TEST(SummaryTest, ParallelMatchesSerial) {
+    std::vector<std::unique_ptr<Figure>> figures;
+    for (int i = 0; i < 30000; ++i) {
+        figures.push_back(diamondWithArea(1 + i % 97));
+        figures.push_back(std::make_unique<Pentagon>());
+    }
+    Summary serial = summarize(figures, 1);
+    Summary parallel = summarize(toBuffer(figures), 4);
+    for (FigureKind kind : {FigureKind::Diamond, FigureKind::Pentagon, FigureKind::Hexagon}) {
+        EXPECT_EQ(serial[kind].count, parallel[kind].count);
+        EXPECT_NEAR(serial[kind].sum, parallel[kind].sum, 1e-6);
+        EXPECT_NEAR(serial[kind].variance(), parallel[kind].variance(), 1e-6);
+        EXPECT_EQ(serial[kind].max, parallel[kind].max);
+    }
+}
+
+// =============== TRANSFORM TESTS ===============
+
+TEST(TransformTest, RotateAboutOwnCenter) {
+    std::array<std::pair<double, double>, 4> verts = {{{3,2}, {2,3}, {1,2}, {2,1}}};
+    Diamond d(verts);
+    applyTransform(d, Transform().rotate(M_PI / 2));
+    std::array<std::pair<double, double>, 4> expected = {{{2,3}, {1,2}, {2,1}, {3,2}}};
+    EXPECT_TRUE(apexes_equal(d.get_apexes(), expected));
+}
+
+TEST(TransformTest, FusedChainMatchesSteps) {
+    Transform chain;
+    chain.translate(1, 2).rotate(0.3).scale(2, 0.5).rotateAbout(-1.1, 4, 5).scale(1.5, 1.5).translate(-3, 0);
+
+    Pentagon fused;
+    Pentagon steps;
+    applyTransform(fused, chain);
+    applyTransform(steps, Transform().translate(1, 2));
+    applyTransform(steps, Transform().rotate(0.3));
+    applyTransform(steps, Transform().scale(2, 0.5));
+    applyTransform(steps, Transform().rotateAbout(-1.1, 4, 5));
+    applyTransform(steps, Transform().scale(1.5, 1.5));
+    applyTransform(steps, Transform().translate(-3, 0));
+    EXPECT_TRUE(apexes_equal(fused.get_apexes(), steps.get_apexes(), 1e-9));
+    EXPECT_NEAR(static_cast<double>(fused), static_cast<double>(Pentagon()) * chain.areaFactor(), 1e-9);
+}
+
+TEST(TransformTest, BufferAndSelection) {
+    std::vector<std::unique_ptr<Figure>> figures;
+    figures.push_back(std::make_unique<Hexagon>());
+    figures.push_back(std::make_unique<Hexagon>());
+    FigureBuffer buf = toBuffer(figures);
+
+    Transform tr;
+    tr.scaleAbout(2, 2, 0, 0).translate(5, 0);
+    applyTransform(buf, tr, 2);
+    applyTransform(figures, {1}, tr);
+
+    EXPECT_NEAR(buf.center(0).first, 5.0, 1e-9);
+    EXPECT_NEAR(figures[0]->getCenter().first, 0.0, 1e-9);
+    EXPECT_NEAR(figures[1]->getCenter().first, 5.0, 1e-9);
+    EXPECT_NEAR(buf.area(1), static_cast<double>(*figures[1]), 1e-9);
+    EXPECT_TRUE(tr.isSimilarity());
+    EXPECT_NEAR(tr.areaFactor(), 4.0, 1e-12);
+}
+
+// =============== VALIDATION TESTS ===============
+
+TEST(ValidationTest, ValidShapes) {
+    EXPECT_EQ(validateFigure(Diamond()), VALID);
+    EXPECT_EQ(validateFigure(Pentagon()), VALID);
+    EXPECT_EQ(validateFigure(Hexagon()), VALID);
+}
+
+TEST(ValidationTest, NotARhombus) {
+    Diamond kite(std::array<std::pair<double, double>, 4>{{{2,0}, {0,1}, {-1,0}, {0,-1}}});
+    std::uint32_t errors = validateFigure(kite);
+    EXPECT_TRUE(errors & RHOMBUS_SIDES);
+    EXPECT_TRUE(errors & RHOMBUS_DIAGONALS);
+}
+
+TEST(ValidationTest, SelfIntersectingAndConcave) {
+    // "Бантик": стороны 0-1 и 2-3 пересекаются
+    Pentagon bow(std::array<std::pair<double, double>, 5>{{{0,0}, {2,2}, {2,0}, {0,2}, {-1,1}}});
+    EXPECT_TRUE(validateFigure(bow) & SELF_INTERSECTING);
+
+    Hexagon arrow(std::array<std::pair<double, double>, 6>{{{0,0}, {2,0}, {3,1}, {2,2}, {0,2}, {1,1}}});
+    EXPECT_EQ(validateFigure(arrow), NOT_CONVEX);
+    ValidationOptions loose;
+    loose.requireConvex = false;
+    EXPECT_EQ(validateFigure(arrow, loose), VALID);
+}
+
+TEST(ValidationTest, WindingAndDegenerate) {
+    ValidationOptions cw;
+    cw.winding = Winding::Clockwise;
+    EXPECT_EQ(validateFigure(Hexagon(), cw), WRONG_WINDING);
+
+    Diamond point(std::array<std::pair<double, double>, 4>{{{1,1}, {1,1}, {1,1}, {1,1}}});
+    EXPECT_EQ(validateFigure(point), DEGENERATE);
+}
+
+TEST(ValidationTest, NonFiniteCoordinates) {
+    const double inf = std::numeric_limits<double>::infinity();
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    Diamond far(std::array<std::pair<double, double>, 4>{{{inf,0}, {0,1}, {-1,0}, {0,-1}}});
+    EXPECT_EQ(validateFigure(far), NOT_FINITE);
+    const double xs[5] = {0, 4, 5, 2, -1};
+    const double ys[5] = {0, 0, nan, 5, 3};
+    EXPECT_EQ(validateApexes(FigureKind::Polygon, xs, ys, 5), static_cast<std::uint32_t>(NOT_FINITE));
+    EXPECT_EQ(describeErrors(NOT_FINITE), "non-finite coordinates");
+}
+
+TEST(ValidationTest, BatchReportAndFilter) {
+    FigureBuffer buf;
+    for (int i = 0; i < 10000; ++i) {
+        buf.push(Diamond());
+        if (i % 1000 == 0) {
+            buf.push(Diamond(std::array<std::pair<double, double>, 4>{{{3,0}, {0,1}, {-1,0}, {0,-1}}}));
+        }
+    }
+    ValidationReport report = validateAll(buf, {}, 4);
+    EXPECT_EQ(report.checked, 10010u);
+    ASSERT_EQ(report.failures.size(), 10u);
+    EXPECT_EQ(report.failures[1].first, 1002u);
+    EXPECT_EQ(dropInvalid(buf, report).size(), 10000u);
+}
+
+TEST(ValidationTest, FilterKeepsPolygonVertices) {
+    FigureBuffer buf;
+    const double hx[6] = {1, 0.5, -0.5, -1, -0.5, 0.5};
+    const double hy[6] = {0, 0.866025403784, 0.866025403784, 0, -0.866025403784, -0.866025403784};
+    const double dx[4] = {3, 0, -1, 0}, dy[4] = {0, 1, 0, -1};   // не ромб
+    const double px[5] = {0, 4, 5, 2, -1}, py[5] = {0, 0, 3, 5, 3};
+    buf.push(FigureKind::Hexagon, hx, hy);
+    buf.push(FigureKind::Diamond, dx, dy);
+    buf.push(FigureKind::Polygon, px, py, 5);
+    ValidationReport report = validateAll(buf);
+    ASSERT_EQ(report.failures.size(), 1u);
+    FigureBuffer kept = dropInvalid(buf, report);
+    ASSERT_EQ(kept.size(), 2u);
+    EXPECT_EQ(kept.kind(1), FigureKind::Polygon);
+    ASSERT_EQ(kept.apexCount(1), 5u);
+    EXPECT_EQ(kept.xs(1)[2], 5.0);
+    EXPECT_DOUBLE_EQ(kept.area(1), buf.area(2));
+}
+
+// =============== HULL TESTS ===============
+
+TEST(HullTest, ConvexHullSquare) {
+    std::vector<std::pair<double, double>> pts = {{0,0}, {2,0}, {2,2}, {0,2}, {1,1}, {1,0}, {0,0}};
+    auto hull = convexHull(pts);
+    ASSERT_EQ(hull.size(), 4u);
+    EXPECT_NEAR(polygonArea(hull), 4.0, 1e-12);
+}
+
+TEST(HullTest, CollectionHullAndExtent) {
+    std::vector<std::unique_ptr<Figure>> figures;
+    for (int i = 0; i < 3000; ++i) {
+        auto h = std::make_unique<Hexagon>();
+        applyTransform(*h, Transform().translate(i % 10, i / 300));
+        figures.push_back(std::move(h));
+    }
+    Extent e = extentOf(figures, 4);
+    EXPECT_NEAR(e.minX, -1.0, 1e-9);
+    EXPECT_NEAR(e.maxX, 10.0, 1e-9);
+    EXPECT_NEAR(e.maxY, 9.0 + std::sqrt(3.0) / 2.0, 1e-9);
+
+    auto serial = collectionHull(figures, 1);
+    auto parallel = collectionHull(toBuffer(figures), 4);
+    ASSERT_EQ(serial.size(), parallel.size());
+    EXPECT_NEAR(polygonArea(serial), polygonArea(parallel), 1e-9);
+    // Сумма Минковского квадрата 9x9 центров и шестиугольника (ширина 2, высота sqrt(3))
+    EXPECT_NEAR(polygonArea(serial), 81.0 + 9 * 2.0 + 9 * std::sqrt(3.0) + 3 * std::sqrt(3.0) / 2.0, 1e-6);
+}
+
+// =============== CONCURRENT STORE TESTS ===============
+
+TEST(ConcurrentStoreTest, SnapshotIsImmutable) {
+    ConcurrentStore store(2);
+    FigureId a = store.add(std::make_unique<Diamond>());
+    store.add(std::make_unique<Hexagon>());
+    FigureSnapshot before = store.snapshot();
+
+    EXPECT_TRUE(store.remove(a));
+    EXPECT_FALSE(store.remove(a));
+    store.add(std::make_unique<Pentagon>());
+    // Удалённая фигура ещё видна старому снимку, поэтому не освобождается
+    EXPECT_EQ(store.collect(), 0u);
+
+    EXPECT_EQ(before.size(), 2u);
+    EXPECT_NEAR(before.totalArea(), static_cast<double>(Diamond()) + static_cast<double>(Hexagon()), 1e-9);
+    EXPECT_EQ(store.snapshot().size(), 2u);
+
+    before = store.snapshot();
+    EXPECT_EQ(store.collect(), 1u);
+}
+
+TEST(ConcurrentStoreTest, ShardsAreAssignedPerStore) {
+    // Пустое хранилище не выделяет оглавление кусков заранее
+    std::optional<ConcurrentStore> empty;
+    long long grown = heapDelta([&] { empty.emplace(4); });
+    EXPECT_LT(grown, 32 * 1024);
+
+    ConcurrentStore a(2);
+    ConcurrentStore b(2);
+    auto addFrom = [](ConcurrentStore& store) {
+        FigureId id{};
+        std::thread t([&]() { id = store.add(std::make_unique<Diamond>()); });
+        t.join();
+        return id;
+    };
+    // Первый писатель каждого хранилища получает его шард 0, второй — 1,
+    // независимо от того, в какие хранилища эти потоки писали раньше
+    std::vector<std::uint32_t> seen;
+    std::thread first([&]() {
+        a.add(std::make_unique<Diamond>());
+        seen.push_back(addFrom(b).shard);
+        seen.push_back(b.add(std::make_unique<Diamond>()).shard);
+    });
+    first.join();
+    EXPECT_EQ(seen, (std::vector<std::uint32_t>{0, 1}));
+    EXPECT_EQ(addFrom(a).shard, 1u);
+}
+
+TEST(ConcurrentStoreTest, StressWritersAndReaders) {
+    ConcurrentStore store(4);
+    const int writers = 4;
+    const int perWriter = 5000;
+    std::atomic<bool> done{false};
+    std::atomic<int> inconsistent{0};
+
+    std::vector<std::thread> pool;
+    for (int w = 0; w < writers; ++w) {
+        pool.emplace_back([&store, perWriter]() {
+            for (int i = 0; i < perWriter; ++i) {
+                FigureId id = store.add(std::make_unique<Diamond>());
+                if (i % 2 == 0) {
+                    store.remove(id);
+                }
+                if (i % 1000 == 0) {
+                    store.collect();
+                }
+            }
+        });
+    }
+    std::vector<std::thread> readers;
+    for (int r = 0; r < 2; ++r) {
+        readers.emplace_back([&]() {
+            while (!done) {
+                FigureSnapshot snap = store.snapshot();
+                size_t n1 = snap.size();
+                double a1 = snap.totalArea();
+                if (snap.size() != n1 || snap.totalArea() != a1) {
+                    ++inconsistent;
+                }
+            }
+        });
+    }
+    for (auto& t : pool) t.join();
+    done = true;
+    for (auto& t : readers) t.join();
+
+    EXPECT_EQ(inconsistent, 0);
+    FigureSnapshot last = store.snapshot();
+    EXPECT_EQ(last.size(), static_cast<size_t>(writers * perWriter / 2));
+    EXPECT_NEAR(last.totalArea(), writers * perWriter / 2 * static_cast<double>(Diamond()), 1e-6);
+}
+
+// =============== SHELL AND SERVER TESTS ===============
+
+TEST(ShellTest, ExecutesCommands) {
+    Shell shell(false);
+    std::stringstream in("add diamond 2 0 0 3 -2 0 0 -3\nadd hexagon 1 0 0 1 -1 0 0 -1 0.5 0.5 -0.5 -0.5\ncount\nremove 1\ntotal\n");
+    std::stringstream out;
+    while (shell.execute(in, out)) {}
+    EXPECT_EQ(shell.collection().size(), 1u);
+    EXPECT_NE(out.str().find("Фигур: 2"), std::string::npos);
+    EXPECT_NE(out.str().find("Общая площадь: 12"), std::string::npos);
+}
+
+TEST(ShellTest, RejectsMissingOrInvalidArguments) {
+    Shell shell(false);
+    std::stringstream out;
+    auto run = [&](const std::string& line) {
+        std::stringstream in(line + "\n");
+        out.str("");
+        shell.execute(in, out);
+        return out.str();
+    };
+    EXPECT_EQ(run("remove 0"), "Ошибка: нет фигур\n");
+    run("add diamond 1 0 0 1 -1 0 0 -1");
+    run("add diamond 2 0 0 2 -2 0 0 -2");
+    EXPECT_EQ(run("remove"), "Ошибка: ожидается номер фигуры\n");
+    EXPECT_EQ(run("remove x"), "Ошибка: ожидается номер фигуры\n");
+    EXPECT_EQ(run("remove 0 1"), "Ошибка: ожидается номер фигуры\n");
+    EXPECT_EQ(run("remove 5"), "Ошибка: индекс вне диапазона [0, 1]\n");
+    EXPECT_EQ(shell.collection().size(), 2u);
+    EXPECT_EQ(run("top"), "Ошибка: ожидается число фигур\n");
+    EXPECT_EQ(run("bottom many"), "Ошибка: ожидается число фигур\n");
+    EXPECT_EQ(run("range 1"), "Ошибка: ожидаются границы площади: range <от> <до>\n");
+    EXPECT_NE(run("top 1").find("Площадь: 8"), std::string::npos);
+    EXPECT_EQ(run("remove 1"), "Фигура удалена.\n");
+    EXPECT_EQ(shell.collection().size(), 1u);
+}
+
+// Читает из сокета ответы, пока не наберётся count строк-терминаторов
+static std::string readResponses(int fd, size_t count) {
+    std::string reply;
+    char buf[4096];
+    size_t seen = 0;
+    while (seen < count) {
+        ssize_t got = ::recv(fd, buf, sizeof(buf), 0);
+        if (got <= 0) break;
+        reply.append(buf, static_cast<size_t>(got));
+        seen = 0;
+        for (size_t pos = 0; (pos = reply.find(".\n", pos)) != std::string::npos; pos += 2) {
+            if (pos == 0 || reply[pos - 1] == '\n') ++seen;
+        }
+    }
+    return reply;
+}
+
+TEST(ServerTest, PipelinedClients) {
+    Shell shell(false);
+    Server server(shell, "tcp:0");
+    std::thread loop([&server]() { server.run(); });
+
+    std::string address = "tcp:" + std::to_string(server.port());
+    int a = connectToServer(address);
+    int b = connectToServer(address);
+    std::string batch = "add diamond 1 0 0 1 -1 0 0 -1\nadd diamond 1 0 0 1 -1 0 0 -1\n\ncount\n";
+    ::send(a, batch.data(), batch.size(), 0);
+    std::string first = readResponses(a, 4);
+    EXPECT_EQ(first, ".\n.\n.\nФигур: 2\n.\n");
+
+    std::string query = "total\nquit\n";
+    ::send(b, query.data(), query.size(), 0);
+    std::string second = readResponses(b, 2);
+    EXPECT_EQ(second, "Общая площадь: 4\n.\n.\n");
+    char c;
+    EXPECT_EQ(::recv(b, &c, 1, 0), 0);   // после quit сервер закрывает соединение
+
+    ::close(a);
+    ::close(b);
+    server.stop();
+    loop.join();
+}
+
+TEST(ServerTest, RejectsOverlongLine) {
+    Shell shell(false);
+    Server server(shell, "tcp:0");
+    std::thread loop([&server]() { server.run(); });
+
+    int fd = connectToServer("tcp:" + std::to_string(server.port()));
+    std::string request = "count\n" + std::string(3 << 20, 'x');
+    const char* p = request.data();
+    size_t left = request.size();
+    while (left > 0) {
+        ssize_t sent = ::send(fd, p, left, MSG_NOSIGNAL);
+        if (sent <= 0) break;   // сервер мог закрыть соединение раньше
+        p += sent;
+        left -= static_cast<size_t>(sent);
+    }
+    std::string reply = readResponses(fd, 2);
+    EXPECT_EQ(reply.rfind("Фигур: 0\n.\nОшибка: строка длиннее", 0), 0u);
+    ::close(fd);
+
+    // Сервер продолжает обслуживать других клиентов
+    int other = connectToServer("tcp:" + std::to_string(server.port()));
+    std::string query = "count\n";
+    ::send(other, query.data(), query.size(), 0);
+    EXPECT_EQ(readResponses(other, 1), "Фигур: 0\n.\n");
+    ::close(other);
+    server.stop();
+    loop.join();
+}
+
+TEST(ServerTest, FileCommandsOnlyOverUnixSocket) {
+    std::string path = testing::TempDir() + "server_files.arc";
+    std::string socketPath = testing::TempDir() + "server_files.sock";
+    std::remove(path.c_str());
+    Shell shell(false);
+    Server tcp(shell, "tcp:0");
+    std::thread tcpLoop([&tcp]() { tcp.run(); });
+    int fd = connectToServer("tcp:" + std::to_string(tcp.port()));
+    std::string request = "save " + path + "\nexport " + path + ".json\ncount\n";
+    ::send(fd, request.data(), request.size(), 0);
+    std::string reply = readResponses(fd, 3);
+    EXPECT_EQ(reply.rfind("Ошибка: команда save работает с файлами", 0), 0u);
+    EXPECT_NE(reply.find("Ошибка: команда export"), std::string::npos);
+    EXPECT_NE(reply.find("Фигур: 0\n.\n"), std::string::npos);
+    EXPECT_FALSE(std::ifstream(path).good());
+    ::close(fd);
+    tcp.stop();
+    tcpLoop.join();
+
+    Server local(shell, "unix:" + socketPath);
+    std::thread localLoop([&local]() { local.run(); });
+    fd = connectToServer("unix:" + socketPath);
+    request = "save " + path + "\n";
+    ::send(fd, request.data(), request.size(), 0);
+    EXPECT_EQ(readResponses(fd, 1), "Сохранено фигур: 0\n.\n");
+    ::close(fd);
+    local.stop();
+    localLoop.join();
+    std::remove(path.c_str());
+}
+
+TEST(ServerTest, RejectsInvalidPort) {
+    Shell shell(false);
+    EXPECT_THROW(Server(shell, "tcp:70000"), std::invalid_argument);
+    EXPECT_THROW(Server(shell, "tcp:-1"), std::invalid_argument);
+    EXPECT_THROW(Server(shell, "tcp:80x"), std::invalid_argument);
+    EXPECT_THROW(Server(shell, "tcp:"), std::invalid_argument);
+    EXPECT_THROW(connectToServer("tcp:65536"), std::invalid_argument);
+}
+
+// =============== PIPELINE TESTS ===============
+
+TEST(PipelineTest, StagesProduceOrderedBatches) {
+    std::string text;
+    for (int i = 1; i <= 3000; ++i) {
+        text += "add diamond " + std::to_string(i) + " 0 0 1 -" + std::to_string(i) + " 0 0 -1\n";
+        text += "add diamond 2 0 0 1 -1 0 0 -1\n";   // не ромб
+    }
+    std::stringstream in(text);
+    PipelineOptions opts;
+    opts.chunkBytes = 4096;
+    opts.queueDepth = 2;
+
+    size_t seen = 0;
+    size_t invalid = 0;
+    bool ordered = true;
+    PipelineMetrics metrics = runIngestPipeline(in, [&](IngestBatch& batch) {
+        for (size_t i = 0; i < batch.figures.size(); ++i, ++seen) {
+            if (batch.errors[i] != VALID) ++invalid;
+            if (seen % 2 == 0 && batch.figures.xs(i)[0] != static_cast<double>(seen / 2 + 1)) ordered = false;
+            if (batch.areas[i] != batch.figures.area(i)) ordered = false;
+        }
+    }, opts);
+
+    EXPECT_EQ(seen, 6000u);
+    EXPECT_EQ(invalid, 3000u);
+    EXPECT_TRUE(ordered);
+    for (const StageMetrics& m : metrics.stages) {
+        EXPECT_EQ(m.figures, 6000u);
+        EXPECT_GT(m.batches, 1u);
+    }
+}
+
+TEST(PipelineTest, ParseErrorStopsPipeline) {
+    std::string text;
+    for (int i = 0; i < 5000; ++i) {
+        text += "add hexagon 1 0 0 1 -1 0 0 -1 0.5 0.5 -0.5 -0.5\n";
+    }
+    text += "oops\n";
+    std::stringstream in(text);
+    PipelineOptions opts;
+    opts.chunkBytes = 1024;
+    EXPECT_THROW(runIngestPipeline(in, [](IngestBatch&) {}, opts), std::runtime_error);
+}
+
+// =============== COPY-ON-WRITE COLLECTION TESTS ===============
+
+TEST(FigureCollectionTest, SnapshotSharesUntouchedChunks) {
+    FigureCollection figures;
+    for (int i = 0; i < 1000; ++i) {
+        figures.push_back(std::make_unique<Diamond>());
+    }
+    FigureCollection snapshot = figures;
+    EXPECT_EQ(&snapshot[500], &figures[500]);
+
+    Transform tr;
+    tr.scale(2.0, 2.0);
+    applyTransform(figures.mutate(500), tr);
+    figures.erase(10);
+    figures.push_back(std::make_unique<Hexagon>());
+
+    EXPECT_EQ(snapshot.size(), 1000u);
+    EXPECT_EQ(figures.size(), 1000u);
+    EXPECT_DOUBLE_EQ(static_cast<double>(snapshot[499]), 0.5);   // снимок не изменился
+    EXPECT_DOUBLE_EQ(static_cast<double>(figures[499]), 2.0);    // индексы сдвинулись после erase
+    EXPECT_EQ(&snapshot[600], &figures[599]);                     // фигура не копировалась
+
+    CollectionDiff diff = figures.diff(snapshot);
+    EXPECT_EQ(diff.added, 2u);
+    EXPECT_EQ(diff.removed, 2u);
+}
+
+TEST(ShellTest, UndoAndRestore) {
+    Shell shell(false);
+    std::stringstream in(
+        "add diamond 1 0 0 1 -1 0 0 -1\n"
+        "snapshot\n"
+        "add diamond 2 0 0 2 -2 0 0 -2\n"
+        "transform scale 3\n"
+        "remove 0\n"
+        "undo\n"
+        "undo\n"
+        "top 1\n"
+        "restore 0\n"
+        "total\n"
+        "undo\n"
+        "diff 0\n");
+    std::stringstream out;
+    while (shell.execute(in, out)) {}
+    std::string text = out.str();
+    EXPECT_NE(text.find("Площадь: 8\n"), std::string::npos);         // top после двух undo
+    EXPECT_NE(text.find("Общая площадь: 2\n"), std::string::npos);   // после restore
+    EXPECT_NE(text.find("новых или изменённых фигур 1, удалённых или изменённых 0"), std::string::npos);
+    EXPECT_EQ(shell.collection().size(), 2u);
+}
+
+// Подобное преобразование всей коллекции: фигуры общие с историей и
+// копируются, индекс масштабируется целиком и указывает на копии
+TEST(ShellTest, TransformAllKeepsIndexOnCopies) {
+    Shell shell(false);
+    std::stringstream in(
+        "add diamond 1 0 0 1 -1 0 0 -1\n"
+        "add diamond 2 0 0 2 -2 0 0 -2\n"
+        "transform scale 2 translate 10 0\n"
+        "top 1\n"
+        "range 7 9\n"
+        "remove 1\n"
+        "bottom 5\n"
+        "undo\n"
+        "undo\n"
+        "top 1\n");
+    std::stringstream out;
+    while (shell.execute(in, out)) {}
+    std::string text = out.str();
+    size_t top = text.find("Центр: (10, 0), Площадь: 32\n");
+    size_t range = text.find("Центр: (10, 0), Площадь: 8\n", top);
+    size_t bottom = text.find("Центр: (10, 0), Площадь: 8\n", range + 1);
+    EXPECT_NE(top, std::string::npos);
+    EXPECT_NE(range, std::string::npos);
+    EXPECT_NE(bottom, std::string::npos);
+    EXPECT_EQ(text.find("Площадь: 32", bottom), std::string::npos);   // удалённая фигура ушла из индекса
+    EXPECT_NE(text.find("Центр: (0, 0), Площадь: 8\n", bottom), std::string::npos);   // после двух undo
+}
+
+// =============== WRITE-AHEAD LOG TESTS ===============
+
+TEST(WalTest, ShellStateSurvivesRestart) {
+    std::string path = testing::TempDir() + "wal_restart.log";
+    std::remove(path.c_str());
+    std::string before;
+    {
+        Shell shell(false);
+        shell.attachLog(path);
+        std::stringstream in(
+            "add diamond 1 0 0 1 -1 0 0 -1\n"
+            "add hexagon 1 0 0 1 -1 0 0 -1 0.5 0.5 -0.5 -0.5\n"
+            "add diamond 2 0 0 2 -2 0 0 -2\n"
+            "remove 1\n"
+            "transform translate 1 2 on 1\n"
+            "list\n");
+        std::stringstream out;
+        while (shell.execute(in, out)) {
+            shell.commit();
+        }
+        before = out.str().substr(out.str().find("[0]"));
+    }
+    Shell restarted(false);
+    WalReplay replay = restarted.attachLog(path);
+    EXPECT_EQ(replay.records, 5u);
+    EXPECT_FALSE(replay.tornTail);
+    std::stringstream in("list\n");
+    std::stringstream out;
+    restarted.execute(in, out);
+    EXPECT_EQ(out.str(), before);
+    std::remove(path.c_str());
+}
+
+TEST(WalTest, TornTailIsDiscarded) {
+    std::string path = testing::TempDir() + "wal_torn.log";
+    const double xs[4] = {1, 0, -1, 0};
+    const double ys[4] = {0, 1, 0, -1};
+    {
+        WalOptions opts;
+        opts.durability = Durability::PerOp;
+        WriteAheadLog wal(path, opts);
+        wal.logAdd(FigureKind::Diamond, xs, ys);
+        wal.logAdd(FigureKind::Diamond, xs, ys);
+    }
+    {
+        // Имитация падения посреди записи
+        std::ofstream out(path, std::ios::binary | std::ios::app);
+        out.write("\x40\x00\x00\x00garbage", 11);
+    }
+    FigureCollection figures;
+    WalReplay replay = replayWal(path, figures);
+    EXPECT_EQ(figures.size(), 2u);
+    EXPECT_TRUE(replay.tornTail);
+
+    {
+        WriteAheadLog wal(path, {}, replay.validBytes);
+        wal.logRemove(0);
+    }
+    FigureCollection again;
+    replay = replayWal(path, again);
+    EXPECT_EQ(again.size(), 1u);
+    EXPECT_FALSE(replay.tornTail);
+    std::remove(path.c_str());
+}
+
+TEST(WalTest, CheckpointCompactsLog) {
+    std::string path = testing::TempDir() + "wal_checkpoint.log";
+    std::remove(path.c_str());
+    WalOptions opts;
+    opts.checkpointRecords = 100;
+    {
+        Shell shell(false);
+        shell.attachLog(path, opts);
+        std::stringstream in;
+        for (int i = 0; i < 300; ++i) {
+            in << "add diamond 1 0 0 1 -1 0 0 -1\nremove 0\n";
+        }
+        in << "add pentagon 0 0 2 0 3 1 1 3 -1 1\n";
+        std::stringstream out;
+        while (shell.execute(in, out)) {
+            shell.commit();
+        }
+    }
+    FigureCollection figures;
+    WalReplay replay = replayWal(path, figures);
+    EXPECT_EQ(figures.size(), 1u);
+    EXPECT_LT(replay.records, 100u);
+    std::remove(path.c_str());
+}
+
+// Ограничение размера файла процесса: запись сверх него завершается EFBIG
+static void limitFileSize(rlim_t bytes) {
+    rlimit limit;
+    ::getrlimit(RLIMIT_FSIZE, &limit);
+    limit.rlim_cur = std::min(bytes, limit.rlim_max);
+    ::setrlimit(RLIMIT_FSIZE, &limit);
+}
+
+TEST(WalTest, WriteFailureUndoesCommand) {
+    std::string path = testing::TempDir() + "wal_failure.log";
+    std::remove(path.c_str());
+    std::signal(SIGXFSZ, SIG_IGN);
+    WalOptions opts;
+    opts.durability = Durability::PerOp;
+    Shell shell(false);
+    shell.attachLog(path, opts);
+    std::stringstream out;
+    for (int i = 0; i < 3; ++i) {
+        std::stringstream in("add diamond 1 0 0 1 -1 0 0 -1\n");
+        shell.execute(in, out);
+    }
+
+    // Журнал не дописан: коллекция откатывается, журнал переписывается по ней
+    limitFileSize(4096);
+    std::stringstream generate("generate 200\n");
+    shell.execute(generate, out);
+    EXPECT_NE(out.str().find("command undone"), std::string::npos);
+    EXPECT_EQ(shell.collection().size(), 3u);
+
+    // Не удалась и контрольная точка: журнал отключается
+    limitFileSize(100);
+    std::stringstream add("add diamond 1 0 0 1 -1 0 0 -1\n");
+    EXPECT_THROW(shell.execute(add, out), std::runtime_error);
+    EXPECT_EQ(shell.collection().size(), 3u);
+    limitFileSize(RLIM_INFINITY);
+    std::signal(SIGXFSZ, SIG_DFL);
+
+    FigureCollection replayed;
+    replayWal(path, replayed);
+    EXPECT_EQ(replayed.size(), 3u);
+    std::stringstream again("add diamond 1 0 0 1 -1 0 0 -1\n");
+    EXPECT_TRUE(shell.execute(again, out));
+    shell.commit();
+    EXPECT_EQ(shell.collection().size(), 4u);
+    std::remove(path.c_str());
+}
+
+TEST(WalTest, FailedSyncRefusesAppendsUntilCheckpoint) {
+    std::string path = testing::TempDir() + "wal_failed_sync.log";
+    std::remove(path.c_str());
+    std::signal(SIGXFSZ, SIG_IGN);
+    FigureCollection figures;
+    figures.push_back(std::make_unique<Diamond>());
+    {
+        WriteAheadLog wal(path);
+        wal.logAdd(figures[0]);
+        wal.commit();
+
+        // Следующая пачка не помещается в файл: она не повторяется, журнал отказывает
+        std::ifstream written(path, std::ios::binary | std::ios::ate);
+        limitFileSize(static_cast<rlim_t>(written.tellg()));
+        wal.logAdd(figures[0]);
+        EXPECT_THROW(wal.commit(), std::runtime_error);
+        limitFileSize(RLIM_INFINITY);
+        EXPECT_THROW(wal.logAdd(figures[0]), std::runtime_error);
+        EXPECT_THROW(wal.commit(), std::runtime_error);
+
+        wal.checkpoint(figures);
+        figures.push_back(std::make_unique<Hexagon>());
+        wal.logAdd(figures[1]);
+        wal.commit();
+    }
+    std::signal(SIGXFSZ, SIG_DFL);
+    FigureCollection replayed;
+    WalReplay replay = replayWal(path, replayed);
+    EXPECT_EQ(replayed.size(), 2u);
+    EXPECT_FALSE(replay.tornTail);
+    std::remove(path.c_str());
+}
+
+// =============== FIGURE VALUE TESTS ===============
+
+// Пользовательская фигура: треугольник, помещается во встроенный буфер
+class TestTriangle : public Figure
+{
+    public:
+        std::array<std::pair<double, double>, 3> apexes{{{0, 0}, {4, 0}, {0, 3}}};
+
+        TestTriangle() = default;
+        TestTriangle(const TestTriangle& other) noexcept : apexes(other.apexes) {}
+        std::pair<double, double> getCenter() const override { return {4.0 / 3, 1.0}; }
+        void print(std::ostream& os) const override { os << "Треугольник"; }
+        void read(std::istream&) override {}
+        operator double() const override { return calculateArea(); }
+        double calculateArea() const override { return 6.0; }
+        Figure& operator=(const Figure&) override { return *this; }
+        Figure& operator=(Figure&&) noexcept override { return *this; }
+        bool operator==(const Figure&) const override { return false; }
+        std::unique_ptr<Figure> clone() const override { return std::make_unique<TestTriangle>(*this); }
+        size_t apexCount() const override { return 3; }
+        const std::pair<double, double>* apexData() const override { return apexes.data(); }
+        std::pair<double, double>* apexData() override { return apexes.data(); }
+};
+
+// Слишком большая для буфера фигура
+class TestBigTriangle : public TestTriangle
+{
+    public:
+        double padding[32] = {};
+
+        TestBigTriangle() = default;
+        TestBigTriangle(const TestBigTriangle& other) noexcept : TestTriangle(other) {}
+        double calculateArea() const override { return 60.0; }
+        std::unique_ptr<Figure> clone() const override { return std::make_unique<TestBigTriangle>(*this); }
+};
+
+TEST(FigureValueTest, ValueSemanticsInline) {
+    std::vector<FigureValue> values;
+    values.emplace_back(Diamond());
+    values.emplace_back(Hexagon());
+    values.emplace_back(TestTriangle());
+    for (const auto& v : values) {
+        EXPECT_TRUE(v.isInline());
+    }
+    EXPECT_DOUBLE_EQ(values[0].area(), 0.5);
+    EXPECT_NEAR(values[1].area(), 3.0 * std::sqrt(3.0) / 2.0, 1e-12);
+    EXPECT_DOUBLE_EQ(values[2].area(), 6.0);
+
+    FigureValue copy = values[1];
+    Transform tr;
+    tr.scale(2.0, 2.0);
+    applyTransform(copy.get(), tr);
+    EXPECT_NEAR(copy.area(), 4.0 * values[1].area(), 1e-12);   // оригинал не изменился
+
+    FigureValue moved = std::move(copy);
+    EXPECT_TRUE(copy.empty());
+    EXPECT_NEAR(moved.center().first, 0.0, 1e-12);
+}
+
+TEST(FigureValueTest, LargeAndPolymorphicFiguresUseHeap) {
+    FigureValue big{TestBigTriangle()};
+    EXPECT_FALSE(big.isInline());
+    FigureValue copy = big;
+    EXPECT_DOUBLE_EQ(copy.area(), 60.0);
+    EXPECT_NE(&copy.get(), &big.get());
+
+    std::unique_ptr<Figure> base = std::make_unique<TestBigTriangle>();
+    FigureValue fromBase = FigureValue::copyOf(*base);
+    EXPECT_DOUBLE_EQ(fromBase.area(), 60.0);
+    FigureValue hexagon = FigureValue::copyOf(Hexagon());
+    EXPECT_TRUE(hexagon.isInline());
+}
+
+// Пользовательская фигура без доступа к вершинам
+class TestOpaqueFigure : public Figure
+{
+    public:
+        TestOpaqueFigure() = default;
+        TestOpaqueFigure(const TestOpaqueFigure&) noexcept {}
+        std::pair<double, double> getCenter() const override { return {1.0, 2.0}; }
+        void print(std::ostream& os) const override { os << "Фигура"; }
+        void read(std::istream&) override {}
+        operator double() const override { return calculateArea(); }
+        double calculateArea() const override { return 2.0; }
+        Figure& operator=(const Figure&) override { return *this; }
+        Figure& operator=(Figure&&) noexcept override { return *this; }
+        bool operator==(const Figure&) const override { return false; }
+        std::unique_ptr<Figure> clone() const override { return std::make_unique<TestOpaqueFigure>(*this); }
+};
+
+TEST(FigureValueTest, UserFiguresInBatchCode) {
+    // Класс, не известный библиотеке, обрабатывается как многоугольник из своих вершин
+    TestTriangle triangle;
+    EXPECT_EQ(kindOf(triangle), FigureKind::Polygon);
+    FigureBuffer buf;
+    buf.push(triangle);
+    EXPECT_EQ(buf.apexCount(0), 3u);
+    EXPECT_DOUBLE_EQ(buf.area(0), 6.0);
+
+    // Фигура без вершин работает как значение, но в буфер и преобразования не попадает
+    TestOpaqueFigure opaque;
+    FigureValue value{opaque};
+    EXPECT_DOUBLE_EQ(value.area(), 2.0);
+    EXPECT_EQ(kindOf(opaque), FigureKind::Polygon);
+    EXPECT_THROW(buf.push(opaque), std::invalid_argument);
+    EXPECT_EQ(buf.size(), 1u);
+    Transform tr;
+    tr.translate(1.0, 0.0);
+    EXPECT_THROW(applyTransform(opaque, tr), std::invalid_argument);
+
+    std::vector<std::unique_ptr<Figure>> figures;
+    figures.push_back(std::make_unique<TestTriangle>());
+    figures.push_back(std::make_unique<TestOpaqueFigure>());
+    MemoryReport report = measureMemory(figures);
+    EXPECT_EQ(report[FigureKind::Polygon].count, 2u);
+    EXPECT_EQ(report[FigureKind::Polygon].objectBytes, 0u);
+}
+
+// =============== POLYGON TESTS ===============
+
+// Правильный n-угольник радиуса r с центром (cx, cy)
+static void regularPolygon(size_t n, double r, double cx, double cy, std::vector<double>& xs, std::vector<double>& ys) {
+    xs.resize(n);
+    ys.resize(n);
+    for (size_t j = 0; j < n; ++j) {
+        xs[j] = cx + r * std::cos(2.0 * M_PI * j / n);
+        ys[j] = cy + r * std::sin(2.0 * M_PI * j / n);
+    }
+}
+
+TEST(PolygonTest, AreaCenterAndRead) {
+    Polygon square({{0, 0}, {2, 0}, {2, 2}, {0, 2}});
+    EXPECT_DOUBLE_EQ(static_cast<double>(square), 4.0);
+    EXPECT_EQ(square.getCenter(), std::make_pair(1.0, 1.0));
+
+    Polygon tri;
+    std::istringstream in("3 0 0 4 0 0 3");
+    in >> tri;
+    EXPECT_DOUBLE_EQ(tri.calculateArea(), 6.0);
+    std::ostringstream out;
+    out << tri;
+    EXPECT_EQ(out.str(), "Вершины: 0,0;4,0;0,3");
+    EXPECT_THROW(Polygon({{0, 0}, {1, 1}}), std::invalid_argument);
+}
+
+TEST(PolygonTest, MixedBufferKernelsAndFormats) {
+    FigureBuffer buf;
+    std::vector<double> xs, ys;
+    for (size_t i = 0; i < 600; ++i) {
+        size_t sizes[] = {3, 8, 12};
+        size_t n = sizes[i % 3];
+        regularPolygon(n, 1.0 + i * 0.01, i * 0.5, -1.0 * i, xs, ys);
+        buf.push(FigureKind::Polygon, xs.data(), ys.data(), n);
+        buf.push(Hexagon());
+        buf.push(Diamond({{{2, 0}, {0, 3}, {-2, 0}, {0, -3}}}));
+    }
+    std::vector<double> areas(buf.size());
+    batchAreas(buf, areas.data());
+    for (size_t i = 0; i < buf.size(); ++i) {
+        ASSERT_EQ(areas[i], buf.area(i)) << i;
+    }
+    EXPECT_DOUBLE_EQ(buf.area(2), 12.0);
+    EXPECT_EQ(buf.apexCount(3), 8u);
+
+    // Текстовый формат
+    std::ostringstream text;
+    writeFigures(text, buf);
+    std::string str = text.str();
+    FigureBuffer parsed;
+    parseFigures(str.data(), str.data() + str.size(), parsed);
+    ASSERT_EQ(parsed.size(), buf.size());
+    EXPECT_EQ(parsed.kind(3), FigureKind::Polygon);
+    EXPECT_EQ(parsed.apexCount(3), 8u);
+    EXPECT_EQ(parsed.area(3), buf.area(3));
+
+    // Архив
+    std::stringstream archive;
+    writeArchive(archive, buf);
+    FigureBuffer restored = ArchiveReader(archive).readAll();
+    ASSERT_EQ(restored.size(), buf.size());
+    EXPECT_EQ(restored.apexCount(6), 12u);
+    EXPECT_NEAR(restored.area(6), buf.area(6), 1e-4);
+
+    // Объекты и сводка
+    auto poly = buf.materialize(0);
+    EXPECT_EQ(kindOf(*poly), FigureKind::Polygon);
+    EXPECT_EQ(static_cast<double>(*poly), buf.area(0));
+    Summary summary = summarize(buf);
+    EXPECT_EQ(summary[FigureKind::Polygon].count, 600u);
+    EXPECT_EQ(summary.all.count, buf.size());
+}
+
+TEST(PolygonTest, ValidationAndShell) {
+    // Невыпуклый «наконечник стрелы»
+    const double xs[] = {0, 2, 0, 1};
+    const double ys[] = {0, 1, 2, 1};
+    EXPECT_EQ(validateApexes(FigureKind::Polygon, xs, ys, 4), static_cast<std::uint32_t>(NOT_CONVEX));
+
+    Shell shell(false);
+    std::stringstream in("add polygon 3 0 0 4 0 0 3\nadd polygon 2 0 0 1 1\ncount\ntotal\n");
+    std::stringstream out;
+    while (shell.execute(in, out)) {}
+    EXPECT_NE(out.str().find("Ошибка: неверные координаты"), std::string::npos);
+    EXPECT_NE(out.str().find("Фигур: 1"), std::string::npos);
+    EXPECT_NE(out.str().find("Общая площадь: 6"), std::string::npos);
+}
+
+TEST(PolygonTest, RejectsUntrustedVertexCounts) {
+    // Число вершин приходит извне и не должно определять размер выделения
+    Shell shell(false);
+    std::stringstream in("add polygon -1\nadd polygon 400000000000 0 0\n"
+                         "add polygon 3 0 0 1 0 0 1\ncount\n");
+    std::stringstream out;
+    while (shell.execute(in, out)) {}
+    EXPECT_NE(out.str().find("Фигур: 1"), std::string::npos);
+
+    FigureBuffer figures;
+    std::string text = "add polygon 400000000000 0 0 1 0 0 1\n";
+    EXPECT_THROW(parseFigures(text.data(), text.data() + text.size(), figures), std::runtime_error);
+    EXPECT_EQ(figures.size(), 0u);
+}
+
+// =============== KD-TREE TESTS ===============
+
+namespace {
+
+std::vector<KdPoint> randomPoints(size_t n, unsigned seed) {
+    std::mt19937 rng(seed);
+    // Целые координаты дают много равных расстояний и совпадающих точек
+    std::uniform_int_distribution<int> coord(0, 40);
+    std::vector<KdPoint> pts(n);
+    for (size_t i = 0; i < n; ++i) {
+        pts[i] = {static_cast<double>(coord(rng)), static_cast<double>(coord(rng)), i};
+    }
+    return pts;
+}
+
+std::vector<Neighbor> bruteNearest(const std::vector<KdPoint>& pts, double x, double y, size_t k) {
+    std::vector<Neighbor> all;
+    for (const KdPoint& p : pts) {
+        all.push_back({p.id, (p.x - x) * (p.x - x) + (p.y - y) * (p.y - y)});
+    }
+    std::sort(all.begin(), all.end(), [](const Neighbor& a, const Neighbor& b) {
+        return a.distance < b.distance || (a.distance == b.distance && a.id < b.id);
+    });
+    all.resize(std::min(k, all.size()));
+    for (Neighbor& n : all) {
+        n.distance = std::sqrt(n.distance);
+    }
+    return all;
+}
+
+} // namespace
+
+TEST(KdTreeTest, MatchesBruteForce) {
+    auto pts = randomPoints(3000, 7);
+    KdTree tree(pts, 4);
+    ASSERT_EQ(tree.size(), pts.size());
+
+    std::vector<std::pair<double, double>> queries;
+    for (int i = 0; i < 50; ++i) {
+        queries.emplace_back(i * 0.9 - 3.0, 40.5 - i * 0.7);
+    }
+    auto batch = tree.nearestBatch(queries, 10, 3);
+    auto ranges = tree.withinBatch(queries, 3.0, 3);
+    for (size_t q = 0; q < queries.size(); ++q) {
+        auto expected = bruteNearest(pts, queries[q].first, queries[q].second, 10);
+        ASSERT_EQ(batch[q].size(), expected.size());
+        for (size_t i = 0; i < expected.size(); ++i) {
+            EXPECT_EQ(batch[q][i].id, expected[i].id);
+            EXPECT_DOUBLE_EQ(batch[q][i].distance, expected[i].distance);
+        }
+        std::vector<size_t> inside;
+        for (const KdPoint& p : pts) {
+            double dx = p.x - queries[q].first, dy = p.y - queries[q].second;
+            if (dx * dx + dy * dy <= 9.0) inside.push_back(p.id);
+        }
+        EXPECT_EQ(ranges[q], inside);
+        EXPECT_EQ(tree.within(queries[q].first, queries[q].second, 3.0), inside);
+    }
+    EXPECT_TRUE(KdTree().nearest(0, 0, 3).empty());
+    EXPECT_EQ(tree.nearest(0, 0, 0).size(), 0u);
+    EXPECT_EQ(KdTree(randomPoints(5, 1)).nearest(0, 0, 10).size(), 5u);
+}
+
+TEST(KdTreeTest, PairsWithinAndFigureCenters) {
+    auto pts = randomPoints(800, 11);
+    KdTree tree(pts);
+    std::vector<std::pair<size_t, size_t>> expected;
+    for (size_t a = 0; a < pts.size(); ++a) {
+        for (size_t b = a + 1; b < pts.size(); ++b) {
+            double dx = pts[a].x - pts[b].x, dy = pts[a].y - pts[b].y;
+            if (dx * dx + dy * dy <= 2.25) expected.emplace_back(a, b);
+        }
+    }
+    EXPECT_EQ(tree.pairsWithin(1.5, 4), expected);
+
+    // Дерево по центрам фигур буфера
+    FigureBuffer buf;
+    for (int i = 0; i < 20; ++i) {
+        const double xs[] = {i * 10.0, i * 10.0 + 2, i * 10.0, i * 10.0 - 2};
+        const double ys[] = {-2, 0, 2, 0};
+        buf.push(FigureKind::Diamond, xs, ys);
+    }
+    KdTree centers;
+    centers.build(buf);
+    auto near = centers.nearest(41.0, 1.0, 2);
+    ASSERT_EQ(near.size(), 2u);
+    EXPECT_EQ(near[0].id, 4u);
+    EXPECT_EQ(near[1].id, 5u);
+    EXPECT_EQ(centers.within(50.0, 0.0, 10.0), (std::vector<size_t>{4, 5, 6}));
+}
+
+TEST(KdTreeTest, IncrementalMatchesStatic) {
+    auto pts = randomPoints(1000, 3);
+    IncrementalKdTree inc;
+    for (size_t i = 0; i < pts.size(); ++i) {
+        inc.insert(pts[i].x, pts[i].y, pts[i].id);
+        if (i % 97 == 0 || i + 1 == pts.size()) {
+            std::vector<KdPoint> prefix(pts.begin(), pts.begin() + i + 1);
+            KdTree tree(prefix);
+            auto a = inc.nearest(20.0, 20.0, 7);
+            auto b = tree.nearest(20.0, 20.0, 7);
+            ASSERT_EQ(a.size(), b.size());
+            for (size_t j = 0; j < a.size(); ++j) {
+                EXPECT_EQ(a[j].id, b[j].id);
+            }
+            EXPECT_EQ(inc.within(5.0, 30.0, 4.0), tree.within(5.0, 30.0, 4.0));
+        }
+    }
+    EXPECT_EQ(inc.size(), pts.size());
+}
+
+// =============== RASTER TESTS ===============
+
+TEST(RasterTest, SquareFillsViewExactly) {
+    FigureBuffer buf;
+    const double xs[] = {0, 10, 10, 0};
+    const double ys[] = {0, 0, 10, 10};
+    buf.push(FigureKind::Diamond, xs, ys);
+    RasterOptions opts;
+    opts.width = 20;
+    opts.height = 20;
+    opts.tile = 8;
+    Raster raster = rasterize(buf, opts);
+    ASSERT_EQ(raster.coverage.size(), 400u);
+    for (float c : raster.coverage) {
+        EXPECT_EQ(c, 1.0f);
+    }
+
+    // Та же фигура в левой половине области: правая половина пуста
+    opts.view.add(0, 0);
+    opts.view.add(20, 10);
+    opts.width = 40;
+    raster = rasterize(buf, opts);
+    EXPECT_EQ(raster.at(0, 0), 1.0f);
+    EXPECT_EQ(raster.at(19, 19), 1.0f);
+    EXPECT_EQ(raster.at(20, 0), 0.0f);
+
+    std::stringstream pgm;
+    writePgm(pgm, raster);
+    std::string data = pgm.str();
+    EXPECT_EQ(data.substr(0, 13), "P5\n40 20\n255\n");
+    EXPECT_EQ(static_cast<unsigned char>(data[13]), 0);
+    EXPECT_EQ(static_cast<unsigned char>(data[13 + 39]), 255);
+}
+
+TEST(RasterTest, AntialiasedCoverageMatchesArea) {
+    // Непересекающиеся правильные шестиугольники и пятиугольники
+    FigureBuffer buf;
+    double total = 0.0;
+    for (int i = 0; i < 30; ++i) {
+        FigureKind kind = i % 2 ? FigureKind::Pentagon : FigureKind::Hexagon;
+        size_t n = kindApexCount(kind);
+        double xs[6], ys[6];
+        for (size_t j = 0; j < n; ++j) {
+            xs[j] = (i % 6) * 10.0 + 3.0 * std::cos(0.3 * i + 2.0 * M_PI * j / n);
+            ys[j] = (i / 6) * 10.0 + 3.0 * std::sin(0.3 * i + 2.0 * M_PI * j / n);
+        }
+        buf.push(kind, xs, ys);
+        total += buf.area(i);
+    }
+    RasterOptions opts;
+    opts.view.add(-5, -5);
+    opts.view.add(55, 45);
+    opts.width = 240;
+    opts.height = 200;
+    opts.samples = 8;
+    opts.tile = 16;
+    opts.threads = 1;
+    Raster raster = rasterize(buf, opts);
+    double covered = 0.0;
+    for (float c : raster.coverage) {
+        covered += c;
+    }
+    double pixel = 0.25 * 0.25;
+    EXPECT_NEAR(covered * pixel, total, total * 0.01);
+
+    // Число потоков и размер плиток не влияют на результат
+    opts.threads = 4;
+    opts.tile = 7;
+    EXPECT_EQ(rasterize(buf, opts).coverage, raster.coverage);
+    opts.samples = 17;
+    EXPECT_THROW(rasterize(buf, opts), std::invalid_argument);
+}
+
+TEST(RasterTest, ShellRender) {
+    std::string path = testing::TempDir() + "render_test.pgm";
+    Shell shell(false);
+    std::stringstream in("add diamond 0 0 4 0 4 4 0 4\nrender " + path + " 16 8\n");
+    std::stringstream out;
+    while (shell.execute(in, out)) {}
+    EXPECT_NE(out.str().find("Изображение 16 x 8"), std::string::npos);
+    std::ifstream file(path, std::ios::binary);
+    std::string header;
+    std::getline(file, header);
+    EXPECT_EQ(header, "P5");
+    file.close();
+
+    std::stringstream bad("render " + path + " 0 8\nrender " + path + " -16 8\nrender " + path + " 16\n"
+                          "render " + path + " 16 x\nrender " + path + " 100000 4 99\n");
+    std::stringstream report;
+    while (shell.execute(bad, report)) {}
+    std::string text = report.str();
+    size_t errors = 0;
+    for (size_t pos = text.find("Ошибка"); pos != std::string::npos; pos = text.find("Ошибка", pos + 1)) ++errors;
+    EXPECT_EQ(errors, 4u);
+    EXPECT_NE(text.find("Изображение 8192 x 4"), std::string::npos);
+    std::remove(path.c_str());
+}
+
+// =============== COVERAGE TESTS ===============
+
+namespace {
+
+// Оценка покрытой площади методом Монте-Карло: доля случайных точек
+// габаритного прямоугольника, попавших хотя бы в одну фигуру (чёт-нечет)
+double monteCarloCoverage(const FigureBuffer& figures, size_t samples, unsigned seed) {
+    Extent ext = extentOf(figures);
+    std::mt19937_64 rng(seed);
+    std::uniform_real_distribution<double> px(ext.minX, ext.maxX);
+    std::uniform_real_distribution<double> py(ext.minY, ext.maxY);
+    size_t hits = 0;
+    for (size_t s = 0; s < samples; ++s) {
+        double x = px(rng), y = py(rng);
+        for (size_t i = 0; i < figures.size(); ++i) {
+            const double* xs = figures.xs(i);
+            const double* ys = figures.ys(i);
+            size_t n = figures.apexCount(i);
+            bool inside = false;
+            for (size_t j = 0, k = n - 1; j < n; k = j++) {
+                if ((ys[j] > y) != (ys[k] > y) && x < xs[j] + (y - ys[j]) * (xs[k] - xs[j]) / (ys[k] - ys[j])) {
+                    inside = !inside;
+                }
+            }
+            if (inside) {
+                ++hits;
+                break;
+            }
+        }
+    }
+    return ext.width() * ext.height() * hits / samples;
+}
+
+} // namespace
+
+TEST(CoverageTest, ExactForSimpleOverlaps) {
+    FigureBuffer buf;
+    EXPECT_EQ(unionArea(buf), 0.0);
+    // Два квадрата 2x2 с перекрытием 1x1 и третий внутри первого
+    const double ax[] = {0, 2, 2, 0}, ay[] = {0, 0, 2, 2};
+    const double bx[] = {1, 3, 3, 1}, by[] = {1, 1, 3, 3};
+    const double cx[] = {0.5, 1, 0.5, 0}, cy[] = {0, 0.5, 1, 0.5};
+    buf.push(FigureKind::Diamond, ax, ay);
+    EXPECT_DOUBLE_EQ(unionArea(buf), 4.0);
+    buf.push(FigureKind::Diamond, bx, by);
+    EXPECT_DOUBLE_EQ(unionArea(buf), 7.0);
+    buf.push(FigureKind::Diamond, cx, cy);
+    EXPECT_DOUBLE_EQ(unionArea(buf), 7.0);
+    // Отдельная фигура добавляется целиком
+    const double dx[] = {10, 11, 10}, dy[] = {10, 10, 11};
+    buf.push(FigureKind::Polygon, dx, dy, 3);
+    EXPECT_DOUBLE_EQ(unionArea(buf, 4), 7.5);
+
+    // Самопересекающийся «бантик»: два треугольника по 1
+    FigureBuffer bow;
+    const double wx[] = {0, 2, 2, 0}, wy[] = {0, 2, 0, 2};
+    bow.push(FigureKind::Diamond, wx, wy);
+    EXPECT_DOUBLE_EQ(unionArea(bow), 2.0);
+}
+
+TEST(CoverageTest, DenseOverlapsStayExact) {
+    // 400 квадратов, сдвинутых по диагонали на d: каждый следующий
+    // добавляет 2d - d^2. Все фигуры в одной ячейке сетки
+    const size_t n = 400;
+    const double d = 1e-3;
+    FigureBuffer buf;
+    for (size_t i = 0; i < n; ++i) {
+        double t = i * d;
+        const double xs[] = {t, t + 1, t + 1, t};
+        const double ys[] = {t, t, t + 1, t + 1};
+        buf.push(FigureKind::Diamond, xs, ys);
+    }
+    EXPECT_NEAR(unionArea(buf, 1), 1.0 + (n - 1) * (2 * d - d * d), 1e-9);
+
+    // 300 повёрнутых шестиугольников с общим центром; значение получено
+    // прежним разбором без деления ячеек (все пары фигур ячейки)
+    FigureBuffer rings;
+    for (size_t i = 0; i < 300; ++i) {
+        double xs[6], ys[6];
+        for (size_t j = 0; j < 6; ++j) {
+            double phi = 2.0 * M_PI * j / 6 + i * (M_PI / 3) / 300;
+            xs[j] = 10.0 * std::cos(phi);
+            ys[j] = 10.0 * std::sin(phi);
+        }
+        rings.push(FigureKind::Hexagon, xs, ys);
+    }
+    EXPECT_NEAR(unionArea(rings, 1), 313.843334676, 1e-8);
+
+    // Вертикальные стороны, проходящие через ячейку без вершин в ней
+    FigureBuffer tall;
+    const double tx[] = {0, 1, 1, 0}, ty[] = {0, 0, 10, 10};
+    const double sx[] = {20, 21, 21, 20}, sy[] = {0, 0, 1, 1};
+    tall.push(FigureKind::Diamond, tx, ty);
+    tall.push(FigureKind::Diamond, sx, sy);
+    EXPECT_DOUBLE_EQ(unionArea(tall, 1), 11.0);
+}
+
+TEST(CoverageTest, MatchesMonteCarlo) {
+    // Плотное скопление правильных фигур с многочисленными перекрытиями
+    std::mt19937_64 rng(5);
+    std::uniform_real_distribution<double> pos(0.0, 20.0);
+    std::uniform_real_distribution<double> radius(0.5, 3.0);
+    std::uniform_real_distribution<double> phase(0.0, 2.0 * M_PI);
+    FigureBuffer buf;
+    double total = 0.0;
+    for (int i = 0; i < 200; ++i) {
+        FigureKind kind = static_cast<FigureKind>(4 + i % 3);
+        size_t n = kindApexCount(kind);
+        double ox = pos(rng), oy = pos(rng), r = radius(rng), phi = phase(rng);
+        double xs[6], ys[6];
+        for (size_t j = 0; j < n; ++j) {
+            xs[j] = ox + r * std::cos(phi + 2.0 * M_PI * j / n);
+            ys[j] = oy + r * std::sin(phi + 2.0 * M_PI * j / n);
+        }
+        buf.push(kind, xs, ys);
+        total += buf.area(i);
+    }
+    double exact = unionArea(buf, 1);
+    EXPECT_LT(exact, total);
+    EXPECT_EQ(unionArea(buf, 4), exact);
+    // Стандартное отклонение оценки около 0.3%
+    EXPECT_NEAR(monteCarloCoverage(buf, 200000, 9), exact, exact * 0.01);
+
+    Shell shell(false);
+    std::stringstream in("add diamond 0 0 2 0 2 2 0 2\nadd diamond 1 1 3 1 3 3 1 3\ncoverage\n");
+    std::stringstream out;
+    while (shell.execute(in, out)) {}
+    EXPECT_NE(out.str().find("Покрытая площадь: 7"), std::string::npos);
+}
+
+// =============== MEMORY ACCOUNTING TESTS ===============
+
+TEST(MemoryTest, HeapCounters) {
+    HeapStats before = heapStats();
+    long long delta = 0;
+    {
+        std::vector<double> v;
+        delta = heapDelta([&] { v.resize(1000); });
+        EXPECT_EQ(static_cast<size_t>(delta), blockSize(v.data()));
+        EXPECT_GE(blockSize(v.data()), 1000 * sizeof(double));
+        EXPECT_GE(heapStats().peakBytes, heapStats().liveBytes);
+    }
+    HeapStats after = heapStats();
+    EXPECT_GT(after.allocations, before.allocations);
+    EXPECT_EQ(blockSize(nullptr), 0u);
+}
+
+TEST(MemoryTest, ReportMatchesHeapGrowth) {
+    auto build = [](auto& add) {
+        for (int i = 0; i < 300; ++i) {
+            switch (i % 4) {
+                case 0: add(std::make_unique<Diamond>()); break;
+                case 1: add(std::make_unique<Pentagon>()); break;
+                case 2: add(std::make_unique<Hexagon>()); break;
+                default: add(std::make_unique<Polygon>()); break;
+            }
+        }
+    };
+
+    std::optional<FigureCollection> collection;
+    long long grown = heapDelta([&] {
+        collection.emplace();
+        auto add = [&](std::unique_ptr<Figure> fig) { collection->push_back(std::move(fig)); };
+        build(add);
+    });
+    MemoryReport report = measureMemory(*collection);
+    // Не более одной лишней гранулы распределителя на скрытый блок
+    EXPECT_LE(report.heapBytes(), static_cast<size_t>(grown));
+    EXPECT_GE(report.heapBytes() + 16 * 305, static_cast<size_t>(grown));
+    EXPECT_EQ(report.count(), 300u);
+    EXPECT_EQ(report[FigureKind::Hexagon].count, 75u);
+    EXPECT_EQ(report[FigureKind::Hexagon].vertexBytes, 75u * 6 * 16);
+    EXPECT_EQ(report[FigureKind::Diamond].objectBytes, 75 * sizeof(Diamond));
+    EXPECT_GE(report[FigureKind::Diamond].heapBytes, report[FigureKind::Diamond].objectBytes);
+    EXPECT_GE(report.container.capacityBytes, report.container.usedBytes);
+    EXPECT_GT(report.overheadBytes(), 0u);
+
+    std::vector<std::unique_ptr<Figure>> vec;
+    grown = heapDelta([&] {
+        auto add = [&](std::unique_ptr<Figure> fig) { vec.push_back(std::move(fig)); };
+        build(add);
+    });
+    EXPECT_EQ(measureMemory(vec).heapBytes(), static_cast<size_t>(grown));
+
+    // Плоский буфер: те же вершины, только массивы координат
+    std::optional<FigureBuffer> buf;
+    grown = heapDelta([&] { buf.emplace(toBuffer(vec)); });
+    MemoryReport flat = measureMemory(*buf);
+    EXPECT_EQ(flat.heapBytes(), static_cast<size_t>(grown));
+    EXPECT_EQ(flat.vertexBytes(), measureMemory(vec).vertexBytes());
+    EXPECT_LT(flat.heapBytes(), measureMemory(vec).heapBytes());
+
+    Shell shell(false);
+    std::stringstream in("add diamond 0 0 1 0 1 1 0 1\nmem\n");
+    std::stringstream out;
+    while (shell.execute(in, out)) {}
+    EXPECT_NE(out.str().find("Ромбы: количество 1, в куче"), std::string::npos);
+    EXPECT_NE(out.str().find("Куча процесса:"), std::string::npos);
+}
+
+TEST(MemoryTest, VersionsCountOnlyUnsharedParts) {
+    FigureCollection live;
+    for (int i = 0; i < 300; ++i) {
+        live.push_back(std::make_unique<Diamond>());
+    }
+    FigureCollection before = live;
+    FigureCollection same = before;
+    EXPECT_EQ(measureVersions(live, {&before}).heapBytes(), 0u);
+
+    // После изменения у старой версии свои оглавление, кусок и фигура
+    live.mutate(0).apexData()[0].first = 5.0;
+    MemoryReport extra = measureVersions(live, {&before, &same});
+    EXPECT_EQ(extra.count(), 1u);
+    EXPECT_EQ(extra[FigureKind::Diamond].count, 1u);
+    EXPECT_GT(extra.container.heapBytes, 0u);
+    EXPECT_LT(extra.heapBytes(), measureMemory(live).heapBytes() / 10);
+
+    Shell shell(false);
+    std::stringstream in("add diamond 0 0 1 0 1 1 0 1\nsnapshot\nremove 0\nmem\n");
+    std::stringstream out;
+    while (shell.execute(in, out)) {}
+    EXPECT_NE(out.str().find("История и снимки (3): ещё "), std::string::npos);
+    EXPECT_NE(out.str().find("фигур вне коллекции 1\n"), std::string::npos);
+}
+
+// =============== GENERATOR TESTS ===============
+
+TEST(GeneratorTest, DeterministicAcrossThreadCounts) {
+    GeneratorOptions opts;
+    opts.count = 20000;
+    opts.seed = 42;
+    opts.threads = 1;
+    FigureBuffer a = generateFigures(opts);
+    opts.threads = 4;
+    FigureBuffer b = generateFigures(opts);
+    ASSERT_EQ(a.size(), 20000u);
+    ASSERT_EQ(b.size(), a.size());
+    ASSERT_EQ(b.apexTotal(), a.apexTotal());
+    for (size_t i = 0; i < a.size(); ++i) {
+        ASSERT_EQ(a.kind(i), b.kind(i));
+        for (size_t j = 0; j < a.apexCount(i); ++j) {
+            ASSERT_EQ(a.xs(i)[j], b.xs(i)[j]);
+            ASSERT_EQ(a.ys(i)[j], b.ys(i)[j]);
+        }
+    }
+
+    opts.seed = 43;
+    FigureBuffer c = generateFigures(opts);
+    EXPECT_NE(c.xs(0)[0], a.xs(0)[0]);
+}
+
+TEST(GeneratorTest, ValidFiguresFollowMixAndSizes) {
+    GeneratorOptions opts;
+    opts.count = 30000;
+    setGeneratorOption(opts, "mix=diamond:2,irregular-pentagon:1,irregular-hexagon:1");
+    setGeneratorOption(opts, "layout=clustered");
+    setGeneratorOption(opts, "sizes=zipf");
+    setGeneratorOption(opts, "min=0.5");
+    setGeneratorOption(opts, "max=50");
+    FigureBuffer figures = generateFigures(opts);
+
+    ValidationReport report = validateAll(figures);
+    EXPECT_EQ(report.checked, 30000u);
+    EXPECT_TRUE(report.failures.empty());
+
+    size_t counts[7] = {};
+    size_t small = 0;
+    for (size_t i = 0; i < figures.size(); ++i) {
+        ++counts[static_cast<size_t>(figures.kind(i))];
+        // Вершины лежат в круге радиуса размера: поперечник не больше 2 max
+        double diameter = 0.0;
+        for (size_t j = 0; j < figures.apexCount(i); ++j) {
+            for (size_t k = 0; k < j; ++k) {
+                diameter = std::max(diameter, std::hypot(figures.xs(i)[j] - figures.xs(i)[k],
+                                                         figures.ys(i)[j] - figures.ys(i)[k]));
+            }
+        }
+        EXPECT_LE(diameter, 100.0 + 1e-9);
+        if (diameter < 10.0) ++small;
+    }
+    EXPECT_NEAR(counts[4] / 30000.0, 0.5, 0.02);
+    EXPECT_NEAR(counts[5] / 30000.0, 0.25, 0.02);
+    EXPECT_NEAR(counts[6] / 30000.0, 0.25, 0.02);
+    // Закон Ципфа: мелкие фигуры преобладают
+    EXPECT_GT(small, figures.size() / 2);
+
+    // Правильный пятиугольник: площадь 5/2 r² sin 72°
+    GeneratorOptions regular;
+    regular.count = 100;
+    setGeneratorOption(regular, "mix=pentagon");
+    FigureBuffer pentagons = generateFigures(regular);
+    for (size_t i = 0; i < pentagons.size(); ++i) {
+        ASSERT_EQ(pentagons.kind(i), FigureKind::Pentagon);
+        auto c = pentagons.center(i);
+        double r = std::hypot(pentagons.xs(i)[0] - c.first, pentagons.ys(i)[0] - c.second);
+        EXPECT_NEAR(pentagons.area(i), 2.5 * r * r * std::sin(2 * M_PI / 5), 1e-9 * r * r);
+    }
+}
+
+TEST(GeneratorTest, OptionsAndShellCommand) {
+    GeneratorOptions opts;
+    EXPECT_THROW(setGeneratorOption(opts, "layout=spiral"), std::invalid_argument);
+    EXPECT_THROW(setGeneratorOption(opts, "colour=red"), std::invalid_argument);
+    EXPECT_THROW(setGeneratorOption(opts, "seed"), std::invalid_argument);
+    EXPECT_THROW(setGeneratorOption(opts, "mix=triangle:1"), std::invalid_argument);
+    setGeneratorOption(opts, "mix=hexagon:0");
+    EXPECT_THROW(generateFigures(opts), std::invalid_argument);
+
+    Shell shell(false);
+    std::stringstream in("generate 500 seed=7 mix=diamond\ngenerate 1000001\n"
+                         "generate 5 layout=clustered clusters=99999999999\ncount\n");
+    std::stringstream out;
+    while (shell.execute(in, out)) {}
+    EXPECT_NE(out.str().find("Создано фигур: 500"), std::string::npos);
+    EXPECT_NE(out.str().find("Ошибка: At most 1000000"), std::string::npos);
+    EXPECT_NE(out.str().find("Фигур: 500"), std::string::npos);
+    EXPECT_EQ(shell.collection().size(), 500u);
+}
+
+// =============== ARROW TESTS ===============
+
+namespace {
+
+FigureBuffer arrowSample() {
+    GeneratorOptions opts;
+    opts.count = 1000;
+    opts.seed = 11;
+    FigureBuffer figures = generateFigures(opts);
+    double xs[7] = {0, 4, 6, 5, 3, 1, -1};
+    double ys[7] = {0, 0, 2, 4, 5, 4, 2};
+    figures.push(FigureKind::Polygon, xs, ys, 7);
+    return figures;
+}
+
+void expectSameFigures(const FigureBuffer& a, const FigureBuffer& b) {
+    ASSERT_EQ(a.size(), b.size());
+    for (size_t i = 0; i < a.size(); ++i) {
+        ASSERT_EQ(a.kind(i), b.kind(i));
+        ASSERT_EQ(a.apexCount(i), b.apexCount(i));
+        for (size_t j = 0; j < a.apexCount(i); ++j) {
+            ASSERT_EQ(a.xs(i)[j], b.xs(i)[j]);
+            ASSERT_EQ(a.ys(i)[j], b.ys(i)[j]);
+        }
+    }
+}
+
+} // namespace
+
+TEST(ArrowTest, FileAndStreamRoundTrip) {
+    FigureBuffer figures = arrowSample();
+    for (bool file : {true, false}) {
+        ArrowOptions opts;
+        opts.file = file;
+        opts.batchSize = 300;
+        std::stringstream ss;
+        writeArrow(ss, figures, opts);
+        std::string bytes = ss.str();
+        // Файл: сигнатура в начале и в конце после длины оглавления
+        EXPECT_EQ(bytes.compare(0, 6, "ARROW1") == 0, file);
+        EXPECT_EQ(bytes.size() % 8, file ? 2u : 0u);
+
+        ArrowReader reader(ss);
+        EXPECT_EQ(reader.figureCount(), figures.size());
+        EXPECT_EQ(reader.batchCount(), 4u);
+        EXPECT_TRUE(reader.zeroCopy());
+        const ArrowBatchView& last = reader.batch(3);
+        EXPECT_EQ(last.length, 101u);
+        EXPECT_EQ(last.kinds[100], 0);
+        EXPECT_EQ(last.offsets[101] - last.offsets[100], 7);
+        expectSameFigures(reader.readAll(), figures);
+    }
+
+    std::stringstream empty;
+    writeArrow(empty, FigureBuffer());
+    EXPECT_EQ(ArrowReader(empty).figureCount(), 0u);
+}
+
+TEST(ArrowTest, MappedFileIsReadInPlace) {
+    FigureBuffer figures = arrowSample();
+    std::string path = "arrow_test.arrow";
+    {
+        std::ofstream out(path, std::ios::binary);
+        writeArrow(out, figures);
+    }
+    {
+        ArrowReader reader(path);
+        ASSERT_EQ(reader.batchCount(), 1u);
+        EXPECT_TRUE(reader.zeroCopy());
+        const ArrowBatchView& view = reader.batch(0);
+        EXPECT_EQ(reinterpret_cast<std::uintptr_t>(view.xs) % 8, 0u);
+        EXPECT_EQ(view.xs[view.offsets[5]], figures.xs(5)[0]);
+        EXPECT_EQ(view.ys[view.offsets[5] + 1], figures.ys(5)[1]);
+    }
+
+    Shell shell(false);
+    std::stringstream in("add diamond 0 0 1 0 1 1 0 1\nexport arrow_shell.arrows\nimport arrow_shell.arrows\ncount\n");
+    std::stringstream out;
+    while (shell.execute(in, out)) {}
+    EXPECT_NE(out.str().find("Выгружено фигур: 1"), std::string::npos);
+    EXPECT_EQ(shell.collection().size(), 2u);
+    std::remove(path.c_str());
+    std::remove("arrow_shell.arrows");
+}
+
+TEST(ArrowTest, RejectsCorruptOrForeignData) {
+    std::stringstream ss;
+    ArrowOptions opts;
+    opts.file = false;
+    writeArrow(ss, arrowSample(), opts);
+    std::string bytes = ss.str();
+
+    std::stringstream truncated(bytes.substr(0, bytes.size() / 2));
+    EXPECT_THROW(ArrowReader{truncated}, std::runtime_error);
+
+    std::stringstream garbage(std::string(64, '\x7f'));
+    EXPECT_THROW(ArrowReader{garbage}, std::runtime_error);
+
+    // Поток: сообщение схемы, затем запись; тело записи начинается со
+    // столбца type. Неизвестный код вида обнаруживается при чтении фигур
+    std::uint32_t schemaLength, batchLength;
+    std::memcpy(&schemaLength, bytes.data() + 4, 4);
+    std::memcpy(&batchLength, bytes.data() + 12 + schemaLength, 4);
+    std::string patched = bytes;
+    patched[16 + schemaLength + batchLength] = 3;
+    std::stringstream bad(patched);
+    ArrowReader reader(bad);
+    EXPECT_EQ(reader.batch(0).kinds[0], 3);
+    EXPECT_THROW(reader.readAll(), std::runtime_error);
+}
+
+// =============== JSON TESTS ===============
+
+TEST(JsonTest, RoundTripAndSmallChunks) {
+    FigureBuffer figures = arrowSample();
+    std::stringstream ss;
+    writeJson(ss, figures);
+    std::string text = ss.str();
+
+    FigureBuffer parsed;
+    EXPECT_EQ(parseJson(text.data(), text.data() + text.size(), parsed), figures.size());
+    expectSameFigures(parsed, figures);
+
+    // Куски по 7 байт режут числа, строки и ключи посередине
+    std::stringstream in(text);
+    JsonReader reader(in, 7);
+    FigureBuffer streamed;
+    while (reader.next(streamed)) {}
+    expectSameFigures(streamed, figures);
+
+    std::stringstream empty;
+    writeJson(empty, FigureBuffer());
+    EXPECT_EQ(readJson(empty).size(), 0u);
+}
+
+TEST(JsonTest, AcceptsFormattingAndExtraKeys) {
+    std::string text =
+        "  [\n"
+        "    {\n"
+        "      \"id\": 17, \"tags\": [\"a\\\"b\", {\"x\": null, \"y\": [true, false]}],\n"
+        "      \"vertices\": [ [0, 0], [2, 0], [2, 2], [0, 2] ],\n"
+        "      \"t\\u0079pe\": \"diamond\"\n"
+        "    },\n"
+        "    {\"type\": \"polygon\", \"vertices\": [[-1.5e1, 0], [1E+1, 0], [0, 2.5e-1]]}\n"
+        "  ]  \n";
+    FigureBuffer figures;
+    EXPECT_EQ(parseJson(text.data(), text.data() + text.size(), figures), 2u);
+    EXPECT_EQ(figures.kind(0), FigureKind::Diamond);
+    EXPECT_DOUBLE_EQ(figures.area(0), 4.0);
+    EXPECT_EQ(figures.kind(1), FigureKind::Polygon);
+    EXPECT_EQ(figures.xs(1)[0], -15.0);
+    EXPECT_EQ(figures.ys(1)[2], 0.25);
+
+    Shell shell(false);
+    std::stringstream cmd("add diamond 0 0 1 0 1 1 0 1\nexport json_test.json\nimport json_test.json\ncount\n");
+    std::stringstream out;
+    while (shell.execute(cmd, out)) {}
+    EXPECT_EQ(shell.collection().size(), 2u);
+    std::remove("json_test.json");
+}
+
+TEST(JsonTest, ReportsErrorPositions) {
+    auto error = [](const std::string& text) {
+        FigureBuffer figures;
+        try {
+            std::stringstream in(text);
+            JsonReader reader(in, 5);
+            while (reader.next(figures)) {}
+        } catch (const std::runtime_error& e) {
+            return std::string(e.what());
+        }
+        return std::string("no error");
+    };
+    EXPECT_EQ(error("[\n{\"type\": \"triangle\", \"vertices\": []}]"),
+              "JSON line 2, column 10: unknown figure type 'triangle'");
+    EXPECT_EQ(error("[{\"type\": \"diamond\",\n  \"vertices\": [[0, 0], [1, 0], [1, 1]]}]"),
+              "JSON line 2, column 15: diamond needs 4 vertices, got 3");
+    EXPECT_EQ(error("[{\"type\": \"pentagon\", \"vertices\": [[0, 01]]}]"),
+              "JSON line 1, column 41: expected ']' after two vertex coordinates");
+    EXPECT_EQ(error("[{\"type\": \"hexagon\", \"vertices\": [[0, 1e999]]}]"),
+              "JSON line 1, column 39: number out of range");
+    EXPECT_EQ(error("[{\"type\": \"hexagon\"}"), "JSON line 1, column 2: figure needs both 'type' and 'vertices'");
+    EXPECT_EQ(error("[\n\n"), "JSON line 3, column 1: unexpected end of input");
+    EXPECT_EQ(error("[] x"), "JSON line 1, column 4: unexpected characters after the figure array");
+}
+
+// =============== QUERY TESTS ===============
+
+TEST(QueryTest, AggregatesMatchBruteForce) {
+    GeneratorOptions opts;
+    opts.count = 5000;
+    opts.seed = 11;
+    FigureBuffer figures = generateFigures(opts);
+
+    Query q = parseQuery("SELECT count(*), sum(area), avg(center.x), min(bbox.minx), max(vertices) "
+                         "where (type = hexagon or type = pentagon) and not area < 20 and center.y between 100 and 900");
+    size_t count = 0;
+    double sum = 0.0, sumX = 0.0, minX = 1e300, maxV = 0.0;
+    for (size_t i = 0; i < figures.size(); ++i) {
+        FigureKind k = figures.kind(i);
+        double area = figures.area(i);
+        auto c = figures.center(i);
+        if ((k != FigureKind::Hexagon && k != FigureKind::Pentagon) || area < 20 || c.second < 100 || c.second > 900) continue;
+        ++count;
+        sum += area;
+        sumX += c.first;
+        minX = std::min(minX, *std::min_element(figures.xs(i), figures.xs(i) + figures.apexCount(i)));
+        maxV = std::max(maxV, static_cast<double>(figures.apexCount(i)));
+    }
+    ASSERT_GT(count, 0u);
+    for (unsigned threads : {1u, 4u}) {
+        QueryResult r = runQuery(q, figures, threads);
+        ASSERT_EQ(r.rows.size(), 1u);
+        EXPECT_EQ(r.rows[0][0], static_cast<double>(count));
+        EXPECT_NEAR(r.rows[0][1], sum, 1e-9 * sum);
+        EXPECT_NEAR(r.rows[0][2], sumX / count, 1e-9);
+        EXPECT_EQ(r.rows[0][3], minX);
+        EXPECT_EQ(r.rows[0][4], maxV);
+        EXPECT_NE(r.plan.find("виды: pentagon hexagon"), std::string::npos);
+    }
+
+    QueryResult rows = runQuery(parseQuery("select index, type where type in (diamond) limit 3"), figures);
+    ASSERT_EQ(rows.rows.size(), 3u);
+    EXPECT_EQ(rows.columns, (std::vector<std::string>{"index", "type"}));
+    for (const auto& row : rows.rows) {
+        EXPECT_EQ(figures.kind(static_cast<size_t>(row[0])), FigureKind::Diamond);
+    }
+    EXPECT_LT(rows.rows[0][0], rows.rows[1][0]);
+
+    QueryResult empty = runQuery(parseQuery("select count, avg(area) where area > 1e9"), figures);
+    EXPECT_EQ(empty.rows[0][0], 0.0);
+    EXPECT_TRUE(std::isnan(empty.rows[0][1]));
+}
+
+TEST(QueryTest, AreaIndexPushdownMatchesFullScan) {
+    GeneratorOptions opts;
+    opts.count = 3000;
+    opts.seed = 5;
+    FigureBuffer generated = generateFigures(opts);
+    FigureCollection figures;
+    for (size_t i = 0; i < generated.size(); ++i) {
+        figures.push_back(generated.materialize(i));
+    }
+    AreaIndex index;
+    index.build(figures);
+
+    std::string text = "select * where area >= 10 and area < 30 and center.x > 200";
+    QueryResult indexed = runQuery(parseQuery(text), figures, index);
+    QueryResult scanned = runQuery(parseQuery(text), toBuffer(figures));
+    EXPECT_NE(indexed.plan.find("индекс площади [10, 30]"), std::string::npos);
+    EXPECT_LT(indexed.scanned, figures.size() / 2);
+    ASSERT_FALSE(scanned.rows.empty());
+    EXPECT_EQ(indexed.rows, scanned.rows);
+
+    QueryResult wide = runQuery(parseQuery("select count where area > 0"), figures, index);
+    EXPECT_EQ(wide.plan.rfind("полный просмотр", 0), 0u);
+    EXPECT_EQ(wide.rows[0][0], static_cast<double>(figures.size()));
+}
+
+TEST(QueryTest, PushdownToleratesRescaledIndexAreas) {
+    // Площадь в индексе после rescale может отличаться от пересчитанной
+    // в последнем бите; точное равенство всё равно находит фигуру
+    FigureCollection figures;
+    AreaIndex index;
+    for (int i = 1; i <= 10; ++i) {
+        double r = i;
+        std::array<std::pair<double, double>, 4> verts = {{{r, 0}, {0, r}, {-r, 0}, {0, -r}}};
+        const Figure& fig = figures.push_back(std::make_unique<Diamond>(verts));
+        double area = fig.calculateArea();
+        index.insert(fig, i == 3 ? std::nextafter(area, 0.0) : area);
+    }
+    QueryResult indexed = runQuery(parseQuery("select count where area = 18"), figures, index);
+    EXPECT_EQ(indexed.plan.rfind("индекс площади", 0), 0u);
+    EXPECT_NE(indexed.plan.find("O(n)"), std::string::npos);
+    ASSERT_EQ(indexed.rows.size(), 1u);
+    EXPECT_EQ(indexed.rows[0][0], 1.0);
+}
+
+TEST(QueryTest, ReportsErrorsAndRunsFromShell) {
+    auto error = [](const std::string& text) {
+        try {
+            parseQuery(text);
+        } catch (const std::invalid_argument& e) {
+            return std::string(e.what());
+        }
+        return std::string("no error");
+    };
+    EXPECT_EQ(error("select area, count"), "Query: cannot mix aggregates and per-figure columns at position 8 ('area')");
+    EXPECT_EQ(error("select area where type < 3"), "Query: type supports only =, != and in at position 24 ('<')");
+    EXPECT_EQ(error("select area where area between 1"), "Query: expected 'and' at position 33 (end of query)");
+    EXPECT_EQ(error("select radius"), "Query: expected a field (area, center.x, bbox.minx, type, ...) at position 8 ('radius')");
+    EXPECT_EQ(error("select area limit -1"), "Query: expected a non-negative integer at position 19 ('-1')");
+    std::string deep = "select count where ";
+    for (int i = 0; i < 300000; ++i) deep += "not ";
+    EXPECT_EQ(error(deep + "area > 0").find("Query: condition nested too deep at position "), 0u);
+    EXPECT_EQ(error(std::string(100, '(')).find("Query: expected 'select'"), 0u);
+    EXPECT_EQ(parseQuery("select area limit 1e30").limit, std::numeric_limits<size_t>::max());
+    EXPECT_EQ(parseQuery("select area where not not (area > 1 or (not area < 0))").filtered, true);
+
+    Shell shell(false);
+    std::stringstream cmd("add diamond 0 0 2 0 2 2 0 2\nadd diamond 0 0 1 0 1 1 0 1\n"
+                          "select type, area where area > 2\nselect max(area)\nexplain select count where type = hexagon\n");
+    std::stringstream out;
+    while (shell.execute(cmd, out)) {}
+    std::string text = out.str();
+    EXPECT_NE(text.find("type  area\ndiamond  4\nСтрок: 1\n"), std::string::npos);
+    EXPECT_NE(text.find("max(area)\n4\n"), std::string::npos);
+    EXPECT_NE(text.find("Просмотрено фигур: 0, строк: 1"), std::string::npos);
+}
+
+// =============== CENTROID TESTS ===============
+
+TEST(CentroidTest, AreaWeightedCentroidOfIrregularFigures) {
+    // Дом: квадрат 2x2 и треугольная крыша высотой 1
+    const double xs[] = {0, 2, 2, 1, 0};
+    const double ys[] = {0, 0, 2, 3, 2};
+    auto c = apexCentroid(FigureKind::Pentagon, xs, ys, 5);
+    EXPECT_NEAR(c.first, 1.0, 1e-12);
+    EXPECT_NEAR(c.second, 19.0 / 15.0, 1e-12);
+    EXPECT_DOUBLE_EQ(apexCenter(FigureKind::Pentagon, xs, ys, 5).second, 1.4);
+
+    // Тот же дом вдали от начала координат и с обходом по часовой стрелке
+    const double fx[] = {1e6, 1e6, 1e6 + 1, 1e6 + 2, 1e6 + 2};
+    const double fy[] = {-1e6, -1e6 + 2, -1e6 + 3, -1e6 + 2, -1e6};
+    c = apexCentroid(FigureKind::Pentagon, fx, fy, 5);
+    EXPECT_NEAR(c.first, 1e6 + 1.0, 1e-9);
+    EXPECT_NEAR(c.second, -1e6 + 19.0 / 15.0, 1e-9);
+
+    // Вырожденная фигура — среднее вершин
+    const double lx[] = {0, 1, 2, 3};
+    const double ly[] = {0, 1, 2, 3};
+    c = apexCentroid(FigureKind::Diamond, lx, ly, 4);
+    EXPECT_DOUBLE_EQ(c.first, 1.5);
+    EXPECT_DOUBLE_EQ(c.second, 1.5);
+}
+
+TEST(CentroidTest, BatchMatchesPerFigureBitForBit) {
+    GeneratorOptions opts;
+    opts.count = 4000;
+    opts.seed = 3;
+    FigureBuffer figures = generateFigures(opts);
+    std::vector<double> xs, ys;
+    regularPolygon(9, 2.0, 5.0, -3.0, xs, ys);
+    figures.push(FigureKind::Polygon, xs.data(), ys.data(), 9);
+    const double line[] = {1, 1, 1, 1, 1, 1};
+    figures.push(FigureKind::Hexagon, line, line);
+
+    size_t n = figures.size();
+    std::vector<double> areas(n), cx(n), cy(n);
+    batchAreaCentroids(figures, areas.data(), cx.data(), cy.data());
+    for (size_t i = 0; i < n; ++i) {
+        ASSERT_EQ(areas[i], figures.area(i)) << i;
+        ASSERT_EQ(cx[i], figures.centroid(i).first) << i;
+        ASSERT_EQ(cy[i], figures.centroid(i).second) << i;
+    }
+    EXPECT_NEAR(cx[n - 2], 5.0, 1e-12);
+    EXPECT_NEAR(cy[n - 2], -3.0, 1e-12);
+    EXPECT_EQ(cx[n - 1], 1.0);
+}
+
+// =============== COMPACT TESTS ===============
+
+TEST(CompactTest, DetectsRegularFigures) {
+    FigureBuffer buf;
+    buf.push(Pentagon());
+    buf.push(Hexagon());
+    RegularShape shape;
+    ASSERT_TRUE(detectRegular(FigureKind::Pentagon, buf.xs(0), buf.ys(0), 1e-9, shape));
+    EXPECT_NEAR(shape.radius(), 1.0, 1e-15);
+    EXPECT_NEAR(shape.phase(), 0.0, 1e-15);
+    EXPECT_NEAR(regularArea(FigureKind::Pentagon, shape), buf.area(0), 1e-15);
+    ASSERT_TRUE(detectRegular(FigureKind::Hexagon, buf.xs(1), buf.ys(1), 1e-9, shape));
+    EXPECT_NEAR(regularArea(FigureKind::Hexagon, shape), 3.0 * std::sqrt(3.0) / 2.0, 1e-14);
+
+    // Повёрнутый шестиугольник вдали от начала координат
+    double xs[6], ys[6];
+    RegularShape far{1e5, -2e5, 3.0 * std::cos(0.7), 3.0 * std::sin(0.7)};
+    expandRegular(FigureKind::Hexagon, far, xs, ys);
+    ASSERT_TRUE(detectRegular(FigureKind::Hexagon, xs, ys, 1e-9, shape));
+    EXPECT_NEAR(shape.phase(), 0.7, 1e-9);
+    EXPECT_NEAR(shape.radius(), 3.0, 1e-9);
+
+    // Сдвиг вершины, обход по часовой стрелке и ромб — не правильные
+    xs[2] += 1e-6;
+    EXPECT_FALSE(detectRegular(FigureKind::Hexagon, xs, ys, 1e-9, shape));
+    EXPECT_TRUE(detectRegular(FigureKind::Hexagon, xs, ys, 1e-6, shape));
+    const double cwX[] = {1, std::cos(-2 * M_PI / 5), std::cos(-4 * M_PI / 5), std::cos(-6 * M_PI / 5), std::cos(-8 * M_PI / 5)};
+    const double cwY[] = {0, std::sin(-2 * M_PI / 5), std::sin(-4 * M_PI / 5), std::sin(-6 * M_PI / 5), std::sin(-8 * M_PI / 5)};
+    EXPECT_FALSE(detectRegular(FigureKind::Pentagon, cwX, cwY, 1e-9, shape));
+    const double dx[] = {1, 0, -1, 0};
+    const double dy[] = {0, 1, 0, -1};
+    EXPECT_FALSE(detectRegular(FigureKind::Diamond, dx, dy, 1e-9, shape));
+}
+
+TEST(CompactTest, StoresRegularFiguresByParameters) {
+    GeneratorOptions opts;
+    opts.count = 3000;
+    opts.seed = 9;
+    FigureBuffer flat = generateFigures(opts);
+    CompactBuffer compact = toCompact(flat);
+    ASSERT_EQ(compact.size(), flat.size());
+    EXPECT_GT(compact.regularCount(), flat.size() / 5);
+    EXPECT_LT(compact.regularCount(), flat.size());
+
+    FigureBuffer expanded = compact.expand();
+    ASSERT_EQ(expanded.size(), flat.size());
+    for (size_t i = 0; i < flat.size(); ++i) {
+        ASSERT_EQ(compact.kind(i), flat.kind(i));
+        ASSERT_EQ(compact.apexCount(i), flat.apexCount(i));
+        double scale = std::abs(flat.xs(i)[0]) + std::abs(flat.ys(i)[0]) + 1.0;
+        EXPECT_NEAR(compact.area(i), flat.area(i), 1e-9 * flat.area(i));
+        EXPECT_NEAR(compact.center(i).first, flat.center(i).first, 1e-12 * scale);
+        for (size_t j = 0; j < flat.apexCount(i); ++j) {
+            ASSERT_NEAR(expanded.xs(i)[j], flat.xs(i)[j], 1e-9 * scale);
+            ASSERT_NEAR(expanded.ys(i)[j], flat.ys(i)[j], 1e-9 * scale);
+        }
+        if (!compact.isRegular(i)) {
+            ASSERT_EQ(expanded.xs(i)[1], flat.xs(i)[1]);
+        }
+    }
+    std::vector<double> areas(compact.size());
+    compact.areas(areas.data());
+    EXPECT_EQ(areas[7], compact.area(7));
+    EXPECT_NEAR(static_cast<double>(*compact.materialize(7)), flat.area(7), 1e-9 * flat.area(7));
+
+    // Только правильные фигуры: параметры вместо координат
+    opts.diamonds = opts.irregularPentagons = opts.irregularHexagons = 0;
+    FigureBuffer regular = generateFigures(opts);
+    CompactBuffer packed = toCompact(regular);
+    EXPECT_EQ(packed.regularCount(), regular.size());
+    EXPECT_LT(packed.memoryUsage().heapBytes * 2, regular.memoryUsage().heapBytes);
+}
+
+TEST(CompactTest, ShellReportsCompactSize) {
+    Shell shell(false);
+    std::stringstream cmd("add pentagon 1 0 0.309017 0.951057 -0.809017 0.587785 -0.809017 -0.587785 0.309017 -0.951057\n"
+                          "generate 50 seed=2\nmem\n");
+    std::stringstream out;
+    while (shell.execute(cmd, out)) {}
+    std::string text = out.str();
+    size_t pos = text.find("компактное хранение: ");
+    ASSERT_NE(pos, std::string::npos);
+    EXPECT_NE(text.find(" из 51)", pos), std::string::npos);
+}
+
+TEST(CompactTest, EstimateMatchesBuiltBuffers) {
+    GeneratorOptions opts;
+    opts.count = 300;
+    FigureBuffer generated = generateFigures(opts);
+    FigureCollection figures;
+    double xs[6], ys[6];
+    for (int i = 0; i < 40; ++i) {
+        RegularShape shape{i * 3.0, -1.0, 1.0 + i, 0.5};
+        FigureKind kind = i % 2 ? FigureKind::Pentagon : FigureKind::Hexagon;
+        expandRegular(kind, shape, xs, ys);
+        figures.push_back(makeFigure(kind, xs, ys));
+    }
+    for (size_t i = 0; i < generated.size(); ++i) {
+        figures.push_back(generated.materialize(i));
+    }
+
+    CompactEstimate est = estimateCompact(figures);
+    FigureBuffer flat = toBuffer(figures);
+    CompactBuffer compact = toCompact(flat);
+    EXPECT_EQ(est.figures, compact.size());
+    EXPECT_EQ(est.regular, compact.regularCount());
+    EXPECT_GE(est.regular, 40u);
+    EXPECT_EQ(est.flatBytes, flat.memoryUsage().usedBytes);
+    EXPECT_EQ(est.compactBytes, compact.memoryUsage().usedBytes);
+}